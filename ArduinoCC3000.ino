@@ -89,6 +89,33 @@ Arduino pin -----> 560 Ohm --+--> 1K Ohm -----> GND
 
 
 
+// The benchmarks (menu item 9) each bring in their own module, and all of
+// them together won't fit in an ATmega328. Uncomment the ones you want.
+
+//#define BENCHMARK_UDP_SEND		// a - sendto_batch
+//#define BENCHMARK_UDP_RECV		// b - recvfrom_batch
+//#define BENCHMARK_TCP_STREAM		// c - send_stream
+//#define BENCHMARK_CONNECT			// d - connect_async
+//#define BENCHMARK_DNS				// e - gethostbyname_async
+//#define BENCHMARK_ACCEPT			// f - listener
+//#define BENCHMARK_HTTP_SERVER		// g - httpd
+//#define BENCHMARK_HTTP_CLIENT		// h - httpc, connpool
+//#define BENCHMARK_MQTT			// i - mqtt
+//#define BENCHMARK_WEBSOCKET		// j - ws
+//#define BENCHMARK_RECONNECT		// k - fastconnect
+//#define BENCHMARK_SCAN			// l - scan
+//#define BENCHMARK_ROAM			// m - roam
+//#define BENCHMARK_SUPERVISOR		// n - supervisor
+//#define BENCHMARK_BOOT			// o - CC3000_InitAsync
+//#define BENCHMARK_EVENT_MASK		// p - wlan_event_subscribe
+//#define BENCHMARK_DUTY_CYCLE		// q - dutycycle
+//#define BENCHMARK_PROFILE			// r - profile
+//#define BENCHMARK_AES				// s - aes_encrypt_block
+//#define BENCHMARK_AES_STREAM		// t - aesstream
+
+
+
+
 #include <SPI.h>
 
 #include "ArduinoCC3000Core.h"
@@ -98,6 +125,42 @@ Arduino pin -----> 560 Ohm --+--> 1K Ohm -----> GND
 #include "hci.h"
 #include "security.h"
 #include "netapp.h"
+#include "reactor.h"
+#include "profile.h"
+#ifdef BENCHMARK_ACCEPT
+#include "listener.h"
+#endif
+#ifdef BENCHMARK_HTTP_SERVER
+#include "httpd.h"
+#endif
+#ifdef BENCHMARK_HTTP_CLIENT
+#include "connpool.h"
+#include "httpc.h"
+#endif
+#ifdef BENCHMARK_MQTT
+#include "mqtt.h"
+#endif
+#ifdef BENCHMARK_WEBSOCKET
+#include "ws.h"
+#endif
+#ifdef BENCHMARK_RECONNECT
+#include "fastconnect.h"
+#endif
+#ifdef BENCHMARK_SCAN
+#include "scan.h"
+#endif
+#ifdef BENCHMARK_ROAM
+#include "roam.h"
+#endif
+#ifdef BENCHMARK_SUPERVISOR
+#include "supervisor.h"
+#endif
+#ifdef BENCHMARK_DUTY_CYCLE
+#include "dutycycle.h"
+#endif
+#ifdef BENCHMARK_AES_STREAM
+#include "aesstream.h"
+#endif
 
 
 
@@ -147,6 +210,10 @@ void AsyncEventPrint(void) {
 			Serial.println(F("CC3000 Async event: OK to shut down"));
 			break;
 
+		case HCI_EVNT_BSD_TCP_CLOSE_WAIT:
+			Serial.println(F("CC3000 Async event: Remote side closed a socket"));
+			break;
+
 		case HCI_EVNT_WLAN_KEEPALIVE:
 			// Once initialized, the CC3000 will send these keepalive events
 			// every 20 seconds.
@@ -211,6 +278,8 @@ void loop(void) {
 	Serial.println(F("  5 - Manually add connection profile"));
 	Serial.println(F("  6 - List access points"));
 	Serial.println(F("  7 - Show CC3000 information"));
+	Serial.println(F("  8 - Run multi-client echo server"));
+	Serial.println(F("  9 - Benchmarks"));
 	Serial.println();
 
 	for (;;) {
@@ -249,6 +318,12 @@ void loop(void) {
 		case '7':
 			ShowInformation();
 			break;
+		case '8':
+			RunEchoServer();
+			break;
+		case '9':
+			Benchmarks();
+			break;
 		default:
 			Serial.print(F("**Unknown command \""));
 			Serial.print(cmd);
@@ -444,7 +519,7 @@ void StartSmartConfig(void) {
 		}
 		
 	Serial.println(F("  Deleting all existing profiles..."));
-	if ((rval = wlan_ioctl_del_profile(255))!=0) {
+	if ((rval = profile_delete_all())!=0) {
 		Serial.print(F("    Deleting all profiles failed, error: "));
 		Serial.println(rval, HEX);
 		return;
@@ -484,6 +559,9 @@ void StartSmartConfig(void) {
 
 	Serial.println(F("  Smart Config packet seen!"));
 
+	// The CC3000 stored the new profile itself, behind the mirror's back
+	profile_invalidate();
+
 	Serial.println(F("  Enabling auto-connect policy..."));
 	if ((rval=wlan_ioctl_set_connection_policy(DISABLE, DISABLE, ENABLE))!=0) {
 		Serial.print(F("    Setting auto connection policy failed, error: "));
@@ -556,7 +634,7 @@ void ManualConnect(void) {
 	rval = wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE);
 
 	Serial.println(F("  Deleting all existing profiles..."));
-	rval = wlan_ioctl_del_profile(255);
+	rval = profile_delete_all();
 
 	Serial.println(F("  Waiting until disconnected..."));
 	while (ulCC3000Connected == 1) {
@@ -618,8 +696,10 @@ void ManualConnect(void) {
 	255 on failure.
 	
 	Unfortunately the API doesn't give you any way to see how many profiles
-	are in use or which profile is stored in which slot, so if you want to
-	manage multiple profiles you'll need to do that yourself.
+	are in use or which profile is stored in which slot, so profile_add()
+	keeps track of that in a mirror of the profile table (see profile.h). It
+	also fills in the undocumented cipher arguments, and doesn't send
+	anything to the CC3000 if the same profile is already stored.
 */
 
 void ManualAddProfile(void) {
@@ -637,23 +717,16 @@ void ManualAddProfile(void) {
 	wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE);
 
 	Serial.println("  Adding profile...");
-	byte rval = wlan_add_profile  (
+	long rval = profile_add(
 					WLAN_SEC_WPA2,		// WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or WLAN_SEC_WPA2
-					(unsigned char *)ssidName,
+					ssidName,
 					strlen(ssidName),
-					NULL,				// BSSID, TI always uses NULL
 					0,					// profile priority
-					0x18,				// key length for WEP security, undocumented why this needs to be 0x18
-					0x1e,				// key index, undocumented why this needs to be 0x1e
-					0x2,				// key management, undocumented why this needs to be 2
 					(unsigned char *)AP_KEY,	// WPA security key
 					strlen(AP_KEY)		// WPA security key length
 					);
 
-	if (rval!=255) {
-
-		// This code is lifted from http://e2e.ti.com/support/low_power_rf/f/851/p/180859/672551.aspx;
-		// the actual API documentation on wlan_add_profile doesn't specify any of this....
+	if (rval>=0) {
 
 		Serial.print(F("  Manual add profile success, stored in profile: "));
 		Serial.println(rval, DEC);
@@ -674,7 +747,8 @@ void ManualAddProfile(void) {
 
 		}
 	else {
-		Serial.print(F("  Manual add profile failured (all profiles full?)."));
+		Serial.print(F("  Manual add profile failured (all profiles full?), error: "));
+		Serial.println(rval);
 		}
 	}
 	
@@ -928,4 +1002,1640 @@ void ShowInformation(void) {
 	Serial.print(F("  Connected to SSID: "));
 	Serial.println(localB);
 
+	}
+
+
+
+
+
+
+
+
+
+
+
+/*
+	A small TCP echo server on port 7 to show off the reactor. Several
+	clients can be connected at once; each one is echoed from the same
+	loop. Every 5 seconds it prints the reactor counters so you can see
+	how loop time grows as you add connections (try a few copies of
+	"telnet <ip> 7" or a load generator). Press any key to stop.
+*/
+
+#define ECHO_PORT	7
+
+void EchoHandler(long sd, unsigned char event, long arg) {
+	char buf[32];
+	int len;
+
+	switch(event) {
+		case REACTOR_EVENT_ACCEPT:
+			if (reactor_register(arg, REACTOR_EVENT_READ, EchoHandler)!=0) {
+				closesocket(arg);
+				}
+			break;
+
+		case REACTOR_EVENT_READ:
+			len = recv(sd, buf, sizeof(buf), 0);
+			if (len>0) {
+				send(sd, buf, len, 0);
+				}
+			break;
+
+		case REACTOR_EVENT_CLOSE:
+			closesocket(sd);
+			break;
+		}
+	}
+
+void RunEchoServer(void) {
+	sockaddr addr;
+	long listenSd;
+	unsigned long lastReport;
+	tReactorStats stats;
+
+	if (!isInitialized) {
+		Serial.println(F("CC3000 not initialized; can't run echo server."));
+		return;
+		}
+
+	listenSd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSd<0) {
+		Serial.println(F("Unable to open socket."));
+		return;
+		}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (ECHO_PORT >> 8) & 0xff;
+	addr.sa_data[1] = ECHO_PORT & 0xff;
+
+	if ((bind(listenSd, &addr, sizeof(addr))!=0) || (listen(listenSd, 1)!=0)) {
+		Serial.println(F("Unable to bind/listen."));
+		closesocket(listenSd);
+		return;
+		}
+
+	reactor_register(listenSd, REACTOR_EVENT_ACCEPT, EchoHandler);
+	reactor_reset_stats();
+
+	Serial.println(F("Echo server running on port 7, press any key to stop"));
+
+	lastReport = millis();
+	while (!Serial.available()) {
+		reactor_run_once(20);
+
+		if (millis()-lastReport >= 5000) {
+			lastReport = millis();
+			reactor_get_stats(&stats);
+			Serial.print(F("  sockets: "));
+			Serial.print(stats.ucRegistered);
+			Serial.print(F("  loops: "));
+			Serial.print(stats.ulIterations);
+			Serial.print(F("  handled: "));
+			Serial.print(stats.ulDispatched);
+			Serial.print(F("  accepted: "));
+			Serial.print(stats.ulAccepted);
+			Serial.print(F("  closed: "));
+			Serial.print(stats.ulClosed);
+			Serial.print(F("  max loop us: "));
+			Serial.println(stats.ulMaxIterationMicros);
+			reactor_reset_stats();
+			}
+		}
+	Serial.read();
+
+	for (long sd=0; sd<REACTOR_MAX_SOCKETS; sd++) {
+		if (reactor_unregister(sd)==0) {
+			closesocket(sd);
+			}
+		}
+
+	Serial.println(F("Echo server stopped."));
+	}
+
+
+
+
+
+
+
+
+
+
+
+/*
+	Throughput benchmarks for the socket extensions. Each one prints the
+	result of the plain driver calls next to the new API so you can see
+	what it buys you on your board. UDP traffic goes to the discard port (9)
+	of your gateway, which will just drop it.
+*/
+
+#define BENCH_PORT		9
+#define BENCH_DATAGRAMS	100
+#define BENCH_BATCH		10
+#define BENCH_PAYLOAD	32
+
+char WaitForKey(void) {
+	char c;
+	for (;;) {
+		while (!Serial.available()) {
+			}
+		c = Serial.read();
+		if (c!='\n' && c!='\r') {
+			return c;
+			}
+		}
+	}
+
+void GatewayAddress(sockaddr *addr, unsigned short port) {
+	tNetappIpconfigRetArgs inf;
+
+	netapp_ipconfig(&inf);
+
+	memset(addr, 0, sizeof(sockaddr));
+	addr->sa_family = AF_INET;
+	addr->sa_data[0] = (port >> 8) & 0xff;
+	addr->sa_data[1] = port & 0xff;
+	addr->sa_data[2] = inf.aucDefaultGateway[3];
+	addr->sa_data[3] = inf.aucDefaultGateway[2];
+	addr->sa_data[4] = inf.aucDefaultGateway[1];
+	addr->sa_data[5] = inf.aucDefaultGateway[0];
+	}
+
+void PrintRate(unsigned long count, unsigned long ms, const __FlashStringHelper *units) {
+	Serial.print(count);
+	Serial.print(F(" in "));
+	Serial.print(ms);
+	Serial.print(F(" ms = "));
+	Serial.print(ms ? (count*1000UL)/ms : 0);
+	Serial.print(F(" "));
+	Serial.println(units);
+	}
+
+#ifdef BENCHMARK_UDP_SEND
+void BenchUDPSend(void) {
+	sockaddr addr;
+	tSendtoMsg msgs[BENCH_BATCH];
+	unsigned char payload[BENCH_PAYLOAD];
+	unsigned long start, sent;
+	long sd;
+
+	sd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sd<0) {
+		Serial.println(F("Unable to open socket."));
+		return;
+		}
+
+	GatewayAddress(&addr, BENCH_PORT);
+	memset(payload, 'x', sizeof(payload));
+
+	Serial.print(F("  sendto:       "));
+	sent = 0;
+	start = millis();
+	for (int i=0; i<BENCH_DATAGRAMS; i++) {
+		if (sendto(sd, payload, sizeof(payload), 0, &addr, sizeof(addr))==sizeof(payload)) {
+			sent++;
+			}
+		}
+	PrintRate(sent, millis()-start, F("datagrams/s"));
+
+	for (int i=0; i<BENCH_BATCH; i++) {
+		msgs[i].buf = payload;
+		msgs[i].len = sizeof(payload);
+		msgs[i].to = &addr;
+		msgs[i].tolen = sizeof(addr);
+		}
+
+	Serial.print(F("  sendto_batch: "));
+	sent = 0;
+	start = millis();
+	for (int i=0; i<BENCH_DATAGRAMS/BENCH_BATCH; i++) {
+		sent += sendto_batch(sd, msgs, BENCH_BATCH, 0);
+		}
+	PrintRate(sent, millis()-start, F("datagrams/s"));
+
+	closesocket(sd);
+	}
+#endif
+
+#ifdef BENCHMARK_UDP_RECV
+#define BENCH_RECV_PORT	5001
+#define BENCH_RECV_SECS	10
+
+void BenchUDPRecv(void) {
+	sockaddr addr;
+	tRecvfromMsg msgs[BENCH_BATCH/2];
+	unsigned char payload[BENCH_BATCH/2][BENCH_PAYLOAD];
+	tRecvfromBatchStats before, after;
+	unsigned long start;
+	long sd;
+
+	sd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sd<0) {
+		Serial.println(F("Unable to open socket."));
+		return;
+		}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (BENCH_RECV_PORT >> 8) & 0xff;
+	addr.sa_data[1] = BENCH_RECV_PORT & 0xff;
+	if (bind(sd, &addr, sizeof(addr))!=0) {
+		Serial.println(F("Unable to bind."));
+		closesocket(sd);
+		return;
+		}
+
+	for (int i=0; i<BENCH_BATCH/2; i++) {
+		msgs[i].buf = payload[i];
+		msgs[i].len = BENCH_PAYLOAD;
+		}
+
+	Serial.println(F("  Send a burst of UDP datagrams to port 5001 now, e.g."));
+	Serial.println(F("    iperf -u -c <ip> -p 5001 -l 32 -b 200k"));
+
+	recvfrom_batch_stats(&before);
+	start = millis();
+	while (millis()-start < BENCH_RECV_SECS*1000UL) {
+		recvfrom_batch(sd, msgs, BENCH_BATCH/2, 0, 100);
+		}
+	recvfrom_batch_stats(&after);
+
+	Serial.print(F("  received:  "));
+	PrintRate(after.ulDatagrams-before.ulDatagrams, BENCH_RECV_SECS*1000UL, F("datagrams/s"));
+	Serial.print(F("  ceiling:   "));
+	PrintRate(after.ulDatagrams-before.ulDatagrams, (after.ulBusyMicros-before.ulBusyMicros)/1000, F("datagrams/s while busy"));
+	Serial.print(F("  idle polls: "));
+	Serial.print(after.ulIdleCalls-before.ulIdleCalls);
+	Serial.print(F("  largest batch: "));
+	Serial.println(after.usLargestBatch);
+
+	closesocket(sd);
+	}
+#endif
+
+#define BENCH_STREAM_PORT	5002
+#define BENCH_STREAM_BYTES	4096
+
+#ifdef BENCHMARK_TCP_STREAM
+const unsigned char benchAsset[256] PROGMEM = {
+	'<','h','t','m','l','>','C','C','3','0','0','0',' ','s','t','r','e','a','m',' ','t','e','s','t','<','/','h','t','m','l','>','\n'
+	};
+
+long BenchAssetSource(unsigned char *dst, unsigned long offset, unsigned short len, void *context) {
+	unsigned short n = 0;
+
+	(void)context;
+
+	while (n<len) {
+		unsigned short pos = (offset+n) % sizeof(benchAsset);
+		unsigned short run = sizeof(benchAsset)-pos;
+		if (run>len-n) {
+			run = len-n;
+			}
+		memcpy_P(dst+n, benchAsset+pos, run);
+		n += run;
+		}
+	return n;
+	}
+
+void BenchTCPStream(void) {
+	sockaddr addr;
+	socklen_t addrlen;
+	unsigned char buf[64];
+	unsigned long start, sent;
+	long listenSd, sd;
+
+	listenSd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSd<0) {
+		Serial.println(F("Unable to open socket."));
+		return;
+		}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (BENCH_STREAM_PORT >> 8) & 0xff;
+	addr.sa_data[1] = BENCH_STREAM_PORT & 0xff;
+	if ((bind(listenSd, &addr, sizeof(addr))!=0) || (listen(listenSd, 1)!=0)) {
+		Serial.println(F("Unable to bind/listen."));
+		closesocket(listenSd);
+		return;
+		}
+
+	Serial.println(F("  Connect to port 5002 now, e.g. nc <ip> 5002 > /dev/null"));
+	addrlen = sizeof(addr);
+	sd = accept(listenSd, &addr, &addrlen);
+	if (sd<0) {
+		Serial.println(F("Accept failed."));
+		closesocket(listenSd);
+		return;
+		}
+
+	Serial.print(F("  memcpy_P + send: "));
+	sent = 0;
+	start = millis();
+	while (sent<BENCH_STREAM_BYTES) {
+		BenchAssetSource(buf, sent, sizeof(buf), NULL);
+		if (send(sd, buf, sizeof(buf), 0)!=sizeof(buf)) {
+			break;
+			}
+		sent += sizeof(buf);
+		}
+	PrintRate(sent, millis()-start, F("bytes/s"));
+
+	Serial.print(F("  send_stream:     "));
+	start = millis();
+	sent = send_stream(sd, BenchAssetSource, BENCH_STREAM_BYTES, NULL);
+	PrintRate(sent, millis()-start, F("bytes/s"));
+
+	closesocket(sd);
+	closesocket(listenSd);
+	}
+#endif
+
+#ifdef BENCHMARK_CONNECT
+#define BENCH_CONNECT_PORT	80
+#define BENCH_CONNECTS		3
+
+void BenchConnect(void) {
+	sockaddr addr;
+	tConnectAsyncStats stats;
+	long sds[BENCH_CONNECTS], result;
+	unsigned long start, spins;
+	int i, opened;
+
+	GatewayAddress(&addr, BENCH_CONNECT_PORT);
+
+	Serial.print(F("  connect:       "));
+	opened = 0;
+	start = millis();
+	for (i=0; i<BENCH_CONNECTS; i++) {
+		sds[i] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (sds[i]>=0 && connect(sds[i], &addr, sizeof(addr))==0) {
+			opened++;
+			}
+		}
+	PrintRate(opened, millis()-start, F("connects/s"));
+	for (i=0; i<BENCH_CONNECTS; i++) {
+		if (sds[i]>=0) {
+			closesocket(sds[i]);
+			}
+		}
+
+	Serial.print(F("  connect_async: "));
+	for (i=0; i<BENCH_CONNECTS; i++) {
+		sds[i] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		}
+	opened = 0;
+	spins = 0;
+	start = millis();
+	for (i=0; i<BENCH_CONNECTS; i++) {
+		if (sds[i]>=0) {
+			connect_async(sds[i], &addr, sizeof(addr), NULL);
+			}
+		}
+	while (connect_async_poll()>0) {
+		spins++;				// free for other work while the handshakes run
+		}
+	for (i=0; i<BENCH_CONNECTS; i++) {
+		if (sds[i]>=0 && connect_async_status(sds[i], &result)==1 && result==0) {
+			opened++;
+			}
+		}
+	PrintRate(opened, millis()-start, F("connects/s"));
+	Serial.print(F("  loop passes while connecting: "));
+	Serial.println(spins);
+	for (i=0; i<BENCH_CONNECTS; i++) {
+		if (sds[i]>=0) {
+			closesocket(sds[i]);
+			}
+		}
+
+	connect_async_stats(&stats);
+	Serial.print(F("  average handshake: "));
+	Serial.print((stats.ulSucceeded+stats.ulFailed) ? stats.ulConnectMillis/(stats.ulSucceeded+stats.ulFailed) : 0);
+	Serial.print(F(" ms, max "));
+	Serial.print(stats.ulMaxConnectMillis);
+	Serial.print(F(" ms, queued "));
+	Serial.print(stats.ulQueueMillis);
+	Serial.println(F(" ms in total"));
+	}
+#endif
+
+#ifdef BENCHMARK_DNS
+const char * const benchHosts[] = { "www.ti.com", "www.arduino.cc", "www.google.com" };
+#define BENCH_HOSTS	(sizeof(benchHosts)/sizeof(benchHosts[0]))
+
+void BenchDNSResolved(long handle, long result, unsigned long ip, unsigned long ms) {
+	Serial.print(F("    "));
+	Serial.print(benchHosts[handle]);
+	Serial.print(F(": "));
+	if (result>0 && ip!=0) {
+		Serial.print(ip >> 24);
+		Serial.print(F("."));
+		Serial.print((ip >> 16) & 0xff);
+		Serial.print(F("."));
+		Serial.print((ip >> 8) & 0xff);
+		Serial.print(F("."));
+		Serial.print(ip & 0xff);
+		}
+	else {
+		Serial.print(F("not resolved"));
+		}
+	Serial.print(F(" in "));
+	Serial.print(ms);
+	Serial.println(F(" ms"));
+	}
+
+void BenchDNS(void) {
+	tGethostbynameAsyncStats stats;
+	unsigned long start, ip, spins;
+	unsigned int i, resolved;
+
+	gethostbyname_cache_flush();
+	Serial.print(F("  gethostbyname:       "));
+	resolved = 0;
+	start = millis();
+	for (i=0; i<BENCH_HOSTS; i++) {
+		if (gethostbyname((char *)benchHosts[i], strlen(benchHosts[i]), &ip)>0 && ip!=0) {
+			resolved++;
+			}
+		}
+	PrintRate(resolved, millis()-start, F("lookups/s"));
+
+	// Start from cold again so both runs query the DNS server
+	gethostbyname_cache_flush();
+	Serial.println(F("  gethostbyname_async:"));
+	spins = 0;
+	start = millis();
+	for (i=0; i<BENCH_HOSTS; i++) {
+		// handles are handed out in order from an idle table, so the
+		// handle doubles as the index into benchHosts
+		gethostbyname_async(benchHosts[i], strlen(benchHosts[i]), BenchDNSResolved);
+		}
+	while (gethostbyname_async_poll()>0) {
+		spins++;				// free for other work while the queries run
+		}
+	Serial.print(F("    all done in "));
+	Serial.print(millis()-start);
+	Serial.print(F(" ms, loop passes meanwhile: "));
+	Serial.println(spins);
+
+	gethostbyname_async_stats(&stats);
+	Serial.print(F("  slowest lookup: "));
+	Serial.print(stats.ulMaxMillis);
+	Serial.print(F(" ms, queued "));
+	Serial.print(stats.ulQueueMillis);
+	Serial.println(F(" ms in total"));
+	}
+#endif
+
+#ifdef BENCHMARK_ACCEPT
+#define BENCH_ACCEPT_PORT	5003
+#define BENCH_ACCEPT_SECS	15
+
+void BenchAccept(void) {
+	sockaddr addr;
+	tListenerStats stats;
+	unsigned long start;
+	long listenSd, sd;
+
+	listenSd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSd<0) {
+		Serial.println(F("Unable to open socket."));
+		return;
+		}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (BENCH_ACCEPT_PORT >> 8) & 0xff;
+	addr.sa_data[1] = BENCH_ACCEPT_PORT & 0xff;
+	if ((bind(listenSd, &addr, sizeof(addr))!=0) || (listen(listenSd, MAX_LISTEN_QUEUE)!=0) ||
+			(listener_attach(listenSd)!=0)) {
+		Serial.println(F("Unable to bind/listen."));
+		closesocket(listenSd);
+		return;
+		}
+
+	Serial.println(F("  Open a burst of connections to port 5003 now, e.g."));
+	Serial.println(F("    for i in $(seq 20); do nc -z <ip> 5003 & done"));
+
+	listener_reset_stats();
+	start = millis();
+	while (millis()-start < BENCH_ACCEPT_SECS*1000UL) {
+		listener_poll();
+		while ((sd = listener_accept(listenSd, &addr, NULL)) >= 0) {
+			closesocket(sd);
+			}
+		}
+	listener_get_stats(&stats);
+
+	Serial.print(F("  accepted: "));
+	Serial.print(stats.ulAccepted);
+	Serial.print(F(", handed out: "));
+	Serial.print(stats.ulHandedOut);
+	Serial.print(F(", dropped: "));
+	Serial.print(stats.ulDropped);
+	Serial.print(F(", errors: "));
+	Serial.println(stats.ulErrors);
+	Serial.print(F("  accept() round trip: "));
+	Serial.print(stats.ulAcceptPolls ? stats.ulAcceptMicros/stats.ulAcceptPolls : 0);
+	Serial.print(F(" us, queue wait max "));
+	Serial.print(stats.ulMaxQueueWaitMillis);
+	Serial.print(F(" ms, peak queued "));
+	Serial.println(stats.ucPeakQueued);
+
+	listener_detach(listenSd);
+	closesocket(listenSd);
+	}
+#endif
+
+#ifdef BENCHMARK_HTTP_SERVER
+#define BENCH_HTTP_PORT	80
+
+const char benchIndexPath[] PROGMEM = "/";
+const char benchStatusPath[] PROGMEM = "/status";
+const char benchTypeHtml[] PROGMEM = "text/html";
+const char benchTypePlain[] PROGMEM = "text/plain";
+const unsigned char benchIndexBody[] PROGMEM =
+	"<html><body><h1>CC3000</h1><a href=\"/status\">status</a></body></html>";
+
+void BenchStatusPage(long sd, const char *query) {
+	char line[24];
+	int len;
+
+	(void)query;
+
+	len = sprintf(line, "uptime %lu s\n", millis()/1000);
+	httpd_write_chunk(sd, line, len);
+	len = sprintf(line, "free RAM %d\n", freeRam());
+	httpd_write_chunk(sd, line, len);
+	}
+
+const tHttpdRoute benchRoutes[] PROGMEM = {
+	{ benchIndexPath, benchTypeHtml, benchIndexBody, sizeof(benchIndexBody)-1, NULL },
+	{ benchStatusPath, benchTypePlain, NULL, 0, BenchStatusPage },
+	{ NULL, NULL, NULL, 0, NULL }
+	};
+
+void BenchHTTP(void) {
+	tHttpdStats stats;
+	unsigned long lastReport, lastRequests;
+
+	if (httpd_begin(BENCH_HTTP_PORT, benchRoutes)<0) {
+		Serial.println(F("Unable to start the HTTP server."));
+		return;
+		}
+
+	Serial.println(F("  HTTP server on port 80, press any key to stop. Load it with e.g."));
+	Serial.println(F("    ab -k -c 3 -n 500 http://<ip>/"));
+
+	httpd_reset_stats();
+	lastReport = millis();
+	lastRequests = 0;
+	while (!Serial.available()) {
+		httpd_poll(20);
+
+		if (millis()-lastReport >= 5000) {
+			httpd_get_stats(&stats);
+			Serial.print(F("  "));
+			PrintRate(stats.ulRequests-lastRequests, millis()-lastReport, F("requests/s"));
+			Serial.print(F("    kept alive: "));
+			Serial.print(stats.ulKeptAlive);
+			Serial.print(F("  pipelined: "));
+			Serial.print(stats.ulPipelined);
+			Serial.print(F("  rejected: "));
+			Serial.print(stats.ulRejected);
+			Serial.print(F("  avg service us: "));
+			Serial.println(stats.ulRequests ? stats.ulServiceMicros/stats.ulRequests : 0);
+			lastRequests = stats.ulRequests;
+			lastReport = millis();
+			}
+		}
+	Serial.read();
+
+	httpd_end();
+	}
+#endif
+
+#ifdef BENCHMARK_HTTP_CLIENT
+#define BENCH_HTTPC_HOST	"www.example.com"
+#define BENCH_HTTPC_PATH	"/"
+#define BENCH_HTTPC_RUNS	5
+
+void BenchHTTPClientBody(const unsigned char *data, unsigned short len, void *ctx) {
+	(void)data;
+	*(unsigned long *)ctx += len;
+	}
+
+void BenchHTTPClient(void) {
+	tHttpcResult result;
+	unsigned long bytes;
+	long status;
+	int i;
+
+	Serial.print(F("  GET http://"));
+	Serial.print(F(BENCH_HTTPC_HOST));
+	Serial.println(F(BENCH_HTTPC_PATH));
+	Serial.println(F("  run status  DNS ms  connect ms  first byte ms  total ms  bytes  reused"));
+
+	for (i=0; i<BENCH_HTTPC_RUNS; i++) {
+		bytes = 0;
+		status = httpc_get(BENCH_HTTPC_HOST, 80, BENCH_HTTPC_PATH, NULL, BenchHTTPClientBody,
+			&bytes, &result);
+
+		Serial.print(F("  "));
+		Serial.print(i+1);
+		Serial.print(F("   "));
+		Serial.print(status);
+		Serial.print(F("     "));
+		Serial.print(result.ulDnsMillis);
+		Serial.print(F("       "));
+		Serial.print(result.ulConnectMillis);
+		Serial.print(F("           "));
+		Serial.print(result.ulFirstByteMillis);
+		Serial.print(F("              "));
+		Serial.print(result.ulTotalMillis);
+		Serial.print(F("      "));
+		Serial.print(bytes);
+		Serial.print(F("   "));
+		Serial.println(result.ucReused ? F("yes") : F("no"));
+
+		if (status<0) {
+			break;
+			}
+		}
+
+	connpool_flush();
+	}
+#endif
+
+#ifdef BENCHMARK_MQTT
+// Address of the machine running the broker, e.g. mosquitto -v
+#define BENCH_MQTT_BROKER	((192UL<<24) | (168UL<<16) | (1UL<<8) | 100UL)
+#define BENCH_MQTT_PORT		1883
+#define BENCH_MQTT_MSGS		200
+
+void BenchMQTTRun(unsigned char qos) {
+	tMqttStats stats;
+	char payload[16];
+	unsigned long start;
+	int i, len;
+	long res;
+
+	mqtt_reset_stats();
+	start = millis();
+	for (i=0; i<BENCH_MQTT_MSGS; ) {
+		len = sprintf(payload, "%d %lu", i, millis());
+		res = mqtt_publish("bench/cc3000", payload, len, qos, 0);
+		if (res>=0) {
+			i++;
+			}
+		else if (res!=MQTT_ERR_INFLIGHT) {
+			Serial.println(F("  publish failed"));
+			break;
+			}
+		if (mqtt_loop(0)<0) {
+			Serial.println(F("  connection lost"));
+			return;
+			}
+		}
+	// Collect the outstanding PUBACKs
+	while (mqtt_inflight() && (mqtt_loop(10)==0)) {
+		}
+	mqtt_get_stats(&stats);
+
+	Serial.print(F("  QoS "));
+	Serial.print(qos);
+	Serial.print(F(": "));
+	PrintRate(stats.ulPublished, millis()-start, F("messages/s"));
+	Serial.print(F("    avg mqtt_publish us: "));
+	Serial.print(stats.ulPublished ? stats.ulPublishMicros/stats.ulPublished : 0);
+	if (qos) {
+		Serial.print(F("  acked: "));
+		Serial.print(stats.ulAcked);
+		Serial.print(F("  lost: "));
+		Serial.print(stats.ulLost);
+		Serial.print(F("  avg/max ack ms: "));
+		Serial.print(stats.ulAcked ? stats.ulAckMillis/stats.ulAcked : 0);
+		Serial.print(F("/"));
+		Serial.print(stats.ulMaxAckMillis);
+		Serial.print(F("  window full: "));
+		Serial.print(stats.ulInflightFull);
+		}
+	Serial.println();
+	}
+
+void BenchMQTT(void) {
+	long res;
+
+	res = mqtt_connect(BENCH_MQTT_BROKER, BENCH_MQTT_PORT, "cc3000-bench", NULL, NULL, 30, NULL, NULL);
+	if (res!=0) {
+		Serial.print(F("Unable to connect to the broker: "));
+		Serial.println(res);
+		return;
+		}
+
+	BenchMQTTRun(0);
+	BenchMQTTRun(1);
+
+	mqtt_disconnect();
+	}
+#endif
+
+#ifdef BENCHMARK_WEBSOCKET
+#define BENCH_WS_PORT		8080
+#define BENCH_WS_MSGS		200
+#define BENCH_WS_WINDOW		4
+
+long benchWsClient;
+unsigned long benchWsStamp, benchWsEchoed, benchWsRtt, benchWsMaxRtt;
+
+void BenchWSHandler(long sd, unsigned char event, unsigned char *data, unsigned short len, unsigned char flags) {
+	unsigned long rtt;
+
+	switch (event) {
+		case WS_EVENT_OPEN:
+			if (benchWsClient<0) {
+				benchWsClient = sd;
+				}
+			break;
+		case WS_EVENT_DATA:
+			// Echoed messages are the millis() they were sent at
+			if (flags & WS_FLAG_FIRST) {
+				benchWsStamp = 0;
+				}
+			for (unsigned short i=0; i<len; i++) {
+				if (data[i]>='0' && data[i]<='9') {
+					benchWsStamp = benchWsStamp*10 + (data[i]-'0');
+					}
+				}
+			if (flags & WS_FLAG_FINAL) {
+				rtt = millis()-benchWsStamp;
+				benchWsRtt += rtt;
+				if (rtt>benchWsMaxRtt) {
+					benchWsMaxRtt = rtt;
+					}
+				benchWsEchoed++;
+				}
+			break;
+		case WS_EVENT_CLOSE:
+			if (sd==benchWsClient) {
+				benchWsClient = -1;
+				}
+			break;
+		}
+	}
+
+void BenchWebSocket(void) {
+	tWsStats stats;
+	char msg[12];
+	unsigned long start, sent;
+	int len;
+
+	benchWsClient = -1;
+	if (ws_begin(BENCH_WS_PORT, BenchWSHandler)<0) {
+		Serial.println(F("Unable to start the WebSocket server."));
+		return;
+		}
+
+	Serial.println(F("  WebSocket echo client on port 8080 now, e.g."));
+	Serial.println(F("    websocat -t ws://<ip>:8080/ cmd:cat"));
+	while (benchWsClient<0 && !Serial.available()) {
+		ws_poll(20);
+		}
+	if (benchWsClient<0) {
+		Serial.read();
+		ws_end();
+		return;
+		}
+
+	ws_reset_stats();
+	benchWsEchoed = benchWsRtt = benchWsMaxRtt = 0;
+	sent = 0;
+	start = millis();
+	while (benchWsClient>=0 && benchWsEchoed<BENCH_WS_MSGS && millis()-start<30000UL) {
+		if (sent<BENCH_WS_MSGS && sent-benchWsEchoed<BENCH_WS_WINDOW) {
+			len = sprintf(msg, "%lu", millis());
+			if (ws_send(benchWsClient, WS_OPCODE_TEXT, msg, len)==len) {
+				sent++;
+				}
+			}
+		ws_poll(0);
+		}
+	ws_get_stats(&stats);
+
+	Serial.print(F("  "));
+	PrintRate(benchWsEchoed, millis()-start, F("messages/s round trip"));
+	Serial.print(F("  avg/max latency ms: "));
+	Serial.print(benchWsEchoed ? benchWsRtt/benchWsEchoed : 0);
+	Serial.print(F("/"));
+	Serial.print(benchWsMaxRtt);
+	Serial.print(F("  avg ws_send us: "));
+	Serial.println(stats.ulMessagesOut ? stats.ulSendMicros/stats.ulMessagesOut : 0);
+
+	ws_end();
+	}
+#endif
+
+// Same network as ManualConnect; set the channel your AP is on
+#define BENCH_SSID			"PotatoTron"
+#define BENCH_KEY			"cromulent"
+#define BENCH_CHANNEL		6
+#define BENCH_RECONNECTS	3
+
+void BenchDisconnect(void) {
+	wlan_disconnect();
+	while (ulCC3000Connected == 1) {
+		delay(10);
+		}
+	}
+
+#ifdef BENCHMARK_RECONNECT
+void BenchReconnectRun(const __FlashStringHelper *label) {
+	tFastConnectResult result;
+	long res;
+
+	res = fastconnect(WLAN_SEC_WPA2, (char *)BENCH_SSID, strlen(BENCH_SSID),
+		(unsigned char *)BENCH_KEY, strlen(BENCH_KEY), BENCH_CHANNEL, 20000UL, &result);
+
+	Serial.print(F("  "));
+	Serial.print(label);
+	Serial.print(F(": "));
+	if (res!=0) {
+		Serial.print(F("failed "));
+		Serial.println(res);
+		return;
+		}
+	Serial.print(result.ulAssociateMillis);
+	Serial.print(F(" ms to associate"));
+	if (result.ucFellBack) {
+		Serial.print(F(" (cache missed, full scan)"));
+		}
+	else if (result.ucCached) {
+		Serial.print(F(" (cached BSSID/channel)"));
+		}
+	Serial.println();
+	}
+
+void BenchReconnect(void) {
+	wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE);
+
+	BenchDisconnect();
+	fastconnect_forget();
+	BenchReconnectRun(F("cold  "));
+
+	for (int i=0; i<BENCH_RECONNECTS; i++) {
+		BenchDisconnect();
+		BenchReconnectRun(F("cached"));
+		}
+	}
+#endif
+
+#ifdef BENCHMARK_SCAN
+// Records kept per snapshot; each is 44 bytes of stack
+#define BENCH_SCAN_RECORDS	6
+#define BENCH_SCAN_RUNS		5
+
+void BenchScan(void) {
+	tScanRecord records[BENCH_SCAN_RECORDS];
+	tScanStats stats;
+	unsigned long total = 0, entries = 0;
+	char localB[33];
+	long count = 0;
+
+	Serial.println(F("  (list access points first so the CC3000 is scanning)"));
+	for (int i=0; i<BENCH_SCAN_RUNS; i++) {
+		count = scan_snapshot(records, BENCH_SCAN_RECORDS, SCAN_SORT_RSSI | SCAN_DEDUPE_SSID, &stats);
+		if (count<0) {
+			Serial.println(F("  scan_snapshot failed"));
+			return;
+			}
+		total += stats.ulFetchMicros;
+		entries += stats.usRoundTrips;
+		}
+
+	Serial.print(F("  table of "));
+	Serial.print(stats.usTableSize);
+	Serial.print(F(" entries, avg fetch us: "));
+	Serial.print(total/BENCH_SCAN_RUNS);
+	Serial.print(F(", per entry us: "));
+	Serial.println(entries ? total/entries : 0);
+	Serial.print(F("  duplicates merged: "));
+	Serial.print(stats.usDuplicates);
+	Serial.print(F(", dropped: "));
+	Serial.println(stats.usDropped);
+
+	for (int i=0; i<count; i++) {
+		sprintf(localB, "    %3d  ", records[i].ucRssi);
+		Serial.print(localB);
+		memset(localB, 0, 33);
+		memcpy(localB, records[i].acSsid, records[i].ucSsidLen);
+		Serial.println(localB);
+		}
+	}
+#endif
+
+#ifdef BENCHMARK_ROAM
+#define BENCH_ROAM_MS		3000UL
+
+// UDP bytes/s to the gateway's discard port; needs an IP address
+unsigned long BenchRoamThroughput(void) {
+	sockaddr addr;
+	unsigned char payload[BENCH_PAYLOAD];
+	unsigned long start, bytes;
+	long sd;
+
+	while (ulCC3000DHCP!=1) {
+		delay(10);
+		}
+
+	sd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sd<0) {
+		return 0;
+		}
+	GatewayAddress(&addr, BENCH_PORT);
+	memset(payload, 'x', sizeof(payload));
+
+	bytes = 0;
+	start = millis();
+	while (millis()-start<BENCH_ROAM_MS) {
+		if (sendto(sd, payload, sizeof(payload), 0, &addr, sizeof(addr))==sizeof(payload)) {
+			bytes += sizeof(payload);
+			}
+		}
+	closesocket(sd);
+
+	return (bytes*1000UL)/BENCH_ROAM_MS;
+	}
+
+void BenchRoam(void) {
+	tRoamStats stats;
+	unsigned long before;
+	long res;
+
+	wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE);
+	if (roam_begin(WLAN_SEC_WPA2, (char *)BENCH_SSID, strlen(BENCH_SSID),
+			(unsigned char *)BENCH_KEY, strlen(BENCH_KEY))!=0) {
+		Serial.println(F("  roam_begin failed"));
+		return;
+		}
+
+	Serial.println(F("  Letting the scan table fill..."));
+	delay(5000);
+	BenchDisconnect();
+	if ((res=roam_connect())!=0) {
+		Serial.print(F("  roam_connect failed "));
+		Serial.println(res);
+		roam_end();
+		return;
+		}
+	Serial.println(F("  On the strongest AP. Move the board or power down its AP;"));
+	Serial.println(F("  any key to stop"));
+
+	// Keep traffic going between checks; the last window before the
+	// roam is the "before" throughput
+	res = 0;
+	while (res!=1 && !Serial.available()) {
+		before = BenchRoamThroughput();
+		res = roam_poll(0);
+		if (res<0) {
+			Serial.print(F("  roam_poll failed "));
+			Serial.println(res);
+			}
+		}
+	if (res!=1) {
+		Serial.read();
+		roam_end();
+		return;
+		}
+
+	roam_get_stats(&stats);
+	Serial.print(F("  roamed in "));
+	Serial.print(stats.ulLastRoamMillis);
+	Serial.print(F(" ms, RSSI "));
+	Serial.print(stats.ucRssiBefore);
+	Serial.print(F(" -> "));
+	Serial.println(stats.ucRssiAfter);
+	Serial.print(F("  UDP bytes/s before: "));
+	Serial.print(before);
+	Serial.print(F(", after: "));
+	Serial.println(BenchRoamThroughput());
+
+	roam_end();
+	}
+#endif
+
+#ifdef BENCHMARK_SUPERVISOR
+void BenchSupervisor(void) {
+	tSupervisorStats stats;
+	unsigned char state, last;
+
+	wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE);
+	BenchDisconnect();
+	CC3000_SetEventHook(supervisor_event);
+	supervisor_begin(WLAN_SEC_WPA2, (char *)BENCH_SSID, strlen(BENCH_SSID),
+		(unsigned char *)BENCH_KEY, strlen(BENCH_KEY));
+	supervisor_reset_stats();
+
+	Serial.println(F("  Power the AP off and on to see outages; any key to stop"));
+	last = SUPERVISOR_STATE_IDLE;
+	while (!Serial.available()) {
+		state = supervisor_poll();
+		if (state==last) {
+			continue;
+			}
+		last = state;
+		supervisor_get_stats(&stats);
+		switch (state) {
+			case SUPERVISOR_STATE_ONLINE:
+				Serial.print(F("  online, time to IP ms: "));
+				Serial.print(stats.ulLastTimeToIp);
+				if (stats.ulDrops) {
+					Serial.print(F(", outage ms: "));
+					Serial.print(stats.ulLastOutage);
+					}
+				Serial.println();
+				break;
+			case SUPERVISOR_STATE_LOST:
+				Serial.println(F("  link lost"));
+				break;
+			case SUPERVISOR_STATE_BACKOFF:
+				Serial.print(F("  attempt failed, backoff ms: "));
+				Serial.println(stats.ulBackoffMillis);
+				break;
+			}
+		}
+	Serial.read();
+
+	supervisor_get_stats(&stats);
+	supervisor_end();
+	CC3000_SetEventHook(NULL);
+	Serial.print(F("  attempts/failures/drops: "));
+	Serial.print(stats.ulAttempts);
+	Serial.print(F("/"));
+	Serial.print(stats.ulFailures);
+	Serial.print(F("/"));
+	Serial.println(stats.ulDrops);
+	Serial.print(F("  uptime ms: "));
+	Serial.print(stats.ulUptimeMillis);
+	Serial.print(F(", avg time to IP ms: "));
+	Serial.print(stats.ulOnlines ? stats.ulTotalTimeToIp/stats.ulOnlines : 0);
+	Serial.print(F(", max outage ms: "));
+	Serial.println(stats.ulMaxOutage);
+	}
+#endif
+
+#ifdef BENCHMARK_BOOT
+#define BENCH_BOOT_IP_MS	30000UL
+
+void BenchBootReport(const __FlashStringHelper *label, unsigned long work) {
+	tWlanStartTiming timing;
+
+	wlan_start_get_timing(&timing);
+	Serial.print(F("  "));
+	Serial.print(label);
+	Serial.print(F(": ready ms: "));
+	Serial.print(timing.ulReadyMillis);
+	Serial.print(F(" (power-up "));
+	Serial.print(timing.ulPowerUpMillis);
+	Serial.print(F(")"));
+	if (work) {
+		Serial.print(F(", analogReads meanwhile: "));
+		Serial.print(work);
+		}
+
+	// The IP address comes from the stored profiles and connection policy
+	while (ulCC3000DHCP!=1 && millis()-timing.ulEnableMillis<BENCH_BOOT_IP_MS) {
+		delay(1);
+		}
+	if (ulCC3000DHCP==1) {
+		Serial.print(F(", IP ms: "));
+		Serial.println(millis()-timing.ulEnableMillis);
+		}
+	else {
+		Serial.println(F(", no IP"));
+		}
+	}
+
+void BenchBoot(void) {
+	unsigned long work, start;
+
+	Serial.println(F("  (needs a stored profile and auto-connect for the IP timing)"));
+
+	wlan_stop();
+	delay(1000);
+	ulCC3000Connected = ulCC3000DHCP = 0;
+	CC3000_Init();
+	BenchBootReport(F("blocking"), 0);
+
+	wlan_stop();
+	delay(1000);
+	ulCC3000Connected = ulCC3000DHCP = 0;
+	CC3000_InitAsync();
+
+	// Stand-in for the sketch's own set-up, done while the CC3000 boots
+	work = 0;
+	start = millis();
+	while (wlan_start_poll()!=WLAN_START_READY) {
+		if (millis()-start>10000UL) {
+			Serial.println(F("  staged start timed out"));
+			return;
+			}
+		analogRead(A0);
+		work++;
+		}
+	BenchBootReport(F("staged  "), work);
+	}
+#endif
+
+#ifdef BENCHMARK_EVENT_MASK
+#define BENCH_EVENT_SECS	60
+
+void BenchEventMaskRun(const __FlashStringHelper *label) {
+	tWlanEventStats stats;
+	unsigned long start, ms;
+
+	wlan_event_reset_stats();
+	start = millis();
+	while (millis()-start<BENCH_EVENT_SECS*1000UL) {
+		// Let the IRQ deliver whatever the CC3000 sends while idle
+		delay(100);
+		}
+	wlan_event_get_stats(&stats);
+	ms = millis()-stats.ulSinceMillis;
+
+	Serial.print(F("  "));
+	Serial.print(label);
+	Serial.print(F(" mask 0x"));
+	Serial.print(stats.ulMask, HEX);
+	Serial.print(F(": "));
+	Serial.print(ms ? (stats.ulInterrupts*60000UL)/ms : 0);
+	Serial.print(F(" interrupts/minute, "));
+	Serial.print(stats.ulUnsolicited);
+	Serial.println(F(" unsolicited"));
+	}
+
+void BenchEventMask(void) {
+	Serial.println(F("  One minute idle per run..."));
+
+	// CC3000_Init leaves only the events the core needs unmasked
+	BenchEventMaskRun(F("minimal    "));
+	wlan_event_subscribe(CC3000_SKETCH_EVENTS);
+	BenchEventMaskRun(F("every event"));
+	wlan_event_unsubscribe(CC3000_SKETCH_EVENTS);
+	}
+#endif
+
+#ifdef BENCHMARK_DUTY_CYCLE
+#define BENCH_DUTY_MESSAGES	48
+#define BENCH_DUTY_INTERVAL	250
+
+void BenchDutyCycleRun(unsigned long ip, unsigned short batch) {
+	tDutyCycleStats stats;
+	unsigned char reading[8];
+	unsigned short i;
+	long res;
+
+	dutycycle_begin(ip, BENCH_PORT, IPPROTO_UDP, batch, 60000UL);
+	dutycycle_reset_stats();
+
+	// One fake sensor reading every BENCH_DUTY_INTERVAL ms
+	for (i=0; i<BENCH_DUTY_MESSAGES; i++) {
+		memset(reading, i, sizeof(reading));
+		dutycycle_queue(reading, sizeof(reading));
+		res = dutycycle_poll();
+		if (res<0) {
+			Serial.print(F("  cycle failed: "));
+			Serial.println(res);
+			}
+		delay(BENCH_DUTY_INTERVAL);
+		}
+	dutycycle_flush();
+
+	dutycycle_get_stats(&stats);
+	Serial.print(F("  batch "));
+	Serial.print(batch);
+	Serial.print(F(" bytes: "));
+	Serial.print(stats.ulCycles);
+	Serial.print(F(" cycles, "));
+	Serial.print(stats.ulBytes);
+	Serial.print(F(" bytes, radio on ms: "));
+	Serial.print(stats.ulRadioOnMillis);
+	Serial.print(F(" (join "));
+	Serial.print(stats.ulJoinMillis);
+	Serial.print(F(", flush "));
+	Serial.print(stats.ulFlushMillis);
+	Serial.print(F("), us/byte: "));
+	Serial.println(stats.ulMicrosPerByte);
+	}
+
+void BenchDutyCycle(void) {
+	tNetappIpconfigRetArgs inf;
+	unsigned long ip;
+
+	Serial.println(F("  (needs a stored profile and auto-connect)"));
+	if (ulCC3000DHCP!=1) {
+		Serial.println(F("  not connected"));
+		return;
+		}
+
+	netapp_ipconfig(&inf);
+	ip = ((unsigned long)inf.aucDefaultGateway[3] << 24) | ((unsigned long)inf.aucDefaultGateway[2] << 16) |
+		((unsigned long)inf.aucDefaultGateway[1] << 8) | inf.aucDefaultGateway[0];
+
+	wlan_stop();
+	BenchDutyCycleRun(ip, 10);
+	BenchDutyCycleRun(ip, 120);
+
+	ulCC3000Connected = ulCC3000DHCP = 0;
+	wlan_start(0);
+	}
+#endif
+
+#ifdef BENCHMARK_PROFILE
+#define BENCH_PROFILE_RUNS	5
+
+void BenchProfile(void) {
+	tProfileStats stats;
+	unsigned long start;
+	unsigned char i;
+	long slot;
+
+	Serial.println(F("  Provisioning the same profile repeatedly (replaces stored profiles)"));
+	wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE);
+
+	// What StartSmartConfig and ManualAddProfile used to do every time
+	start = millis();
+	for (i=0; i<BENCH_PROFILE_RUNS; i++) {
+		wlan_ioctl_del_profile(255);
+		wlan_add_profile(WLAN_SEC_WPA2, (unsigned char *)BENCH_SSID, strlen(BENCH_SSID), NULL, 0,
+			0x18, 0x1e, 0x2, (unsigned char *)BENCH_KEY, strlen(BENCH_KEY));
+		}
+	Serial.print(F("  direct: "));
+	Serial.print(BENCH_PROFILE_RUNS*2);
+	Serial.print(F(" ioctls, ms per run: "));
+	Serial.println((millis()-start)/BENCH_PROFILE_RUNS);
+	profile_invalidate();
+
+	// The first run has to clear the table and add; the rest are local
+	profile_reset_stats();
+	start = millis();
+	profile_delete_all();
+	for (i=0; i<BENCH_PROFILE_RUNS; i++) {
+		profile_add(WLAN_SEC_WPA2, (char *)BENCH_SSID, strlen(BENCH_SSID), 0,
+			(unsigned char *)BENCH_KEY, strlen(BENCH_KEY));
+		}
+	profile_get_stats(&stats);
+	Serial.print(F("  mirror: "));
+	Serial.print(stats.ulIoctls);
+	Serial.print(F(" ioctls, "));
+	Serial.print(stats.ulAvoided);
+	Serial.print(F(" avoided, "));
+	Serial.print(stats.ulNvmemWrites);
+	Serial.print(F(" nvmem writes, ms per run: "));
+	Serial.println((millis()-start)/BENCH_PROFILE_RUNS);
+
+	// Answered from RAM, no HCI traffic at all
+	start = micros();
+	slot = profile_find((char *)BENCH_SSID, strlen(BENCH_SSID));
+	Serial.print(F("  lookup: slot "));
+	Serial.print(slot);
+	Serial.print(F(" in us: "));
+	Serial.println(micros()-start);
+	}
+#endif
+
+#ifdef BENCHMARK_AES
+#define BENCH_AES_BLOCKS	1000
+
+void BenchAESReport(const __FlashStringHelper *label, unsigned long us) {
+	Serial.print(F("  "));
+	Serial.print(label);
+	Serial.print(F(": "));
+	Serial.print(us/BENCH_AES_BLOCKS);
+	Serial.print(F(" us, "));
+	Serial.print((us/BENCH_AES_BLOCKS)*(F_CPU/1000000UL));
+	Serial.println(F(" cycles per block"));
+	}
+
+void BenchAES(void) {
+	tAesContext ctx;
+	unsigned char key[AES128_KEY_SIZE], block[16];
+	unsigned long start;
+	unsigned short i;
+
+	for (i=0; i<sizeof(key); i++) {
+		key[i] = i;
+		block[i] = i*0x11;
+		}
+
+#ifdef AES_COMPACT
+	Serial.println(F("  Byte-wise (AES_COMPACT) core"));
+#else
+	Serial.println(F("  T-table core"));
+#endif
+
+	// What aes_encrypt used to cost: a key expansion for every block
+	start = micros();
+	for (i=0; i<BENCH_AES_BLOCKS; i++) {
+		aes_set_key(&ctx, key);
+		aes_encrypt_block(&ctx, block);
+		}
+	BenchAESReport(F("expand + encrypt"), micros()-start);
+
+	aes_set_key(&ctx, key);
+	start = micros();
+	for (i=0; i<BENCH_AES_BLOCKS; i++) {
+		aes_encrypt_block(&ctx, block);
+		}
+	BenchAESReport(F("encrypt, cached "), micros()-start);
+
+	start = micros();
+	for (i=0; i<BENCH_AES_BLOCKS; i++) {
+		aes_decrypt_block(&ctx, block);
+		}
+	BenchAESReport(F("decrypt, cached "), micros()-start);
+	}
+#endif
+
+#ifdef BENCHMARK_AES_STREAM
+#define BENCH_AES_STREAM_BYTES	4096UL
+
+void BenchAESStreamRAM(unsigned char mode, const __FlashStringHelper *label) {
+	tAesStream stream;
+	unsigned char key[AES128_KEY_SIZE], iv[AES_STREAM_BLOCK], buf[64+AES_STREAM_BLOCK];
+	unsigned long start, done;
+
+	memset(key, 0x2b, sizeof(key));
+	memset(iv, 0, sizeof(iv));
+	memset(buf, 0x55, sizeof(buf));
+	aes_stream_init(&stream, mode, AES_STREAM_ENCRYPT, key, iv);
+
+	Serial.print(label);
+	done = 0;
+	start = millis();
+	while (done<BENCH_AES_STREAM_BYTES) {
+		aes_stream_update(&stream, buf, buf, 64);
+		done += 64;
+		}
+	aes_stream_final(&stream, buf);
+	PrintRate(done, millis()-start, F("bytes/s"));
+	}
+
+void BenchAESStreamSend(long sd, unsigned char mode, const __FlashStringHelper *label) {
+	tAesStream stream;
+	unsigned char key[AES128_KEY_SIZE], iv[AES_STREAM_BLOCK], *frame;
+	unsigned short max, payload;
+	unsigned long start, sent, frames;
+	long len;
+
+	memset(key, 0x2b, sizeof(key));
+	memset(iv, 0, sizeof(iv));
+	aes_stream_init(&stream, mode, AES_STREAM_ENCRYPT, key, iv);
+
+	// Leave room in the frame for the CBC padding block
+	frame = send_buffer_get(&max);
+	payload = (max/AES_STREAM_BLOCK-1)*AES_STREAM_BLOCK;
+
+	Serial.print(label);
+	sent = frames = 0;
+	start = millis();
+	while (sent<BENCH_STREAM_BYTES) {
+		// A fresh IV per frame: the frame number
+		iv[12] = frames >> 24;
+		iv[13] = frames >> 16;
+		iv[14] = frames >> 8;
+		iv[15] = frames;
+		aes_stream_reset(&stream, iv);
+
+		frame = send_buffer_get(&max);
+		memset(frame, 0x55, payload);
+		len = aes_stream_update(&stream, frame, frame, payload);
+		len += aes_stream_final(&stream, frame+len);
+		if (send_buffer_commit(sd, len, 0)!=len) {
+			break;
+			}
+		sent += payload;
+		frames++;
+		}
+	PrintRate(sent, millis()-start, F("plain text bytes/s"));
+	}
+
+void BenchAESStream(void) {
+	sockaddr addr;
+	socklen_t addrlen;
+	long listenSd, sd;
+
+	BenchAESStreamRAM(AES_STREAM_CTR, F("  CTR in RAM:      "));
+	BenchAESStreamRAM(AES_STREAM_CBC, F("  CBC in RAM:      "));
+
+	listenSd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listenSd<0) {
+		Serial.println(F("Unable to open socket."));
+		return;
+		}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (BENCH_STREAM_PORT >> 8) & 0xff;
+	addr.sa_data[1] = BENCH_STREAM_PORT & 0xff;
+	if ((bind(listenSd, &addr, sizeof(addr))!=0) || (listen(listenSd, 1)!=0)) {
+		Serial.println(F("Unable to bind/listen."));
+		closesocket(listenSd);
+		return;
+		}
+
+	Serial.println(F("  Connect to port 5002 now, e.g. nc <ip> 5002 > /dev/null"));
+	addrlen = sizeof(addr);
+	sd = accept(listenSd, &addr, &addrlen);
+	if (sd<0) {
+		Serial.println(F("Accept failed."));
+		closesocket(listenSd);
+		return;
+		}
+
+	BenchAESStreamSend(sd, AES_STREAM_CTR, F("  CTR in TX frame: "));
+	BenchAESStreamSend(sd, AES_STREAM_CBC, F("  CBC in TX frame: "));
+
+	closesocket(sd);
+	closesocket(listenSd);
+	}
+#endif
+
+void Benchmarks(void) {
+	if (!isInitialized) {
+		Serial.println(F("CC3000 not initialized; can't run benchmarks."));
+		return;
+		}
+
+	Serial.println(F("Benchmarks (connect to an AP first):"));
+	Serial.println(F("  (choose them with the BENCHMARK_ defines at the top of the sketch)"));
+#ifdef BENCHMARK_UDP_SEND
+	Serial.println(F("  a - UDP send: sendto vs sendto_batch"));
+#endif
+#ifdef BENCHMARK_UDP_RECV
+	Serial.println(F("  b - UDP receive: recvfrom_batch ceiling"));
+#endif
+#ifdef BENCHMARK_TCP_STREAM
+	Serial.println(F("  c - TCP send from PROGMEM: send vs send_stream"));
+#endif
+#ifdef BENCHMARK_CONNECT
+	Serial.println(F("  d - TCP connect to the gateway: connect vs connect_async"));
+#endif
+#ifdef BENCHMARK_DNS
+	Serial.println(F("  e - DNS: gethostbyname vs gethostbyname_async"));
+#endif
+#ifdef BENCHMARK_ACCEPT
+	Serial.println(F("  f - TCP accept burst through the listener queue"));
+#endif
+#ifdef BENCHMARK_HTTP_SERVER
+	Serial.println(F("  g - HTTP server: requests/s"));
+#endif
+#ifdef BENCHMARK_HTTP_CLIENT
+	Serial.println(F("  h - HTTP client: per-phase timing, cold vs kept alive"));
+#endif
+#ifdef BENCHMARK_MQTT
+	Serial.println(F("  i - MQTT publish rate, QoS 0 and 1"));
+#endif
+#ifdef BENCHMARK_WEBSOCKET
+	Serial.println(F("  j - WebSocket echo: messages/s and latency"));
+#endif
+#ifdef BENCHMARK_RECONNECT
+	Serial.println(F("  k - Reconnect: cold vs cached BSSID/channel"));
+#endif
+#ifdef BENCHMARK_SCAN
+	Serial.println(F("  l - Scan table snapshot: fetch time"));
+#endif
+#ifdef BENCHMARK_ROAM
+	Serial.println(F("  m - Roaming: roam time, throughput before and after"));
+#endif
+#ifdef BENCHMARK_SUPERVISOR
+	Serial.println(F("  n - Supervisor: time to IP, outage and backoff"));
+#endif
+#ifdef BENCHMARK_BOOT
+	Serial.println(F("  o - Boot: blocking vs staged start, boot to ready and to IP"));
+#endif
+#ifdef BENCHMARK_EVENT_MASK
+	Serial.println(F("  p - Event mask: interrupts/minute, minimal vs every event"));
+#endif
+#ifdef BENCHMARK_DUTY_CYCLE
+	Serial.println(F("  q - Duty cycle: radio-on time per delivered byte, small vs large batches"));
+#endif
+#ifdef BENCHMARK_PROFILE
+	Serial.println(F("  r - Profile table: direct ioctls vs mirror"));
+#endif
+#ifdef BENCHMARK_AES
+	Serial.println(F("  s - AES-128: cycles per block, key expanded per block vs cached"));
+#endif
+#ifdef BENCHMARK_AES_STREAM
+	Serial.println(F("  t - AES streams: CTR vs CBC throughput, in RAM and in the TX frame"));
+#endif
+
+	switch(WaitForKey()) {
+#ifdef BENCHMARK_UDP_SEND
+		case 'a':
+			BenchUDPSend();
+			break;
+#endif
+#ifdef BENCHMARK_UDP_RECV
+		case 'b':
+			BenchUDPRecv();
+			break;
+#endif
+#ifdef BENCHMARK_TCP_STREAM
+		case 'c':
+			BenchTCPStream();
+			break;
+#endif
+#ifdef BENCHMARK_CONNECT
+		case 'd':
+			BenchConnect();
+			break;
+#endif
+#ifdef BENCHMARK_DNS
+		case 'e':
+			BenchDNS();
+			break;
+#endif
+#ifdef BENCHMARK_ACCEPT
+		case 'f':
+			BenchAccept();
+			break;
+#endif
+#ifdef BENCHMARK_HTTP_SERVER
+		case 'g':
+			BenchHTTP();
+			break;
+#endif
+#ifdef BENCHMARK_HTTP_CLIENT
+		case 'h':
+			BenchHTTPClient();
+			break;
+#endif
+#ifdef BENCHMARK_MQTT
+		case 'i':
+			BenchMQTT();
+			break;
+#endif
+#ifdef BENCHMARK_WEBSOCKET
+		case 'j':
+			BenchWebSocket();
+			break;
+#endif
+#ifdef BENCHMARK_RECONNECT
+		case 'k':
+			BenchReconnect();
+			break;
+#endif
+#ifdef BENCHMARK_SCAN
+		case 'l':
+			BenchScan();
+			break;
+#endif
+#ifdef BENCHMARK_ROAM
+		case 'm':
+			BenchRoam();
+			break;
+#endif
+#ifdef BENCHMARK_SUPERVISOR
+		case 'n':
+			BenchSupervisor();
+			break;
+#endif
+#ifdef BENCHMARK_BOOT
+		case 'o':
+			BenchBoot();
+			break;
+#endif
+#ifdef BENCHMARK_EVENT_MASK
+		case 'p':
+			BenchEventMask();
+			break;
+#endif
+#ifdef BENCHMARK_DUTY_CYCLE
+		case 'q':
+			BenchDutyCycle();
+			break;
+#endif
+#ifdef BENCHMARK_PROFILE
+		case 'r':
+			BenchProfile();
+			break;
+#endif
+#ifdef BENCHMARK_AES
+		case 's':
+			BenchAES();
+			break;
+#endif
+#ifdef BENCHMARK_AES_STREAM
+		case 't':
+			BenchAESStream();
+			break;
+#endif
+		default:
+			Serial.println(F("**Unknown benchmark**"));
+			break;
+		}
 	}
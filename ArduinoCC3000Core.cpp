@@ -72,6 +72,8 @@ byte asyncNotificationWaiting=false;
 long lastAsyncEvent;
 byte dhcpIPAddress[4];
 
+static volatile tCC3000EventHook eventHook;
+
 
 
 
@@ -93,6 +95,12 @@ void CC3000_AsyncCallback(long lEventType, char * data, unsigned char length) {
 
 	lastAsyncEvent = lEventType;
 
+	// e.g. the supervisor, which keeps its own link state; the globals
+	// below are still kept up to date for sketches that read them directly
+	if (eventHook) {
+		eventHook(lEventType, data, length);
+		}
+
 	switch (lEventType) {
   
 		case HCI_EVNT_WLAN_ASYNC_SIMPLE_CONFIG_DONE:
@@ -279,9 +287,15 @@ void WlanInterruptDisable(void) {
     wlan_init() with all the callbacks and wlan_start() with 0
     to indicate we're not sending any patches.
     
+    CC3000_InitAsync() does the same but calls wlan_start_async(), so
+    it returns while the CC3000 is still booting. Call wlan_start_poll()
+    until it returns WLAN_START_READY before using the CC3000, and do
+    your own setup in between.
+    
  --------------------------------------------------------------------*/
 
-void CC3000_Init(void) {
+static void CC3000_Setup(void) {
+	static byte coreEventsSubscribed = false;
 
 	SPIInterruptsEnabled = 0;
 
@@ -307,6 +321,33 @@ void CC3000_Init(void) {
 		WlanInterruptEnable,
 		WlanInterruptDisable,
 		WriteWlanEnablePin);
-	
+
+	// Applied by wlan_start once the CC3000 is running
+	if (!coreEventsSubscribed) {
+		wlan_event_subscribe(CC3000_CORE_EVENTS);
+		coreEventsSubscribed = true;
+		}
+	}
+
+
+
+void CC3000_SetEventHook(tCC3000EventHook pfHook) {
+	// A pointer write isn't atomic on AVR and the IRQ reads it
+	noInterrupts();
+	eventHook = pfHook;
+	interrupts();
+	}
+
+
+
+void CC3000_Init(void) {
+	CC3000_Setup();
 	wlan_start(0);
+	}
+
+
+
+void CC3000_InitAsync(void) {
+	CC3000_Setup();
+	wlan_start_async(0);
 	}
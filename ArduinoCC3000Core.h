@@ -14,7 +14,9 @@
 *
 *
 *  This file is the main module for the Arduino CC3000 library.
-*  Your program must call CC3000_Init() before any other API calls.
+*  Your program must call CC3000_Init() before any other API calls, or
+*  CC3000_InitAsync() and then wlan_start_poll() until it returns
+*  WLAN_START_READY.
 * 
 ****************************************************************************/
 
@@ -220,6 +222,17 @@ extern byte dhcpIPAddress[];
 
 
 extern void CC3000_Init(void);
+extern void CC3000_InitAsync(void);
+
+
+/* CC3000_SetEventHook() passes every event CC3000_AsyncCallback gets on
+   to one more handler, e.g. supervisor_event while the connection
+   supervisor runs. The hook may be called in interrupt context. Pass NULL
+   to remove it. */
+
+typedef void (*tCC3000EventHook)(long lEventType, char *data, unsigned char length);
+
+extern void CC3000_SetEventHook(tCC3000EventHook pfHook);
 
 
 extern volatile unsigned long ulSmartConfigFinished,
@@ -229,3 +242,18 @@ extern volatile unsigned long ulSmartConfigFinished,
 	ulCC3000DHCP_configured;
 
 extern volatile unsigned char ucStopSmartConfig;
+
+
+
+/* CC3000_Init() subscribes only to the events that keep the globals above
+   up to date (CC3000_CORE_EVENTS), see wlan_event_subscribe. Everything
+   else is masked, so the CC3000 doesn't interrupt for events nothing
+   uses. A sketch that calls netapp_ping_send, or wants the init and
+   keepalive events in its callback, subscribes to them itself, e.g. to
+   CC3000_SKETCH_EVENTS after CC3000_Init(). */
+
+#define CC3000_CORE_EVENTS	(HCI_EVNT_WLAN_UNSOL_CONNECT | HCI_EVNT_WLAN_UNSOL_DISCONNECT |\
+	HCI_EVNT_WLAN_UNSOL_DHCP | HCI_EVNT_WLAN_ASYNC_SIMPLE_CONFIG_DONE | HCI_EVNT_WLAN_TX_COMPLETE)
+
+#define CC3000_SKETCH_EVENTS	(HCI_EVNT_WLAN_UNSOL_INIT | HCI_EVNT_WLAN_ASYNC_PING_REPORT |\
+	HCI_EVNT_WLAN_KEEPALIVE)
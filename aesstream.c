@@ -0,0 +1,341 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Streaming AES-128, see aesstream.h
+*
+*  Whole blocks are worked on where they lie in the caller's buffer and
+*  only the pieces of a block split across calls go through aucBlock, so
+*  a message handed over in one call is never copied.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "security.h"
+#include "aesstream.h"
+
+#if !defined(CC3000_TINY_DRIVER) && !defined(CC3000_UNENCRYPTED_SMART_CONFIG)
+
+
+//*****************************************************************************
+//
+//! aes_stream_xor
+//!
+//!  @param  pucDst  destination, may be pucA
+//!  @param  pucA    first operand
+//!  @param  pucB    second operand
+//!  @param  ucLen   length
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+aes_stream_xor(unsigned char *pucDst, const unsigned char *pucA, const unsigned char *pucB,
+               unsigned char ucLen)
+{
+	while (ucLen--)
+	{
+		*pucDst++ = *pucA++ ^ *pucB++;
+	}
+}
+
+//*****************************************************************************
+//
+//! aes_stream_ctr
+//!
+//!  @brief  CTR part of aes_stream_update
+//
+//*****************************************************************************
+static unsigned long
+aes_stream_ctr(tAesStream *pStream, const unsigned char *pucIn, unsigned char *pucOut,
+               unsigned long ulLen)
+{
+	unsigned long ulDone;
+	unsigned char ucChunk;
+	signed char i;
+
+	ulDone = 0;
+	while (ulDone < ulLen)
+	{
+		if (pStream->ucUsed == AES_STREAM_BLOCK)
+		{
+			memcpy(pStream->aucBlock, pStream->aucIv, AES_STREAM_BLOCK);
+			aes_encrypt_block(&pStream->ctx, pStream->aucBlock);
+			pStream->ucUsed = 0;
+
+			// Big-endian increment of the whole counter block
+			for (i = AES_STREAM_BLOCK - 1; i >= 0; i--)
+			{
+				if (++pStream->aucIv[i] != 0)
+				{
+					break;
+				}
+			}
+		}
+
+		ucChunk = AES_STREAM_BLOCK - pStream->ucUsed;
+		if (ulLen - ulDone < ucChunk)
+		{
+			ucChunk = (unsigned char)(ulLen - ulDone);
+		}
+		aes_stream_xor(pucOut + ulDone, pucIn + ulDone, &pStream->aucBlock[pStream->ucUsed],
+		               ucChunk);
+		pStream->ucUsed += ucChunk;
+		ulDone += ucChunk;
+	}
+
+	return ulLen;
+}
+
+//*****************************************************************************
+//
+//! aes_stream_cbc_encrypt
+//!
+//!  @brief  CBC encryption part of aes_stream_update. The plain text is
+//!          XORed with the previous cipher block as it arrives, so
+//!          aucBlock only ever holds one partial block.
+//
+//*****************************************************************************
+static unsigned long
+aes_stream_cbc_encrypt(tAesStream *pStream, const unsigned char *pucIn, unsigned char *pucOut,
+                       unsigned long ulLen)
+{
+	unsigned long ulOut;
+	unsigned char ucChunk;
+
+	ulOut = 0;
+	while (ulLen != 0)
+	{
+		if ((pStream->ucUsed == 0) && (ulLen >= AES_STREAM_BLOCK))
+		{
+			aes_stream_xor(pucOut, pucIn, pStream->aucIv, AES_STREAM_BLOCK);
+			aes_encrypt_block(&pStream->ctx, pucOut);
+			memcpy(pStream->aucIv, pucOut, AES_STREAM_BLOCK);
+			pucIn += AES_STREAM_BLOCK;
+			pucOut += AES_STREAM_BLOCK;
+			ulLen -= AES_STREAM_BLOCK;
+			ulOut += AES_STREAM_BLOCK;
+			continue;
+		}
+
+		ucChunk = AES_STREAM_BLOCK - pStream->ucUsed;
+		if (ulLen < ucChunk)
+		{
+			ucChunk = (unsigned char)ulLen;
+		}
+		aes_stream_xor(&pStream->aucBlock[pStream->ucUsed], pucIn,
+		               &pStream->aucIv[pStream->ucUsed], ucChunk);
+		pStream->ucUsed += ucChunk;
+		pucIn += ucChunk;
+		ulLen -= ucChunk;
+
+		if (pStream->ucUsed == AES_STREAM_BLOCK)
+		{
+			aes_encrypt_block(&pStream->ctx, pStream->aucBlock);
+			memcpy(pStream->aucIv, pStream->aucBlock, AES_STREAM_BLOCK);
+			memcpy(pucOut, pStream->aucBlock, AES_STREAM_BLOCK);
+			pucOut += AES_STREAM_BLOCK;
+			ulOut += AES_STREAM_BLOCK;
+			pStream->ucUsed = 0;
+		}
+	}
+
+	return ulOut;
+}
+
+//*****************************************************************************
+//
+//! aes_stream_cbc_decrypt
+//!
+//!  @brief  CBC decryption part of aes_stream_update. A full block is only
+//!          decrypted once more input follows it, so the last block (the
+//!          one with the padding) is left in aucBlock for aes_stream_final.
+//
+//*****************************************************************************
+static unsigned long
+aes_stream_cbc_decrypt(tAesStream *pStream, const unsigned char *pucIn, unsigned char *pucOut,
+                       unsigned long ulLen)
+{
+	unsigned char aucCipher[AES_STREAM_BLOCK];
+	unsigned long ulOut;
+	unsigned char ucChunk;
+
+	ulOut = 0;
+	while (ulLen != 0)
+	{
+		if (pStream->ucUsed == AES_STREAM_BLOCK)
+		{
+			memcpy(aucCipher, pStream->aucBlock, AES_STREAM_BLOCK);
+			aes_decrypt_block(&pStream->ctx, pStream->aucBlock);
+			aes_stream_xor(pucOut, pStream->aucBlock, pStream->aucIv, AES_STREAM_BLOCK);
+			memcpy(pStream->aucIv, aucCipher, AES_STREAM_BLOCK);
+			pucOut += AES_STREAM_BLOCK;
+			ulOut += AES_STREAM_BLOCK;
+			pStream->ucUsed = 0;
+		}
+
+		if ((pStream->ucUsed == 0) && (ulLen > AES_STREAM_BLOCK))
+		{
+			memcpy(aucCipher, pucIn, AES_STREAM_BLOCK);
+			memmove(pucOut, pucIn, AES_STREAM_BLOCK);
+			aes_decrypt_block(&pStream->ctx, pucOut);
+			aes_stream_xor(pucOut, pucOut, pStream->aucIv, AES_STREAM_BLOCK);
+			memcpy(pStream->aucIv, aucCipher, AES_STREAM_BLOCK);
+			pucIn += AES_STREAM_BLOCK;
+			pucOut += AES_STREAM_BLOCK;
+			ulLen -= AES_STREAM_BLOCK;
+			ulOut += AES_STREAM_BLOCK;
+			continue;
+		}
+
+		ucChunk = AES_STREAM_BLOCK - pStream->ucUsed;
+		if (ulLen < ucChunk)
+		{
+			ucChunk = (unsigned char)ulLen;
+		}
+		memcpy(&pStream->aucBlock[pStream->ucUsed], pucIn, ucChunk);
+		pStream->ucUsed += ucChunk;
+		pucIn += ucChunk;
+		ulLen -= ucChunk;
+	}
+
+	return ulOut;
+}
+
+//*****************************************************************************
+//
+//! aes_stream_init
+//!
+//!  @brief  see aesstream.h
+//
+//*****************************************************************************
+long
+aes_stream_init(tAesStream *pStream, unsigned char ucMode, unsigned char ucDirection,
+                unsigned char *key, const unsigned char *iv)
+{
+	if ((ucMode > AES_STREAM_CBC) || (ucDirection > AES_STREAM_DECRYPT))
+	{
+		return AES_STREAM_ERR_PARAM;
+	}
+
+	aes_set_key(&pStream->ctx, key);
+	pStream->ucMode = ucMode;
+	pStream->ucDirection = ucDirection;
+	aes_stream_reset(pStream, iv);
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! aes_stream_reset
+//!
+//!  @brief  see aesstream.h
+//
+//*****************************************************************************
+void
+aes_stream_reset(tAesStream *pStream, const unsigned char *iv)
+{
+	memcpy(pStream->aucIv, iv, AES_STREAM_BLOCK);
+
+	// CTR: no key stream left, make the next block
+	pStream->ucUsed = (pStream->ucMode == AES_STREAM_CTR) ? AES_STREAM_BLOCK : 0;
+}
+
+//*****************************************************************************
+//
+//! aes_stream_update
+//!
+//!  @brief  see aesstream.h
+//
+//*****************************************************************************
+unsigned long
+aes_stream_update(tAesStream *pStream, const unsigned char *pucIn, unsigned char *pucOut,
+                  unsigned long ulLen)
+{
+	if (pStream->ucMode == AES_STREAM_CTR)
+	{
+		return aes_stream_ctr(pStream, pucIn, pucOut, ulLen);
+	}
+	if (pStream->ucDirection == AES_STREAM_ENCRYPT)
+	{
+		return aes_stream_cbc_encrypt(pStream, pucIn, pucOut, ulLen);
+	}
+
+	return aes_stream_cbc_decrypt(pStream, pucIn, pucOut, ulLen);
+}
+
+//*****************************************************************************
+//
+//! aes_stream_final
+//!
+//!  @brief  see aesstream.h
+//
+//*****************************************************************************
+long
+aes_stream_final(tAesStream *pStream, unsigned char *pucOut)
+{
+	unsigned char ucPad, i;
+
+	if (pStream->ucMode == AES_STREAM_CTR)
+	{
+		return 0;
+	}
+
+	if (pStream->ucDirection == AES_STREAM_ENCRYPT)
+	{
+		// PKCS#7: 1 to 16 bytes, each holding the pad length
+		ucPad = AES_STREAM_BLOCK - pStream->ucUsed;
+		for (i = pStream->ucUsed; i < AES_STREAM_BLOCK; i++)
+		{
+			pStream->aucBlock[i] = pStream->aucIv[i] ^ ucPad;
+		}
+		aes_encrypt_block(&pStream->ctx, pStream->aucBlock);
+		memcpy(pucOut, pStream->aucBlock, AES_STREAM_BLOCK);
+		pStream->ucUsed = 0;
+
+		return AES_STREAM_BLOCK;
+	}
+
+	if (pStream->ucUsed != AES_STREAM_BLOCK)
+	{
+		return AES_STREAM_ERR_LENGTH;
+	}
+	pStream->ucUsed = 0;
+
+	aes_decrypt_block(&pStream->ctx, pStream->aucBlock);
+	aes_stream_xor(pStream->aucBlock, pStream->aucBlock, pStream->aucIv, AES_STREAM_BLOCK);
+
+	ucPad = pStream->aucBlock[AES_STREAM_BLOCK - 1];
+	if ((ucPad == 0) || (ucPad > AES_STREAM_BLOCK))
+	{
+		return AES_STREAM_ERR_PADDING;
+	}
+	for (i = AES_STREAM_BLOCK - ucPad; i < AES_STREAM_BLOCK; i++)
+	{
+		if (pStream->aucBlock[i] != ucPad)
+		{
+			return AES_STREAM_ERR_PADDING;
+		}
+	}
+
+	memcpy(pucOut, pStream->aucBlock, AES_STREAM_BLOCK - ucPad);
+
+	return AES_STREAM_BLOCK - ucPad;
+}
+
+#endif	// CC3000_TINY_DRIVER, CC3000_UNENCRYPTED_SMART_CONFIG
@@ -0,0 +1,169 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a streaming AES-128 API for application payloads, built
+*  on the driver's AES core (security.h). A tAesStream holds the key
+*  schedule, the mode and the chaining state, so a payload can be fed in
+*  pieces with aes_stream_update and closed with aes_stream_final, and
+*  the next payload only needs aes_stream_reset with a fresh IV.
+*
+*  CTR turns AES into a stream cipher: the output is as long as the input
+*  and there is no padding. CBC pads with PKCS#7, so the output is
+*  rounded up to the next whole block (see AES_STREAM_CBC_LEN).
+*
+*  Data can be encrypted where it already is, including straight in the
+*  TX buffer: write the payload at send_buffer_get, encrypt it in place,
+*  and send it with send_buffer_commit.
+*
+*  This gives confidentiality only. Nothing here detects a modified
+*  message, and an IV must never be reused with the same key in CTR mode.
+*
+****************************************************************************/
+#ifndef __AESSTREAM_H__
+#define __AESSTREAM_H__
+
+#include "security.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#if !defined(CC3000_TINY_DRIVER) && !defined(CC3000_UNENCRYPTED_SMART_CONFIG)
+
+#define AES_STREAM_BLOCK			(16)
+
+//--------- Modes --------
+
+#define AES_STREAM_CTR				(0)		// counter mode, IV is the first counter block
+#define AES_STREAM_CBC				(1)		// cipher block chaining, PKCS#7 padding
+
+#define AES_STREAM_ENCRYPT			(0)
+#define AES_STREAM_DECRYPT			(1)
+
+// CBC cipher text length for a plain text of n bytes
+#define AES_STREAM_CBC_LEN(n)		((((n) / AES_STREAM_BLOCK) + 1) * AES_STREAM_BLOCK)
+
+//--------- Errors --------
+
+#define AES_STREAM_ERR_PARAM		(-1)	// bad mode or direction
+#define AES_STREAM_ERR_LENGTH		(-2)	// CBC cipher text not a whole number of blocks
+#define AES_STREAM_ERR_PADDING		(-3)	// CBC padding wrong: bad key, IV or data
+
+typedef struct _aes_stream_t
+{
+	tAesContext		ctx;
+	unsigned char	aucIv[AES_STREAM_BLOCK];	// CTR counter, CBC previous cipher block
+	unsigned char	aucBlock[AES_STREAM_BLOCK];	// CTR key stream, CBC partial block
+	unsigned char	ucUsed;					// bytes of aucBlock used
+	unsigned char	ucMode;
+	unsigned char	ucDirection;
+} tAesStream;
+
+
+//*****************************************************************************
+//
+//! aes_stream_init
+//!
+//!  @param[out]  pStream      stream
+//!  @param[in]   ucMode       AES_STREAM_CTR or AES_STREAM_CBC
+//!  @param[in]   ucDirection  AES_STREAM_ENCRYPT or AES_STREAM_DECRYPT
+//!  @param[in]   key          AES128 key of size 16 bytes
+//!  @param[in]   iv           16 byte IV (CTR: initial counter block)
+//!
+//!  @return  0 on success, AES_STREAM_ERR_PARAM
+//!
+//!  @brief  Expand the key and start the first message
+//
+//*****************************************************************************
+extern long aes_stream_init(tAesStream *pStream, unsigned char ucMode,
+                            unsigned char ucDirection, unsigned char *key,
+                            const unsigned char *iv);
+
+//*****************************************************************************
+//
+//! aes_stream_reset
+//!
+//!  @param[in,out]  pStream  stream
+//!  @param[in]      iv       16 byte IV for the next message
+//!
+//!  @return  none
+//!
+//!  @brief  Start another message with the same key, mode and direction,
+//!          without expanding the key again. Anything buffered is dropped.
+//
+//*****************************************************************************
+extern void aes_stream_reset(tAesStream *pStream, const unsigned char *iv);
+
+//*****************************************************************************
+//
+//! aes_stream_update
+//!
+//!  @param[in,out]  pStream  stream
+//!  @param[in]      pucIn    input
+//!  @param[out]     pucOut   output; may be pucIn
+//!  @param[in]      ulLen    input length
+//!
+//!  @return  bytes written to pucOut
+//!
+//!  @brief  Encrypt or decrypt the next piece of a message. CTR writes as
+//!          many bytes as it reads. CBC only writes whole blocks: up to 15
+//!          bytes are kept for the next call, and when decrypting the last
+//!          block is kept for aes_stream_final, so pucOut needs room for
+//!          ulLen + 15 bytes. Encrypting in place (pucOut == pucIn) always
+//!          works in CTR; in CBC it needs the whole message in one
+//!          aes_stream_update call.
+//
+//*****************************************************************************
+extern unsigned long aes_stream_update(tAesStream *pStream, const unsigned char *pucIn,
+                                       unsigned char *pucOut, unsigned long ulLen);
+
+//*****************************************************************************
+//
+//! aes_stream_final
+//!
+//!  @param[in,out]  pStream  stream
+//!  @param[out]     pucOut   where the last bytes go, straight after the
+//!                           output of the last aes_stream_update
+//!
+//!  @return  bytes written to pucOut (CTR: 0, CBC encrypt: 16, CBC decrypt:
+//!           0 to 16), AES_STREAM_ERR_xxx otherwise
+//!
+//!  @brief  Finish the message: CBC encryption pads and writes the last
+//!          block, CBC decryption checks and strips the padding. Call
+//!          aes_stream_reset before the next message.
+//
+//*****************************************************************************
+extern long aes_stream_final(tAesStream *pStream, unsigned char *pucOut);
+
+#endif	// CC3000_TINY_DRIVER, CC3000_UNENCRYPTED_SMART_CONFIG
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __AESSTREAM_H__
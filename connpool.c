@@ -0,0 +1,276 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Outbound TCP connection pool, see connpool.h
+*
+*  Every socket() and closesocket() is an HCI round trip and every
+*  connect() is a TCP handshake over the air, so for a sketch that posts
+*  to the same server over and over most of the time goes there. The
+*  pool keeps track of every socket it handed out by socket descriptor
+*  and parks the released ones until they are asked for again.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "connpool.h"
+
+
+#define CONNPOOL_SLOTS				(8)		// one per CC3000 socket, see M_IS_VALID_SD
+
+#define CONNPOOL_STATE_FREE			(0)
+#define CONNPOOL_STATE_BUSY			(1)		// handed out by connpool_connect()
+#define CONNPOOL_STATE_IDLE			(2)		// released and waiting for reuse
+
+typedef struct _connpool_entry_t
+{
+	unsigned long	ulIp;
+	unsigned long	ulIdleSince;	// millis() when released
+	unsigned short	usPort;
+	unsigned char	ucState;
+} tConnPoolEntry;
+
+
+static tConnPoolEntry	connpoolTable[CONNPOOL_SLOTS];
+static tConnPoolStats	connpoolStats;
+
+
+//*****************************************************************************
+//
+//! connpool_close
+//!
+//!  @param  sd  socket handle
+//!
+//!  @return  none
+//!
+//!  @brief  Close a pooled socket and free its slot
+//
+//*****************************************************************************
+static void
+connpool_close(long sd)
+{
+	connpoolTable[sd].ucState = CONNPOOL_STATE_FREE;
+	closesocket(sd);
+}
+
+//*****************************************************************************
+//
+//! connpool_is_alive
+//!
+//!  @param  sd  socket handle
+//!
+//!  @return  1 if the connection can still be used, 0 otherwise
+//
+//*****************************************************************************
+static unsigned char
+connpool_is_alive(long sd)
+{
+	return ((SOCKET_STATUS_ACTIVE == get_socket_active_status(sd)) &&
+		!get_socket_close_wait_status(sd));
+}
+
+//*****************************************************************************
+//
+//! connpool_maintain
+//!
+//!  @brief  see connpool.h
+//
+//*****************************************************************************
+void
+connpool_maintain(void)
+{
+	unsigned long ulNow;
+	long sd;
+
+	ulNow = millis();
+
+	for (sd = 0; sd < CONNPOOL_SLOTS; sd++)
+	{
+		if (connpoolTable[sd].ucState != CONNPOOL_STATE_IDLE)
+		{
+			continue;
+		}
+
+		if (!connpool_is_alive(sd) ||
+				((ulNow - connpoolTable[sd].ulIdleSince) >= CONNPOOL_IDLE_TIMEOUT_MS))
+		{
+			connpoolStats.ulEvicted++;
+			connpool_close(sd);
+		}
+	}
+}
+
+//*****************************************************************************
+//
+//! connpool_connect
+//!
+//!  @brief  see connpool.h
+//
+//*****************************************************************************
+long
+connpool_connect(unsigned long ulIp, unsigned short usPort)
+{
+	sockaddr addr;
+	unsigned long ulStart;
+	long sd;
+
+	connpoolStats.ulRequests++;
+
+	connpool_maintain();
+
+	for (sd = 0; sd < CONNPOOL_SLOTS; sd++)
+	{
+		if ((connpoolTable[sd].ucState == CONNPOOL_STATE_IDLE) &&
+				(connpoolTable[sd].ulIp == ulIp) && (connpoolTable[sd].usPort == usPort))
+		{
+			connpoolTable[sd].ucState = CONNPOOL_STATE_BUSY;
+			connpoolStats.ulReused++;
+			if (connpoolStats.ulConnects)
+			{
+				connpoolStats.ulSavedMillis += connpoolStats.ulConnectMillis / connpoolStats.ulConnects;
+			}
+			return sd;
+		}
+	}
+
+	ulStart = millis();
+
+	sd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (!M_IS_VALID_SD(sd))
+	{
+		connpoolStats.ulConnectFailures++;
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (usPort >> 8) & 0xff;
+	addr.sa_data[1] = usPort & 0xff;
+	addr.sa_data[2] = (ulIp >> 24) & 0xff;
+	addr.sa_data[3] = (ulIp >> 16) & 0xff;
+	addr.sa_data[4] = (ulIp >> 8) & 0xff;
+	addr.sa_data[5] = ulIp & 0xff;
+
+	if (connect(sd, &addr, sizeof(addr)) != 0)
+	{
+		closesocket(sd);
+		connpoolStats.ulConnectFailures++;
+		return -1;
+	}
+
+	connpoolStats.ulConnects++;
+	connpoolStats.ulConnectMillis += millis() - ulStart;
+
+	connpoolTable[sd].ulIp = ulIp;
+	connpoolTable[sd].usPort = usPort;
+	connpoolTable[sd].ucState = CONNPOOL_STATE_BUSY;
+
+	return sd;
+}
+
+//*****************************************************************************
+//
+//! connpool_release
+//!
+//!  @brief  see connpool.h
+//
+//*****************************************************************************
+long
+connpool_release(long sd, unsigned char ucReusable)
+{
+	unsigned char ucIdle;
+	long i, oldest;
+
+	if (!M_IS_VALID_SD(sd))
+	{
+		return 1;
+	}
+
+	if ((connpoolTable[sd].ucState != CONNPOOL_STATE_BUSY) || !ucReusable ||
+			!connpool_is_alive(sd))
+	{
+		connpool_close(sd);
+		return 1;
+	}
+
+	// Make room if the pool is full, dropping the connection idle longest
+	ucIdle = 0;
+	oldest = -1;
+	for (i = 0; i < CONNPOOL_SLOTS; i++)
+	{
+		if (connpoolTable[i].ucState == CONNPOOL_STATE_IDLE)
+		{
+			ucIdle++;
+			if ((oldest < 0) || ((long)(connpoolTable[i].ulIdleSince - connpoolTable[oldest].ulIdleSince) < 0))
+			{
+				oldest = i;
+			}
+		}
+	}
+
+	if (ucIdle >= CONNPOOL_MAX_IDLE)
+	{
+		if (oldest < 0)
+		{
+			// CONNPOOL_MAX_IDLE is 0, pooling disabled
+			connpool_close(sd);
+			return 1;
+		}
+		connpool_close(oldest);
+	}
+
+	connpoolTable[sd].ucState = CONNPOOL_STATE_IDLE;
+	connpoolTable[sd].ulIdleSince = millis();
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! connpool_flush
+//!
+//!  @brief  see connpool.h
+//
+//*****************************************************************************
+void
+connpool_flush(void)
+{
+	long sd;
+
+	for (sd = 0; sd < CONNPOOL_SLOTS; sd++)
+	{
+		if (connpoolTable[sd].ucState == CONNPOOL_STATE_IDLE)
+		{
+			connpool_close(sd);
+		}
+	}
+}
+
+//*****************************************************************************
+//
+//! connpool_get_stats
+//!
+//!  @brief  see connpool.h
+//
+//*****************************************************************************
+void
+connpool_get_stats(tConnPoolStats *pStats)
+{
+	memcpy(pStats, &connpoolStats, sizeof(tConnPoolStats));
+}
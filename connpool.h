@@ -0,0 +1,150 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a pool of outbound TCP connections. Instead of
+*  socket() / connect() / ... / closesocket() for every request, take a
+*  connection with connpool_connect() and hand it back with
+*  connpool_release(). A connection to the same (ip, port) is reused as
+*  long as the server keeps it open.
+*
+****************************************************************************/
+#ifndef __CONNPOOL_H__
+#define __CONNPOOL_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Most idle connections kept open. The CC3000 only has 8 sockets in total
+// so keep this small
+#ifndef CONNPOOL_MAX_IDLE
+#define CONNPOOL_MAX_IDLE			(2)
+#endif
+
+// Idle connections older than this are closed rather than reused; most
+// servers drop keep-alive connections after 5 to 60 seconds
+#ifndef CONNPOOL_IDLE_TIMEOUT_MS
+#define CONNPOOL_IDLE_TIMEOUT_MS	(15000UL)
+#endif
+
+typedef struct _connpool_stats_t
+{
+	unsigned long	ulRequests;			// connpool_connect() calls
+	unsigned long	ulReused;			// answered with an idle connection
+	unsigned long	ulConnects;			// new connections made
+	unsigned long	ulConnectFailures;
+	unsigned long	ulEvicted;			// idle connections found closed or stale
+	unsigned long	ulConnectMillis;	// total time in socket() + connect()
+	unsigned long	ulSavedMillis;		// reuses * average connect time
+} tConnPoolStats;
+
+
+//*****************************************************************************
+//
+//! connpool_connect
+//!
+//!  @param  ulIp     IPv4 address as returned by gethostbyname()
+//!  @param  usPort   TCP port, host byte order
+//!
+//!  @return  connected socket handle, or -1 on failure
+//!
+//!  @brief  Get a connected socket to (ulIp, usPort). An idle pooled
+//!          connection to the same address is reused if it is still
+//!          active and the server hasn't closed it, otherwise a new
+//!          connection is made.
+//
+//*****************************************************************************
+extern long connpool_connect(unsigned long ulIp, unsigned short usPort);
+
+//*****************************************************************************
+//
+//! connpool_release
+//!
+//!  @param  sd           socket handle from connpool_connect()
+//!  @param  ucReusable   non-zero if the exchange completed cleanly (the
+//!                       whole response was read and the server didn't
+//!                       ask to close), 0 to close the connection
+//!
+//!  @return  0 if the connection was kept, 1 if it was closed
+//!
+//!  @brief  Return a connection to the pool. If the pool already holds
+//!          CONNPOOL_MAX_IDLE connections the oldest one is closed.
+//
+//*****************************************************************************
+extern long connpool_release(long sd, unsigned char ucReusable);
+
+//*****************************************************************************
+//
+//! connpool_maintain
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Close idle connections the server has closed
+//!          (HCI_EVNT_BSD_TCP_CLOSE_WAIT), that went inactive or that have
+//!          been idle longer than CONNPOOL_IDLE_TIMEOUT_MS. Called by
+//!          connpool_connect(); call it from loop() as well to give the
+//!          sockets back to the CC3000 promptly.
+//
+//*****************************************************************************
+extern void connpool_maintain(void);
+
+//*****************************************************************************
+//
+//! connpool_flush
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Close every idle connection
+//
+//*****************************************************************************
+extern void connpool_flush(void);
+
+//*****************************************************************************
+//
+//! connpool_get_stats
+//!
+//!  @param[out]  pStats  filled with the pool counters
+//!
+//!  @return  none
+//!
+//!  @brief  The reuse rate is ulReused / ulRequests
+//
+//*****************************************************************************
+extern void connpool_get_stats(tConnPoolStats *pStats);
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __CONNPOOL_H__
@@ -0,0 +1,397 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Radio duty-cycle scheduler, see dutycycle.h
+*
+*  The CC3000 raises HCI_EVENT_CC3000_CAN_SHUT_DOWN when every packet the
+*  host handed it has been released back, which is when NumberOfSentPackets
+*  catches up with NumberOfReleasedPackets. The scheduler waits on those two
+*  counters directly rather than on the event, since the event is only
+*  delivered to the sketch's callback.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "wlan.h"
+#include "netapp.h"
+#include "socket.h"
+#include "dutycycle.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+// Length prefix in front of each queued message
+#define DUTYCYCLE_HEADER			(2)
+
+typedef struct _dutycycle_state_t
+{
+	unsigned long	ulIp;
+	unsigned long	ulDeadline;
+	unsigned long	ulOldest;				// millis() the oldest queued message arrived
+	long			lProtocol;
+	unsigned short	usPort;
+	unsigned short	usBatch;
+	unsigned short	usUsed;					// bytes of aucQueue in use
+	unsigned char	aucQueue[DUTYCYCLE_QUEUE_SIZE];
+} tDutyCycleState;
+
+
+static tDutyCycleState	dutyCycleState;
+static tDutyCycleStats	dutyCycleStats;
+
+
+//*****************************************************************************
+//
+//! dutycycle_join
+//!
+//!  @param  ulStart  millis() wlan_start was called at
+//!
+//!  @return  0 once associated with an IP address, DUTYCYCLE_ERR_JOIN
+//
+//*****************************************************************************
+static long
+dutycycle_join(unsigned long ulStart)
+{
+	tNetappIpconfigRetArgs ipconfig;
+
+	if (wlan_wait_connected(ulStart, DUTYCYCLE_JOIN_TIMEOUT_MS) != 0)
+	{
+		return DUTYCYCLE_ERR_JOIN;
+	}
+
+	while (millis() - ulStart < DUTYCYCLE_JOIN_TIMEOUT_MS)
+	{
+		netapp_ipconfig(&ipconfig);
+		if (ipconfig.aucIP[0] | ipconfig.aucIP[1] | ipconfig.aucIP[2] | ipconfig.aucIP[3])
+		{
+			return 0;
+		}
+		delay(10);
+	}
+
+	return DUTYCYCLE_ERR_JOIN;
+}
+
+//*****************************************************************************
+//
+//! dutycycle_flushed
+//!
+//!  @param  none
+//!
+//!  @return  1 once the CC3000 has released every packet it was handed
+//
+//*****************************************************************************
+static unsigned char
+dutycycle_flushed(void)
+{
+	unsigned long ulSent, ulReleased;
+
+	// The SPI IRQ updates both counters and a 32 bit read isn't atomic on
+	// AVR, so take both with the IRQ held off
+	noInterrupts();
+	ulSent = tSLInformation.NumberOfSentPackets;
+	ulReleased = tSLInformation.NumberOfReleasedPackets;
+	interrupts();
+
+	return (ulSent == ulReleased);
+}
+
+//*****************************************************************************
+//
+//! dutycycle_send
+//!
+//!  @param  none
+//!
+//!  @return  bytes of aucQueue sent, headers included, DUTYCYCLE_ERR_SOCKET
+//!
+//!  @brief  Send queued messages in order until one fails
+//
+//*****************************************************************************
+static long
+dutycycle_send(void)
+{
+	sockaddr addr;
+	unsigned char *pucMsg;
+	unsigned short usOffset, usLen;
+	long lSocket, lType;
+	int iRes;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (dutyCycleState.usPort >> 8) & 0xff;
+	addr.sa_data[1] = dutyCycleState.usPort & 0xff;
+	addr.sa_data[2] = (dutyCycleState.ulIp >> 24) & 0xff;
+	addr.sa_data[3] = (dutyCycleState.ulIp >> 16) & 0xff;
+	addr.sa_data[4] = (dutyCycleState.ulIp >> 8) & 0xff;
+	addr.sa_data[5] = dutyCycleState.ulIp & 0xff;
+
+	lType = (dutyCycleState.lProtocol == IPPROTO_TCP) ? SOCK_STREAM : SOCK_DGRAM;
+	lSocket = socket(AF_INET, lType, dutyCycleState.lProtocol);
+	if (lSocket < 0)
+	{
+		return DUTYCYCLE_ERR_SOCKET;
+	}
+	if ((lType == SOCK_STREAM) && (connect(lSocket, &addr, sizeof(addr)) != 0))
+	{
+		closesocket(lSocket);
+		return DUTYCYCLE_ERR_SOCKET;
+	}
+
+	usOffset = 0;
+	while (usOffset < dutyCycleState.usUsed)
+	{
+		pucMsg = &dutyCycleState.aucQueue[usOffset];
+		usLen = (unsigned short)pucMsg[0] | ((unsigned short)pucMsg[1] << 8);
+
+		if (lType == SOCK_STREAM)
+		{
+			iRes = send(lSocket, pucMsg + DUTYCYCLE_HEADER, usLen, 0);
+		}
+		else
+		{
+			iRes = sendto(lSocket, pucMsg + DUTYCYCLE_HEADER, usLen, 0, &addr, sizeof(addr));
+		}
+		if (iRes != (int)usLen)
+		{
+			break;
+		}
+
+		usOffset += DUTYCYCLE_HEADER + usLen;
+		dutyCycleStats.ulMessages++;
+		dutyCycleStats.ulBytes += usLen;
+	}
+
+	closesocket(lSocket);
+
+	return usOffset;
+}
+
+//*****************************************************************************
+//
+//! dutycycle_cycle
+//!
+//!  @param  none
+//!
+//!  @return  payload bytes delivered, DUTYCYCLE_ERR_xxx
+//!
+//!  @brief  Power up, join, send, wait for the CC3000 to release every
+//!          packet, power down. Whatever wasn't sent moves to the front of
+//!          the queue.
+//
+//*****************************************************************************
+static long
+dutycycle_cycle(void)
+{
+	unsigned long ulStart, ulFlush, ulBytes;
+	long lRes;
+
+	ulStart = millis();
+	ulBytes = dutyCycleStats.ulBytes;
+	dutyCycleStats.ulCycles++;
+
+	wlan_start(0);
+
+	lRes = dutycycle_join(ulStart);
+	if (lRes == 0)
+	{
+		dutyCycleStats.ulJoinMillis += millis() - ulStart;
+		lRes = dutycycle_send();
+	}
+
+	ulFlush = millis();
+	while (!dutycycle_flushed() && (millis() - ulFlush < DUTYCYCLE_FLUSH_TIMEOUT_MS))
+	{
+		delay(1);
+	}
+	dutyCycleStats.ulFlushMillis += millis() - ulFlush;
+
+	wlan_stop();
+	dutyCycleStats.ulRadioOnMillis += millis() - ulStart;
+
+	if (lRes > 0)
+	{
+		dutyCycleState.usUsed -= (unsigned short)lRes;
+		memmove(dutyCycleState.aucQueue, &dutyCycleState.aucQueue[lRes], dutyCycleState.usUsed);
+		lRes = 0;
+	}
+	if (dutyCycleState.usUsed != 0)
+	{
+		// Give the leftovers a full deadline rather than retrying straight away
+		dutyCycleState.ulOldest = millis();
+		dutyCycleStats.ulFailures++;
+		if (lRes == 0)
+		{
+			lRes = DUTYCYCLE_ERR_SEND;
+		}
+	}
+
+	return (lRes < 0) ? lRes : (long)(dutyCycleStats.ulBytes - ulBytes);
+}
+
+//*****************************************************************************
+//
+//! dutycycle_begin
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+long
+dutycycle_begin(unsigned long ulIp, unsigned short usPort, long lProtocol,
+                unsigned short usBatchBytes, unsigned long ulDeadlineMs)
+{
+	if ((lProtocol != IPPROTO_UDP) && (lProtocol != IPPROTO_TCP))
+	{
+		return DUTYCYCLE_ERR_PARAM;
+	}
+
+	dutyCycleState.ulIp = ulIp;
+	dutyCycleState.usPort = usPort;
+	dutyCycleState.lProtocol = lProtocol;
+	dutyCycleState.usBatch = usBatchBytes;
+	dutyCycleState.ulDeadline = ulDeadlineMs;
+	dutyCycleState.usUsed = 0;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! dutycycle_queue
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+long
+dutycycle_queue(const void *pvData, unsigned short usLen)
+{
+	unsigned char *pucMsg;
+
+	if ((usLen == 0) || (usLen > DUTYCYCLE_QUEUE_SIZE - DUTYCYCLE_HEADER))
+	{
+		return DUTYCYCLE_ERR_PARAM;
+	}
+	if (dutyCycleState.usUsed + DUTYCYCLE_HEADER + usLen > DUTYCYCLE_QUEUE_SIZE)
+	{
+		dutyCycleStats.ulRejected++;
+		return DUTYCYCLE_ERR_FULL;
+	}
+
+	if (dutyCycleState.usUsed == 0)
+	{
+		dutyCycleState.ulOldest = millis();
+	}
+
+	pucMsg = &dutyCycleState.aucQueue[dutyCycleState.usUsed];
+	pucMsg[0] = usLen & 0xff;
+	pucMsg[1] = (usLen >> 8) & 0xff;
+	memcpy(pucMsg + DUTYCYCLE_HEADER, pvData, usLen);
+	dutyCycleState.usUsed += DUTYCYCLE_HEADER + usLen;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! dutycycle_poll
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+long
+dutycycle_poll(void)
+{
+	if (dutyCycleState.usUsed == 0)
+	{
+		return 0;
+	}
+
+	// Full means the next message can't be smaller than 1 byte and still fit
+	if ((dutyCycleState.usUsed >= dutyCycleState.usBatch) ||
+			(dutyCycleState.usUsed + DUTYCYCLE_HEADER >= DUTYCYCLE_QUEUE_SIZE) ||
+			(millis() - dutyCycleState.ulOldest >= dutyCycleState.ulDeadline))
+	{
+		return dutycycle_cycle();
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! dutycycle_flush
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+long
+dutycycle_flush(void)
+{
+	if (dutyCycleState.usUsed == 0)
+	{
+		return 0;
+	}
+
+	return dutycycle_cycle();
+}
+
+//*****************************************************************************
+//
+//! dutycycle_queued
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+unsigned short
+dutycycle_queued(void)
+{
+	return dutyCycleState.usUsed;
+}
+
+//*****************************************************************************
+//
+//! dutycycle_get_stats
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+void
+dutycycle_get_stats(tDutyCycleStats *pStats)
+{
+	memcpy(pStats, &dutyCycleStats, sizeof(tDutyCycleStats));
+
+	// Radio-on time runs to hours on a long test, so divide before scaling
+	if (pStats->ulBytes != 0)
+	{
+		pStats->ulMicrosPerByte = (pStats->ulRadioOnMillis / pStats->ulBytes) * 1000UL +
+			((pStats->ulRadioOnMillis % pStats->ulBytes) * 1000UL) / pStats->ulBytes;
+	}
+}
+
+//*****************************************************************************
+//
+//! dutycycle_reset_stats
+//!
+//!  @brief  see dutycycle.h
+//
+//*****************************************************************************
+void
+dutycycle_reset_stats(void)
+{
+	memset(&dutyCycleStats, 0, sizeof(dutyCycleStats));
+}
+
+#endif	// CC3000_TINY_DRIVER
@@ -0,0 +1,202 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a radio duty-cycle scheduler for battery nodes that
+*  upload now and then. Messages are queued in RAM while the CC3000 is
+*  off. When enough bytes are queued, or the oldest message has waited
+*  long enough, dutycycle_poll powers the CC3000 up, waits for it to
+*  rejoin the network (from its stored profiles), sends the whole batch
+*  to one server, waits until the CC3000 has transmitted every packet
+*  (the condition behind HCI_EVENT_CC3000_CAN_SHUT_DOWN), and powers it
+*  down again.
+*
+*  The CC3000 needs a stored profile and an auto-connect policy, e.g.
+*  wlan_ioctl_set_connection_policy(DISABLE, ENABLE, ENABLE). Call
+*  CC3000_Init once at start-up and wlan_stop before the first
+*  dutycycle_poll; the scheduler uses wlan_start / wlan_stop after that.
+*
+****************************************************************************/
+#ifndef __DUTYCYCLE_H__
+#define __DUTYCYCLE_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// RAM for queued messages, 2 bytes of it per message for the length
+#ifndef DUTYCYCLE_QUEUE_SIZE
+#define DUTYCYCLE_QUEUE_SIZE		(256)
+#endif
+
+// Longest wait from wlan_start to an IP address
+#ifndef DUTYCYCLE_JOIN_TIMEOUT_MS
+#define DUTYCYCLE_JOIN_TIMEOUT_MS	(15000UL)
+#endif
+
+// Longest wait for the CC3000 to finish transmitting before power-down
+#ifndef DUTYCYCLE_FLUSH_TIMEOUT_MS
+#define DUTYCYCLE_FLUSH_TIMEOUT_MS	(2000UL)
+#endif
+
+//--------- Errors --------
+
+#define DUTYCYCLE_ERR_PARAM			(-1)	// bad protocol or message length
+#define DUTYCYCLE_ERR_FULL			(-2)	// not enough queue space
+#define DUTYCYCLE_ERR_JOIN			(-3)	// no IP address in time
+#define DUTYCYCLE_ERR_SOCKET		(-4)	// socket or connect failed
+#define DUTYCYCLE_ERR_SEND			(-5)	// not every message could be sent
+
+typedef struct _dutycycle_stats_t
+{
+	unsigned long	ulCycles;				// power-up / power-down cycles
+	unsigned long	ulFailures;				// cycles that delivered less than the batch
+	unsigned long	ulMessages;				// messages delivered
+	unsigned long	ulBytes;				// payload bytes delivered
+	unsigned long	ulRejected;				// dutycycle_queue calls refused, queue full
+	unsigned long	ulRadioOnMillis;		// wlan_start to wlan_stop, all cycles
+	unsigned long	ulJoinMillis;			// wlan_start to IP address, all cycles
+	unsigned long	ulFlushMillis;			// last send to CAN_SHUT_DOWN, all cycles
+	unsigned long	ulMicrosPerByte;		// radio-on time per delivered byte
+} tDutyCycleStats;
+
+
+//*****************************************************************************
+//
+//! dutycycle_begin
+//!
+//!  @param[in]  ulIp           server IP address, e.g. 0xC0A80164 for
+//!                             192.168.1.100
+//!  @param[in]  usPort         server port
+//!  @param[in]  lProtocol      IPPROTO_UDP (one datagram per message) or
+//!                             IPPROTO_TCP (one connection per cycle)
+//!  @param[in]  usBatchBytes   power up once this many bytes are queued
+//!  @param[in]  ulDeadlineMs   or once the oldest message is this old
+//!
+//!  @return  0 on success, DUTYCYCLE_ERR_PARAM
+//!
+//!  @brief  Set where the batches go and when they are sent. The queue is
+//!          emptied.
+//
+//*****************************************************************************
+extern long dutycycle_begin(unsigned long ulIp, unsigned short usPort, long lProtocol,
+                            unsigned short usBatchBytes, unsigned long ulDeadlineMs);
+
+//*****************************************************************************
+//
+//! dutycycle_queue
+//!
+//!  @param[in]  pvData  message
+//!  @param[in]  usLen   message length, 1 to DUTYCYCLE_QUEUE_SIZE - 2
+//!
+//!  @return  0 on success, DUTYCYCLE_ERR_xxx otherwise
+//!
+//!  @brief  Copy a message into the queue. Nothing is sent until
+//!          dutycycle_poll decides it is time.
+//
+//*****************************************************************************
+extern long dutycycle_queue(const void *pvData, unsigned short usLen);
+
+//*****************************************************************************
+//
+//! dutycycle_poll
+//!
+//!  @param  none
+//!
+//!  @return  bytes delivered if a cycle ran, 0 if it wasn't time yet,
+//!           DUTYCYCLE_ERR_xxx if a cycle failed
+//!
+//!  @brief  Call this from loop(). If the batch size or deadline has been
+//!          reached (or the queue is full), run a cycle: power up, join,
+//!          send, flush, power down. This blocks for the whole cycle.
+//!          Messages that couldn't be sent stay queued for the next one.
+//
+//*****************************************************************************
+extern long dutycycle_poll(void);
+
+//*****************************************************************************
+//
+//! dutycycle_flush
+//!
+//!  @param  none
+//!
+//!  @return  as dutycycle_poll
+//!
+//!  @brief  Run a cycle now if anything is queued, e.g. before the host
+//!          goes to sleep for a long time
+//
+//*****************************************************************************
+extern long dutycycle_flush(void);
+
+//*****************************************************************************
+//
+//! dutycycle_queued
+//!
+//!  @param  none
+//!
+//!  @return  bytes of queue in use
+//
+//*****************************************************************************
+extern unsigned short dutycycle_queued(void);
+
+//*****************************************************************************
+//
+//! dutycycle_get_stats
+//!
+//!  @param[out]  pStats  copy of the statistics
+//!
+//!  @return  none
+//!
+//!  @brief  Read the duty-cycle statistics
+//
+//*****************************************************************************
+extern void dutycycle_get_stats(tDutyCycleStats *pStats);
+
+//*****************************************************************************
+//
+//! dutycycle_reset_stats
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Clear the statistics
+//
+//*****************************************************************************
+extern void dutycycle_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __DUTYCYCLE_H__
@@ -33,6 +33,22 @@
      was changed to
           RetParams = (unsigned char *)pRetParams;  
      to stop a compiler warning about an implicit cast
+     
+   + HCI_EVNT_BSD_TCP_CLOSE_WAIT now records the closed socket in
+     socket_close_wait_status and passes the event data (socket
+     descriptor first) to the wlan callback instead of NULL
+     
+   + HCI_EVNT_WLAN_UNSOL_DISCONNECT flushes the gethostbyname cache
+     
+   + update_socket_active_status counts inactive-socket send errors in
+     the per-socket stats (CC3000_SOCKET_STATS)
+     
+   + Added the background command slot (hci_async_start, hci_async_poll,
+     hci_async_wait, hci_async_reset). hci_unsol_event_handler consumes
+     the completion event of the command in the slot
+     
+   + GET_HOST_BY_NAME_RETVAL_OFFSET and GET_HOST_BY_NAME_ADDR_OFFSET
+     moved to evnt_handler.h
 * 
 ****************************************************************************/
 
@@ -115,9 +131,6 @@
 #define BSD_RSP_PARAMS_SOCKET_OFFSET		(0)
 #define BSD_RSP_PARAMS_STATUS_OFFSET		(4)
 
-#define GET_HOST_BY_NAME_RETVAL_OFFSET	(0)
-#define GET_HOST_BY_NAME_ADDR_OFFSET	(4)
-
 #define ACCEPT_SD_OFFSET			(0)
 #define ACCEPT_RETURN_STATUS_OFFSET	(4)
 #define ACCEPT_ADDRESS__OFFSET		(8)
@@ -165,6 +178,12 @@
 //*****************************************************************************
 
 unsigned long socket_active_status = SOCKET_STATUS_INIT_VAL; 
+unsigned long socket_close_wait_status = 0;
+
+// Background command slot, see hci_async_start
+static volatile unsigned short usAsyncOpcode = 0;		// event awaited, 0 = none
+static volatile unsigned short usAsyncDoneOpcode = 0;	// event received, not yet polled
+static unsigned char aucAsyncParams[HCI_ASYNC_PARAMS_LEN];
 
 
 //*****************************************************************************
@@ -551,6 +570,16 @@ hci_unsol_event_handler(char *event_hdr)
 	unsigned long NumberOfSentPackets;
 	
 	STREAM_TO_UINT16(event_hdr, HCI_EVENT_OPCODE_OFFSET,event_type);
+	
+	// Completion of the command running in the background
+	if ((usAsyncOpcode != 0) && (event_type == usAsyncOpcode))
+	{
+		memcpy(aucAsyncParams, event_hdr + HCI_EVENT_HEADER_SIZE, HCI_ASYNC_PARAMS_LEN);
+		usAsyncDoneOpcode = usAsyncOpcode;
+		usAsyncOpcode = 0;
+		
+		return 1;
+	}
 		
 	if (event_type & HCI_EVNT_UNSOL_BASE)
 	{
@@ -587,6 +616,13 @@ hci_unsol_event_handler(char *event_hdr)
 		case HCI_EVNT_WLAN_UNSOL_INIT:
 		case HCI_EVNT_WLAN_ASYNC_SIMPLE_CONFIG_DONE:
 			
+#if !defined(CC3000_TINY_DRIVER) && (CC3000_DNS_CACHE_SIZE > 0)
+			if (event_type == HCI_EVNT_WLAN_UNSOL_DISCONNECT)
+			{
+				gethostbyname_cache_flush();
+			}
+#endif
+			
 			if( tSLInformation.sWlanCB )
 			{
 				tSLInformation.sWlanCB(event_type, 0, 0);
@@ -643,9 +679,15 @@ hci_unsol_event_handler(char *event_hdr)
 			break;
 		case HCI_EVNT_BSD_TCP_CLOSE_WAIT:
 			{
+				long sd;
+				
+				data = (char*)(event_hdr) + HCI_EVENT_HEADER_SIZE;
+				STREAM_TO_UINT32(data, BSD_RSP_PARAMS_SOCKET_OFFSET, sd);
+				set_socket_close_wait_status(sd, 1);
+				
 				if( tSLInformation.sWlanCB )
 				{
-					tSLInformation.sWlanCB(event_type, NULL, 0);
+					tSLInformation.sWlanCB(event_type, data, 1);
 				}
 			}
 			break;
@@ -747,6 +789,151 @@ void set_socket_active_status(long Sd, long Status)
 }
 
 
+//*****************************************************************************
+//
+//!  set_socket_close_wait_status
+//!
+//!  @param Sd
+//!	 @param Status   1 if the remote side closed the socket, 0 to clear
+//!  @return         none
+//!
+//!  @brief          Record (or clear) a remote close for the given socket
+//
+//*****************************************************************************
+void set_socket_close_wait_status(long Sd, long Status)
+{
+	if(M_IS_VALID_SD(Sd))
+	{
+		if (Status)
+		{
+			socket_close_wait_status |= (1 << Sd);
+		}
+		else
+		{
+			socket_close_wait_status &= ~(1 << Sd);
+		}
+	}
+}
+
+//*****************************************************************************
+//
+//!  get_socket_close_wait_status
+//!
+//!  @param  Sd  Socket ID
+//!  @return     1 if the remote side closed the socket, 0 otherwise
+//!
+//!  @brief  Retrieve the remote close status of a socket
+//
+//*****************************************************************************
+long
+get_socket_close_wait_status(long Sd)
+{
+	if(M_IS_VALID_SD(Sd))
+	{
+		return (socket_close_wait_status & (1 << Sd)) ? 1 : 0;
+	}
+	return 0;
+}
+
+//*****************************************************************************
+//
+//!  hci_async_start
+//!
+//!  @param  usEventOpcode  event that completes the command
+//!
+//!  @return  0 if the slot was taken, -1 if it is busy
+//!
+//!  @brief  Claim the background command slot before sending a command
+//!          with hci_async_command_send
+//
+//*****************************************************************************
+long
+hci_async_start(unsigned short usEventOpcode)
+{
+	if ((usAsyncOpcode != 0) || (usAsyncDoneOpcode != 0))
+	{
+		return -1;
+	}
+	
+	usAsyncOpcode = usEventOpcode;
+	
+	return 0;
+}
+
+//*****************************************************************************
+//
+//!  hci_async_poll
+//!
+//!  @param  usEventOpcode  event the caller is waiting for
+//!  @param  pucParams      filled with the first HCI_ASYNC_PARAMS_LEN bytes
+//!                         of the event parameters on completion
+//!
+//!  @return  1 if the event arrived (the slot is freed), 0 if the command
+//!           is still running, -1 if no such command is in the slot
+//
+//*****************************************************************************
+long
+hci_async_poll(unsigned short usEventOpcode, unsigned char *pucParams)
+{
+	unsigned short usOpcode, usDoneOpcode;
+	
+	// The IRQ sets usAsyncDoneOpcode then clears usAsyncOpcode, and neither
+	// 16 bit read is atomic on AVR, so take both with the IRQ held off
+	noInterrupts();
+	usOpcode = usAsyncOpcode;
+	usDoneOpcode = usAsyncDoneOpcode;
+	interrupts();
+	
+	if (usDoneOpcode == usEventOpcode)
+	{
+		memcpy(pucParams, aucAsyncParams, HCI_ASYNC_PARAMS_LEN);
+		usAsyncDoneOpcode = 0;
+		return 1;
+	}
+	
+	return (usOpcode == usEventOpcode) ? 0 : -1;
+}
+
+//*****************************************************************************
+//
+//!  hci_async_wait
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Wait until the command in the background slot (if any) has
+//!          completed. The CC3000 handles one command at a time so every
+//!          other command has to wait for it.
+//
+//*****************************************************************************
+void
+hci_async_wait(void)
+{
+	while (usAsyncOpcode != 0)
+	{
+	}
+}
+
+//*****************************************************************************
+//
+//!  hci_async_reset
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Forget the background command, used when the CC3000 is stopped
+//
+//*****************************************************************************
+void
+hci_async_reset(void)
+{
+	usAsyncOpcode = 0;
+	usAsyncDoneOpcode = 0;
+}
+
+
 //*****************************************************************************
 //
 //!  hci_event_unsol_flowcontrol_handler
@@ -829,6 +1016,9 @@ update_socket_active_status(char *resp_params)
 	if(ERROR_SOCKET_INACTIVE == status)
 	{
 		set_socket_active_status(sd, SOCKET_STATUS_INACTIVE);
+#ifdef CC3000_SOCKET_STATS
+		socket_stats_count_inactive(sd);
+#endif
 	}
 }
 
@@ -17,7 +17,12 @@
 *  reference library. Changes to the reference library file,
 *  if any, are listed below:
 *
-*  No changes to this file.
+*  + Added socket_close_wait_status and its accessors
+     
+   + Added the background command slot (hci_async_xxx)
+     
+   + GET_HOST_BY_NAME_RETVAL_OFFSET and GET_HOST_BY_NAME_ADDR_OFFSET
+     moved here from evnt_handler.cpp, socket.c uses them too
 * 
 ****************************************************************************/
 
@@ -144,6 +149,25 @@ extern unsigned long socket_active_status;
 extern void set_socket_active_status(long Sd, long Status);
 extern long get_socket_active_status(long Sd);
 
+/* socket_close_wait_status: one bit per socket, set when the remote side has
+   closed the connection (HCI_EVNT_BSD_TCP_CLOSE_WAIT). Cleared by 'socket',
+   'accept' and 'closesocket' */
+extern unsigned long socket_close_wait_status;
+
+extern void set_socket_close_wait_status(long Sd, long Status);
+extern long get_socket_close_wait_status(long Sd);
+
+/* Background command slot: one command can be left running on the CC3000
+   while the host carries on. Its completion event is consumed by
+   hci_unsol_event_handler (from the IRQ) and kept until hci_async_poll
+   collects it. Every other command waits in hci_async_wait first */
+#define HCI_ASYNC_PARAMS_LEN	(8)
+
+extern long hci_async_start(unsigned short usEventOpcode);
+extern long hci_async_poll(unsigned short usEventOpcode, unsigned char *pucParams);
+extern void hci_async_wait(void);
+extern void hci_async_reset(void);
+
 typedef struct _bsd_accept_return_t
 {
     long             iSocketDescriptor;
@@ -163,6 +187,9 @@ typedef struct _bsd_read_return_t
 #define BSD_RECV_FROM_FROMLEN_OFFSET	(4)
 #define BSD_RECV_FROM_FROM_OFFSET		(16)
 
+#define GET_HOST_BY_NAME_RETVAL_OFFSET	(0)
+#define GET_HOST_BY_NAME_ADDR_OFFSET	(4)
+
 
 typedef struct _bsd_select_return_t
 {
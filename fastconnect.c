@@ -0,0 +1,269 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Fast-reconnect cache, see fastconnect.h
+*
+*  The scan parameters are saved in the CC3000's own NVMEM, so a
+*  narrowed channel mask would outlive the connect that set it and keep
+*  the CC3000 from finding the network anywhere else. The mask is
+*  narrowed only for the cached attempt and put back, with the interval
+*  and threshold last set through scan_set_params, as soon as that
+*  attempt has succeeded or failed.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "wlan.h"
+#include "nvmem.h"
+#include "scan.h"
+#include "fastconnect.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#define FASTCONNECT_MAGIC			(0xFC)
+
+typedef struct _fastconnect_record_t
+{
+	unsigned char	ucMagic;
+	unsigned char	ucSecType;
+	unsigned char	ucChannel;				// 0 if unknown
+	unsigned char	ucSsidLen;
+	unsigned short	usSsidCrc;
+	unsigned short	usKeyCrc;				// reference to the key, never the key itself
+	unsigned char	aucBssid[6];
+	unsigned char	ucCheck;
+} tFastConnectRecord;
+
+
+static tFastConnectRecord	fastconnectRecord;
+static unsigned char		ucFastconnectLoaded;
+
+
+//*****************************************************************************
+//
+//! fastconnect_load
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Read the cache from NVMEM the first time it is needed. A
+//!          missing or damaged record reads as empty
+//
+//*****************************************************************************
+static void
+fastconnect_load(void)
+{
+	if (ucFastconnectLoaded)
+	{
+		return;
+	}
+
+	if ((nvmem_read(FASTCONNECT_FILEID, sizeof(tFastConnectRecord), 0,
+				(unsigned char *)&fastconnectRecord) != 0) ||
+			(fastconnectRecord.ucMagic != FASTCONNECT_MAGIC) ||
+			(fastconnectRecord.ucCheck != nvmem_check((unsigned char *)&fastconnectRecord,
+				sizeof(tFastConnectRecord) - 1)))
+	{
+		memset(&fastconnectRecord, 0, sizeof(tFastConnectRecord));
+	}
+
+	ucFastconnectLoaded = 1;
+}
+
+//*****************************************************************************
+//
+//! fastconnect_store
+//!
+//!  @param  none
+//!
+//!  @return  0 on success, error otherwise
+//!
+//!  @brief  Write the cache to NVMEM, creating the file the first time
+//
+//*****************************************************************************
+static long
+fastconnect_store(void)
+{
+	long res;
+
+	fastconnectRecord.ucMagic = FASTCONNECT_MAGIC;
+	fastconnectRecord.ucCheck = nvmem_check((unsigned char *)&fastconnectRecord,
+		sizeof(tFastConnectRecord) - 1);
+
+	res = nvmem_write(FASTCONNECT_FILEID, sizeof(tFastConnectRecord), 0,
+		(unsigned char *)&fastconnectRecord);
+	if (res != 0)
+	{
+		nvmem_create_entry(FASTCONNECT_FILEID, sizeof(tFastConnectRecord));
+		res = nvmem_write(FASTCONNECT_FILEID, sizeof(tFastConnectRecord), 0,
+			(unsigned char *)&fastconnectRecord);
+	}
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! fastconnect
+//!
+//!  @brief  see fastconnect.h
+//
+//*****************************************************************************
+long
+fastconnect(unsigned long ulSecType, char *ssid, long ssid_len, unsigned char *key,
+            long key_len, unsigned char ucChannel, unsigned long ulTimeoutMs,
+            tFastConnectResult *pResult)
+{
+	static const unsigned char aucNoBssid[6] = { 0, 0, 0, 0, 0, 0 };
+	tFastConnectResult result;
+	unsigned long ulStart, ulCachedTimeout;
+	unsigned short usSsidCrc, usKeyCrc;
+	tScanRecord record;
+	unsigned char ucDirty, ucNarrowed;
+	long res;
+
+	fastconnect_load();
+
+	memset(&result, 0, sizeof(result));
+	usSsidCrc = nvmem_crc((unsigned char *)ssid, ssid_len);
+	usKeyCrc = nvmem_crc(key, key_len);
+	if (ucChannel > 13)
+	{
+		ucChannel = 0;
+	}
+	ucDirty = 0;
+	res = FASTCONNECT_ERR_TIMEOUT;
+
+	ulStart = millis();
+
+	if ((fastconnectRecord.ucMagic == FASTCONNECT_MAGIC) &&
+			(fastconnectRecord.ucSecType == ulSecType) &&
+			(fastconnectRecord.ucSsidLen == ssid_len) &&
+			(fastconnectRecord.usSsidCrc == usSsidCrc) &&
+			(fastconnectRecord.usKeyCrc == usKeyCrc) &&
+			(memcmp(fastconnectRecord.aucBssid, aucNoBssid, 6) != 0))
+	{
+		result.ucCached = 1;
+
+		if (ucChannel == 0)
+		{
+			ucChannel = fastconnectRecord.ucChannel;
+		}
+		ucNarrowed = 0;
+		if (ucChannel && (scan_limit_channels(1UL << (ucChannel - 1)) == 0))
+		{
+			ucNarrowed = 1;
+			if (fastconnectRecord.ucChannel != ucChannel)
+			{
+				fastconnectRecord.ucChannel = ucChannel;
+				ucDirty = 1;
+			}
+		}
+
+		ulCachedTimeout = (ulTimeoutMs < FASTCONNECT_CACHED_TIMEOUT_MS) ? ulTimeoutMs :
+			FASTCONNECT_CACHED_TIMEOUT_MS;
+
+		if (wlan_connect(ulSecType, ssid, ssid_len, fastconnectRecord.aucBssid, key, key_len) == 0)
+		{
+			res = (wlan_wait_connected(ulStart, ulCachedTimeout) == 0) ? 0 :
+				FASTCONNECT_ERR_TIMEOUT;
+		}
+
+		// Associated or not, later scans have to see the old channels again
+		if (ucNarrowed)
+		{
+			scan_limit_channels(0);
+		}
+
+		if (res != 0)
+		{
+			// The AP moved or is gone, stop trying it
+			result.ucFellBack = 1;
+			wlan_disconnect();
+			memset(fastconnectRecord.aucBssid, 0, 6);
+			ucDirty = 1;
+		}
+	}
+
+	if (res != 0)
+	{
+		if (wlan_connect(ulSecType, ssid, ssid_len, NULL, key, key_len) != 0)
+		{
+			res = FASTCONNECT_ERR_CONNECT;
+		}
+		else
+		{
+			res = (wlan_wait_connected(ulStart, ulTimeoutMs) == 0) ? 0 : FASTCONNECT_ERR_TIMEOUT;
+		}
+
+		if (res == 0)
+		{
+			fastconnectRecord.ucSecType = (unsigned char)ulSecType;
+			fastconnectRecord.ucSsidLen = (unsigned char)ssid_len;
+			fastconnectRecord.usSsidCrc = usSsidCrc;
+			fastconnectRecord.usKeyCrc = usKeyCrc;
+			fastconnectRecord.ucChannel = ucChannel;
+
+			// wlan_connect doesn't say which AP it associated with, so take
+			// the strongest one with the SSID from the scan table
+			if (scan_snapshot_ssid(&record, 1, SCAN_SORT_RSSI, ssid, ssid_len, NULL) == 1)
+			{
+				memcpy(fastconnectRecord.aucBssid, record.aucBssid, 6);
+			}
+			else
+			{
+				memset(fastconnectRecord.aucBssid, 0, 6);
+			}
+			ucDirty = 1;
+		}
+	}
+
+	result.ulAssociateMillis = millis() - ulStart;
+
+	if (ucDirty)
+	{
+		fastconnect_store();
+	}
+
+	if (pResult)
+	{
+		memcpy(pResult, &result, sizeof(tFastConnectResult));
+	}
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! fastconnect_forget
+//!
+//!  @brief  see fastconnect.h
+//
+//*****************************************************************************
+long
+fastconnect_forget(void)
+{
+	memset(&fastconnectRecord, 0, sizeof(tFastConnectRecord));
+	ucFastconnectLoaded = 1;
+
+	// Length 0 marks the file invalid without freeing it
+	return nvmem_create_entry(FASTCONNECT_FILEID, 0);
+}
+
+#endif	// CC3000_TINY_DRIVER
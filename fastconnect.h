@@ -0,0 +1,122 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a fast-reconnect cache for wlan_connect. After a
+*  successful association the AP's BSSID, security type, channel and a
+*  reference to the key are kept in CC3000 NVMEM user file 14. The next
+*  connect to the same network narrows the scan to that channel and
+*  passes the BSSID to wlan_connect, so the CC3000 doesn't have to scan
+*  every channel first. If the cached AP doesn't answer, it falls back
+*  to an ordinary connect.
+*
+****************************************************************************/
+#ifndef __FASTCONNECT_H__
+#define __FASTCONNECT_H__
+
+#include "wlan.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// CC3000 NVMEM user file holding the cache
+#ifndef FASTCONNECT_FILEID
+#define FASTCONNECT_FILEID			(14)
+#endif
+
+// How long a connect through the cache may take before falling back to
+// a full scan
+#ifndef FASTCONNECT_CACHED_TIMEOUT_MS
+#define FASTCONNECT_CACHED_TIMEOUT_MS	(3000UL)
+#endif
+
+//--------- Errors --------
+
+#define FASTCONNECT_ERR_CONNECT		(-1)	// wlan_connect refused the request
+#define FASTCONNECT_ERR_TIMEOUT		(-2)	// not associated in time
+
+typedef struct _fastconnect_result_t
+{
+	unsigned long	ulAssociateMillis;		// wlan_connect to associated, fallback included
+	unsigned char	ucCached;				// 1 if the cached BSSID and channel were tried
+	unsigned char	ucFellBack;				// 1 if that failed and a full connect was done
+} tFastConnectResult;
+
+
+//*****************************************************************************
+//
+//! fastconnect
+//!
+//!  @param[in]   ulSecType    WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or
+//!                            WLAN_SEC_WPA2
+//!  @param[in]   ssid         SSID, up to 32 bytes
+//!  @param[in]   ssid_len     length of the SSID
+//!  @param[in]   key          security key
+//!  @param[in]   key_len      key length
+//!  @param[in]   ucChannel    channel of the AP (1 to 13) if known, else 0.
+//!                            The CC3000 scan table doesn't report channels,
+//!                            so this is the only way to learn it.
+//!  @param[in]   ulTimeoutMs  longest wait for the association
+//!  @param[out]  pResult      timing and which path was taken, or NULL
+//!
+//!  @return  0 once associated, FASTCONNECT_ERR_xxx otherwise
+//!
+//!  @brief  Connect to an AP and wait for the association. If the cache
+//!          holds this network (same SSID, security type and key) the
+//!          scan channel mask is narrowed to its channel (and opened up
+//!          again straight after) and wlan_connect is given its BSSID. On
+//!          success the cache is brought up to date; the key itself is
+//!          never stored, only a checksum of it.
+//
+//*****************************************************************************
+extern long fastconnect(unsigned long ulSecType, char *ssid, long ssid_len,
+                        unsigned char *key, long key_len, unsigned char ucChannel,
+                        unsigned long ulTimeoutMs, tFastConnectResult *pResult);
+
+//*****************************************************************************
+//
+//! fastconnect_forget
+//!
+//!  @param  none
+//!
+//!  @return  0 on success, error otherwise
+//!
+//!  @brief  Invalidate the cache
+//
+//*****************************************************************************
+extern long fastconnect_forget(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __FASTCONNECT_H__
@@ -27,6 +27,12 @@
      was changed to
           #include "ArduinoCC3000SPI.h"
      because Arduino already has a "SPI.h" library
+     
+   + hci_command_send, hci_data_send and hci_data_command_send wait for
+     the command in the background slot (see evnt_handler.h) before
+     writing to the CC3000
+     
+   + Added hci_async_command_send
 * 
 ****************************************************************************/
 
@@ -111,6 +117,8 @@ hci_command_send(unsigned short usOpcode, unsigned char *pucBuff,
 { 
 	unsigned char *stream;
 	
+	hci_async_wait();
+	
 	stream = (pucBuff + SPI_HEADER_SIZE);
 	
 	UINT8_TO_STREAM(stream, HCI_TYPE_CMND);
@@ -123,6 +131,43 @@ hci_command_send(unsigned short usOpcode, unsigned char *pucBuff,
 	return(0);
 }
 
+//*****************************************************************************
+//
+//!  hci_async_command_send
+//!
+//!  @param  usOpcode      command operation code
+//!  @param  pucBuff       pointer to the command's arguments buffer
+//!  @param  ucArgsLength  length of the arguments
+//!  @param  usEventOpcode event that completes the command
+//!
+//!  @return  0 if the command was sent, -1 if the background slot is busy
+//!
+//!  @brief  Initiate an HCI command without waiting for its event. The
+//!          event is collected later with hci_async_poll.
+//
+//*****************************************************************************
+long
+hci_async_command_send(unsigned short usOpcode, unsigned char *pucBuff,
+                       unsigned char ucArgsLength, unsigned short usEventOpcode)
+{
+	unsigned char *stream;
+	
+	if (hci_async_start(usEventOpcode) != 0)
+	{
+		return -1;
+	}
+	
+	stream = (pucBuff + SPI_HEADER_SIZE);
+	
+	UINT8_TO_STREAM(stream, HCI_TYPE_CMND);
+	stream = UINT16_TO_STREAM(stream, usOpcode);
+	UINT8_TO_STREAM(stream, ucArgsLength);
+	
+	SpiWrite(pucBuff, ucArgsLength + SIMPLE_LINK_HCI_CMND_HEADER_SIZE);
+	
+	return 0;
+}
+
 //*****************************************************************************
 //
 //!  hci_data_send
@@ -148,6 +193,8 @@ hci_data_send(unsigned char ucOpcode,
 {
 	unsigned char *stream;
 	
+	hci_async_wait();
+	
 	stream = ((ucArgs) + SPI_HEADER_SIZE);
 	
 	UINT8_TO_STREAM(stream, HCI_TYPE_DATA);
@@ -181,6 +228,8 @@ void hci_data_command_send(unsigned short usOpcode, unsigned char *pucBuff,
 { 
  	unsigned char *stream = (pucBuff + SPI_HEADER_SIZE);
 	
+	hci_async_wait();
+	
 	UINT8_TO_STREAM(stream, HCI_TYPE_DATA);
 	UINT8_TO_STREAM(stream, usOpcode);
 	UINT8_TO_STREAM(stream, ucArgsLength);
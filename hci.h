@@ -17,7 +17,7 @@
 *  reference library. Changes to the reference library file,
 *  if any, are listed below:
 *
-*  No changes to this file.
+*  + Added hci_async_command_send
 * 
 ****************************************************************************/
 
@@ -290,6 +290,24 @@ extern unsigned short hci_command_send(unsigned short usOpcode,
                                    unsigned char ucArgsLength);
  
 
+//*****************************************************************************
+//
+//!  hci_async_command_send
+//!
+//!  @param  usOpcode      command operation code
+//!  @param  pucBuff       pointer to the command's arguments buffer
+//!  @param  ucArgsLength  length of the arguments
+//!  @param  usEventOpcode event that completes the command
+//!
+//!  @return  0 if the command was sent, -1 if the background slot is busy
+//!
+//!  @brief  Initiate an HCI command without waiting for its event. The
+//!          event is collected later with hci_async_poll.
+//
+//*****************************************************************************
+extern long hci_async_command_send(unsigned short usOpcode, unsigned char *pucBuff,
+                                   unsigned char ucArgsLength, unsigned short usEventOpcode);
+
 //*****************************************************************************
 //
 //!  hci_data_send
@@ -0,0 +1,638 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Streaming HTTP/1.1 client, see httpc.h
+*
+*  The parser is a byte-at-a-time state machine for the status line,
+*  the headers and the chunk framing; body bytes are not looked at one
+*  by one but handed to the body callback in runs, straight out of the
+*  recv() buffer.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "connpool.h"
+#include "httpc.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+//--------- Parser states --------
+
+#define HTTPC_STATE_STATUS			(0)
+#define HTTPC_STATE_HEADER_NAME		(1)
+#define HTTPC_STATE_HEADER_VALUE	(2)
+#define HTTPC_STATE_BODY			(3)		// Content-Length or to the end of the connection
+#define HTTPC_STATE_CHUNK_SIZE		(4)
+#define HTTPC_STATE_CHUNK_EXT		(5)		// rest of the chunk size line
+#define HTTPC_STATE_CHUNK_DATA		(6)
+#define HTTPC_STATE_CHUNK_END		(7)		// CRLF after the chunk data
+#define HTTPC_STATE_TRAILER			(8)
+#define HTTPC_STATE_DONE			(9)
+#define HTTPC_STATE_ERROR			(10)
+
+#define HTTPC_FLAG_CHUNKED			(0x01)
+#define HTTPC_FLAG_LENGTH			(0x02)	// Content-Length seen
+#define HTTPC_FLAG_CLOSE			(0x04)	// server closes the connection after the response
+#define HTTPC_FLAG_DIGITS			(0x08)	// chunk size has at least one digit
+
+
+//*****************************************************************************
+//
+//! httpc_parser_init
+//!
+//!  @brief  see httpc.h
+//
+//*****************************************************************************
+void
+httpc_parser_init(tHttpcParser *pParser, tHttpcHeaderCallback header,
+                  tHttpcBodyCallback body, void *pvContext)
+{
+	memset(pParser, 0, sizeof(tHttpcParser));
+	pParser->header = header;
+	pParser->body = body;
+	pParser->pvContext = pvContext;
+	pParser->ucState = HTTPC_STATE_STATUS;
+}
+
+//*****************************************************************************
+//
+//! httpc_parser_status
+//!
+//!  @param  pParser  parser with the status line in acValue
+//!
+//!  @return  0 on success, -1 if it isn't an HTTP/1.x status line
+//
+//*****************************************************************************
+static long
+httpc_parser_status(tHttpcParser *pParser)
+{
+	const char *p = pParser->acValue;
+
+	// "HTTP/1.x nnn reason"
+	if ((pParser->ucLen < 12) || (strncmp_P(p, PSTR("HTTP/1."), 7) != 0) || (p[8] != ' ') ||
+			(p[9] < '1') || (p[9] > '5') || (p[10] < '0') || (p[10] > '9') ||
+			(p[11] < '0') || (p[11] > '9'))
+	{
+		return -1;
+	}
+
+	pParser->usStatus = (p[9] - '0') * 100 + (p[10] - '0') * 10 + (p[11] - '0');
+
+	// HTTP/1.0 servers close unless they say otherwise
+	if (p[7] == '0')
+	{
+		pParser->ucFlags |= HTTPC_FLAG_CLOSE;
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! httpc_parser_header
+//!
+//!  @param  pParser  parser with a complete header in acName / acValue
+//!
+//!  @return  none
+//!
+//!  @brief  Pick out the headers that frame the body, then pass the
+//!          header on
+//
+//*****************************************************************************
+static void
+httpc_parser_header(tHttpcParser *pParser)
+{
+	if (strcmp_P(pParser->acName, PSTR("content-length")) == 0)
+	{
+		pParser->ulRemaining = strtoul(pParser->acValue, NULL, 10);
+		pParser->ucFlags |= HTTPC_FLAG_LENGTH;
+	}
+	else if (strcmp_P(pParser->acName, PSTR("transfer-encoding")) == 0)
+	{
+		if (strncasecmp_P(pParser->acValue, PSTR("chunked"), 7) == 0)
+		{
+			pParser->ucFlags |= HTTPC_FLAG_CHUNKED;
+		}
+	}
+	else if (strcmp_P(pParser->acName, PSTR("connection")) == 0)
+	{
+		if (strncasecmp_P(pParser->acValue, PSTR("close"), 5) == 0)
+		{
+			pParser->ucFlags |= HTTPC_FLAG_CLOSE;
+		}
+		else if (strncasecmp_P(pParser->acValue, PSTR("keep-alive"), 10) == 0)
+		{
+			pParser->ucFlags &= ~HTTPC_FLAG_CLOSE;
+		}
+	}
+
+	if (pParser->header)
+	{
+		pParser->header(pParser->acName, pParser->acValue, pParser->pvContext);
+	}
+}
+
+//*****************************************************************************
+//
+//! httpc_parser_body_start
+//!
+//!  @param  pParser  parser at the end of the response header
+//!
+//!  @return  none
+//!
+//!  @brief  Work out how the body is framed
+//
+//*****************************************************************************
+static void
+httpc_parser_body_start(tHttpcParser *pParser)
+{
+	// 1xx, 204 and 304 responses never have a body
+	if ((pParser->usStatus < 200) || (pParser->usStatus == 204) || (pParser->usStatus == 304))
+	{
+		pParser->ucState = HTTPC_STATE_DONE;
+	}
+	else if (pParser->ucFlags & HTTPC_FLAG_CHUNKED)
+	{
+		pParser->ulRemaining = 0;
+		pParser->ucState = HTTPC_STATE_CHUNK_SIZE;
+	}
+	else if (pParser->ucFlags & HTTPC_FLAG_LENGTH)
+	{
+		pParser->ucState = (pParser->ulRemaining) ? HTTPC_STATE_BODY : HTTPC_STATE_DONE;
+	}
+	else
+	{
+		// Body runs to the end of the connection
+		pParser->ucFlags |= HTTPC_FLAG_CLOSE;
+		pParser->ucState = HTTPC_STATE_BODY;
+	}
+}
+
+//*****************************************************************************
+//
+//! httpc_parser_deliver
+//!
+//!  @param  pParser  parser
+//!  @param  pucBuf   body bytes
+//!  @param  usLen    number of bytes
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+httpc_parser_deliver(tHttpcParser *pParser, const unsigned char *pucBuf, unsigned short usLen)
+{
+	pParser->ulBodyBytes += usLen;
+	if (pParser->body)
+	{
+		pParser->body(pucBuf, usLen, pParser->pvContext);
+	}
+}
+
+//*****************************************************************************
+//
+//! httpc_parser_feed
+//!
+//!  @brief  see httpc.h
+//
+//*****************************************************************************
+long
+httpc_parser_feed(tHttpcParser *pParser, const unsigned char *pucBuf, unsigned short usLen)
+{
+	unsigned short usRun;
+	unsigned char c;
+
+	while (usLen && (pParser->ucState < HTTPC_STATE_DONE))
+	{
+		// Body bytes go to the callback in runs
+		if ((pParser->ucState == HTTPC_STATE_BODY) || (pParser->ucState == HTTPC_STATE_CHUNK_DATA))
+		{
+			usRun = usLen;
+			if (pParser->ucFlags & (HTTPC_FLAG_CHUNKED | HTTPC_FLAG_LENGTH))
+			{
+				if (pParser->ulRemaining < usRun)
+				{
+					usRun = (unsigned short)pParser->ulRemaining;
+				}
+				pParser->ulRemaining -= usRun;
+			}
+
+			httpc_parser_deliver(pParser, pucBuf, usRun);
+			pucBuf += usRun;
+			usLen -= usRun;
+
+			if ((pParser->ulRemaining == 0) && (pParser->ucFlags & (HTTPC_FLAG_CHUNKED | HTTPC_FLAG_LENGTH)))
+			{
+				pParser->ucState = (pParser->ucState == HTTPC_STATE_CHUNK_DATA) ?
+					HTTPC_STATE_CHUNK_END : HTTPC_STATE_DONE;
+			}
+			continue;
+		}
+
+		c = *pucBuf++;
+		usLen--;
+
+		switch (pParser->ucState)
+		{
+		case HTTPC_STATE_STATUS:
+			if (c == '\r')
+			{
+				break;
+			}
+			if (c != '\n')
+			{
+				if (pParser->ucLen < HTTPC_VALUE_MAX)
+				{
+					pParser->acValue[pParser->ucLen++] = c;
+				}
+				break;
+			}
+			pParser->acValue[pParser->ucLen] = '\0';
+			if (httpc_parser_status(pParser) != 0)
+			{
+				pParser->ucState = HTTPC_STATE_ERROR;
+				break;
+			}
+			pParser->ucLen = 0;
+			pParser->ucState = HTTPC_STATE_HEADER_NAME;
+			break;
+
+		case HTTPC_STATE_HEADER_NAME:
+			if (c == '\r')
+			{
+				break;
+			}
+			if (c == '\n')
+			{
+				if (pParser->ucLen)
+				{
+					// Header line without a ':', ignore it
+					pParser->ucLen = 0;
+					break;
+				}
+
+				// End of the response header. A 100 Continue is followed
+				// by the real response
+				if ((pParser->usStatus >= 100) && (pParser->usStatus < 200))
+				{
+					pParser->ucFlags = 0;
+					pParser->ucState = HTTPC_STATE_STATUS;
+					break;
+				}
+				httpc_parser_body_start(pParser);
+				break;
+			}
+			if (c == ':')
+			{
+				pParser->acName[pParser->ucLen] = '\0';
+				pParser->ucLen = 0;
+				pParser->ucState = HTTPC_STATE_HEADER_VALUE;
+				break;
+			}
+			if (pParser->ucLen < HTTPC_NAME_MAX)
+			{
+				pParser->acName[pParser->ucLen++] = ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c;
+			}
+			break;
+
+		case HTTPC_STATE_HEADER_VALUE:
+			if ((c == '\r') || (((c == ' ') || (c == '\t')) && (pParser->ucLen == 0)))
+			{
+				break;
+			}
+			if (c != '\n')
+			{
+				if (pParser->ucLen < HTTPC_VALUE_MAX)
+				{
+					pParser->acValue[pParser->ucLen++] = c;
+				}
+				break;
+			}
+			pParser->acValue[pParser->ucLen] = '\0';
+			httpc_parser_header(pParser);
+			pParser->ucLen = 0;
+			pParser->ucState = HTTPC_STATE_HEADER_NAME;
+			break;
+
+		case HTTPC_STATE_CHUNK_SIZE:
+			if ((c >= '0') && (c <= '9'))
+			{
+				pParser->ulRemaining = (pParser->ulRemaining << 4) | (c - '0');
+			}
+			else if (((c | 0x20) >= 'a') && ((c | 0x20) <= 'f'))
+			{
+				pParser->ulRemaining = (pParser->ulRemaining << 4) | ((c | 0x20) - 'a' + 10);
+			}
+			else if ((c == ';') || (c == ' ') || (c == '\t') || (c == '\r'))
+			{
+				pParser->ucState = HTTPC_STATE_CHUNK_EXT;
+				break;
+			}
+			else if (c == '\n')
+			{
+				pParser->ucState = HTTPC_STATE_CHUNK_EXT;
+				pucBuf--;
+				usLen++;
+				break;
+			}
+			else
+			{
+				pParser->ucState = HTTPC_STATE_ERROR;
+				break;
+			}
+			pParser->ucFlags |= HTTPC_FLAG_DIGITS;
+			break;
+
+		case HTTPC_STATE_CHUNK_EXT:
+			if (c != '\n')
+			{
+				break;
+			}
+			if (!(pParser->ucFlags & HTTPC_FLAG_DIGITS))
+			{
+				pParser->ucState = HTTPC_STATE_ERROR;
+				break;
+			}
+			pParser->ucFlags &= ~HTTPC_FLAG_DIGITS;
+			pParser->ucLen = 0;
+			pParser->ucState = (pParser->ulRemaining) ? HTTPC_STATE_CHUNK_DATA : HTTPC_STATE_TRAILER;
+			break;
+
+		case HTTPC_STATE_CHUNK_END:
+			if (c == '\n')
+			{
+				pParser->ulRemaining = 0;
+				pParser->ucState = HTTPC_STATE_CHUNK_SIZE;
+			}
+			break;
+
+		case HTTPC_STATE_TRAILER:
+			// Trailer headers are skipped, an empty line ends the response
+			if (c == '\r')
+			{
+				break;
+			}
+			if (c == '\n')
+			{
+				if (pParser->ucLen == 0)
+				{
+					pParser->ucState = HTTPC_STATE_DONE;
+				}
+				pParser->ucLen = 0;
+				break;
+			}
+			pParser->ucLen = 1;
+			break;
+		}
+	}
+
+	if (pParser->ucState == HTTPC_STATE_ERROR)
+	{
+		return HTTPC_PARSE_ERROR;
+	}
+
+	return (pParser->ucState == HTTPC_STATE_DONE) ? HTTPC_PARSE_DONE : HTTPC_PARSE_MORE;
+}
+
+//*****************************************************************************
+//
+//! httpc_parser_eof
+//!
+//!  @brief  see httpc.h
+//
+//*****************************************************************************
+long
+httpc_parser_eof(tHttpcParser *pParser)
+{
+	if ((pParser->ucState == HTTPC_STATE_BODY) &&
+			!(pParser->ucFlags & (HTTPC_FLAG_CHUNKED | HTTPC_FLAG_LENGTH)))
+	{
+		pParser->ucState = HTTPC_STATE_DONE;
+	}
+
+	return (pParser->ucState == HTTPC_STATE_DONE) ? HTTPC_PARSE_DONE : HTTPC_PARSE_ERROR;
+}
+
+//--------- Request --------
+
+#define HTTPC_REQUEST_PARTS			(5)
+
+typedef struct _httpc_request_t
+{
+	const char		*apcPart[HTTPC_REQUEST_PARTS];
+	unsigned char	aucProgmem[HTTPC_REQUEST_PARTS];
+} tHttpcRequest;
+
+//*****************************************************************************
+//
+//! httpc_request_source
+//!
+//!  @brief  tSendStreamSource over the parts of the request, which are
+//!          either RAM or PROGMEM strings
+//
+//*****************************************************************************
+static long
+httpc_request_source(unsigned char *pucDst, unsigned long ulOffset, unsigned short usLen,
+                     void *pvContext)
+{
+	tHttpcRequest *pRequest = (tHttpcRequest *)pvContext;
+	unsigned long ulPartStart;
+	unsigned short n, usPartLen, usRun, usOff;
+	unsigned char i;
+
+	n = 0;
+	ulPartStart = 0;
+	for (i = 0; (i < HTTPC_REQUEST_PARTS) && (n < usLen); i++)
+	{
+		usPartLen = (pRequest->aucProgmem[i]) ? strlen_P(pRequest->apcPart[i]) :
+			strlen(pRequest->apcPart[i]);
+
+		if (ulOffset + n < ulPartStart + usPartLen)
+		{
+			usOff = (unsigned short)(ulOffset + n - ulPartStart);
+			usRun = usPartLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			if (pRequest->aucProgmem[i])
+			{
+				memcpy_P(pucDst + n, pRequest->apcPart[i] + usOff, usRun);
+			}
+			else
+			{
+				memcpy(pucDst + n, pRequest->apcPart[i] + usOff, usRun);
+			}
+			n += usRun;
+		}
+
+		ulPartStart += usPartLen;
+	}
+
+	return n;
+}
+
+//*****************************************************************************
+//
+//! httpc_get
+//!
+//!  @brief  see httpc.h
+//
+//*****************************************************************************
+long
+httpc_get(const char *pcHost, unsigned short usPort, const char *pcPath,
+          tHttpcHeaderCallback header, tHttpcBodyCallback body,
+          void *pvContext, tHttpcResult *pResult)
+{
+	tHttpcResult result;
+	tHttpcParser parser;
+	tHttpcRequest request;
+	tConnPoolStats poolStats;
+	unsigned char aucBuf[HTTPC_RECV_BUF];
+	unsigned long ulIp, ulStart, ulPhase, ulTimeout, ulReused, ulTotal;
+	unsigned char i, ucAttempt, ucReceived;
+	long sd, res;
+	int len;
+
+	memset(&result, 0, sizeof(result));
+	ulStart = millis();
+
+	// DNS
+	res = gethostbyname((char *)pcHost, strlen(pcHost), &ulIp);
+	result.ulDnsMillis = millis() - ulStart;
+	if ((res < 0) || (ulIp == 0))
+	{
+		res = HTTPC_ERR_DNS;
+		goto done;
+	}
+
+	// Request
+	request.apcPart[0] = PSTR("GET ");
+	request.apcPart[1] = pcPath;
+	request.apcPart[2] = PSTR(" HTTP/1.1\r\nHost: ");
+	request.apcPart[3] = pcHost;
+	request.apcPart[4] = PSTR("\r\nConnection: keep-alive\r\n\r\n");
+	for (i = 0; i < HTTPC_REQUEST_PARTS; i++)
+	{
+		request.aucProgmem[i] = !(i & 1);
+	}
+	ulTotal = 0;
+	for (i = 0; i < HTTPC_REQUEST_PARTS; i++)
+	{
+		ulTotal += (request.aucProgmem[i]) ? strlen_P(request.apcPart[i]) : strlen(request.apcPart[i]);
+	}
+
+	for (ucAttempt = 0; ; ucAttempt++)
+	{
+		// Connect
+		ulPhase = millis();
+		connpool_get_stats(&poolStats);
+		ulReused = poolStats.ulReused;
+		sd = connpool_connect(ulIp, usPort);
+		result.ulConnectMillis = millis() - ulPhase;
+		if (sd < 0)
+		{
+			res = HTTPC_ERR_CONNECT;
+			goto done;
+		}
+		connpool_get_stats(&poolStats);
+		result.ucReused = (poolStats.ulReused != ulReused);
+
+		ulPhase = millis();
+		ucReceived = 0;
+		if (send_stream(sd, httpc_request_source, ulTotal, &request) != (long)ulTotal)
+		{
+			connpool_release(sd, 0);
+			res = HTTPC_ERR_SEND;
+		}
+		else
+		{
+			// Response
+			ulTimeout = HTTPC_TIMEOUT_MS;
+			setsockopt(sd, SOL_SOCKET, SOCKOPT_RECV_TIMEOUT, &ulTimeout, sizeof(ulTimeout));
+
+			httpc_parser_init(&parser, header, body, pvContext);
+			res = HTTPC_PARSE_MORE;
+			while (res == HTTPC_PARSE_MORE)
+			{
+				len = recv(sd, aucBuf, sizeof(aucBuf), 0);
+				if (len <= 0)
+				{
+					res = httpc_parser_eof(&parser);
+					if ((res != HTTPC_PARSE_DONE) && !ucReceived)
+					{
+						res = HTTPC_PARSE_MORE;		// nothing at all: time out
+					}
+					break;
+				}
+				if (!ucReceived)
+				{
+					ucReceived = 1;
+					result.ulFirstByteMillis = millis() - ulPhase;
+				}
+				res = httpc_parser_feed(&parser, aucBuf, len);
+			}
+
+			// Only a cleanly finished keep-alive response leaves the
+			// connection usable for the next request
+			connpool_release(sd, (res == HTTPC_PARSE_DONE) && !(parser.ucFlags & HTTPC_FLAG_CLOSE));
+		}
+
+		// A kept-alive connection the server had already closed gives
+		// nothing back; try once more on a new one
+		if (!result.ucReused || ucReceived || (ucAttempt != 0))
+		{
+			break;
+		}
+	}
+
+	if (res == HTTPC_ERR_SEND)
+	{
+		goto done;
+	}
+
+	result.usStatus = parser.usStatus;
+	result.ulBodyBytes = parser.ulBodyBytes;
+
+	if (res == HTTPC_PARSE_DONE)
+	{
+		res = parser.usStatus;
+	}
+	else if (res == HTTPC_PARSE_ERROR)
+	{
+		res = HTTPC_ERR_PARSE;
+	}
+	else
+	{
+		res = HTTPC_ERR_TIMEOUT;
+	}
+
+done:
+	result.ulTotalMillis = millis() - ulStart;
+	if (pResult)
+	{
+		memcpy(pResult, &result, sizeof(tHttpcResult));
+	}
+
+	return res;
+}
+
+#endif	// CC3000_TINY_DRIVER
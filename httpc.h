@@ -0,0 +1,200 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a streaming HTTP/1.1 client. The response is pushed
+*  through an incremental parser as it is received: headers and body
+*  bytes are handed to callbacks straight from the receive buffer, so
+*  the RAM used does not depend on the size of the response. Connections
+*  are kept alive through the connection pool.
+*
+****************************************************************************/
+#ifndef __HTTPC_H__
+#define __HTTPC_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// Header names and values longer than these are truncated before they are
+// handed to the header callback
+#ifndef HTTPC_NAME_MAX
+#define HTTPC_NAME_MAX				(20)
+#endif
+#ifndef HTTPC_VALUE_MAX
+#define HTTPC_VALUE_MAX				(32)
+#endif
+
+// Bytes read from the socket per recv()
+#ifndef HTTPC_RECV_BUF
+#define HTTPC_RECV_BUF				(64)
+#endif
+
+// Longest wait for the next part of the response
+#ifndef HTTPC_TIMEOUT_MS
+#define HTTPC_TIMEOUT_MS			(10000UL)
+#endif
+
+//--------- httpc_get errors --------
+
+#define HTTPC_ERR_DNS				(-1)
+#define HTTPC_ERR_CONNECT			(-2)
+#define HTTPC_ERR_SEND				(-3)
+#define HTTPC_ERR_TIMEOUT			(-4)	// connection closed or nothing received in time
+#define HTTPC_ERR_PARSE				(-5)	// malformed response
+
+//--------- httpc_parser_feed results --------
+
+#define HTTPC_PARSE_MORE			(0)
+#define HTTPC_PARSE_DONE			(1)
+#define HTTPC_PARSE_ERROR			(-1)
+
+// Header callback, the name is lower case
+typedef void (*tHttpcHeaderCallback)(const char *pcName, const char *pcValue, void *pvContext);
+
+// Body callback, called for every run of body bytes as it arrives. Chunked
+// framing has already been removed
+typedef void (*tHttpcBodyCallback)(const unsigned char *pucData, unsigned short usLen,
+                                   void *pvContext);
+
+typedef struct _httpc_parser_t
+{
+	tHttpcHeaderCallback	header;
+	tHttpcBodyCallback		body;
+	void					*pvContext;
+	unsigned long			ulRemaining;		// body or chunk bytes still to come
+	unsigned long			ulBodyBytes;		// body bytes delivered so far
+	unsigned short			usStatus;
+	char					acName[HTTPC_NAME_MAX + 1];
+	char					acValue[HTTPC_VALUE_MAX + 1];
+	unsigned char			ucState;
+	unsigned char			ucLen;
+	unsigned char			ucFlags;
+} tHttpcParser;
+
+typedef struct _httpc_result_t
+{
+	unsigned long	ulDnsMillis;			// gethostbyname
+	unsigned long	ulConnectMillis;		// connection from the pool, or a new one
+	unsigned long	ulFirstByteMillis;		// request sent to first response byte
+	unsigned long	ulTotalMillis;			// whole request, DNS included
+	unsigned long	ulBodyBytes;
+	unsigned short	usStatus;				// HTTP status code, 0 if none was received
+	unsigned char	ucReused;				// 1 if a kept-alive connection was used
+} tHttpcResult;
+
+
+//*****************************************************************************
+//
+//! httpc_parser_init
+//!
+//!  @param  pParser    parser state
+//!  @param  header     header callback, or NULL
+//!  @param  body       body callback, or NULL
+//!  @param  pvContext  passed to the callbacks
+//!
+//!  @return  none
+//!
+//!  @brief  Get a parser ready for a new response
+//
+//*****************************************************************************
+extern void httpc_parser_init(tHttpcParser *pParser, tHttpcHeaderCallback header,
+                              tHttpcBodyCallback body, void *pvContext);
+
+//*****************************************************************************
+//
+//! httpc_parser_feed
+//!
+//!  @param  pParser  parser state
+//!  @param  pucBuf   received bytes
+//!  @param  usLen    number of bytes
+//!
+//!  @return  HTTPC_PARSE_DONE once the whole response has been seen (any
+//!           bytes after it are ignored), HTTPC_PARSE_MORE if more is
+//!           needed, HTTPC_PARSE_ERROR on a malformed response
+//!
+//!  @brief  Push received bytes through the parser. The status line,
+//!          Content-Length, Transfer-Encoding: chunked and Connection:
+//!          close are understood; every header is passed to the header
+//!          callback.
+//
+//*****************************************************************************
+extern long httpc_parser_feed(tHttpcParser *pParser, const unsigned char *pucBuf,
+                              unsigned short usLen);
+
+//*****************************************************************************
+//
+//! httpc_parser_eof
+//!
+//!  @param  pParser  parser state
+//!
+//!  @return  HTTPC_PARSE_DONE if the response was complete or its body ran
+//!           to the end of the connection, HTTPC_PARSE_ERROR otherwise
+//!
+//!  @brief  Tell the parser the server closed the connection
+//
+//*****************************************************************************
+extern long httpc_parser_eof(tHttpcParser *pParser);
+
+//*****************************************************************************
+//
+//! httpc_get
+//!
+//!  @param[in]   pcHost     host name
+//!  @param[in]   usPort     TCP port
+//!  @param[in]   pcPath     path and query, starting with '/'
+//!  @param[in]   header     header callback, or NULL
+//!  @param[in]   body       body callback, or NULL
+//!  @param[in]   pvContext  passed to the callbacks
+//!  @param[out]  pResult    per-phase timing and sizes, or NULL
+//!
+//!  @return  HTTP status code, or HTTPC_ERR_xxx
+//!
+//!  @brief  GET a resource and stream the response through the callbacks.
+//!          The name is resolved through the gethostbyname cache and the
+//!          connection comes from (and goes back to) the connection pool
+//!          so polling the same server skips both DNS and the TCP
+//!          handshake. If a reused connection gives back nothing at all
+//!          (the server had closed it) the request is sent once more on
+//!          a new one.
+//
+//*****************************************************************************
+extern long httpc_get(const char *pcHost, unsigned short usPort, const char *pcPath,
+                      tHttpcHeaderCallback header, tHttpcBodyCallback body,
+                      void *pvContext, tHttpcResult *pResult);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __HTTPC_H__
@@ -0,0 +1,964 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  HTTP/1.1 server, see httpd.h
+*
+*  Each connection only keeps its parser state, the path and one short
+*  token (method, version or the value of a header we care about), so a
+*  request costs the same RAM however many headers the browser sends.
+*  Responses are written with send_stream(): headers and body go out in
+*  full-size packets and PROGMEM bodies are copied straight into the TX
+*  buffer.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "reactor.h"
+#include "httpd.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+//--------- Parser states --------
+
+#define HTTPD_STATE_METHOD			(0)
+#define HTTPD_STATE_PATH			(1)
+#define HTTPD_STATE_VERSION			(2)
+#define HTTPD_STATE_HEADER_NAME		(3)
+#define HTTPD_STATE_HEADER_VALUE	(4)
+#define HTTPD_STATE_BODY			(5)		// skipping a request body
+
+#define HTTPD_FLAG_HTTP11			(0x01)
+#define HTTPD_FLAG_KEEPALIVE		(0x02)
+#define HTTPD_FLAG_PATH_LONG		(0x04)
+#define HTTPD_FLAG_USED				(0x08)	// a request has been answered already
+#define HTTPD_FLAG_CLOSE			(0x10)	// close once the response is sent
+
+#define HTTPD_METHOD_GET			(0)
+#define HTTPD_METHOD_HEAD			(1)
+#define HTTPD_METHOD_OTHER			(2)
+
+#define HTTPD_HEADER_OTHER			(0)
+#define HTTPD_HEADER_CONNECTION		(1)
+#define HTTPD_HEADER_CONTENT_LENGTH	(2)
+
+// Long enough for "content-length", "keep-alive" and "HTTP/1.1"
+#define HTTPD_TOKEN_MAX				(16)
+
+// Response headers are built here before going out with the body
+#define HTTPD_HEAD_MAX				(128)
+
+#define HTTPD_RECV_BUF				(64)
+
+typedef struct _httpd_conn_t
+{
+	unsigned long	ulLastActive;			// millis() of the last request bytes
+	unsigned long	ulBodyLeft;
+	char			acPath[HTTPD_PATH_MAX + 1];
+	char			acToken[HTTPD_TOKEN_MAX + 1];
+	unsigned char	ucState;
+	unsigned char	ucLen;					// bytes in acPath or acToken
+	unsigned char	ucFlags;
+	unsigned char	ucMethod;
+	unsigned char	ucHeader;
+	signed char		cSd;					// -1 if free
+} tHttpdConn;
+
+// The three pieces of a response: RAM header, RAM or PROGMEM data, RAM tail
+typedef struct _httpd_out_t
+{
+	const char				*pcHead;
+	const unsigned char		*pucData;
+	const char				*pcTail;
+	unsigned short			usHeadLen;
+	unsigned short			usDataLen;
+	unsigned short			usTailLen;
+	unsigned char			ucProgmem;
+} tHttpdOut;
+
+
+static tHttpdConn			httpdConns[HTTPD_MAX_CONNS];
+static const tHttpdRoute	*httpdRoutes;
+static tHttpdStats			httpdStats;
+static signed char			cHttpdListenSd = -1;
+
+static char					acHttpdHead[HTTPD_HEAD_MAX];
+static unsigned short		usHttpdHeadLen;
+
+
+//*****************************************************************************
+//
+//! httpd_out_source
+//!
+//!  @brief  tSendStreamSource over the pieces of a tHttpdOut
+//
+//*****************************************************************************
+static long
+httpd_out_source(unsigned char *pucDst, unsigned long ulOffset, unsigned short usLen,
+                 void *pvContext)
+{
+	tHttpdOut *pOut = (tHttpdOut *)pvContext;
+	unsigned short n, usRun, usOff;
+
+	n = 0;
+	while (n < usLen)
+	{
+		usOff = (unsigned short)(ulOffset + n);
+
+		if (usOff < pOut->usHeadLen)
+		{
+			usRun = pOut->usHeadLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			memcpy(pucDst + n, pOut->pcHead + usOff, usRun);
+		}
+		else if (usOff < pOut->usHeadLen + pOut->usDataLen)
+		{
+			usOff -= pOut->usHeadLen;
+			usRun = pOut->usDataLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			if (pOut->ucProgmem)
+			{
+				memcpy_P(pucDst + n, pOut->pucData + usOff, usRun);
+			}
+			else
+			{
+				memcpy(pucDst + n, pOut->pucData + usOff, usRun);
+			}
+		}
+		else
+		{
+			usOff -= pOut->usHeadLen + pOut->usDataLen;
+			usRun = pOut->usTailLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			memcpy(pucDst + n, pOut->pcTail + usOff, usRun);
+		}
+
+		n += usRun;
+	}
+
+	return n;
+}
+
+//*****************************************************************************
+//
+//! httpd_send
+//!
+//!  @param  sd  socket handle
+//!  @param  pOut  the response pieces
+//!
+//!  @return  bytes sent, negative on error
+//
+//*****************************************************************************
+static long
+httpd_send(long sd, tHttpdOut *pOut)
+{
+	unsigned long ulTotal;
+	long lSent;
+
+	ulTotal = (unsigned long)pOut->usHeadLen + pOut->usDataLen + pOut->usTailLen;
+	if (ulTotal == 0)
+	{
+		return 0;
+	}
+
+	lSent = send_stream(sd, httpd_out_source, ulTotal, pOut);
+	if (lSent > 0)
+	{
+		httpdStats.ulBytesOut += lSent;
+	}
+
+	return lSent;
+}
+
+//*****************************************************************************
+//
+//! httpd_head_P / httpd_head_ul
+//!
+//!  @brief  Append a PROGMEM string or a number to the response header
+//
+//*****************************************************************************
+static void
+httpd_head_P(const char *pcText)
+{
+	unsigned short usLen;
+
+	usLen = strlen_P(pcText);
+	if (usHttpdHeadLen + usLen > HTTPD_HEAD_MAX)
+	{
+		usLen = HTTPD_HEAD_MAX - usHttpdHeadLen;
+	}
+	memcpy_P(acHttpdHead + usHttpdHeadLen, pcText, usLen);
+	usHttpdHeadLen += usLen;
+}
+
+static void
+httpd_head_ul(unsigned long ulValue, unsigned char ucBase)
+{
+	char acDigits[11];
+	unsigned char i;
+
+	i = sizeof(acDigits);
+	do
+	{
+		acDigits[--i] = "0123456789abcdef"[ulValue % ucBase];
+		ulValue /= ucBase;
+	} while (ulValue && i);
+
+	while ((i < sizeof(acDigits)) && (usHttpdHeadLen < HTTPD_HEAD_MAX))
+	{
+		acHttpdHead[usHttpdHeadLen++] = acDigits[i++];
+	}
+}
+
+//*****************************************************************************
+//
+//! httpd_head_start
+//!
+//!  @param  pConn          connection
+//!  @param  pcStatus       status code and reason, PROGMEM
+//!  @param  pcContentType  PROGMEM
+//!  @param  lLength        Content-Length, or -1 for a page of unknown length
+//!
+//!  @return  none
+//!
+//!  @brief  Build the status line and headers in acHttpdHead. A page of
+//!          unknown length is chunked for HTTP/1.1 and ends the connection
+//!          for HTTP/1.0.
+//
+//*****************************************************************************
+static void
+httpd_head_start(tHttpdConn *pConn, const char *pcStatus, const char *pcContentType,
+                 long lLength)
+{
+	usHttpdHeadLen = 0;
+
+	httpd_head_P(PSTR("HTTP/1.1 "));
+	httpd_head_P(pcStatus);
+	httpd_head_P(PSTR("\r\nContent-Type: "));
+	httpd_head_P(pcContentType);
+
+	if (lLength >= 0)
+	{
+		httpd_head_P(PSTR("\r\nContent-Length: "));
+		httpd_head_ul(lLength, 10);
+	}
+	else if (pConn->ucFlags & HTTPD_FLAG_HTTP11)
+	{
+		httpd_head_P(PSTR("\r\nTransfer-Encoding: chunked"));
+	}
+	else
+	{
+		pConn->ucFlags &= ~HTTPD_FLAG_KEEPALIVE;
+	}
+
+	if (pConn->ucFlags & HTTPD_FLAG_KEEPALIVE)
+	{
+		httpd_head_P(PSTR("\r\nConnection: keep-alive\r\n\r\n"));
+	}
+	else
+	{
+		httpd_head_P(PSTR("\r\nConnection: close\r\n\r\n"));
+		pConn->ucFlags |= HTTPD_FLAG_CLOSE;
+	}
+}
+
+//*****************************************************************************
+//
+//! httpd_find
+//!
+//!  @param  sd  socket handle
+//!
+//!  @return  the connection on sd, or NULL
+//
+//*****************************************************************************
+static tHttpdConn *
+httpd_find(long sd)
+{
+	unsigned char i;
+
+	for (i = 0; i < HTTPD_MAX_CONNS; i++)
+	{
+		if (httpdConns[i].cSd == sd)
+		{
+			return &httpdConns[i];
+		}
+	}
+
+	return NULL;
+}
+
+//*****************************************************************************
+//
+//! httpd_respond
+//!
+//!  @param  pConn  connection with a complete request header
+//!
+//!  @return  none
+//!
+//!  @brief  Route the request and send the response
+//
+//*****************************************************************************
+static void
+httpd_respond(tHttpdConn *pConn)
+{
+	tHttpdRoute route;
+	tHttpdOut out;
+	const char *pcQuery;
+	char *pcMark;
+	unsigned char i;
+	unsigned long ulStart;
+
+	ulStart = micros();
+
+	httpdStats.ulRequests++;
+	if (pConn->ucFlags & HTTPD_FLAG_USED)
+	{
+		httpdStats.ulKeptAlive++;
+	}
+	pConn->ucFlags |= HTTPD_FLAG_USED;
+
+	memset(&out, 0, sizeof(out));
+	out.pcHead = acHttpdHead;
+
+	if (pConn->ucMethod == HTTPD_METHOD_OTHER)
+	{
+		httpdStats.ulBadRequests++;
+		httpd_head_start(pConn, PSTR("501 Not Implemented"), PSTR("text/plain"), 0);
+		out.usHeadLen = usHttpdHeadLen;
+		httpd_send(pConn->cSd, &out);
+		httpdStats.ulServiceMicros += micros() - ulStart;
+		return;
+	}
+
+	// Split off the query string
+	pcQuery = "";
+	pcMark = strchr(pConn->acPath, '?');
+	if (pcMark)
+	{
+		*pcMark = '\0';
+		pcQuery = pcMark + 1;
+	}
+
+	route.pcPath = NULL;
+	if (!(pConn->ucFlags & HTTPD_FLAG_PATH_LONG) && httpdRoutes)
+	{
+		for (i = 0; ; i++)
+		{
+			memcpy_P(&route, &httpdRoutes[i], sizeof(tHttpdRoute));
+			if ((route.pcPath == NULL) || (strcmp_P(pConn->acPath, route.pcPath) == 0))
+			{
+				break;
+			}
+		}
+	}
+
+	if (route.pcPath == NULL)
+	{
+		httpdStats.ulNotFound++;
+		httpd_head_start(pConn, PSTR("404 Not Found"), PSTR("text/plain"), 9);
+		out.usHeadLen = usHttpdHeadLen;
+		if (pConn->ucMethod == HTTPD_METHOD_GET)
+		{
+			out.pcTail = "Not found";
+			out.usTailLen = 9;
+		}
+		httpd_send(pConn->cSd, &out);
+	}
+	else if (route.pucBody)
+	{
+		httpd_head_start(pConn, PSTR("200 OK"), route.pcContentType, route.usBodyLen);
+		out.usHeadLen = usHttpdHeadLen;
+		if (pConn->ucMethod == HTTPD_METHOD_GET)
+		{
+			out.pucData = route.pucBody;
+			out.usDataLen = route.usBodyLen;
+			out.ucProgmem = 1;
+		}
+		httpd_send(pConn->cSd, &out);
+	}
+	else
+	{
+		httpd_head_start(pConn, PSTR("200 OK"), route.pcContentType, -1);
+		out.usHeadLen = usHttpdHeadLen;
+		httpd_send(pConn->cSd, &out);
+
+		if (pConn->ucMethod == HTTPD_METHOD_GET)
+		{
+			if (route.handler)
+			{
+				route.handler(pConn->cSd, pcQuery);
+			}
+
+			if (pConn->ucFlags & HTTPD_FLAG_HTTP11)
+			{
+				// Last chunk
+				memset(&out, 0, sizeof(out));
+				out.pcTail = "0\r\n\r\n";
+				out.usTailLen = 5;
+				httpd_send(pConn->cSd, &out);
+			}
+		}
+	}
+
+	httpdStats.ulServiceMicros += micros() - ulStart;
+}
+
+//*****************************************************************************
+//
+//! httpd_request_start
+//!
+//!  @param  pConn  connection
+//!
+//!  @return  none
+//!
+//!  @brief  Get ready to parse the next request on the connection
+//
+//*****************************************************************************
+static void
+httpd_request_start(tHttpdConn *pConn)
+{
+	pConn->ucState = HTTPD_STATE_METHOD;
+	pConn->ucLen = 0;
+	pConn->ucFlags &= HTTPD_FLAG_USED;
+	pConn->ucMethod = HTTPD_METHOD_OTHER;
+	pConn->ucHeader = HTTPD_HEADER_OTHER;
+	pConn->ulBodyLeft = 0;
+}
+
+//*****************************************************************************
+//
+//! httpd_token_add
+//!
+//!  @brief  Append a character to the connection's token, dropping what
+//!          doesn't fit
+//
+//*****************************************************************************
+static void
+httpd_token_add(tHttpdConn *pConn, char c)
+{
+	if (pConn->ucLen < HTTPD_TOKEN_MAX)
+	{
+		pConn->acToken[pConn->ucLen++] = c;
+	}
+}
+
+//*****************************************************************************
+//
+//! httpd_parse
+//!
+//!  @param  pConn  connection
+//!  @param  pcBuf  received bytes
+//!  @param  usLen  number of bytes
+//!
+//!  @return  1 if the connection has to be closed, 0 otherwise
+//!
+//!  @brief  Feed received bytes to the request parser, answering each
+//!          request as soon as its header is complete. Pipelined requests
+//!          in the same buffer are answered in turn.
+//
+//*****************************************************************************
+static unsigned char
+httpd_parse(tHttpdConn *pConn, const char *pcBuf, unsigned short usLen)
+{
+	unsigned char ucAnswered;
+	char c;
+
+	ucAnswered = 0;
+
+	while (usLen--)
+	{
+		c = *pcBuf++;
+
+		switch (pConn->ucState)
+		{
+		case HTTPD_STATE_METHOD:
+			if ((c == '\r') || (c == '\n'))
+			{
+				// Stray line ends between requests
+				break;
+			}
+			if (c != ' ')
+			{
+				httpd_token_add(pConn, c);
+				break;
+			}
+			pConn->acToken[pConn->ucLen] = '\0';
+			if (strcmp_P(pConn->acToken, PSTR("GET")) == 0)
+			{
+				pConn->ucMethod = HTTPD_METHOD_GET;
+			}
+			else if (strcmp_P(pConn->acToken, PSTR("HEAD")) == 0)
+			{
+				pConn->ucMethod = HTTPD_METHOD_HEAD;
+			}
+			pConn->ucLen = 0;
+			pConn->ucState = HTTPD_STATE_PATH;
+			break;
+
+		case HTTPD_STATE_PATH:
+			if (c != ' ')
+			{
+				if (pConn->ucLen < HTTPD_PATH_MAX)
+				{
+					pConn->acPath[pConn->ucLen++] = c;
+				}
+				else
+				{
+					pConn->ucFlags |= HTTPD_FLAG_PATH_LONG;
+				}
+				break;
+			}
+			pConn->acPath[pConn->ucLen] = '\0';
+			pConn->ucLen = 0;
+			pConn->ucState = HTTPD_STATE_VERSION;
+			break;
+
+		case HTTPD_STATE_VERSION:
+			if (c == '\r')
+			{
+				break;
+			}
+			if (c != '\n')
+			{
+				httpd_token_add(pConn, c);
+				break;
+			}
+			pConn->acToken[pConn->ucLen] = '\0';
+			if (strcmp_P(pConn->acToken, PSTR("HTTP/1.1")) == 0)
+			{
+				// HTTP/1.1 connections are persistent by default
+				pConn->ucFlags |= HTTPD_FLAG_HTTP11 | HTTPD_FLAG_KEEPALIVE;
+			}
+			pConn->ucLen = 0;
+			pConn->ucState = HTTPD_STATE_HEADER_NAME;
+			break;
+
+		case HTTPD_STATE_HEADER_NAME:
+			if (c == '\r')
+			{
+				break;
+			}
+			if (c == '\n')
+			{
+				if (pConn->ucLen)
+				{
+					// Header line without a ':', ignore it
+					pConn->ucLen = 0;
+					break;
+				}
+
+				// End of the request header
+				if (ucAnswered)
+				{
+					httpdStats.ulPipelined++;
+				}
+				httpd_respond(pConn);
+				ucAnswered = 1;
+
+				if (pConn->ucFlags & HTTPD_FLAG_CLOSE)
+				{
+					return 1;
+				}
+
+				if (pConn->ulBodyLeft)
+				{
+					pConn->ucState = HTTPD_STATE_BODY;
+				}
+				else
+				{
+					httpd_request_start(pConn);
+				}
+				break;
+			}
+			if (c != ':')
+			{
+				httpd_token_add(pConn, ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c);
+				break;
+			}
+			pConn->acToken[pConn->ucLen] = '\0';
+			if (strcmp_P(pConn->acToken, PSTR("connection")) == 0)
+			{
+				pConn->ucHeader = HTTPD_HEADER_CONNECTION;
+			}
+			else if (strcmp_P(pConn->acToken, PSTR("content-length")) == 0)
+			{
+				pConn->ucHeader = HTTPD_HEADER_CONTENT_LENGTH;
+			}
+			else
+			{
+				pConn->ucHeader = HTTPD_HEADER_OTHER;
+			}
+			pConn->ucLen = 0;
+			pConn->ucState = HTTPD_STATE_HEADER_VALUE;
+			break;
+
+		case HTTPD_STATE_HEADER_VALUE:
+			if ((c == '\r') || (((c == ' ') || (c == '\t')) && (pConn->ucLen == 0)))
+			{
+				break;
+			}
+			if (c != '\n')
+			{
+				if (pConn->ucHeader != HTTPD_HEADER_OTHER)
+				{
+					httpd_token_add(pConn, c);
+				}
+				break;
+			}
+			pConn->acToken[pConn->ucLen] = '\0';
+			if (pConn->ucHeader == HTTPD_HEADER_CONNECTION)
+			{
+				if (strncasecmp_P(pConn->acToken, PSTR("close"), 5) == 0)
+				{
+					pConn->ucFlags &= ~HTTPD_FLAG_KEEPALIVE;
+				}
+				else if (strncasecmp_P(pConn->acToken, PSTR("keep-alive"), 10) == 0)
+				{
+					pConn->ucFlags |= HTTPD_FLAG_KEEPALIVE;
+				}
+			}
+			else if (pConn->ucHeader == HTTPD_HEADER_CONTENT_LENGTH)
+			{
+				pConn->ulBodyLeft = strtoul(pConn->acToken, NULL, 10);
+			}
+			pConn->ucLen = 0;
+			pConn->ucState = HTTPD_STATE_HEADER_NAME;
+			break;
+
+		case HTTPD_STATE_BODY:
+			if (--pConn->ulBodyLeft == 0)
+			{
+				httpd_request_start(pConn);
+			}
+			break;
+		}
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! httpd_close
+//!
+//!  @param  pConn  connection
+//!
+//!  @return  none
+//!
+//!  @brief  Close a connection and free its slot
+//
+//*****************************************************************************
+static void
+httpd_close(tHttpdConn *pConn)
+{
+	reactor_unregister(pConn->cSd);
+	closesocket(pConn->cSd);
+	pConn->cSd = -1;
+}
+
+//*****************************************************************************
+//
+//! httpd_handler
+//!
+//!  @brief  tReactorHandler for the listening socket and the connections
+//
+//*****************************************************************************
+static void
+httpd_handler(long sd, unsigned char ucEvent, long lArg)
+{
+	char acBuf[HTTPD_RECV_BUF];
+	tHttpdConn *pConn;
+	int len;
+
+	switch (ucEvent)
+	{
+	case REACTOR_EVENT_ACCEPT:
+		pConn = httpd_find(-1);
+		if ((pConn == NULL) || (reactor_register(lArg, REACTOR_EVENT_READ, httpd_handler) != 0))
+		{
+			httpdStats.ulRejected++;
+			closesocket(lArg);
+			break;
+		}
+		httpdStats.ulConnections++;
+		memset(pConn, 0, sizeof(tHttpdConn));
+		pConn->cSd = (signed char)lArg;
+		pConn->ulLastActive = millis();
+		httpd_request_start(pConn);
+		break;
+
+	case REACTOR_EVENT_READ:
+		pConn = httpd_find(sd);
+		if (pConn == NULL)
+		{
+			break;
+		}
+		len = recv(sd, acBuf, sizeof(acBuf), 0);
+		if (len <= 0)
+		{
+			// Readable but nothing to read: the peer closed or the socket failed
+			httpd_close(pConn);
+			break;
+		}
+		httpdStats.ulBytesIn += len;
+		pConn->ulLastActive = millis();
+		if (httpd_parse(pConn, acBuf, len))
+		{
+			httpd_close(pConn);
+		}
+		break;
+
+	case REACTOR_EVENT_CLOSE:
+		pConn = httpd_find(sd);
+		if (pConn)
+		{
+			// Already unregistered by the reactor
+			pConn->cSd = -1;
+		}
+		closesocket(sd);
+		if (sd == cHttpdListenSd)
+		{
+			cHttpdListenSd = -1;
+		}
+		break;
+	}
+}
+
+//*****************************************************************************
+//
+//! httpd_begin
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+long
+httpd_begin(unsigned short usPort, const tHttpdRoute *pRoutes)
+{
+	sockaddr addr;
+	unsigned char i;
+	long sd;
+
+	for (i = 0; i < HTTPD_MAX_CONNS; i++)
+	{
+		httpdConns[i].cSd = -1;
+	}
+	httpdRoutes = pRoutes;
+
+	sd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (!M_IS_VALID_SD(sd))
+	{
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (usPort >> 8) & 0xff;
+	addr.sa_data[1] = usPort & 0xff;
+
+	if ((bind(sd, &addr, sizeof(addr)) != 0) || (listen(sd, MAX_LISTEN_QUEUE) != 0) ||
+			(reactor_register(sd, REACTOR_EVENT_ACCEPT, httpd_handler) != 0))
+	{
+		closesocket(sd);
+		return -1;
+	}
+
+	cHttpdListenSd = (signed char)sd;
+
+	return sd;
+}
+
+//*****************************************************************************
+//
+//! httpd_end
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+void
+httpd_end(void)
+{
+	unsigned char i;
+
+	for (i = 0; i < HTTPD_MAX_CONNS; i++)
+	{
+		if (httpdConns[i].cSd >= 0)
+		{
+			httpd_close(&httpdConns[i]);
+		}
+	}
+
+	if (cHttpdListenSd >= 0)
+	{
+		reactor_unregister(cHttpdListenSd);
+		closesocket(cHttpdListenSd);
+		cHttpdListenSd = -1;
+	}
+}
+
+//*****************************************************************************
+//
+//! httpd_poll
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+int
+httpd_poll(unsigned long ulTimeoutMs)
+{
+	unsigned long ulNow;
+	unsigned char i;
+	int res;
+
+	res = reactor_run_once(ulTimeoutMs);
+
+	// Kept-alive connections hold a CC3000 socket each, give them back
+	ulNow = millis();
+	for (i = 0; i < HTTPD_MAX_CONNS; i++)
+	{
+		if ((httpdConns[i].cSd >= 0) &&
+				((ulNow - httpdConns[i].ulLastActive) >= HTTPD_IDLE_TIMEOUT_MS))
+		{
+			httpdStats.ulTimeouts++;
+			httpd_close(&httpdConns[i]);
+		}
+	}
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! httpd_write
+//!
+//!  @param  sd         socket handle
+//!  @param  buf        data
+//!  @param  usLen      data length
+//!  @param  ucProgmem  1 if buf is in PROGMEM
+//!
+//!  @return  data bytes sent, negative on error
+//
+//*****************************************************************************
+static long
+httpd_write(long sd, const void *buf, unsigned short usLen, unsigned char ucProgmem)
+{
+	tHttpdConn *pConn;
+	tHttpdOut out;
+	long lSent;
+
+	pConn = httpd_find(sd);
+	if ((pConn == NULL) || (sd < 0))
+	{
+		return -1;
+	}
+	if (usLen == 0)
+	{
+		return 0;
+	}
+
+	memset(&out, 0, sizeof(out));
+	out.pucData = (const unsigned char *)buf;
+	out.usDataLen = usLen;
+	out.ucProgmem = ucProgmem;
+
+	if (pConn->ucFlags & HTTPD_FLAG_HTTP11)
+	{
+		// Chunk size line before the data, CRLF after it
+		usHttpdHeadLen = 0;
+		httpd_head_ul(usLen, 16);
+		acHttpdHead[usHttpdHeadLen++] = '\r';
+		acHttpdHead[usHttpdHeadLen++] = '\n';
+		out.pcHead = acHttpdHead;
+		out.usHeadLen = usHttpdHeadLen;
+		out.pcTail = "\r\n";
+		out.usTailLen = 2;
+	}
+
+	lSent = httpd_send(sd, &out);
+	if (lSent < 0)
+	{
+		return lSent;
+	}
+
+	lSent -= out.usHeadLen + out.usTailLen;
+	return (lSent > 0) ? lSent : 0;
+}
+
+//*****************************************************************************
+//
+//! httpd_write_chunk
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+long
+httpd_write_chunk(long sd, const void *buf, unsigned short usLen)
+{
+	return httpd_write(sd, buf, usLen, 0);
+}
+
+//*****************************************************************************
+//
+//! httpd_write_chunk_P
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+long
+httpd_write_chunk_P(long sd, const void *buf, unsigned short usLen)
+{
+	return httpd_write(sd, buf, usLen, 1);
+}
+
+//*****************************************************************************
+//
+//! httpd_get_stats
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+void
+httpd_get_stats(tHttpdStats *pStats)
+{
+	memcpy(pStats, &httpdStats, sizeof(tHttpdStats));
+}
+
+//*****************************************************************************
+//
+//! httpd_reset_stats
+//!
+//!  @brief  see httpd.h
+//
+//*****************************************************************************
+void
+httpd_reset_stats(void)
+{
+	memset(&httpdStats, 0, sizeof(tHttpdStats));
+}
+
+#endif	// CC3000_TINY_DRIVER
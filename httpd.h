@@ -0,0 +1,177 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a small HTTP/1.1 server on top of the reactor. Requests
+*  are parsed a byte at a time as they arrive, so nothing but the path is
+*  buffered; connections are kept alive and pipelined requests are
+*  answered in order. Pages are either static, served straight from
+*  PROGMEM, or generated by a handler that writes chunks.
+*
+****************************************************************************/
+#ifndef __HTTPD_H__
+#define __HTTPD_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// Connections served at once. Each keeps one of the CC3000's 8 sockets
+// while it is kept alive, and the listening socket takes another
+#ifndef HTTPD_MAX_CONNS
+#define HTTPD_MAX_CONNS				(3)
+#endif
+
+// Longest path (including any query string) that can be routed. Longer
+// paths get a 404
+#ifndef HTTPD_PATH_MAX
+#define HTTPD_PATH_MAX				(24)
+#endif
+
+// Kept-alive connections with no request for this long are closed
+#ifndef HTTPD_IDLE_TIMEOUT_MS
+#define HTTPD_IDLE_TIMEOUT_MS		(5000UL)
+#endif
+
+// Dynamic page handler. pcQuery is the part of the path after '?', or "".
+// Write the page with httpd_write_chunk / httpd_write_chunk_P
+typedef void (*tHttpdHandler)(long sd, const char *pcQuery);
+
+// A route, kept in PROGMEM with its strings. The table ends with an
+// entry whose pcPath is NULL
+typedef struct _httpd_route_t
+{
+	const char				*pcPath;			// exact match, without the query
+	const char				*pcContentType;
+	const unsigned char		*pucBody;			// static body, or NULL
+	unsigned short			usBodyLen;
+	tHttpdHandler			handler;			// used when pucBody is NULL
+} tHttpdRoute;
+
+typedef struct _httpd_stats_t
+{
+	unsigned long	ulConnections;			// connections accepted
+	unsigned long	ulRejected;				// closed at once, no free connection
+	unsigned long	ulRequests;				// requests answered
+	unsigned long	ulKeptAlive;			// requests on an already used connection
+	unsigned long	ulPipelined;			// requests read in the same recv as the previous one
+	unsigned long	ulNotFound;
+	unsigned long	ulBadRequests;			// methods other than GET and HEAD
+	unsigned long	ulTimeouts;				// idle connections closed
+	unsigned long	ulBytesIn;
+	unsigned long	ulBytesOut;
+	unsigned long	ulServiceMicros;		// total time spent answering requests
+} tHttpdStats;
+
+
+//*****************************************************************************
+//
+//! httpd_begin
+//!
+//!  @param  usPort   TCP port to listen on
+//!  @param  pRoutes  route table in PROGMEM
+//!
+//!  @return  listening socket, or -1 on failure
+//!
+//!  @brief  Open the listening socket and register it with the reactor
+//
+//*****************************************************************************
+extern long httpd_begin(unsigned short usPort, const tHttpdRoute *pRoutes);
+
+//*****************************************************************************
+//
+//! httpd_end
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Close every connection and the listening socket
+//
+//*****************************************************************************
+extern void httpd_end(void);
+
+//*****************************************************************************
+//
+//! httpd_poll
+//!
+//!  @param  ulTimeoutMs  passed to reactor_run_once
+//!
+//!  @return  return value of reactor_run_once
+//!
+//!  @brief  Run one pass of the reactor (which serves every socket
+//!          registered with it, not just the server's) and close
+//!          connections idle longer than HTTPD_IDLE_TIMEOUT_MS
+//
+//*****************************************************************************
+extern int httpd_poll(unsigned long ulTimeoutMs);
+
+//*****************************************************************************
+//
+//! httpd_write_chunk
+//!
+//!  @param  sd     socket passed to the handler
+//!  @param  buf    data
+//!  @param  usLen  data length, 0 is ignored
+//!
+//!  @return  number of data bytes sent, or negative on error
+//!
+//!  @brief  Send part of a dynamic page. HTTP/1.1 clients get it as one
+//!          chunk of a chunked response; HTTP/1.0 clients get it as is
+//!          and the connection is closed at the end of the page.
+//!          httpd_write_chunk_P takes the data from PROGMEM.
+//
+//*****************************************************************************
+extern long httpd_write_chunk(long sd, const void *buf, unsigned short usLen);
+extern long httpd_write_chunk_P(long sd, const void *buf, unsigned short usLen);
+
+//*****************************************************************************
+//
+//! httpd_get_stats
+//!
+//!  @param[out]  pStats  filled with a copy of the server counters
+//!
+//!  @return  none
+//!
+//!  @brief  Requests per second is ulRequests over the measuring time;
+//!          httpd_reset_stats() zeroes the counters.
+//
+//*****************************************************************************
+extern void httpd_get_stats(tHttpdStats *pStats);
+extern void httpd_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __HTTPD_H__
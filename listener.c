@@ -0,0 +1,308 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Accept queue for listening sockets, see listener.h
+*
+*  The CC3000 keeps at most MAX_LISTEN_QUEUE connections waiting for
+*  accept() and refuses the rest, so under a burst of clients a server
+*  that only calls accept() between requests loses connections. Taking
+*  them off the CC3000 as soon as listener_poll() runs frees its backlog
+*  for the next ones.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "listener.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+typedef struct _listener_conn_t
+{
+	unsigned long	ulAcceptedAt;		// millis() when accept() returned it
+	unsigned char	aucAddr[ASIC_ADDR_LEN];
+	signed char		cSd;
+} tListenerConn;
+
+typedef struct _listener_entry_t
+{
+	tListenerConn	queue[LISTENER_QUEUE_LEN];
+	unsigned char	ucHead;				// oldest queued connection
+	unsigned char	ucCount;
+	signed char		cSd;				// listening socket
+	unsigned char	ucUsed;
+} tListenerEntry;
+
+
+static tListenerEntry	listenerTable[LISTENER_MAX];
+static tListenerStats	listenerStats;
+
+
+//*****************************************************************************
+//
+//! listener_find
+//!
+//!  @param  sd  listening socket
+//!
+//!  @return  the listener for sd, or NULL
+//
+//*****************************************************************************
+static tListenerEntry *
+listener_find(long sd)
+{
+	unsigned char i;
+
+	for (i = 0; i < LISTENER_MAX; i++)
+	{
+		if (listenerTable[i].ucUsed && (listenerTable[i].cSd == sd))
+		{
+			return &listenerTable[i];
+		}
+	}
+
+	return NULL;
+}
+
+//*****************************************************************************
+//
+//! listener_attach
+//!
+//!  @brief  see listener.h
+//
+//*****************************************************************************
+long
+listener_attach(long sd)
+{
+	unsigned long ulOptVal = SOCK_ON;
+	unsigned char i;
+
+	if (!M_IS_VALID_SD(sd) || listener_find(sd))
+	{
+		return -1;
+	}
+
+	for (i = 0; i < LISTENER_MAX; i++)
+	{
+		if (!listenerTable[i].ucUsed)
+		{
+			if (setsockopt(sd, SOL_SOCKET, SOCKOPT_ACCEPT_NONBLOCK, &ulOptVal, sizeof(ulOptVal)) != 0)
+			{
+				return -1;
+			}
+
+			memset(&listenerTable[i], 0, sizeof(tListenerEntry));
+			listenerTable[i].cSd = (signed char)sd;
+			listenerTable[i].ucUsed = 1;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+//*****************************************************************************
+//
+//! listener_detach
+//!
+//!  @brief  see listener.h
+//
+//*****************************************************************************
+long
+listener_detach(long sd)
+{
+	tListenerEntry *pEntry;
+
+	pEntry = listener_find(sd);
+	if (pEntry == NULL)
+	{
+		return -1;
+	}
+
+	while (pEntry->ucCount)
+	{
+		closesocket(pEntry->queue[pEntry->ucHead].cSd);
+		pEntry->ucHead = (pEntry->ucHead + 1) % LISTENER_QUEUE_LEN;
+		pEntry->ucCount--;
+	}
+	pEntry->ucUsed = 0;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! listener_poll
+//!
+//!  @brief  see listener.h
+//
+//*****************************************************************************
+long
+listener_poll(void)
+{
+	tListenerEntry *pEntry;
+	tListenerConn *pConn;
+	sockaddr addr;
+	socklen_t addrlen;
+	unsigned long ulStart;
+	unsigned char i, ucQueued;
+	long newsd;
+
+	ucQueued = 0;
+
+	for (i = 0; i < LISTENER_MAX; i++)
+	{
+		pEntry = &listenerTable[i];
+		if (!pEntry->ucUsed)
+		{
+			continue;
+		}
+
+		// Drain the CC3000's backlog. accept() marks the listening socket
+		// inactive when nothing is pending, so its status is not checked
+		for (;;)
+		{
+			if (pEntry->ucCount >= LISTENER_QUEUE_LEN)
+			{
+				listenerStats.ulQueueFull++;
+				break;
+			}
+
+			addrlen = sizeof(addr);
+			ulStart = micros();
+			newsd = accept(pEntry->cSd, &addr, &addrlen);
+			listenerStats.ulAcceptMicros += micros() - ulStart;
+			listenerStats.ulAcceptPolls++;
+
+			if (!M_IS_VALID_SD(newsd))
+			{
+				if (newsd != SOC_IN_PROGRESS)
+				{
+					listenerStats.ulErrors++;
+				}
+				break;
+			}
+
+			pConn = &pEntry->queue[(pEntry->ucHead + pEntry->ucCount) % LISTENER_QUEUE_LEN];
+			pConn->cSd = (signed char)newsd;
+			pConn->ulAcceptedAt = millis();
+			memcpy(pConn->aucAddr, &addr, ASIC_ADDR_LEN);
+			pEntry->ucCount++;
+
+			listenerStats.ulAccepted++;
+		}
+
+		ucQueued += pEntry->ucCount;
+	}
+
+	if (ucQueued > listenerStats.ucPeakQueued)
+	{
+		listenerStats.ucPeakQueued = ucQueued;
+	}
+
+	return ucQueued;
+}
+
+//*****************************************************************************
+//
+//! listener_accept
+//!
+//!  @brief  see listener.h
+//
+//*****************************************************************************
+long
+listener_accept(long sd, sockaddr *addr, socklen_t *addrlen)
+{
+	tListenerEntry *pEntry;
+	tListenerConn *pConn;
+	unsigned long ulWait;
+	long newsd;
+
+	pEntry = listener_find(sd);
+	if (pEntry == NULL)
+	{
+		return -1;
+	}
+
+	while (pEntry->ucCount)
+	{
+		pConn = &pEntry->queue[pEntry->ucHead];
+		pEntry->ucHead = (pEntry->ucHead + 1) % LISTENER_QUEUE_LEN;
+		pEntry->ucCount--;
+		newsd = pConn->cSd;
+
+		// The client may have given up while the connection was queued
+		if (get_socket_close_wait_status(newsd) ||
+				(SOCKET_STATUS_ACTIVE != get_socket_active_status(newsd)))
+		{
+			listenerStats.ulDropped++;
+			closesocket(newsd);
+			continue;
+		}
+
+		ulWait = millis() - pConn->ulAcceptedAt;
+		listenerStats.ulQueueWaitMillis += ulWait;
+		if (ulWait > listenerStats.ulMaxQueueWaitMillis)
+		{
+			listenerStats.ulMaxQueueWaitMillis = ulWait;
+		}
+		listenerStats.ulHandedOut++;
+
+		if (addr)
+		{
+			memset(addr, 0, sizeof(sockaddr));
+			memcpy(addr, pConn->aucAddr, ASIC_ADDR_LEN);
+		}
+		if (addrlen)
+		{
+			*addrlen = ASIC_ADDR_LEN;
+		}
+
+		return newsd;
+	}
+
+	return SOC_IN_PROGRESS;
+}
+
+//*****************************************************************************
+//
+//! listener_get_stats
+//!
+//!  @brief  see listener.h
+//
+//*****************************************************************************
+void
+listener_get_stats(tListenerStats *pStats)
+{
+	memcpy(pStats, &listenerStats, sizeof(tListenerStats));
+}
+
+//*****************************************************************************
+//
+//! listener_reset_stats
+//!
+//!  @brief  see listener.h
+//
+//*****************************************************************************
+void
+listener_reset_stats(void)
+{
+	memset(&listenerStats, 0, sizeof(tListenerStats));
+}
+
+#endif	// CC3000_TINY_DRIVER
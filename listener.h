@@ -0,0 +1,155 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is an accept queue for listening sockets. listener_poll()
+*  runs non-blocking accept() calls from loop() and keeps the new
+*  connections, with the peer address, in a small local queue so
+*  listener_accept() can hand them out without an HCI round trip.
+*
+****************************************************************************/
+#ifndef __LISTENER_H__
+#define __LISTENER_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// Number of listening sockets that can be attached at once
+#ifndef LISTENER_MAX
+#define LISTENER_MAX				(2)
+#endif
+
+// Accepted connections kept per listener. The CC3000 itself holds at most
+// MAX_LISTEN_QUEUE more that have not been accept()ed yet
+#ifndef LISTENER_QUEUE_LEN
+#define LISTENER_QUEUE_LEN			(4)
+#endif
+
+typedef struct _listener_stats_t
+{
+	unsigned long	ulAcceptPolls;			// accept() round trips
+	unsigned long	ulAccepted;				// connections taken from the CC3000
+	unsigned long	ulHandedOut;			// connections returned by listener_accept()
+	unsigned long	ulDropped;				// closed by the peer while queued
+	unsigned long	ulQueueFull;			// polls that left connections on the CC3000
+	unsigned long	ulErrors;				// accept() failures other than "nothing pending"
+	unsigned long	ulAcceptMicros;			// total time in accept() calls
+	unsigned long	ulQueueWaitMillis;		// total time from accept() to listener_accept()
+	unsigned long	ulMaxQueueWaitMillis;
+	unsigned char	ucPeakQueued;
+} tListenerStats;
+
+
+//*****************************************************************************
+//
+//! listener_attach
+//!
+//!  @param  sd  socket that has been bound and is listening
+//!
+//!  @return  0 on success, -1 on a bad socket or if LISTENER_MAX listeners
+//!           are already attached
+//!
+//!  @brief  Switch the socket to SOCKOPT_ACCEPT_NONBLOCK and start
+//!          queueing its connections in listener_poll()
+//
+//*****************************************************************************
+extern long listener_attach(long sd);
+
+//*****************************************************************************
+//
+//! listener_detach
+//!
+//!  @param  sd  listening socket
+//!
+//!  @return  0 on success, -1 if the socket is not attached
+//!
+//!  @brief  Stop queueing connections. Connections still queued are
+//!          closed; the listening socket itself is left open.
+//
+//*****************************************************************************
+extern long listener_detach(long sd);
+
+//*****************************************************************************
+//
+//! listener_poll
+//!
+//!  @param  none
+//!
+//!  @return  number of connections waiting in the queues
+//!
+//!  @brief  Accept pending connections on every attached listener until
+//!          the CC3000 has none left or the queue is full. Call it from
+//!          loop(), as often as connections should be picked up.
+//
+//*****************************************************************************
+extern long listener_poll(void);
+
+//*****************************************************************************
+//
+//! listener_accept
+//!
+//!  @param[in]   sd       listening socket
+//!  @param[out]  addr     peer address, as for accept
+//!  @param[out]  addrlen  size of addr
+//!
+//!  @return  new socket descriptor, SOC_IN_PROGRESS if the queue is empty,
+//!           -1 if the socket is not attached
+//!
+//!  @brief  Take the oldest queued connection. Connections the peer has
+//!          closed in the meantime are closed and skipped. No HCI traffic
+//!          other than those closes.
+//
+//*****************************************************************************
+extern long listener_accept(long sd, sockaddr *addr, socklen_t *addrlen);
+
+//*****************************************************************************
+//
+//! listener_get_stats
+//!
+//!  @param[out]  pStats  filled with a copy of the listener counters
+//!
+//!  @return  none
+//!
+//!  @brief  The average accept() round trip is ulAcceptMicros /
+//!          ulAcceptPolls. listener_reset_stats() zeroes the counters.
+//
+//*****************************************************************************
+extern void listener_get_stats(tListenerStats *pStats);
+extern void listener_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __LISTENER_H__
@@ -0,0 +1,1109 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  MQTT 3.1.1 client, see mqtt.h
+*
+*  An outgoing packet is described as a list of parts (the topic, the
+*  payload, ...) pointing at the caller's data, plus a few bytes of
+*  scratch for the lengths and flags; the parts are copied once, straight
+*  into the TX buffer. Incoming packets go through a byte-wise state
+*  machine, except for publish payloads which are passed to the callback
+*  in runs out of the recv() buffer.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "mqtt.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+//--------- Packet types (first byte, flags cleared) --------
+
+#define MQTT_CONNECT				(0x10)
+#define MQTT_CONNACK				(0x20)
+#define MQTT_PUBLISH				(0x30)
+#define MQTT_PUBACK					(0x40)
+#define MQTT_SUBSCRIBE				(0x82)	// flags 0010 are required
+#define MQTT_SUBACK					(0x90)
+#define MQTT_PINGREQ				(0xC0)
+#define MQTT_PINGRESP				(0xD0)
+#define MQTT_DISCONNECT				(0xE0)
+
+#define MQTT_CONNECT_FLAG_USER		(0x80)
+#define MQTT_CONNECT_FLAG_PASSWORD	(0x40)
+#define MQTT_CONNECT_FLAG_CLEAN		(0x02)
+
+//--------- Client states --------
+
+#define MQTT_STATE_CLOSED			(0)
+#define MQTT_STATE_CONNECTING		(1)		// CONNECT sent, waiting for the CONNACK
+#define MQTT_STATE_CONNECTED		(2)
+
+//--------- Receive states --------
+
+#define MQTT_RX_TYPE				(0)
+#define MQTT_RX_LENGTH				(1)
+#define MQTT_RX_TOPIC_LEN			(2)
+#define MQTT_RX_TOPIC				(3)
+#define MQTT_RX_PID					(4)
+#define MQTT_RX_PAYLOAD				(5)
+#define MQTT_RX_BODY				(6)		// any other packet, first bytes kept in aucRxBody
+
+#define MQTT_RX_BODY_MAX			(4)
+
+//--------- Outgoing packets --------
+
+#define MQTT_PACKET_PARTS			(10)
+#define MQTT_PACKET_SCRATCH			(20)
+
+typedef struct _mqtt_packet_t
+{
+	const unsigned char	*apucPart[MQTT_PACKET_PARTS];
+	unsigned short		ausLen[MQTT_PACKET_PARTS];
+	unsigned char		aucFixed[5];		// type and remaining length
+	unsigned char		aucScratch[MQTT_PACKET_SCRATCH];
+	unsigned char		ucFixedLen;
+	unsigned char		ucParts;
+	unsigned char		ucScratch;
+} tMqttPacket;
+
+typedef struct _mqtt_inflight_t
+{
+	unsigned long	ulSent;				// millis() when published
+	unsigned short	usId;				// 0 when the entry is free
+} tMqttInflight;
+
+typedef struct _mqtt_client_t
+{
+	tMqttMessageCallback	callback;
+	void					*pvContext;
+	unsigned long			ulLastSent;		// millis() of the last packet sent, for keepalive
+	unsigned long			ulPingSent;
+	unsigned long			ulRxRemaining;	// bytes of the current packet still to come
+	unsigned long			ulPayloadLen;
+	unsigned long			ulPayloadOffset;
+	long					lSd;
+	unsigned short			usKeepAlive;
+	unsigned short			usNextId;
+	unsigned short			usTopicLen;		// topic bytes still to come
+	unsigned short			usRxPid;
+	tMqttInflight			inflight[MQTT_INFLIGHT_MAX];
+	char					acTopic[MQTT_TOPIC_MAX + 1];
+	unsigned char			aucRxBody[MQTT_RX_BODY_MAX];
+	unsigned char			ucState;
+	unsigned char			ucPingPending;
+	unsigned char			ucConnackCode;
+	unsigned char			ucRxState;
+	unsigned char			ucRxType;
+	unsigned char			ucRxShift;		// remaining length bits decoded so far
+	unsigned char			ucRxCount;		// bytes of a two byte field, or of aucRxBody
+	unsigned char			ucTopicPos;
+} tMqttClient;
+
+
+static tMqttClient	mqttClient;
+static tMqttStats	mqttStats;
+
+
+//*****************************************************************************
+//
+//! mqtt_packet_init
+//!
+//!  @param  pPacket  packet to start
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+mqtt_packet_init(tMqttPacket *pPacket)
+{
+	pPacket->ucParts = 0;
+	pPacket->ucScratch = 0;
+}
+
+//*****************************************************************************
+//
+//! mqtt_packet_data
+//!
+//!  @param  pPacket  packet being built
+//!  @param  pucData  bytes to add, must stay valid until the packet is sent
+//!  @param  usLen    number of bytes
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+mqtt_packet_data(tMqttPacket *pPacket, const unsigned char *pucData, unsigned short usLen)
+{
+	pPacket->apucPart[pPacket->ucParts] = pucData;
+	pPacket->ausLen[pPacket->ucParts] = usLen;
+	pPacket->ucParts++;
+}
+
+//*****************************************************************************
+//
+//! mqtt_packet_bytes
+//!
+//!  @param  pPacket  packet being built
+//!  @param  pucData  bytes to add, copied to the packet's scratch space
+//!  @param  ucLen    number of bytes
+//!
+//!  @return  none
+//!
+//!  @brief  Bytes directly after other scratch bytes extend the same part
+//
+//*****************************************************************************
+static void
+mqtt_packet_bytes(tMqttPacket *pPacket, const unsigned char *pucData, unsigned char ucLen)
+{
+	unsigned char *pucDst = pPacket->aucScratch + pPacket->ucScratch;
+
+	memcpy(pucDst, pucData, ucLen);
+	pPacket->ucScratch += ucLen;
+
+	if (pPacket->ucParts &&
+			(pPacket->apucPart[pPacket->ucParts - 1] + pPacket->ausLen[pPacket->ucParts - 1] == pucDst))
+	{
+		pPacket->ausLen[pPacket->ucParts - 1] += ucLen;
+	}
+	else
+	{
+		mqtt_packet_data(pPacket, pucDst, ucLen);
+	}
+}
+
+//*****************************************************************************
+//
+//! mqtt_packet_short
+//!
+//!  @param  pPacket  packet being built
+//!  @param  usValue  two byte integer, added MSB first
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+mqtt_packet_short(tMqttPacket *pPacket, unsigned short usValue)
+{
+	unsigned char aucValue[2];
+
+	aucValue[0] = usValue >> 8;
+	aucValue[1] = usValue & 0xff;
+	mqtt_packet_bytes(pPacket, aucValue, 2);
+}
+
+//*****************************************************************************
+//
+//! mqtt_packet_string
+//!
+//!  @param  pPacket  packet being built
+//!  @param  pcStr    string to add with its length prefix
+//!
+//!  @return  0 on success, MQTT_ERR_TOO_LONG
+//
+//*****************************************************************************
+static long
+mqtt_packet_string(tMqttPacket *pPacket, const char *pcStr)
+{
+	unsigned long ulLen = strlen(pcStr);
+
+	if (ulLen > 0xffff)
+	{
+		return MQTT_ERR_TOO_LONG;
+	}
+
+	mqtt_packet_short(pPacket, (unsigned short)ulLen);
+	mqtt_packet_data(pPacket, (const unsigned char *)pcStr, (unsigned short)ulLen);
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! mqtt_packet_source
+//!
+//!  @brief  tSendStreamSource over the fixed header and the parts of a
+//!          packet too large for one TX buffer
+//
+//*****************************************************************************
+static long
+mqtt_packet_source(unsigned char *pucDst, unsigned long ulOffset, unsigned short usLen,
+                   void *pvContext)
+{
+	tMqttPacket *pPacket = (tMqttPacket *)pvContext;
+	const unsigned char *pucPart;
+	unsigned long ulPartStart;
+	unsigned short n, usPartLen, usRun, usOff;
+	signed char i;
+
+	n = 0;
+	ulPartStart = 0;
+	for (i = -1; (i < (signed char)pPacket->ucParts) && (n < usLen); i++)
+	{
+		if (i < 0)
+		{
+			pucPart = pPacket->aucFixed;
+			usPartLen = pPacket->ucFixedLen;
+		}
+		else
+		{
+			pucPart = pPacket->apucPart[i];
+			usPartLen = pPacket->ausLen[i];
+		}
+
+		if (ulOffset + n < ulPartStart + usPartLen)
+		{
+			usOff = (unsigned short)(ulOffset + n - ulPartStart);
+			usRun = usPartLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			memcpy(pucDst + n, pucPart + usOff, usRun);
+			n += usRun;
+		}
+
+		ulPartStart += usPartLen;
+	}
+
+	return n;
+}
+
+//*****************************************************************************
+//
+//! mqtt_packet_send
+//!
+//!  @param  pPacket  packet with its parts added
+//!  @param  ucType   first byte of the fixed header
+//!
+//!  @return  0 on success, MQTT_ERR_SEND
+//!
+//!  @brief  Encode the fixed header and send the packet. A packet that fits
+//!          is written straight into the TX buffer and sent as one
+//
+//*****************************************************************************
+static long
+mqtt_packet_send(tMqttPacket *pPacket, unsigned char ucType)
+{
+	unsigned long ulRemaining, ulTotal;
+	unsigned short usMax;
+	unsigned char *pucDst;
+	unsigned char i;
+
+	ulRemaining = 0;
+	for (i = 0; i < pPacket->ucParts; i++)
+	{
+		ulRemaining += pPacket->ausLen[i];
+	}
+
+	pPacket->aucFixed[0] = ucType;
+	pPacket->ucFixedLen = 1;
+	ulTotal = ulRemaining;
+	do
+	{
+		pPacket->aucFixed[pPacket->ucFixedLen] = ulRemaining & 0x7f;
+		ulRemaining >>= 7;
+		if (ulRemaining)
+		{
+			pPacket->aucFixed[pPacket->ucFixedLen] |= 0x80;
+		}
+		pPacket->ucFixedLen++;
+	} while (ulRemaining);
+	ulTotal += pPacket->ucFixedLen;
+
+	pucDst = send_buffer_get(&usMax);
+	if (ulTotal <= usMax)
+	{
+		mqtt_packet_source(pucDst, 0, (unsigned short)ulTotal, pPacket);
+		if (send_buffer_commit(mqttClient.lSd, ulTotal, 0) != (int)ulTotal)
+		{
+			return MQTT_ERR_SEND;
+		}
+	}
+	else if (send_stream(mqttClient.lSd, mqtt_packet_source, ulTotal, pPacket) != (long)ulTotal)
+	{
+		return MQTT_ERR_SEND;
+	}
+
+	mqttStats.ulBytesOut += ulTotal;
+	mqttClient.ulLastSent = millis();
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! mqtt_send_short
+//!
+//!  @param  ucType  first byte of the fixed header
+//!  @param  ucLen   0, or 2 to follow it with usId
+//!  @param  usId    packet identifier
+//!
+//!  @return  0 on success, MQTT_ERR_SEND
+//!
+//!  @brief  Send PUBACK, PINGREQ or DISCONNECT
+//
+//*****************************************************************************
+static long
+mqtt_send_short(unsigned char ucType, unsigned char ucLen, unsigned short usId)
+{
+	tMqttPacket packet;
+
+	mqtt_packet_init(&packet);
+	if (ucLen)
+	{
+		mqtt_packet_short(&packet, usId);
+	}
+
+	return mqtt_packet_send(&packet, ucType);
+}
+
+//*****************************************************************************
+//
+//! mqtt_close
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Close the socket and forget the session
+//
+//*****************************************************************************
+static void
+mqtt_close(void)
+{
+	// lSd is only valid once mqtt_connect has opened the socket
+	if (mqttClient.ucState != MQTT_STATE_CLOSED)
+	{
+		closesocket(mqttClient.lSd);
+	}
+	mqttClient.lSd = -1;
+	mqttClient.ucState = MQTT_STATE_CLOSED;
+}
+
+//*****************************************************************************
+//
+//! mqtt_next_id
+//!
+//!  @param  none
+//!
+//!  @return  a packet identifier, never 0
+//
+//*****************************************************************************
+static unsigned short
+mqtt_next_id(void)
+{
+	if (++mqttClient.usNextId == 0)
+	{
+		mqttClient.usNextId = 1;
+	}
+
+	return mqttClient.usNextId;
+}
+
+//*****************************************************************************
+//
+//! mqtt_rx_complete
+//!
+//!  @param  none
+//!
+//!  @return  0 on success, MQTT_ERR_xxx
+//!
+//!  @brief  Act on a fully received packet
+//
+//*****************************************************************************
+static long
+mqtt_rx_complete(void)
+{
+	unsigned long ulMillis;
+	unsigned short usId;
+	unsigned char i;
+	long res = 0;
+
+	switch (mqttClient.ucRxType & 0xf0)
+	{
+	case MQTT_PUBLISH:
+		if (mqttClient.ucRxState != MQTT_RX_PAYLOAD)
+		{
+			// Ended inside the topic or packet identifier
+			return MQTT_ERR_PROTOCOL;
+		}
+		if ((mqttClient.ulPayloadLen == 0) && mqttClient.callback)
+		{
+			mqttClient.callback(mqttClient.acTopic, NULL, 0, 0, 0, mqttClient.pvContext);
+		}
+		mqttStats.ulReceived++;
+		if ((mqttClient.ucRxType & 0x06) == 0x02)
+		{
+			res = mqtt_send_short(MQTT_PUBACK, 2, mqttClient.usRxPid);
+		}
+		break;
+
+	case MQTT_CONNACK:
+		if (mqttClient.ucRxCount < 2)
+		{
+			return MQTT_ERR_PROTOCOL;
+		}
+		mqttClient.ucConnackCode = mqttClient.aucRxBody[1];
+		if ((mqttClient.ucState == MQTT_STATE_CONNECTING) && (mqttClient.ucConnackCode == 0))
+		{
+			mqttClient.ucState = MQTT_STATE_CONNECTED;
+		}
+		break;
+
+	case MQTT_PUBACK:
+		if (mqttClient.ucRxCount < 2)
+		{
+			return MQTT_ERR_PROTOCOL;
+		}
+		usId = (mqttClient.aucRxBody[0] << 8) | mqttClient.aucRxBody[1];
+		for (i = 0; i < MQTT_INFLIGHT_MAX; i++)
+		{
+			if (mqttClient.inflight[i].usId == usId)
+			{
+				ulMillis = millis() - mqttClient.inflight[i].ulSent;
+				mqttStats.ulAcked++;
+				mqttStats.ulAckMillis += ulMillis;
+				if (ulMillis > mqttStats.ulMaxAckMillis)
+				{
+					mqttStats.ulMaxAckMillis = ulMillis;
+				}
+				mqttClient.inflight[i].usId = 0;
+				break;
+			}
+		}
+		break;
+
+	case MQTT_PINGRESP:
+		mqttClient.ucPingPending = 0;
+		break;
+
+	default:
+		// SUBACK, and anything a 3.1.1 broker shouldn't send us
+		break;
+	}
+
+	mqttClient.ucRxState = MQTT_RX_TYPE;
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! mqtt_rx_payload_start
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Topic and packet identifier are in, the rest is payload
+//
+//*****************************************************************************
+static void
+mqtt_rx_payload_start(void)
+{
+	mqttClient.ulPayloadLen = mqttClient.ulRxRemaining;
+	mqttClient.ulPayloadOffset = 0;
+	mqttClient.ucRxState = MQTT_RX_PAYLOAD;
+}
+
+//*****************************************************************************
+//
+//! mqtt_rx_topic_end
+//!
+//!  @param  none
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+mqtt_rx_topic_end(void)
+{
+	mqttClient.acTopic[mqttClient.ucTopicPos] = '\0';
+
+	if (mqttClient.ucRxType & 0x06)
+	{
+		mqttClient.ucRxCount = 0;
+		mqttClient.usRxPid = 0;
+		mqttClient.ucRxState = MQTT_RX_PID;
+	}
+	else
+	{
+		mqtt_rx_payload_start();
+	}
+}
+
+//*****************************************************************************
+//
+//! mqtt_rx
+//!
+//!  @param  pucBuf  received bytes
+//!  @param  usLen   number of bytes
+//!
+//!  @return  0 on success, MQTT_ERR_xxx
+//!
+//!  @brief  Push received bytes through the packet parser
+//
+//*****************************************************************************
+static long
+mqtt_rx(const unsigned char *pucBuf, unsigned short usLen)
+{
+	unsigned short usRun;
+	unsigned char c;
+	long res;
+
+	while (usLen)
+	{
+		if (mqttClient.ucRxState == MQTT_RX_PAYLOAD)
+		{
+			usRun = usLen;
+			if (mqttClient.ulRxRemaining < usRun)
+			{
+				usRun = (unsigned short)mqttClient.ulRxRemaining;
+			}
+
+			if (usRun && mqttClient.callback)
+			{
+				mqttClient.callback(mqttClient.acTopic, pucBuf, usRun, mqttClient.ulPayloadOffset,
+					mqttClient.ulPayloadLen, mqttClient.pvContext);
+			}
+			mqttClient.ulPayloadOffset += usRun;
+			mqttClient.ulRxRemaining -= usRun;
+			pucBuf += usRun;
+			usLen -= usRun;
+
+			if (mqttClient.ulRxRemaining == 0)
+			{
+				res = mqtt_rx_complete();
+				if (res < 0)
+				{
+					return res;
+				}
+			}
+			continue;
+		}
+
+		c = *pucBuf++;
+		usLen--;
+
+		if (mqttClient.ucRxState == MQTT_RX_TYPE)
+		{
+			mqttClient.ucRxType = c;
+			mqttClient.ulRxRemaining = 0;
+			mqttClient.ucRxShift = 0;
+			mqttClient.ucRxState = MQTT_RX_LENGTH;
+			continue;
+		}
+
+		if (mqttClient.ucRxState == MQTT_RX_LENGTH)
+		{
+			if (mqttClient.ucRxShift > 21)
+			{
+				return MQTT_ERR_PROTOCOL;
+			}
+			mqttClient.ulRxRemaining |= (unsigned long)(c & 0x7f) << mqttClient.ucRxShift;
+			mqttClient.ucRxShift += 7;
+			if (c & 0x80)
+			{
+				continue;
+			}
+
+			mqttClient.ucRxCount = 0;
+			if ((mqttClient.ucRxType & 0xf0) == MQTT_PUBLISH)
+			{
+				mqttClient.usTopicLen = 0;
+				mqttClient.ucTopicPos = 0;
+				mqttClient.ucRxState = MQTT_RX_TOPIC_LEN;
+			}
+			else
+			{
+				mqttClient.ucRxState = MQTT_RX_BODY;
+			}
+		}
+		else
+		{
+			mqttClient.ulRxRemaining--;
+
+			switch (mqttClient.ucRxState)
+			{
+			case MQTT_RX_TOPIC_LEN:
+				mqttClient.usTopicLen = (mqttClient.usTopicLen << 8) | c;
+				if (++mqttClient.ucRxCount == 2)
+				{
+					if (mqttClient.usTopicLen)
+					{
+						mqttClient.ucRxState = MQTT_RX_TOPIC;
+					}
+					else
+					{
+						mqtt_rx_topic_end();
+					}
+				}
+				break;
+
+			case MQTT_RX_TOPIC:
+				if (mqttClient.ucTopicPos < MQTT_TOPIC_MAX)
+				{
+					mqttClient.acTopic[mqttClient.ucTopicPos++] = c;
+				}
+				if (--mqttClient.usTopicLen == 0)
+				{
+					mqtt_rx_topic_end();
+				}
+				break;
+
+			case MQTT_RX_PID:
+				mqttClient.usRxPid = (mqttClient.usRxPid << 8) | c;
+				if (++mqttClient.ucRxCount == 2)
+				{
+					mqtt_rx_payload_start();
+				}
+				break;
+
+			case MQTT_RX_BODY:
+				if (mqttClient.ucRxCount < MQTT_RX_BODY_MAX)
+				{
+					mqttClient.aucRxBody[mqttClient.ucRxCount++] = c;
+				}
+				break;
+			}
+		}
+
+		// A payload is only complete once the payload state has been
+		// entered, so an empty one still reaches the callback
+		if ((mqttClient.ulRxRemaining == 0) &&
+				((mqttClient.ucRxState != MQTT_RX_PAYLOAD) || (mqttClient.ulPayloadLen == 0)))
+		{
+			res = mqtt_rx_complete();
+			if (res < 0)
+			{
+				return res;
+			}
+		}
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! mqtt_connect
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+long
+mqtt_connect(unsigned long ulIp, unsigned short usPort, const char *pcClientId,
+             const char *pcUser, const char *pcPassword, unsigned short usKeepAlive,
+             tMqttMessageCallback callback, void *pvContext)
+{
+	tMqttPacket packet;
+	sockaddr addr;
+	unsigned long ulStart;
+	unsigned char aucHeader[10];
+	long sd, res;
+
+	mqtt_disconnect();
+
+	sd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (!M_IS_VALID_SD(sd))
+	{
+		return MQTT_ERR_SOCKET;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (usPort >> 8) & 0xff;
+	addr.sa_data[1] = usPort & 0xff;
+	addr.sa_data[2] = (ulIp >> 24) & 0xff;
+	addr.sa_data[3] = (ulIp >> 16) & 0xff;
+	addr.sa_data[4] = (ulIp >> 8) & 0xff;
+	addr.sa_data[5] = ulIp & 0xff;
+
+	if (connect(sd, &addr, sizeof(addr)) != 0)
+	{
+		closesocket(sd);
+		return MQTT_ERR_SOCKET;
+	}
+
+	memset(&mqttClient, 0, sizeof(mqttClient));
+	mqttClient.lSd = sd;
+	mqttClient.callback = callback;
+	mqttClient.pvContext = pvContext;
+	mqttClient.usKeepAlive = usKeepAlive;
+	mqttClient.ucState = MQTT_STATE_CONNECTING;
+	mqttClient.ucRxState = MQTT_RX_TYPE;
+
+	// Variable header: protocol name "MQTT", level 4, flags, keepalive
+	aucHeader[0] = 0;
+	aucHeader[1] = 4;
+	aucHeader[2] = 'M';
+	aucHeader[3] = 'Q';
+	aucHeader[4] = 'T';
+	aucHeader[5] = 'T';
+	aucHeader[6] = 4;
+	aucHeader[7] = MQTT_CONNECT_FLAG_CLEAN;
+	if (pcUser)
+	{
+		aucHeader[7] |= MQTT_CONNECT_FLAG_USER;
+	}
+	if (pcPassword)
+	{
+		aucHeader[7] |= MQTT_CONNECT_FLAG_PASSWORD;
+	}
+	aucHeader[8] = usKeepAlive >> 8;
+	aucHeader[9] = usKeepAlive & 0xff;
+
+	mqtt_packet_init(&packet);
+	mqtt_packet_bytes(&packet, aucHeader, sizeof(aucHeader));
+	res = mqtt_packet_string(&packet, pcClientId);
+	if ((res == 0) && pcUser)
+	{
+		res = mqtt_packet_string(&packet, pcUser);
+	}
+	if ((res == 0) && pcPassword)
+	{
+		res = mqtt_packet_string(&packet, pcPassword);
+	}
+	if (res == 0)
+	{
+		res = mqtt_packet_send(&packet, MQTT_CONNECT);
+	}
+	if (res != 0)
+	{
+		mqtt_close();
+		return res;
+	}
+
+	ulStart = millis();
+	while (mqttClient.ucState == MQTT_STATE_CONNECTING)
+	{
+		if (millis() - ulStart >= MQTT_CONNECT_TIMEOUT_MS)
+		{
+			mqtt_close();
+			return MQTT_ERR_TIMEOUT;
+		}
+
+		res = mqtt_loop(50);
+		if (res < 0)
+		{
+			return res;
+		}
+
+		if (mqttClient.ucConnackCode != 0)
+		{
+			mqtt_close();
+			return MQTT_ERR_REFUSED;
+		}
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! mqtt_disconnect
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+void
+mqtt_disconnect(void)
+{
+	if (mqttClient.ucState == MQTT_STATE_CONNECTED)
+	{
+		mqtt_send_short(MQTT_DISCONNECT, 0, 0);
+	}
+
+	mqtt_close();
+}
+
+//*****************************************************************************
+//
+//! mqtt_connected
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+unsigned char
+mqtt_connected(void)
+{
+	return (mqttClient.ucState == MQTT_STATE_CONNECTED);
+}
+
+//*****************************************************************************
+//
+//! mqtt_publish
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+long
+mqtt_publish(const char *pcTopic, const void *pvData, unsigned short usLen,
+             unsigned char ucQos, unsigned char ucRetain)
+{
+	tMqttPacket packet;
+	unsigned long ulStart;
+	unsigned short usId;
+	unsigned char i, ucSlot;
+	long res;
+
+	if (mqttClient.ucState != MQTT_STATE_CONNECTED)
+	{
+		return MQTT_ERR_NOT_CONNECTED;
+	}
+
+	ulStart = micros();
+
+	usId = 0;
+	ucSlot = 0;
+	if (ucQos)
+	{
+		ucQos = 1;
+		for (i = 0; i < MQTT_INFLIGHT_MAX; i++)
+		{
+			if (mqttClient.inflight[i].usId == 0)
+			{
+				break;
+			}
+		}
+		if (i == MQTT_INFLIGHT_MAX)
+		{
+			mqttStats.ulInflightFull++;
+			return MQTT_ERR_INFLIGHT;
+		}
+		ucSlot = i;
+		usId = mqtt_next_id();
+	}
+
+	mqtt_packet_init(&packet);
+	res = mqtt_packet_string(&packet, pcTopic);
+	if (res != 0)
+	{
+		return res;
+	}
+	if (ucQos)
+	{
+		mqtt_packet_short(&packet, usId);
+	}
+	mqtt_packet_data(&packet, (const unsigned char *)pvData, usLen);
+
+	res = mqtt_packet_send(&packet, MQTT_PUBLISH | (ucQos << 1) | (ucRetain ? 1 : 0));
+	if (res != 0)
+	{
+		return res;
+	}
+
+	if (ucQos)
+	{
+		mqttClient.inflight[ucSlot].usId = usId;
+		mqttClient.inflight[ucSlot].ulSent = millis();
+	}
+
+	mqttStats.ulPublished++;
+	mqttStats.ulPublishMicros += micros() - ulStart;
+
+	return usId;
+}
+
+//*****************************************************************************
+//
+//! mqtt_subscribe
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+long
+mqtt_subscribe(const char *pcTopic, unsigned char ucQos)
+{
+	tMqttPacket packet;
+	unsigned short usId;
+	unsigned char ucOption;
+	long res;
+
+	if (mqttClient.ucState != MQTT_STATE_CONNECTED)
+	{
+		return MQTT_ERR_NOT_CONNECTED;
+	}
+
+	usId = mqtt_next_id();
+	ucOption = (ucQos) ? 1 : 0;
+
+	mqtt_packet_init(&packet);
+	mqtt_packet_short(&packet, usId);
+	res = mqtt_packet_string(&packet, pcTopic);
+	if (res != 0)
+	{
+		return res;
+	}
+	mqtt_packet_bytes(&packet, &ucOption, 1);
+
+	res = mqtt_packet_send(&packet, MQTT_SUBSCRIBE);
+	if (res != 0)
+	{
+		return res;
+	}
+
+	return usId;
+}
+
+//*****************************************************************************
+//
+//! mqtt_inflight
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+unsigned char
+mqtt_inflight(void)
+{
+	unsigned char i, n;
+
+	n = 0;
+	for (i = 0; i < MQTT_INFLIGHT_MAX; i++)
+	{
+		if (mqttClient.inflight[i].usId)
+		{
+			n++;
+		}
+	}
+
+	return n;
+}
+
+//*****************************************************************************
+//
+//! mqtt_loop
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+long
+mqtt_loop(unsigned long ulTimeoutMs)
+{
+	unsigned char aucBuf[MQTT_RECV_BUF];
+	TICC3000fd_set readsds;
+	timeval timeout;
+	unsigned long ulNow, ulKeepAliveMs;
+	unsigned char i;
+	long sd, res;
+	int len;
+
+	if (mqttClient.ucState == MQTT_STATE_CLOSED)
+	{
+		return MQTT_ERR_NOT_CONNECTED;
+	}
+	sd = mqttClient.lSd;
+
+	ulNow = millis();
+
+	for (i = 0; i < MQTT_INFLIGHT_MAX; i++)
+	{
+		if (mqttClient.inflight[i].usId &&
+				(ulNow - mqttClient.inflight[i].ulSent >= MQTT_ACK_TIMEOUT_MS))
+		{
+			mqttClient.inflight[i].usId = 0;
+			mqttStats.ulLost++;
+		}
+	}
+
+	// Keepalive: ping once the link has been quiet for a period, give up
+	// if the answer takes another one
+	if (mqttClient.usKeepAlive && (mqttClient.ucState == MQTT_STATE_CONNECTED))
+	{
+		ulKeepAliveMs = (unsigned long)mqttClient.usKeepAlive * 1000;
+
+		if (mqttClient.ucPingPending)
+		{
+			if (ulNow - mqttClient.ulPingSent >= ulKeepAliveMs)
+			{
+				mqtt_close();
+				return MQTT_ERR_TIMEOUT;
+			}
+		}
+		else if (ulNow - mqttClient.ulLastSent >= ulKeepAliveMs)
+		{
+			if (mqtt_send_short(MQTT_PINGREQ, 0, 0) != 0)
+			{
+				mqtt_close();
+				return MQTT_ERR_SEND;
+			}
+			mqttClient.ucPingPending = 1;
+			mqttClient.ulPingSent = ulNow;
+			mqttStats.ulPings++;
+		}
+	}
+
+	FD_ZERO(&readsds);
+	FD_SET(sd, &readsds);
+	timeout.tv_sec = ulTimeoutMs / 1000;
+	timeout.tv_usec = (ulTimeoutMs % 1000) * 1000;
+
+	res = select(sd + 1, &readsds, NULL, NULL, &timeout);
+	if ((res <= 0) || !FD_ISSET(sd, &readsds))
+	{
+		return 0;
+	}
+
+	len = recv(sd, aucBuf, sizeof(aucBuf), 0);
+	if (len <= 0)
+	{
+		mqtt_close();
+		return MQTT_ERR_CLOSED;
+	}
+	mqttStats.ulBytesIn += len;
+
+	res = mqtt_rx(aucBuf, len);
+	if (res < 0)
+	{
+		mqtt_close();
+		return res;
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! mqtt_get_stats
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+void
+mqtt_get_stats(tMqttStats *pStats)
+{
+	memcpy(pStats, &mqttStats, sizeof(tMqttStats));
+}
+
+//*****************************************************************************
+//
+//! mqtt_reset_stats
+//!
+//!  @brief  see mqtt.h
+//
+//*****************************************************************************
+void
+mqtt_reset_stats(void)
+{
+	memset(&mqttStats, 0, sizeof(tMqttStats));
+}
+
+#endif	// CC3000_TINY_DRIVER
@@ -0,0 +1,246 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a small MQTT 3.1.1 client. Packets are encoded straight
+*  into the driver's TX buffer and incoming publishes are parsed as they
+*  are received, so neither direction needs a packet buffer: the payload
+*  of a received message is handed to the callback in pieces. QoS 0 and 1
+*  are supported, with a small table of QoS 1 publishes waiting for their
+*  PUBACK. Keepalive is driven from mqtt_loop() and never blocks.
+*
+****************************************************************************/
+#ifndef __MQTT_H__
+#define __MQTT_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// QoS 1 publishes that can wait for a PUBACK at once. mqtt_publish returns
+// MQTT_ERR_INFLIGHT while the table is full
+#ifndef MQTT_INFLIGHT_MAX
+#define MQTT_INFLIGHT_MAX			(4)
+#endif
+
+// A QoS 1 publish not acknowledged in this time is given up and counted in
+// ulLost. The payload isn't kept, so it is up to the sketch to send again
+#ifndef MQTT_ACK_TIMEOUT_MS
+#define MQTT_ACK_TIMEOUT_MS			(5000UL)
+#endif
+
+// Received topics longer than this are truncated before they are handed
+// to the message callback
+#ifndef MQTT_TOPIC_MAX
+#define MQTT_TOPIC_MAX				(32)
+#endif
+
+// Bytes read from the socket per recv()
+#ifndef MQTT_RECV_BUF
+#define MQTT_RECV_BUF				(64)
+#endif
+
+// Longest wait for the CONNACK
+#ifndef MQTT_CONNECT_TIMEOUT_MS
+#define MQTT_CONNECT_TIMEOUT_MS		(5000UL)
+#endif
+
+//--------- Errors --------
+
+#define MQTT_ERR_SOCKET				(-1)	// no socket, or TCP connect failed
+#define MQTT_ERR_SEND				(-2)
+#define MQTT_ERR_REFUSED			(-3)	// CONNACK with a non-zero return code
+#define MQTT_ERR_TIMEOUT			(-4)	// no CONNACK, or no PINGRESP within the keepalive
+#define MQTT_ERR_NOT_CONNECTED		(-5)
+#define MQTT_ERR_INFLIGHT			(-6)	// QoS 1 table full, try again after mqtt_loop
+#define MQTT_ERR_PROTOCOL			(-7)	// malformed packet from the broker
+#define MQTT_ERR_CLOSED				(-8)	// broker closed the connection
+#define MQTT_ERR_TOO_LONG			(-9)	// topic or client id over 65535 bytes
+
+// Received message callback. A payload larger than one recv() comes in
+// several calls: ulOffset is where pucData starts within the payload and
+// ulTotal is the whole payload length, so the message is complete when
+// ulOffset + usLen == ulTotal. An empty payload gives one call with usLen 0
+typedef void (*tMqttMessageCallback)(const char *pcTopic, const unsigned char *pucData,
+                                     unsigned short usLen, unsigned long ulOffset,
+                                     unsigned long ulTotal, void *pvContext);
+
+typedef struct _mqtt_stats_t
+{
+	unsigned long	ulPublished;			// PUBLISH packets sent
+	unsigned long	ulAcked;				// PUBACKs matched to the inflight table
+	unsigned long	ulLost;					// QoS 1 publishes never acknowledged
+	unsigned long	ulInflightFull;			// publishes refused, table full
+	unsigned long	ulReceived;				// PUBLISH packets received
+	unsigned long	ulPings;				// PINGREQs sent
+	unsigned long	ulBytesOut;
+	unsigned long	ulBytesIn;
+	unsigned long	ulAckMillis;			// total PUBLISH to PUBACK time
+	unsigned long	ulMaxAckMillis;
+	unsigned long	ulPublishMicros;		// total time spent in mqtt_publish
+} tMqttStats;
+
+
+//*****************************************************************************
+//
+//! mqtt_connect
+//!
+//!  @param  ulIp          broker address, as from gethostbyname
+//!  @param  usPort        broker port, normally 1883
+//!  @param  pcClientId    client identifier
+//!  @param  pcUser        user name, or NULL
+//!  @param  pcPassword    password, or NULL
+//!  @param  usKeepAlive   keepalive in seconds, 0 for none
+//!  @param  callback      received message callback, or NULL
+//!  @param  pvContext     passed to the callback
+//!
+//!  @return  0 on success, MQTT_ERR_xxx otherwise
+//!
+//!  @brief  Open a TCP connection to the broker, send CONNECT with a clean
+//!          session and wait for the CONNACK. Only one connection is kept;
+//!          an open one is closed first.
+//
+//*****************************************************************************
+extern long mqtt_connect(unsigned long ulIp, unsigned short usPort, const char *pcClientId,
+                         const char *pcUser, const char *pcPassword,
+                         unsigned short usKeepAlive, tMqttMessageCallback callback,
+                         void *pvContext);
+
+//*****************************************************************************
+//
+//! mqtt_disconnect
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Send DISCONNECT and close the socket
+//
+//*****************************************************************************
+extern void mqtt_disconnect(void);
+
+//*****************************************************************************
+//
+//! mqtt_connected
+//!
+//!  @param  none
+//!
+//!  @return  1 while connected to the broker, 0 otherwise
+//
+//*****************************************************************************
+extern unsigned char mqtt_connected(void);
+
+//*****************************************************************************
+//
+//! mqtt_publish
+//!
+//!  @param  pcTopic   topic name
+//!  @param  pvData    payload
+//!  @param  usLen     payload length
+//!  @param  ucQos     0 or 1
+//!  @param  ucRetain  1 to have the broker retain the message
+//!
+//!  @return  the packet identifier for QoS 1, 0 for QoS 0, or MQTT_ERR_xxx
+//!
+//!  @brief  Publish a message. The packet is written directly into the TX
+//!          buffer; payloads too large for one buffer are sent with
+//!          send_stream. QoS 1 publishes stay in the inflight table until
+//!          the PUBACK is read by mqtt_loop.
+//
+//*****************************************************************************
+extern long mqtt_publish(const char *pcTopic, const void *pvData, unsigned short usLen,
+                         unsigned char ucQos, unsigned char ucRetain);
+
+//*****************************************************************************
+//
+//! mqtt_subscribe
+//!
+//!  @param  pcTopic  topic filter
+//!  @param  ucQos    largest QoS wanted, 0 or 1
+//!
+//!  @return  the packet identifier, or MQTT_ERR_xxx
+//!
+//!  @brief  Send SUBSCRIBE. The SUBACK is read (and otherwise ignored) by
+//!          mqtt_loop
+//
+//*****************************************************************************
+extern long mqtt_subscribe(const char *pcTopic, unsigned char ucQos);
+
+//*****************************************************************************
+//
+//! mqtt_inflight
+//!
+//!  @param  none
+//!
+//!  @return  number of QoS 1 publishes waiting for a PUBACK
+//
+//*****************************************************************************
+extern unsigned char mqtt_inflight(void);
+
+//*****************************************************************************
+//
+//! mqtt_loop
+//!
+//!  @param  ulTimeoutMs  longest wait for data from the broker, 0 to poll
+//!
+//!  @return  0 while connected, MQTT_ERR_xxx once the connection is lost
+//!
+//!  @brief  Read and handle whatever the broker sent: messages go to the
+//!          callback and are acknowledged, PUBACKs free the inflight
+//!          table. Also sends PINGREQ when nothing has been sent for the
+//!          keepalive period and gives up on the connection if the
+//!          PINGRESP doesn't come back within another period. Call it
+//!          often, at least a few times per keepalive.
+//
+//*****************************************************************************
+extern long mqtt_loop(unsigned long ulTimeoutMs);
+
+//*****************************************************************************
+//
+//! mqtt_get_stats
+//!
+//!  @param[out]  pStats  filled with a copy of the client counters
+//!
+//!  @return  none
+//!
+//!  @brief  mqtt_reset_stats() zeroes the counters.
+//
+//*****************************************************************************
+extern void mqtt_get_stats(tMqttStats *pStats);
+extern void mqtt_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __MQTT_H__
@@ -18,6 +18,8 @@
 *  if any, are listed below:
 *
    + #include <arduino.h> added
+   
+   + Added nvmem_crc and nvmem_check
 * 
 ****************************************************************************/
 
@@ -362,6 +364,53 @@ nvmem_create_entry(unsigned long ulFileId, unsigned long ulNewLen)
 	return(retval);
 }
 
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//!  nvmem_crc
+//!
+//!  @brief  see nvmem.h
+//
+//*****************************************************************************
+unsigned short
+nvmem_crc(const unsigned char *pucData, long lLen)
+{
+	unsigned short usCrc = 0xffff;
+	unsigned char i;
+	
+	while (lLen-- > 0)
+	{
+		usCrc ^= (unsigned short)*pucData++ << 8;
+		for (i = 0; i < 8; i++)
+		{
+			usCrc = (usCrc & 0x8000) ? (usCrc << 1) ^ 0x1021 : (usCrc << 1);
+		}
+	}
+	
+	return usCrc;
+}
+
+//*****************************************************************************
+//
+//!  nvmem_check
+//!
+//!  @brief  see nvmem.h
+//
+//*****************************************************************************
+unsigned char
+nvmem_check(const unsigned char *pucData, unsigned char ucLen)
+{
+	unsigned char i, ucSum = 0xA5;
+	
+	for (i = 0; i < ucLen; i++)
+	{
+		ucSum = (ucSum << 1 | ucSum >> 7) ^ pucData[i];
+	}
+	
+	return ucSum;
+}
+#endif
+
 
 
 //*****************************************************************************
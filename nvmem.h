@@ -17,7 +17,7 @@
 *  reference library. Changes to the reference library file,
 *  if any, are listed below:
 *
-*  No changes to this file.
+*  + Added nvmem_crc and nvmem_check for records kept in user files
 * 
 ****************************************************************************/
 
@@ -257,6 +257,38 @@ extern	unsigned char nvmem_read_sp_version(unsigned char* patchVer);
 //*****************************************************************************
 extern signed long nvmem_create_entry(unsigned long file_id, unsigned long newlen);
 
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//!  nvmem_crc
+//!
+//!  @param  pucData  data
+//!  @param  lLen     data length
+//!
+//!  @return  CRC-16/CCITT of the data
+//!
+//!  @brief  Identify an SSID or key in a user file record without storing
+//!          the bytes themselves
+//
+//*****************************************************************************
+extern unsigned short nvmem_crc(const unsigned char *pucData, long lLen);
+
+//*****************************************************************************
+//
+//!  nvmem_check
+//!
+//!  @param  pucData  data
+//!  @param  ucLen    data length
+//!
+//!  @return  check byte over the data
+//!
+//!  @brief  Check byte for a user file record, so a record that was never
+//!          written or was only partly written reads as invalid
+//
+//*****************************************************************************
+extern unsigned char nvmem_check(const unsigned char *pucData, unsigned char ucLen);
+#endif
+
 
 //*****************************************************************************
 //
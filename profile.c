@@ -0,0 +1,602 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Profile table mirror, see profile.h
+*
+*  NVMEM reads and writes have to fit in the SPI buffers, so the file is a
+*  small header followed by one record per slot, each with its own check
+*  byte, and only the records that change are written. In RAM each slot
+*  is kept as checksums of the SSID and key, like the fast-reconnect
+*  cache; the SSID text is only read back for profile_get and to confirm
+*  a checksum match.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "wlan.h"
+#include "nvmem.h"
+#include "profile.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#define PROFILE_MAGIC				(0xB7)
+
+#define PROFILE_FLAG_KNOWN			(0x01)	// the mirror matches the CC3000 exactly
+
+// wlan_ioctl_del_profile index that deletes every profile
+#define PROFILE_DELETE_ALL			(255)
+
+// wlan_add_profile cipher arguments for WPA / WPA2, from TI's examples
+#define PROFILE_WPA_PAIRWISE		(0x18)
+#define PROFILE_WPA_GROUP			(0x1e)
+#define PROFILE_WPA_KEY_MGMT		(0x2)
+
+typedef struct _profile_slot_t
+{
+	unsigned short	usSsidCrc;
+	unsigned short	usKeyCrc;				// the key stays in the CC3000 only
+	unsigned char	ucSsidLen;
+	unsigned char	ucSecType;
+	unsigned char	ucPriority;
+	unsigned char	ucUsed;
+} tProfileSlot;
+
+typedef struct _profile_header_t
+{
+	unsigned char	ucCheck;
+	unsigned char	ucMagic;
+	unsigned char	ucFlags;
+	unsigned char	ucReserved;
+} tProfileHeader;
+
+typedef struct _profile_record_t
+{
+	unsigned char	ucCheck;
+	unsigned char	ucReserved;
+	tProfileSlot	slot;
+	char			acSsid[32];
+} tProfileRecord;
+
+#define PROFILE_RECORD_OFFSET(i)	(sizeof(tProfileHeader) + (i) * sizeof(tProfileRecord))
+#define PROFILE_FILE_LEN			PROFILE_RECORD_OFFSET(PROFILE_SLOTS)
+
+typedef struct _profile_state_t
+{
+	tProfileSlot	aSlots[PROFILE_SLOTS];
+	unsigned char	ucFlags;
+	unsigned char	ucLoaded;
+} tProfileState;
+
+
+static tProfileState	profileState;
+static tProfileStats	profileStats;
+
+
+//*****************************************************************************
+//
+//! profile_load
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Read the mirror from NVMEM the first time it is needed. A
+//!          missing or damaged header reads as "not known", a missing or
+//!          damaged record as an empty slot
+//
+//*****************************************************************************
+static void
+profile_load(void)
+{
+	tProfileHeader header;
+	tProfileRecord record;
+	unsigned char i;
+
+	if (profileState.ucLoaded)
+	{
+		return;
+	}
+
+	memset(&profileState, 0, sizeof(profileState));
+
+	if ((nvmem_read(PROFILE_FILEID, sizeof(header), 0, (unsigned char *)&header) == 0) &&
+			(header.ucMagic == PROFILE_MAGIC) &&
+			(header.ucCheck == nvmem_check((unsigned char *)&header + 1, sizeof(header) - 1)))
+	{
+		profileState.ucFlags = header.ucFlags;
+	}
+
+	for (i = 0; i < PROFILE_SLOTS; i++)
+	{
+		if ((nvmem_read(PROFILE_FILEID, sizeof(record), PROFILE_RECORD_OFFSET(i),
+					(unsigned char *)&record) == 0) &&
+				(record.ucCheck == nvmem_check((unsigned char *)&record + 1, sizeof(record) - 1)) &&
+				record.slot.ucUsed)
+		{
+			memcpy(&profileState.aSlots[i], &record.slot, sizeof(tProfileSlot));
+		}
+	}
+
+	profileState.ucLoaded = 1;
+}
+
+//*****************************************************************************
+//
+//! profile_write
+//!
+//!  @param  ulOffset  offset in the file
+//!  @param  ucLen     length
+//!  @param  pucData   data
+//!
+//!  @return  0 on success, PROFILE_ERR_NVMEM
+//!
+//!  @brief  Write part of the file, creating the file the first time
+//
+//*****************************************************************************
+static long
+profile_write(unsigned long ulOffset, unsigned char ucLen, unsigned char *pucData)
+{
+	profileStats.ulNvmemWrites++;
+
+	if (nvmem_write(PROFILE_FILEID, ucLen, ulOffset, pucData) == 0)
+	{
+		return 0;
+	}
+
+	nvmem_create_entry(PROFILE_FILEID, PROFILE_FILE_LEN);
+	if (nvmem_write(PROFILE_FILEID, ucLen, ulOffset, pucData) == 0)
+	{
+		return 0;
+	}
+
+	return PROFILE_ERR_NVMEM;
+}
+
+//*****************************************************************************
+//
+//! profile_save_header
+//!
+//!  @param  none
+//!
+//!  @return  0 on success, PROFILE_ERR_NVMEM
+//
+//*****************************************************************************
+static long
+profile_save_header(void)
+{
+	tProfileHeader header;
+
+	header.ucMagic = PROFILE_MAGIC;
+	header.ucFlags = profileState.ucFlags;
+	header.ucReserved = 0;
+	header.ucCheck = nvmem_check((unsigned char *)&header + 1, sizeof(header) - 1);
+
+	return profile_write(0, sizeof(header), (unsigned char *)&header);
+}
+
+//*****************************************************************************
+//
+//! profile_save_slot
+//!
+//!  @param  ucIndex  slot
+//!  @param  ssid     SSID text, or NULL for an empty slot
+//!
+//!  @return  0 on success, PROFILE_ERR_NVMEM
+//
+//*****************************************************************************
+static long
+profile_save_slot(unsigned char ucIndex, const char *ssid)
+{
+	tProfileRecord record;
+
+	memset(&record, 0, sizeof(record));
+	memcpy(&record.slot, &profileState.aSlots[ucIndex], sizeof(tProfileSlot));
+	if (ssid != NULL)
+	{
+		memcpy(record.acSsid, ssid, record.slot.ucSsidLen);
+	}
+	record.ucCheck = nvmem_check((unsigned char *)&record + 1, sizeof(record) - 1);
+
+	return profile_write(PROFILE_RECORD_OFFSET(ucIndex), sizeof(record),
+		(unsigned char *)&record);
+}
+
+//*****************************************************************************
+//
+//! profile_lookup
+//!
+//!  @param  ssid       SSID
+//!  @param  ucSsidLen  length of the SSID
+//!  @param  usSsidCrc  CRC of the SSID
+//!
+//!  @return  slot holding the SSID, -1 if none
+//!
+//!  @brief  Slots are matched on the CRC first; a match is confirmed
+//!          against the SSID text in the slot's record, so a CRC collision
+//!          can't be taken for the same network. If the record can't be
+//!          read the CRC is trusted.
+//
+//*****************************************************************************
+static long
+profile_lookup(const char *ssid, unsigned char ucSsidLen, unsigned short usSsidCrc)
+{
+	tProfileRecord record;
+	unsigned char i;
+
+	for (i = 0; i < PROFILE_SLOTS; i++)
+	{
+		if (!profileState.aSlots[i].ucUsed ||
+				(profileState.aSlots[i].ucSsidLen != ucSsidLen) ||
+				(profileState.aSlots[i].usSsidCrc != usSsidCrc))
+		{
+			continue;
+		}
+
+		if ((nvmem_read(PROFILE_FILEID, sizeof(record), PROFILE_RECORD_OFFSET(i),
+					(unsigned char *)&record) != 0) ||
+				(record.ucCheck != nvmem_check((unsigned char *)&record + 1, sizeof(record) - 1)) ||
+				(memcmp(record.acSsid, ssid, ucSsidLen) == 0))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+//*****************************************************************************
+//
+//! profile_add
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_add(unsigned long ulSecType, char *ssid, long ssid_len, unsigned long ulPriority,
+            unsigned char *key, long key_len)
+{
+	tProfileSlot *pSlot;
+	unsigned long ulPairwise, ulGroup, ulKeyMgmt;
+	unsigned short usSsidCrc, usKeyCrc;
+	long res;
+
+	if ((ulSecType > WLAN_SEC_WPA2) || (ssid_len <= 0) || (ssid_len > 32) ||
+			(key_len < 0) || (ulPriority > 0xff))
+	{
+		return PROFILE_ERR_PARAM;
+	}
+
+	profile_load();
+
+	usSsidCrc = nvmem_crc((unsigned char *)ssid, ssid_len);
+	usKeyCrc = nvmem_crc(key, key_len);
+
+	res = profile_lookup(ssid, (unsigned char)ssid_len, usSsidCrc);
+	if (res >= 0)
+	{
+		pSlot = &profileState.aSlots[res];
+		if ((pSlot->ucSecType == ulSecType) && (pSlot->ucPriority == ulPriority) &&
+				(pSlot->usKeyCrc == usKeyCrc))
+		{
+			profileStats.ulAvoided++;
+			return res;
+		}
+
+		res = profile_delete((unsigned char)res);
+		if (res < 0)
+		{
+			return res;
+		}
+	}
+
+	switch (ulSecType)
+	{
+	case WLAN_SEC_WEP:
+		ulPairwise = key_len;
+		ulGroup = 0;
+		ulKeyMgmt = 0;
+		break;
+
+	case WLAN_SEC_WPA:
+	case WLAN_SEC_WPA2:
+		ulPairwise = PROFILE_WPA_PAIRWISE;
+		ulGroup = PROFILE_WPA_GROUP;
+		ulKeyMgmt = PROFILE_WPA_KEY_MGMT;
+		break;
+
+	default:
+		ulPairwise = 0;
+		ulGroup = 0;
+		ulKeyMgmt = 0;
+		break;
+	}
+
+	// Returns the slot used, or 255 if there was none free
+	profileStats.ulIoctls++;
+	res = wlan_add_profile(ulSecType, (unsigned char *)ssid, ssid_len, NULL, ulPriority,
+		ulPairwise, ulGroup, ulKeyMgmt, key, key_len);
+	if ((res < 0) || (res >= PROFILE_SLOTS))
+	{
+		return PROFILE_ERR_FULL;
+	}
+
+	pSlot = &profileState.aSlots[res];
+	pSlot->usSsidCrc = usSsidCrc;
+	pSlot->usKeyCrc = usKeyCrc;
+	pSlot->ucSsidLen = (unsigned char)ssid_len;
+	pSlot->ucSecType = (unsigned char)ulSecType;
+	pSlot->ucPriority = (unsigned char)ulPriority;
+	pSlot->ucUsed = 1;
+
+	if (profile_save_slot((unsigned char)res, ssid) != 0)
+	{
+		return PROFILE_ERR_NVMEM;
+	}
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! profile_delete
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_delete(unsigned char ucIndex)
+{
+	if (ucIndex >= PROFILE_SLOTS)
+	{
+		return PROFILE_ERR_PARAM;
+	}
+
+	profile_load();
+
+	if (!profileState.aSlots[ucIndex].ucUsed && (profileState.ucFlags & PROFILE_FLAG_KNOWN))
+	{
+		profileStats.ulAvoided++;
+		return 0;
+	}
+
+	profileStats.ulIoctls++;
+	if (wlan_ioctl_del_profile(ucIndex) != 0)
+	{
+		return PROFILE_ERR_IOCTL;
+	}
+
+	if (profileState.aSlots[ucIndex].ucUsed)
+	{
+		memset(&profileState.aSlots[ucIndex], 0, sizeof(tProfileSlot));
+		return profile_save_slot(ucIndex, NULL);
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! profile_delete_ssid
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_delete_ssid(char *ssid, long ssid_len)
+{
+	long res;
+
+	res = profile_find(ssid, ssid_len);
+	if (res < 0)
+	{
+		return res;
+	}
+
+	return profile_delete((unsigned char)res);
+}
+
+//*****************************************************************************
+//
+//! profile_delete_all
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_delete_all(void)
+{
+	unsigned char i;
+	long res;
+
+	profile_load();
+
+	if ((profileState.ucFlags & PROFILE_FLAG_KNOWN) && (profile_count() == 0))
+	{
+		profileStats.ulAvoided++;
+		return 0;
+	}
+
+	profileStats.ulIoctls++;
+	if (wlan_ioctl_del_profile(PROFILE_DELETE_ALL) != 0)
+	{
+		return PROFILE_ERR_IOCTL;
+	}
+
+	res = 0;
+	for (i = 0; i < PROFILE_SLOTS; i++)
+	{
+		if (profileState.aSlots[i].ucUsed)
+		{
+			memset(&profileState.aSlots[i], 0, sizeof(tProfileSlot));
+			if (profile_save_slot(i, NULL) != 0)
+			{
+				res = PROFILE_ERR_NVMEM;
+			}
+		}
+	}
+
+	if (!(profileState.ucFlags & PROFILE_FLAG_KNOWN))
+	{
+		profileState.ucFlags |= PROFILE_FLAG_KNOWN;
+		if (profile_save_header() != 0)
+		{
+			res = PROFILE_ERR_NVMEM;
+		}
+	}
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! profile_find
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_find(char *ssid, long ssid_len)
+{
+	long res;
+
+	if ((ssid_len <= 0) || (ssid_len > 32))
+	{
+		return PROFILE_ERR_NOT_FOUND;
+	}
+
+	profile_load();
+
+	res = profile_lookup(ssid, (unsigned char)ssid_len,
+		nvmem_crc((unsigned char *)ssid, ssid_len));
+
+	return (res < 0) ? PROFILE_ERR_NOT_FOUND : res;
+}
+
+//*****************************************************************************
+//
+//! profile_get
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_get(unsigned char ucIndex, tProfileEntry *pEntry)
+{
+	tProfileRecord record;
+
+	if (ucIndex >= PROFILE_SLOTS)
+	{
+		return PROFILE_ERR_PARAM;
+	}
+
+	profile_load();
+
+	if (!profileState.aSlots[ucIndex].ucUsed)
+	{
+		return PROFILE_ERR_NOT_FOUND;
+	}
+
+	if ((nvmem_read(PROFILE_FILEID, sizeof(record), PROFILE_RECORD_OFFSET(ucIndex),
+				(unsigned char *)&record) != 0) ||
+			(record.ucCheck != nvmem_check((unsigned char *)&record + 1, sizeof(record) - 1)))
+	{
+		return PROFILE_ERR_NVMEM;
+	}
+
+	memset(pEntry, 0, sizeof(tProfileEntry));
+	memcpy(pEntry->acSsid, record.acSsid, record.slot.ucSsidLen);
+	pEntry->ucSsidLen = record.slot.ucSsidLen;
+	pEntry->ucSecType = record.slot.ucSecType;
+	pEntry->ucPriority = record.slot.ucPriority;
+	pEntry->ucIndex = ucIndex;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! profile_count
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+unsigned char
+profile_count(void)
+{
+	unsigned char i, ucCount;
+
+	profile_load();
+
+	ucCount = 0;
+	for (i = 0; i < PROFILE_SLOTS; i++)
+	{
+		ucCount += profileState.aSlots[i].ucUsed;
+	}
+
+	return ucCount;
+}
+
+//*****************************************************************************
+//
+//! profile_invalidate
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+long
+profile_invalidate(void)
+{
+	profile_load();
+
+	if (!(profileState.ucFlags & PROFILE_FLAG_KNOWN))
+	{
+		return 0;
+	}
+
+	profileState.ucFlags &= ~PROFILE_FLAG_KNOWN;
+
+	return profile_save_header();
+}
+
+//*****************************************************************************
+//
+//! profile_get_stats
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+void
+profile_get_stats(tProfileStats *pStats)
+{
+	memcpy(pStats, &profileStats, sizeof(tProfileStats));
+}
+
+//*****************************************************************************
+//
+//! profile_reset_stats
+//!
+//!  @brief  see profile.h
+//
+//*****************************************************************************
+void
+profile_reset_stats(void)
+{
+	memset(&profileStats, 0, sizeof(profileStats));
+}
+
+#endif	// CC3000_TINY_DRIVER
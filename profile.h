@@ -0,0 +1,239 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a host-side mirror of the CC3000 profile table. The
+*  CC3000 has no way to read its profiles back, so every add or delete
+*  has to be a blind HCI call. The mirror remembers which slot holds
+*  which SSID, security type and priority (and a checksum of the key) in
+*  CC3000 NVMEM user file 15, so adding a profile that is already stored,
+*  or deleting one that isn't, never reaches the radio.
+*
+*  The mirror only knows about changes made through it. After anything
+*  else changes the profile table (Smart Config, or wlan_add_profile /
+*  wlan_ioctl_del_profile called directly) call profile_invalidate.
+*
+****************************************************************************/
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+#include "wlan.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// CC3000 NVMEM user file holding the mirror
+#ifndef PROFILE_FILEID
+#define PROFILE_FILEID				(15)
+#endif
+
+// Profile slots in the CC3000
+#define PROFILE_SLOTS				(7)
+
+//--------- Errors --------
+
+#define PROFILE_ERR_PARAM			(-1)	// bad index, SSID or security type
+#define PROFILE_ERR_FULL			(-2)	// the CC3000 has no free slot
+#define PROFILE_ERR_IOCTL			(-3)	// the CC3000 refused the request
+#define PROFILE_ERR_NOT_FOUND		(-4)	// no such profile in the mirror
+#define PROFILE_ERR_NVMEM			(-5)	// the mirror couldn't be saved
+
+typedef struct _profile_entry_t
+{
+	char			acSsid[32];
+	unsigned char	ucSsidLen;
+	unsigned char	ucSecType;				// WLAN_SEC_xxx
+	unsigned char	ucPriority;
+	unsigned char	ucIndex;				// CC3000 slot, 0 to PROFILE_SLOTS - 1
+} tProfileEntry;
+
+typedef struct _profile_stats_t
+{
+	unsigned long	ulIoctls;				// profile adds and deletes sent to the CC3000
+	unsigned long	ulAvoided;				// requests answered from the mirror alone
+	unsigned long	ulNvmemWrites;			// mirror records written
+} tProfileStats;
+
+
+//*****************************************************************************
+//
+//! profile_add
+//!
+//!  @param[in]  ulSecType   WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or
+//!                          WLAN_SEC_WPA2
+//!  @param[in]  ssid        SSID, up to 32 bytes
+//!  @param[in]  ssid_len    length of the SSID
+//!  @param[in]  ulPriority  profile priority, 0 is lowest
+//!  @param[in]  key         security key. For WEP, the 4 keys one after the
+//!                          other, key_len bytes each.
+//!  @param[in]  key_len     key length
+//!
+//!  @return  CC3000 slot the profile is stored in, PROFILE_ERR_xxx otherwise
+//!
+//!  @brief  Store a profile unless the same one is already stored. A
+//!          profile with the same SSID but a different security type, key
+//!          or priority is deleted first, so an SSID is never stored twice.
+//
+//*****************************************************************************
+extern long profile_add(unsigned long ulSecType, char *ssid, long ssid_len,
+                        unsigned long ulPriority, unsigned char *key, long key_len);
+
+//*****************************************************************************
+//
+//! profile_delete
+//!
+//!  @param  ucIndex  CC3000 slot, 0 to PROFILE_SLOTS - 1
+//!
+//!  @return  0 on success, PROFILE_ERR_xxx otherwise
+//!
+//!  @brief  Delete a profile. Nothing is sent if the mirror knows the slot
+//!          is empty.
+//
+//*****************************************************************************
+extern long profile_delete(unsigned char ucIndex);
+
+//*****************************************************************************
+//
+//! profile_delete_ssid
+//!
+//!  @param  ssid      SSID
+//!  @param  ssid_len  length of the SSID
+//!
+//!  @return  0 on success, PROFILE_ERR_xxx otherwise
+//!
+//!  @brief  Delete the profile stored for an SSID
+//
+//*****************************************************************************
+extern long profile_delete_ssid(char *ssid, long ssid_len);
+
+//*****************************************************************************
+//
+//! profile_delete_all
+//!
+//!  @param  none
+//!
+//!  @return  0 on success, PROFILE_ERR_xxx otherwise
+//!
+//!  @brief  Delete every profile. Nothing is sent if the mirror knows the
+//!          table is already empty.
+//
+//*****************************************************************************
+extern long profile_delete_all(void);
+
+//*****************************************************************************
+//
+//! profile_find
+//!
+//!  @param  ssid      SSID
+//!  @param  ssid_len  length of the SSID
+//!
+//!  @return  CC3000 slot holding the SSID, PROFILE_ERR_NOT_FOUND
+//!
+//!  @brief  Look an SSID up in the mirror. No profile ioctl is sent; a
+//!          match is confirmed with one NVMEM read.
+//
+//*****************************************************************************
+extern long profile_find(char *ssid, long ssid_len);
+
+//*****************************************************************************
+//
+//! profile_get
+//!
+//!  @param[in]   ucIndex  CC3000 slot, 0 to PROFILE_SLOTS - 1
+//!  @param[out]  pEntry   the profile
+//!
+//!  @return  0 on success, PROFILE_ERR_xxx otherwise
+//!
+//!  @brief  Read one profile from the mirror. The SSID text is kept in
+//!          NVMEM only, so this reads the mirror file.
+//
+//*****************************************************************************
+extern long profile_get(unsigned char ucIndex, tProfileEntry *pEntry);
+
+//*****************************************************************************
+//
+//! profile_count
+//!
+//!  @param  none
+//!
+//!  @return  number of profiles in the mirror
+//
+//*****************************************************************************
+extern unsigned char profile_count(void);
+
+//*****************************************************************************
+//
+//! profile_invalidate
+//!
+//!  @param  none
+//!
+//!  @return  0 on success, PROFILE_ERR_NVMEM
+//!
+//!  @brief  Note that the profile table was changed behind the mirror's
+//!          back. The profiles in the mirror are kept, but the next
+//!          profile_delete_all or delete of an empty slot is sent to the
+//!          CC3000 rather than skipped.
+//
+//*****************************************************************************
+extern long profile_invalidate(void);
+
+//*****************************************************************************
+//
+//! profile_get_stats
+//!
+//!  @param[out]  pStats  copy of the statistics
+//!
+//!  @return  none
+//!
+//!  @brief  Read the mirror statistics
+//
+//*****************************************************************************
+extern void profile_get_stats(tProfileStats *pStats);
+
+//*****************************************************************************
+//
+//! profile_reset_stats
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Clear the statistics
+//
+//*****************************************************************************
+extern void profile_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __PROFILE_H__
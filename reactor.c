@@ -0,0 +1,449 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Event loop for multi-socket servers, see reactor.h
+*
+*  The CC3000 only gives us select(), the non-blocking socket options and
+*  the HCI_EVNT_BSD_TCP_CLOSE_WAIT event, and every one of those is a full
+*  SPI round trip. So a pass of the loop is kept to one select() for all
+*  the connected sockets plus one accept() per listener, and the number of
+*  handlers called per pass is capped so one busy socket can't hold up
+*  the rest of the sketch.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "reactor.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+typedef struct _reactor_entry_t
+{
+	tReactorHandler	handler;
+	unsigned char	ucEvents;		// events of interest
+	unsigned char	ucReady;		// events waiting to be dispatched
+	signed char		cAcceptSd;		// socket returned by accept() for REACTOR_EVENT_ACCEPT
+} tReactorEntry;
+
+
+static tReactorEntry	reactorTable[REACTOR_MAX_SOCKETS];
+static unsigned char	ucReactorCursor = 0;
+static unsigned char	ucReactorBudget = REACTOR_DEFAULT_BUDGET;
+static tReactorStats	reactorStats;
+
+
+//*****************************************************************************
+//
+//! reactor_set_nonblock
+//!
+//!  @param  sd       socket handle
+//!  @param  optname  SOCKOPT_ACCEPT_NONBLOCK or SOCKOPT_RECV_NONBLOCK
+//!
+//!  @return  return value of setsockopt
+//!
+//!  @brief  Switch one of the blocking socket calls to non-blocking mode
+//
+//*****************************************************************************
+static int
+reactor_set_nonblock(long sd, long optname)
+{
+	unsigned long ulOptVal = SOCK_ON;
+
+	return setsockopt(sd, SOL_SOCKET, optname, &ulOptVal, sizeof(ulOptVal));
+}
+
+//*****************************************************************************
+//
+//! reactor_register
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+long
+reactor_register(long sd, unsigned char ucEvents, tReactorHandler handler)
+{
+	tReactorEntry *pEntry;
+
+	if (!M_IS_VALID_SD(sd) || (handler == NULL))
+	{
+		return -1;
+	}
+
+	if (ucEvents & REACTOR_EVENT_ACCEPT)
+	{
+		reactor_set_nonblock(sd, SOCKOPT_ACCEPT_NONBLOCK);
+	}
+	else if (ucEvents & REACTOR_EVENT_READ)
+	{
+		reactor_set_nonblock(sd, SOCKOPT_RECV_NONBLOCK);
+	}
+
+	pEntry = &reactorTable[sd];
+
+	if (pEntry->handler == NULL)
+	{
+		reactorStats.ucRegistered++;
+		if (reactorStats.ucRegistered > reactorStats.ucPeakRegistered)
+		{
+			reactorStats.ucPeakRegistered = reactorStats.ucRegistered;
+		}
+	}
+
+	pEntry->handler = handler;
+	pEntry->ucEvents = ucEvents;
+	pEntry->ucReady = 0;
+	pEntry->cAcceptSd = -1;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! reactor_modify
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+long
+reactor_modify(long sd, unsigned char ucEvents)
+{
+	if (!M_IS_VALID_SD(sd) || (reactorTable[sd].handler == NULL))
+	{
+		return -1;
+	}
+
+	if ((ucEvents & REACTOR_EVENT_READ) && !(reactorTable[sd].ucEvents & REACTOR_EVENT_READ))
+	{
+		reactor_set_nonblock(sd, SOCKOPT_RECV_NONBLOCK);
+	}
+
+	reactorTable[sd].ucEvents = ucEvents;
+
+	// Drop anything that was ready for an event we're no longer interested in
+	reactorTable[sd].ucReady &= (ucEvents | REACTOR_EVENT_CLOSE);
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! reactor_unregister
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+long
+reactor_unregister(long sd)
+{
+	if (!M_IS_VALID_SD(sd) || (reactorTable[sd].handler == NULL))
+	{
+		return -1;
+	}
+
+	memset(&reactorTable[sd], 0, sizeof(tReactorEntry));
+	reactorTable[sd].cAcceptSd = -1;
+	reactorStats.ucRegistered--;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! reactor_poll
+//!
+//!  @param  ulTimeoutMs  select() timeout
+//!
+//!  @return  -1 if select() failed, 0 otherwise
+//!
+//!  @brief  Find out which registered sockets are ready and mark them in
+//!          the table. Closed sockets are picked up from the close-wait
+//!          and active status bits without asking the CC3000.
+//
+//*****************************************************************************
+static int
+reactor_poll(unsigned long ulTimeoutMs)
+{
+	TICC3000fd_set readsds, writesds, exceptsds;
+	struct timeval timeout;
+	tReactorEntry *pEntry;
+	sockaddr addr;
+	socklen_t addrlen;
+	long sd, nfds, newsd;
+	unsigned char ucAnyReady;
+
+	FD_ZERO(&readsds);
+	FD_ZERO(&writesds);
+	FD_ZERO(&exceptsds);
+	nfds = 0;
+	ucAnyReady = 0;
+
+	for (sd = 0; sd < REACTOR_MAX_SOCKETS; sd++)
+	{
+		pEntry = &reactorTable[sd];
+
+		if ((pEntry->handler == NULL) || (pEntry->ucEvents & REACTOR_EVENT_ACCEPT))
+		{
+			continue;
+		}
+
+		// No need to select() on a socket we already know is gone
+		if (get_socket_close_wait_status(sd) ||
+				(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd)))
+		{
+			pEntry->ucReady |= REACTOR_EVENT_CLOSE;
+			ucAnyReady = 1;
+			continue;
+		}
+
+		if (pEntry->ucEvents & REACTOR_EVENT_READ)
+		{
+			FD_SET(sd, &readsds);
+		}
+		if (pEntry->ucEvents & REACTOR_EVENT_WRITE)
+		{
+			FD_SET(sd, &writesds);
+		}
+		FD_SET(sd, &exceptsds);
+		nfds = sd + 1;
+	}
+
+	if (nfds > 0)
+	{
+		// Don't sit in select() if there's already work to hand out
+		if (ucAnyReady)
+		{
+			ulTimeoutMs = 0;
+		}
+		timeout.tv_sec = ulTimeoutMs / 1000;
+		timeout.tv_usec = (ulTimeoutMs % 1000) * 1000;
+
+		reactorStats.ulSelects++;
+		if (select(nfds, &readsds, &writesds, &exceptsds, &timeout) < 0)
+		{
+			return -1;
+		}
+
+		for (sd = 0; sd < nfds; sd++)
+		{
+			pEntry = &reactorTable[sd];
+
+			if (FD_ISSET(sd, &readsds))
+			{
+				pEntry->ucReady |= REACTOR_EVENT_READ;
+			}
+			if (FD_ISSET(sd, &writesds))
+			{
+				pEntry->ucReady |= REACTOR_EVENT_WRITE;
+			}
+			if (FD_ISSET(sd, &exceptsds))
+			{
+				pEntry->ucReady |= REACTOR_EVENT_CLOSE;
+			}
+		}
+	}
+
+	// Listening sockets are polled with a non-blocking accept(). Note that
+	// accept() marks the listening socket inactive when nothing is pending,
+	// which is why listeners skip the active status check above.
+	for (sd = 0; sd < REACTOR_MAX_SOCKETS; sd++)
+	{
+		pEntry = &reactorTable[sd];
+
+		if ((pEntry->handler == NULL) || !(pEntry->ucEvents & REACTOR_EVENT_ACCEPT))
+		{
+			continue;
+		}
+
+		addrlen = sizeof(addr);
+		reactorStats.ulAcceptPolls++;
+		newsd = accept(sd, &addr, &addrlen);
+
+		if (M_IS_VALID_SD(newsd))
+		{
+			pEntry->cAcceptSd = (signed char)newsd;
+			pEntry->ucReady |= REACTOR_EVENT_ACCEPT;
+		}
+		else if (newsd != SOC_IN_PROGRESS)
+		{
+			pEntry->ucReady |= REACTOR_EVENT_CLOSE;
+		}
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! reactor_run_once
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+int
+reactor_run_once(unsigned long ulTimeoutMs)
+{
+	static const unsigned char ucOrder[] = { REACTOR_EVENT_ACCEPT, REACTOR_EVENT_READ,
+		REACTOR_EVENT_WRITE, REACTOR_EVENT_CLOSE };
+	tReactorEntry *pEntry;
+	tReactorHandler handler;
+	unsigned long ulStart, ulElapsed;
+	unsigned char ucBudget, ucCarried, ucEvent, i, j;
+	long sd, lArg;
+	int dispatched;
+
+	ulStart = micros();
+	reactorStats.ulIterations++;
+
+	// Only go back to the CC3000 once everything found last time is handled
+	ucCarried = 0;
+	for (sd = 0; sd < REACTOR_MAX_SOCKETS; sd++)
+	{
+		if (reactorTable[sd].handler && reactorTable[sd].ucReady)
+		{
+			ucCarried = 1;
+			break;
+		}
+	}
+
+	if (!ucCarried && (reactor_poll(ulTimeoutMs) < 0))
+	{
+		return -1;
+	}
+
+	dispatched = 0;
+	ucBudget = ucReactorBudget;
+
+	for (i = 0; (i < REACTOR_MAX_SOCKETS) && ucBudget; i++)
+	{
+		sd = (ucReactorCursor + i) % REACTOR_MAX_SOCKETS;
+		pEntry = &reactorTable[sd];
+
+		for (j = 0; (j < sizeof(ucOrder)) && ucBudget; j++)
+		{
+			ucEvent = ucOrder[j];
+
+			// The handler may have unregistered or modified the socket
+			if ((pEntry->handler == NULL) || !(pEntry->ucReady & ucEvent))
+			{
+				continue;
+			}
+
+			pEntry->ucReady &= ~ucEvent;
+			handler = pEntry->handler;
+			lArg = 0;
+
+			if (ucEvent == REACTOR_EVENT_ACCEPT)
+			{
+				lArg = pEntry->cAcceptSd;
+				pEntry->cAcceptSd = -1;
+				reactorStats.ulAccepted++;
+			}
+			else if (ucEvent == REACTOR_EVENT_CLOSE)
+			{
+				// Unregister first so the handler is free to closesocket()
+				// and reuse the descriptor
+				reactor_unregister(sd);
+				reactorStats.ulClosed++;
+			}
+
+			handler(sd, ucEvent, lArg);
+
+			dispatched++;
+			ucBudget--;
+		}
+
+		if (ucBudget == 0)
+		{
+			// Pick up where we stopped on the next pass
+			ucReactorCursor = (pEntry->handler && pEntry->ucReady) ? sd : (sd + 1) % REACTOR_MAX_SOCKETS;
+		}
+	}
+
+	if (ucBudget)
+	{
+		ucReactorCursor = (ucReactorCursor + 1) % REACTOR_MAX_SOCKETS;
+	}
+	else
+	{
+		for (sd = 0; sd < REACTOR_MAX_SOCKETS; sd++)
+		{
+			if (reactorTable[sd].handler && reactorTable[sd].ucReady)
+			{
+				reactorStats.ulDeferred++;
+			}
+		}
+	}
+
+	reactorStats.ulDispatched += dispatched;
+
+	ulElapsed = micros() - ulStart;
+	reactorStats.ulLastIterationMicros = ulElapsed;
+	if (ulElapsed > reactorStats.ulMaxIterationMicros)
+	{
+		reactorStats.ulMaxIterationMicros = ulElapsed;
+	}
+
+	return dispatched;
+}
+
+//*****************************************************************************
+//
+//! reactor_set_budget
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+void
+reactor_set_budget(unsigned char ucBudget)
+{
+	ucReactorBudget = (ucBudget) ? ucBudget : REACTOR_DEFAULT_BUDGET;
+}
+
+//*****************************************************************************
+//
+//! reactor_get_stats
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+void
+reactor_get_stats(tReactorStats *pStats)
+{
+	memcpy(pStats, &reactorStats, sizeof(tReactorStats));
+}
+
+//*****************************************************************************
+//
+//! reactor_reset_stats
+//!
+//!  @brief  see reactor.h
+//
+//*****************************************************************************
+void
+reactor_reset_stats(void)
+{
+	unsigned char ucRegistered = reactorStats.ucRegistered;
+
+	memset(&reactorStats, 0, sizeof(tReactorStats));
+	reactorStats.ucRegistered = ucRegistered;
+	reactorStats.ucPeakRegistered = ucRegistered;
+}
+
+#endif	// CC3000_TINY_DRIVER
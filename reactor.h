@@ -0,0 +1,184 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is the event loop ("reactor") for servers that juggle more
+*  than one socket. Sockets are registered with a handler and a set of
+*  events of interest; reactor_run_once() does a single select() on all
+*  of them and dispatches the ready ones.
+*
+****************************************************************************/
+#ifndef __REACTOR_H__
+#define __REACTOR_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// The CC3000 has 8 sockets (see M_IS_VALID_SD) so the handler table is
+// indexed directly by socket descriptor
+#define REACTOR_MAX_SOCKETS			(8)
+
+// Default number of events dispatched per reactor_run_once() call. Ready
+// events over the budget are kept and dispatched first on the next call
+#ifndef REACTOR_DEFAULT_BUDGET
+#define REACTOR_DEFAULT_BUDGET		(4)
+#endif
+
+//--------- Reactor events --------
+
+#define REACTOR_EVENT_ACCEPT		(0x01)	// listening socket has a new connection, arg = new sd
+#define REACTOR_EVENT_READ			(0x02)	// recv/recvfrom will not block
+#define REACTOR_EVENT_WRITE			(0x04)	// send/sendto will not block
+#define REACTOR_EVENT_CLOSE			(0x08)	// remote side closed or socket went inactive
+
+typedef void (*tReactorHandler)(long sd, unsigned char ucEvent, long lArg);
+
+typedef struct _reactor_stats_t
+{
+	unsigned long	ulIterations;			// reactor_run_once() calls
+	unsigned long	ulSelects;				// select() round trips
+	unsigned long	ulAcceptPolls;			// non-blocking accept() round trips
+	unsigned long	ulDispatched;			// handler calls
+	unsigned long	ulAccepted;				// REACTOR_EVENT_ACCEPT dispatched
+	unsigned long	ulClosed;				// REACTOR_EVENT_CLOSE dispatched
+	unsigned long	ulDeferred;				// ready events carried over by the budget
+	unsigned long	ulLastIterationMicros;
+	unsigned long	ulMaxIterationMicros;
+	unsigned char	ucRegistered;			// sockets currently registered
+	unsigned char	ucPeakRegistered;
+} tReactorStats;
+
+
+//*****************************************************************************
+//
+//! reactor_register
+//!
+//!  @param  sd        socket handle
+//!  @param  ucEvents  REACTOR_EVENT_xxx mask of events of interest. A
+//!                    listening socket should use REACTOR_EVENT_ACCEPT only
+//!  @param  handler   called from reactor_run_once() for every ready event
+//!
+//!  @return  0 on success, -1 on a bad socket or handler
+//!
+//!  @brief  Add a socket to the reactor. Listening sockets are switched to
+//!          SOCKOPT_ACCEPT_NONBLOCK and sockets with REACTOR_EVENT_READ to
+//!          SOCKOPT_RECV_NONBLOCK so a handler can never stall the loop.
+//!          REACTOR_EVENT_CLOSE is always delivered; after it has been
+//!          dispatched the socket is unregistered and the handler is
+//!          expected to call closesocket().
+//
+//*****************************************************************************
+extern long reactor_register(long sd, unsigned char ucEvents, tReactorHandler handler);
+
+//*****************************************************************************
+//
+//! reactor_modify
+//!
+//!  @param  sd        registered socket handle
+//!  @param  ucEvents  new REACTOR_EVENT_xxx mask
+//!
+//!  @return  0 on success, -1 if the socket is not registered
+//!
+//!  @brief  Change the events of interest, typically to add or remove
+//!          REACTOR_EVENT_WRITE while output is pending
+//
+//*****************************************************************************
+extern long reactor_modify(long sd, unsigned char ucEvents);
+
+//*****************************************************************************
+//
+//! reactor_unregister
+//!
+//!  @param  sd  socket handle
+//!
+//!  @return  0 on success, -1 if the socket is not registered
+//!
+//!  @brief  Remove a socket from the reactor. Must be called before
+//!          closesocket() on a socket the reactor did not report closed.
+//
+//*****************************************************************************
+extern long reactor_unregister(long sd);
+
+//*****************************************************************************
+//
+//! reactor_run_once
+//!
+//!  @param  ulTimeoutMs  longest time to wait in select() for activity.
+//!                       The CC3000 rounds anything below 5ms up to 5ms
+//!
+//!  @return  number of handlers called, -1 if select() failed
+//!
+//!  @brief  One pass of the event loop: a single select() over all
+//!          registered sockets, one non-blocking accept() per listener,
+//!          then up to the budget of handler calls, starting after the
+//!          socket served last so no socket can starve the others.
+//
+//*****************************************************************************
+extern int reactor_run_once(unsigned long ulTimeoutMs);
+
+//*****************************************************************************
+//
+//! reactor_set_budget
+//!
+//!  @param  ucBudget  maximum handler calls per reactor_run_once(), 0 for
+//!                    REACTOR_DEFAULT_BUDGET
+//!
+//!  @return  none
+//!
+//!  @brief  Bound the work done by one pass of the event loop
+//
+//*****************************************************************************
+extern void reactor_set_budget(unsigned char ucBudget);
+
+//*****************************************************************************
+//
+//! reactor_get_stats
+//!
+//!  @param[out]  pStats  filled with a copy of the reactor counters
+//!
+//!  @return  none
+//!
+//!  @brief  Read the counters used to measure how the loop scales with the
+//!          number of connections. reactor_reset_stats() zeroes them
+//!          (apart from the registration counts).
+//
+//*****************************************************************************
+extern void reactor_get_stats(tReactorStats *pStats);
+extern void reactor_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __REACTOR_H__
@@ -0,0 +1,315 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Roaming manager, see roam.h
+*
+*  The CC3000 can't tell us which AP it is associated with or how strong
+*  the link is, so the manager only knows the current AP if it picked it
+*  itself, and takes that AP's RSSI from the same scan table as the
+*  candidates. That keeps the comparison fair: both numbers come from the
+*  same background scan.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "wlan.h"
+#include "scan.h"
+#include "supervisor.h"
+#include "roam.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+// APs with the SSID looked at per check
+#define ROAM_RECORDS				(4)
+
+typedef struct _roam_state_t
+{
+	unsigned char	*pucKey;
+	unsigned long	ulSecType;
+	unsigned long	ulLastCheck;
+	long			lKeyLen;
+	char			acSsid[32];
+	unsigned char	ucSsidLen;
+	unsigned char	ucStarted;
+	unsigned char	ucKnown;				// aucBssid in roamStats is valid
+	unsigned char	ucConfirm;				// checks the candidate has stayed stronger
+} tRoamState;
+
+
+static tRoamState	roamState;
+static tRoamStats	roamStats;
+
+
+//*****************************************************************************
+//
+//! roam_associate
+//!
+//!  @param  pucBssid  AP to connect to
+//!  @param  ulStart   millis() the switch was started at
+//!
+//!  @return  0 if associated with pucBssid, 1 if associated after falling
+//!           back to the SSID alone, ROAM_ERR_xxx otherwise
+//!
+//!  @brief  Connect by BSSID and wait. If that AP doesn't answer, let the
+//!          CC3000 pick one; which one it picked isn't known afterwards.
+//
+//*****************************************************************************
+static long
+roam_associate(unsigned char *pucBssid, unsigned long ulStart)
+{
+	if ((wlan_connect(roamState.ulSecType, roamState.acSsid, roamState.ucSsidLen,
+			pucBssid, roamState.pucKey, roamState.lKeyLen) == 0) &&
+			(wlan_wait_connected(ulStart, ROAM_CONNECT_TIMEOUT_MS) == 0))
+	{
+		memcpy(roamStats.aucBssid, pucBssid, sizeof(roamStats.aucBssid));
+		roamState.ucKnown = 1;
+		return 0;
+	}
+
+	wlan_disconnect();
+	memset(roamStats.aucBssid, 0, sizeof(roamStats.aucBssid));
+	roamState.ucKnown = 0;
+
+	if (wlan_connect(roamState.ulSecType, roamState.acSsid, roamState.ucSsidLen,
+			NULL, roamState.pucKey, roamState.lKeyLen) != 0)
+	{
+		return ROAM_ERR_CONNECT;
+	}
+	if (wlan_wait_connected(millis(), ROAM_CONNECT_TIMEOUT_MS) != 0)
+	{
+		return ROAM_ERR_TIMEOUT;
+	}
+
+	return 1;
+}
+
+//*****************************************************************************
+//
+//! roam_begin
+//!
+//!  @brief  see roam.h
+//
+//*****************************************************************************
+long
+roam_begin(unsigned long ulSecType, char *ssid, long ssid_len, unsigned char *key,
+           long key_len)
+{
+	if ((ssid_len < 0) || (ssid_len > (long)sizeof(roamState.acSsid)))
+	{
+		return ROAM_ERR_CONNECT;
+	}
+
+	if (scan_set_params(ROAM_SCAN_INTERVAL_MS, SCAN_ALL_CHANNELS, ROAM_RSSI_THRESHOLD) != 0)
+	{
+		return ROAM_ERR_SCAN;
+	}
+
+	memset(&roamState, 0, sizeof(roamState));
+	memset(&roamStats, 0, sizeof(roamStats));
+	roamState.ulSecType = ulSecType;
+	memcpy(roamState.acSsid, ssid, ssid_len);
+	roamState.ucSsidLen = (unsigned char)ssid_len;
+	roamState.pucKey = key;
+	roamState.lKeyLen = key_len;
+	roamState.ulLastCheck = millis();
+	roamState.ucStarted = 1;
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! roam_end
+//!
+//!  @brief  see roam.h
+//
+//*****************************************************************************
+void
+roam_end(void)
+{
+	roamState.ucStarted = 0;
+	roamState.pucKey = NULL;
+}
+
+//*****************************************************************************
+//
+//! roam_connect
+//!
+//!  @brief  see roam.h
+//
+//*****************************************************************************
+long
+roam_connect(void)
+{
+	tScanRecord records[1];
+	long lRes;
+
+	if (!roamState.ucStarted)
+	{
+		return ROAM_ERR_NOT_STARTED;
+	}
+
+	lRes = scan_snapshot_ssid(records, 1, SCAN_SORT_RSSI, roamState.acSsid,
+	                          roamState.ucSsidLen, NULL);
+	if (lRes < 0)
+	{
+		return ROAM_ERR_SCAN;
+	}
+	if (lRes == 0)
+	{
+		return ROAM_ERR_NO_AP;
+	}
+
+	roamState.ucConfirm = 0;
+	roamStats.ucRssi = records[0].ucRssi;
+	lRes = roam_associate(records[0].aucBssid, millis());
+	roamState.ulLastCheck = millis();
+
+	return (lRes < 0) ? lRes : 0;
+}
+
+//*****************************************************************************
+//
+//! roam_poll
+//!
+//!  @brief  see roam.h
+//
+//*****************************************************************************
+long
+roam_poll(unsigned char ucForce)
+{
+	tScanRecord records[ROAM_RECORDS];
+	unsigned long ulStart, ulElapsed;
+	unsigned char ucCurrent;
+	long lCount, i;
+
+	if (!roamState.ucStarted)
+	{
+		return ROAM_ERR_NOT_STARTED;
+	}
+	if (!ucForce && (millis() - roamState.ulLastCheck < ROAM_CHECK_INTERVAL_MS))
+	{
+		return 0;
+	}
+	roamState.ulLastCheck = millis();
+
+	// Getting connected again is someone else's job
+	if (!roamState.ucKnown || (wlan_ioctl_statusget() != WLAN_STATUS_CONNECTED))
+	{
+		roamState.ucConfirm = 0;
+		return 0;
+	}
+
+	lCount = scan_snapshot_ssid(records, ROAM_RECORDS, SCAN_SORT_RSSI, roamState.acSsid,
+	                            roamState.ucSsidLen, NULL);
+	if (lCount < 0)
+	{
+		return ROAM_ERR_SCAN;
+	}
+	roamStats.ulChecks++;
+
+	// The current AP may have dropped out of the table, below the threshold
+	ucCurrent = 0;
+	for (i = 0; i < lCount; i++)
+	{
+		if (memcmp(records[i].aucBssid, roamStats.aucBssid, sizeof(roamStats.aucBssid)) == 0)
+		{
+			ucCurrent = records[i].ucRssi;
+			break;
+		}
+	}
+	roamStats.ucRssi = ucCurrent;
+
+	if ((lCount == 0) || (i == 0) ||
+			(records[0].ucRssi < ucCurrent + ROAM_HYSTERESIS))
+	{
+		roamState.ucConfirm = 0;
+		return 0;
+	}
+	if (++roamState.ucConfirm < ROAM_CONFIRM_CHECKS)
+	{
+		return 0;
+	}
+	roamState.ucConfirm = 0;
+
+	// The disconnect is ours, the supervisor mustn't undo the roam
+	supervisor_hold(1);
+	ulStart = millis();
+	wlan_disconnect();
+	i = roam_associate(records[0].aucBssid, ulStart);
+	ulElapsed = millis() - ulStart;
+	supervisor_hold(0);
+	roamState.ulLastCheck = millis();
+
+	if (i != 0)
+	{
+		// Fell back to the SSID alone, or not associated at all. Either way
+		// the new AP wasn't joined, so this is no roam.
+		roamStats.ulFailures++;
+		roamStats.ucRssi = 0;
+		return (i < 0) ? i : 0;
+	}
+
+	roamStats.ulRoams++;
+	roamStats.ulLastRoamMillis = ulElapsed;
+	roamStats.ulTotalRoamMillis += ulElapsed;
+	if (ulElapsed > roamStats.ulMaxRoamMillis)
+	{
+		roamStats.ulMaxRoamMillis = ulElapsed;
+	}
+	roamStats.ucRssiBefore = ucCurrent;
+	roamStats.ucRssiAfter = records[0].ucRssi;
+	roamStats.ucRssi = records[0].ucRssi;
+
+	return 1;
+}
+
+//*****************************************************************************
+//
+//! roam_get_stats
+//!
+//!  @brief  see roam.h
+//
+//*****************************************************************************
+void
+roam_get_stats(tRoamStats *pStats)
+{
+	memcpy(pStats, &roamStats, sizeof(tRoamStats));
+}
+
+//*****************************************************************************
+//
+//! roam_reset_stats
+//!
+//!  @brief  see roam.h
+//
+//*****************************************************************************
+void
+roam_reset_stats(void)
+{
+	roamStats.ulChecks = 0;
+	roamStats.ulRoams = 0;
+	roamStats.ulFailures = 0;
+	roamStats.ulLastRoamMillis = 0;
+	roamStats.ulMaxRoamMillis = 0;
+	roamStats.ulTotalRoamMillis = 0;
+	roamStats.ucRssiBefore = 0;
+	roamStats.ucRssiAfter = 0;
+}
+
+#endif	// CC3000_TINY_DRIVER
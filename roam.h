@@ -0,0 +1,209 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a roaming manager for networks where several APs share
+*  one SSID. It keeps the CC3000 scanning in the background, connects to
+*  the strongest AP by BSSID, and moves to another AP only once that AP
+*  has been clearly stronger for a few checks in a row. The CC3000 itself
+*  stays with whichever AP it associated with first until the link drops.
+*
+*  Call wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE) first,
+*  or the CC3000 may reconnect to a profile of its own choosing while a
+*  roam is in progress.
+*
+****************************************************************************/
+#ifndef __ROAM_H__
+#define __ROAM_H__
+
+#include "wlan.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// How often roam_poll looks at the scan table
+#ifndef ROAM_CHECK_INTERVAL_MS
+#define ROAM_CHECK_INTERVAL_MS		(10000UL)
+#endif
+
+// Background scan interval per channel, for wlan_ioctl_set_scan_params
+#ifndef ROAM_SCAN_INTERVAL_MS
+#define ROAM_SCAN_INTERVAL_MS		(2000UL)
+#endif
+
+// APs weaker than this (dBm) aren't put in the scan table at all
+#ifndef ROAM_RSSI_THRESHOLD
+#define ROAM_RSSI_THRESHOLD			(-85)
+#endif
+
+// How much stronger (scan table RSSI units) another AP must be to roam to
+#ifndef ROAM_HYSTERESIS
+#define ROAM_HYSTERESIS				(8)
+#endif
+
+// Consecutive checks the other AP must stay stronger for
+#ifndef ROAM_CONFIRM_CHECKS
+#define ROAM_CONFIRM_CHECKS			(2)
+#endif
+
+// Longest wait for the association after a roam
+#ifndef ROAM_CONNECT_TIMEOUT_MS
+#define ROAM_CONNECT_TIMEOUT_MS		(8000UL)
+#endif
+
+//--------- Errors --------
+
+#define ROAM_ERR_NOT_STARTED		(-1)	// roam_begin wasn't called
+#define ROAM_ERR_SCAN				(-2)	// scan parameters or table couldn't be read
+#define ROAM_ERR_NO_AP				(-3)	// no AP with the SSID in the scan table
+#define ROAM_ERR_CONNECT			(-4)	// wlan_connect refused the request
+#define ROAM_ERR_TIMEOUT			(-5)	// not associated in time
+
+typedef struct _roam_stats_t
+{
+	unsigned long	ulChecks;				// scan tables looked at
+	unsigned long	ulRoams;				// switches to another AP
+	unsigned long	ulFailures;				// switches that fell back or failed
+	unsigned long	ulLastRoamMillis;		// disconnect to associated, last roam
+	unsigned long	ulMaxRoamMillis;
+	unsigned long	ulTotalRoamMillis;
+	unsigned char	aucBssid[6];			// AP connected to, all 0 if unknown
+	unsigned char	ucRssi;					// its RSSI at the last check, 0 if not seen
+	unsigned char	ucRssiBefore;			// old AP's RSSI at the last roam
+	unsigned char	ucRssiAfter;			// new AP's RSSI at the last roam
+} tRoamStats;
+
+
+//*****************************************************************************
+//
+//! roam_begin
+//!
+//!  @param[in]  ulSecType  WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or
+//!                         WLAN_SEC_WPA2
+//!  @param[in]  ssid       SSID, up to 32 bytes
+//!  @param[in]  ssid_len   length of the SSID
+//!  @param[in]  key        security key. Not copied, must stay valid until
+//!                         roam_end.
+//!  @param[in]  key_len    key length
+//!
+//!  @return  0 on success, ROAM_ERR_xxx otherwise
+//!
+//!  @brief  Remember the network and start periodic background scans on
+//!          all channels
+//
+//*****************************************************************************
+extern long roam_begin(unsigned long ulSecType, char *ssid, long ssid_len,
+                       unsigned char *key, long key_len);
+
+//*****************************************************************************
+//
+//! roam_end
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Stop roaming. The connection and scan parameters are left as
+//!          they are.
+//
+//*****************************************************************************
+extern void roam_end(void);
+
+//*****************************************************************************
+//
+//! roam_connect
+//!
+//!  @param  none
+//!
+//!  @return  0 once associated, ROAM_ERR_xxx otherwise
+//!
+//!  @brief  Connect to the strongest AP with the SSID and wait for the
+//!          association. The scan table must have had time to fill, so
+//!          wait a few scan intervals after roam_begin. Roaming only
+//!          starts once the manager knows which AP it is on, i.e. after
+//!          roam_connect.
+//
+//*****************************************************************************
+extern long roam_connect(void);
+
+//*****************************************************************************
+//
+//! roam_poll
+//!
+//!  @param  ucForce  1 to check now rather than waiting for
+//!                   ROAM_CHECK_INTERVAL_MS
+//!
+//!  @return  1 if it roamed to another AP, 0 if not, ROAM_ERR_xxx on error
+//!
+//!  @brief  Call this from loop(). Every ROAM_CHECK_INTERVAL_MS it reads
+//!          the scan table and, if another AP has been ROAM_HYSTERESIS
+//!          stronger than the current one for ROAM_CONFIRM_CHECKS checks,
+//!          disconnects and connects to it by BSSID. If that fails it
+//!          connects by SSID alone, which counts as a failure and returns
+//!          0. Nothing is done while not associated. The supervisor, if
+//!          running, is held during the switch (supervisor_hold).
+//!          Sockets don't survive a roam, and DHCP runs again afterwards.
+//
+//*****************************************************************************
+extern long roam_poll(unsigned char ucForce);
+
+//*****************************************************************************
+//
+//! roam_get_stats
+//!
+//!  @param[out]  pStats  copy of the statistics
+//!
+//!  @return  none
+//!
+//!  @brief  Read the roaming statistics
+//
+//*****************************************************************************
+extern void roam_get_stats(tRoamStats *pStats);
+
+//*****************************************************************************
+//
+//! roam_reset_stats
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Clear the counters and timings; the current AP is kept
+//
+//*****************************************************************************
+extern void roam_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __ROAM_H__
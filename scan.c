@@ -0,0 +1,350 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Scan table snapshot, see scan.h
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "wlan.h"
+#include "scan.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+// One wlan_ioctl_get_scan_results entry, and where its fields are
+#define SCAN_RESULT_LEN				(50)
+#define SCAN_RESULT_COUNT			(0)
+#define SCAN_RESULT_STATUS			(4)
+#define SCAN_RESULT_RSSI			(8)		// bit 0 valid, bits 1-7 RSSI
+#define SCAN_RESULT_SSID_LEN		(9)		// bits 0-1 security, bits 2-7 SSID length
+#define SCAN_RESULT_TIME			(10)
+#define SCAN_RESULT_SSID			(12)
+#define SCAN_RESULT_BSSID			(44)
+
+// The CC3000 keeps at most this many entries; a larger count is garbage
+#define SCAN_TABLE_MAX				(32)
+
+typedef struct _scan_params_t
+{
+	unsigned long	ulInterval;
+	unsigned long	ulChannelMask;
+	long			lRssiThreshold;
+} tScanParams;
+
+
+static tScanParams	scanParams = { SCAN_DEFAULT_INTERVAL_MS, SCAN_ALL_CHANNELS,
+                                   SCAN_DEFAULT_RSSI_THRESHOLD };
+
+
+//*****************************************************************************
+//
+//! scan_find_ssid
+//!
+//!  @param  pRecords  records so far
+//!  @param  ucCount   number of records
+//!  @param  pucEntry  scan result entry
+//!
+//!  @return  index of the record with the entry's SSID, or -1
+//
+//*****************************************************************************
+static signed char
+scan_find_ssid(const tScanRecord *pRecords, unsigned char ucCount, const unsigned char *pucEntry)
+{
+	unsigned char ucLen = pucEntry[SCAN_RESULT_SSID_LEN] >> 2;
+	unsigned char i;
+
+	for (i = 0; i < ucCount; i++)
+	{
+		if ((pRecords[i].ucSsidLen == ucLen) &&
+				(memcmp(pRecords[i].acSsid, pucEntry + SCAN_RESULT_SSID, ucLen) == 0))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+//*****************************************************************************
+//
+//! scan_find_weakest
+//!
+//!  @param  pRecords  records
+//!  @param  ucCount   number of records, at least 1
+//!
+//!  @return  index of the record with the lowest RSSI
+//
+//*****************************************************************************
+static unsigned char
+scan_find_weakest(const tScanRecord *pRecords, unsigned char ucCount)
+{
+	unsigned char i, ucWeakest = 0;
+
+	for (i = 1; i < ucCount; i++)
+	{
+		if (pRecords[i].ucRssi < pRecords[ucWeakest].ucRssi)
+		{
+			ucWeakest = i;
+		}
+	}
+
+	return ucWeakest;
+}
+
+//*****************************************************************************
+//
+//! scan_record_fill
+//!
+//!  @param  pRecord   record to fill
+//!  @param  pucEntry  scan result entry
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+scan_record_fill(tScanRecord *pRecord, const unsigned char *pucEntry)
+{
+	pRecord->ucRssi = pucEntry[SCAN_RESULT_RSSI] >> 1;
+	pRecord->ucSecurity = pucEntry[SCAN_RESULT_SSID_LEN] & 0x03;
+	pRecord->ucSsidLen = pucEntry[SCAN_RESULT_SSID_LEN] >> 2;
+	STREAM_TO_UINT16((char *)pucEntry, SCAN_RESULT_TIME, pRecord->usFrameTime);
+	memcpy(pRecord->acSsid, pucEntry + SCAN_RESULT_SSID, sizeof(pRecord->acSsid));
+	memcpy(pRecord->aucBssid, pucEntry + SCAN_RESULT_BSSID, sizeof(pRecord->aucBssid));
+}
+
+//*****************************************************************************
+//
+//! scan_read
+//!
+//!  @param  pRecords  array for the records
+//!  @param  ucMax     number of records the array holds
+//!  @param  ucFlags   SCAN_SORT_RSSI and/or SCAN_DEDUPE_SSID
+//!  @param  pcSsid    only keep entries with this SSID, or NULL for all
+//!  @param  ucSsidLen length of pcSsid
+//!  @param  pStats    table size and fetch time, or NULL
+//!
+//!  @return  number of records filled in, or -1 if the table couldn't be
+//!           read
+//
+//*****************************************************************************
+static long
+scan_read(tScanRecord *pRecords, unsigned char ucMax, unsigned char ucFlags,
+          const char *pcSsid, unsigned char ucSsidLen, tScanStats *pStats)
+{
+	unsigned char aucEntry[SCAN_RESULT_LEN];
+	tScanRecord record;
+	tScanStats stats;
+	unsigned long ulCount;
+	unsigned char ucFilled, i, j;
+	signed char cSlot;
+
+	memset(&stats, 0, sizeof(stats));
+	ucFilled = 0;
+	ulCount = 1;
+
+	stats.ulFetchMicros = micros();
+
+	for (i = 0; i < ulCount; i++)
+	{
+		if (wlan_ioctl_get_scan_results(0, aucEntry) != 0)
+		{
+			return -1;
+		}
+		stats.usRoundTrips++;
+
+		// The first entry says how many there are
+		if (i == 0)
+		{
+			STREAM_TO_UINT32((char *)aucEntry, SCAN_RESULT_COUNT, ulCount);
+			stats.ucStatus = aucEntry[SCAN_RESULT_STATUS];
+			if (ulCount > SCAN_TABLE_MAX)
+			{
+				ulCount = SCAN_TABLE_MAX;
+			}
+			stats.usTableSize = (unsigned short)ulCount;
+			if (ulCount == 0)
+			{
+				break;
+			}
+		}
+
+		if (!(aucEntry[SCAN_RESULT_RSSI] & 0x01))
+		{
+			stats.usInvalid++;
+			continue;
+		}
+
+		if (pcSsid && (((aucEntry[SCAN_RESULT_SSID_LEN] >> 2) != ucSsidLen) ||
+				(memcmp(aucEntry + SCAN_RESULT_SSID, pcSsid, ucSsidLen) != 0)))
+		{
+			continue;
+		}
+
+		cSlot = -1;
+		if (ucFlags & SCAN_DEDUPE_SSID)
+		{
+			cSlot = scan_find_ssid(pRecords, ucFilled, aucEntry);
+			if (cSlot >= 0)
+			{
+				stats.usDuplicates++;
+				if ((aucEntry[SCAN_RESULT_RSSI] >> 1) <= pRecords[cSlot].ucRssi)
+				{
+					continue;
+				}
+			}
+		}
+
+		if (cSlot < 0)
+		{
+			if (ucFilled < ucMax)
+			{
+				cSlot = ucFilled++;
+			}
+			else
+			{
+				// Full: a sorted snapshot keeps the strongest APs
+				stats.usDropped++;
+				if (!(ucFlags & SCAN_SORT_RSSI) || (ucMax == 0))
+				{
+					continue;
+				}
+				cSlot = scan_find_weakest(pRecords, ucFilled);
+				if ((aucEntry[SCAN_RESULT_RSSI] >> 1) <= pRecords[cSlot].ucRssi)
+				{
+					continue;
+				}
+			}
+		}
+
+		scan_record_fill(&pRecords[cSlot], aucEntry);
+	}
+
+	stats.ulFetchMicros = micros() - stats.ulFetchMicros;
+
+	if (ucFlags & SCAN_SORT_RSSI)
+	{
+		// Insertion sort, strongest first; there are only a handful
+		for (i = 1; i < ucFilled; i++)
+		{
+			memcpy(&record, &pRecords[i], sizeof(tScanRecord));
+			for (j = i; (j > 0) && (pRecords[j - 1].ucRssi < record.ucRssi); j--)
+			{
+				memcpy(&pRecords[j], &pRecords[j - 1], sizeof(tScanRecord));
+			}
+			memcpy(&pRecords[j], &record, sizeof(tScanRecord));
+		}
+	}
+
+	if (pStats)
+	{
+		memcpy(pStats, &stats, sizeof(tScanStats));
+	}
+
+	return ucFilled;
+}
+
+//*****************************************************************************
+//
+//! scan_snapshot
+//!
+//!  @brief  see scan.h
+//
+//*****************************************************************************
+long
+scan_snapshot(tScanRecord *pRecords, unsigned char ucMax, unsigned char ucFlags,
+              tScanStats *pStats)
+{
+	return scan_read(pRecords, ucMax, ucFlags, NULL, 0, pStats);
+}
+
+//*****************************************************************************
+//
+//! scan_snapshot_ssid
+//!
+//!  @brief  see scan.h
+//
+//*****************************************************************************
+long
+scan_snapshot_ssid(tScanRecord *pRecords, unsigned char ucMax, unsigned char ucFlags,
+                   const char *ssid, long ssid_len, tScanStats *pStats)
+{
+	if ((ssid_len < 0) || (ssid_len > 32))
+	{
+		return -1;
+	}
+
+	return scan_read(pRecords, ucMax, ucFlags, ssid, (unsigned char)ssid_len, pStats);
+}
+
+//*****************************************************************************
+//
+//! scan_write_params
+//!
+//!  @param  ulChannelMask  channels to scan
+//!
+//!  @return  return value of wlan_ioctl_set_scan_params
+//!
+//!  @brief  Write the remembered parameters with this channel mask
+//
+//*****************************************************************************
+static long
+scan_write_params(unsigned long ulChannelMask)
+{
+	unsigned long aulIntervals[16];
+	unsigned char i;
+
+	for (i = 0; i < 16; i++)
+	{
+		aulIntervals[i] = scanParams.ulInterval;
+	}
+
+	return wlan_ioctl_set_scan_params(scanParams.ulInterval, 20, 30, 2, ulChannelMask,
+		scanParams.lRssiThreshold, 0, 205, aulIntervals);
+}
+
+//*****************************************************************************
+//
+//! scan_set_params
+//!
+//!  @brief  see scan.h
+//
+//*****************************************************************************
+long
+scan_set_params(unsigned long ulIntervalMs, unsigned long ulChannelMask, long lRssiThreshold)
+{
+	scanParams.ulInterval = ulIntervalMs;
+	scanParams.ulChannelMask = ulChannelMask;
+	scanParams.lRssiThreshold = lRssiThreshold;
+
+	return scan_write_params(ulChannelMask);
+}
+
+//*****************************************************************************
+//
+//! scan_limit_channels
+//!
+//!  @brief  see scan.h
+//
+//*****************************************************************************
+long
+scan_limit_channels(unsigned long ulChannelMask)
+{
+	return scan_write_params(ulChannelMask ? ulChannelMask : scanParams.ulChannelMask);
+}
+
+#endif	// CC3000_TINY_DRIVER
@@ -0,0 +1,168 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file drains the CC3000's scan result table into an array of
+*  fixed-size records in one call. wlan_ioctl_get_scan_results hands out
+*  one entry per HCI round trip; scan_snapshot makes those calls back to
+*  back into a single entry buffer and keeps only the fields that matter,
+*  optionally sorted by signal strength and with one record per SSID.
+*
+*  The CC3000 keeps its scan parameters in NVMEM and can't report them
+*  back. Modules that change them go through scan_set_params, which
+*  remembers them, so a module that only needs the channel mask for a
+*  while (scan_limit_channels) can put the rest back as it found it.
+*
+****************************************************************************/
+#ifndef __SCAN_H__
+#define __SCAN_H__
+
+#include "wlan.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+//--------- scan_snapshot flags --------
+
+#define SCAN_SORT_RSSI				(0x01)	// strongest first; when the array is full the weakest are dropped
+#define SCAN_DEDUPE_SSID			(0x02)	// one record per SSID, the strongest AP
+
+// wlan_ioctl_set_scan_params defaults, used until scan_set_params is called
+#define SCAN_ALL_CHANNELS			(0x7ff)
+#define SCAN_DEFAULT_INTERVAL_MS	(2000UL)
+#define SCAN_DEFAULT_RSSI_THRESHOLD	(-80)
+
+typedef struct _scan_record_t
+{
+	unsigned char	aucBssid[6];
+	char			acSsid[32];				// not NUL terminated, see ucSsidLen
+	unsigned short	usFrameTime;			// when the entry entered the table
+	unsigned char	ucSsidLen;
+	unsigned char	ucRssi;					// as reported, larger is stronger
+	unsigned char	ucSecurity;				// WLAN_SEC_UNSEC, _WEP, _WPA or _WPA2
+} tScanRecord;
+
+typedef struct _scan_stats_t
+{
+	unsigned long	ulFetchMicros;			// time to drain the table
+	unsigned short	usTableSize;			// entries the CC3000 reported
+	unsigned short	usRoundTrips;			// wlan_ioctl_get_scan_results calls
+	unsigned short	usInvalid;				// entries marked not valid
+	unsigned short	usDuplicates;			// merged by SCAN_DEDUPE_SSID
+	unsigned short	usDropped;				// didn't fit in the array
+	unsigned char	ucStatus;				// 0 aged results, 1 valid, 2 none
+} tScanStats;
+
+
+//*****************************************************************************
+//
+//! scan_snapshot
+//!
+//!  @param[out]  pRecords  array for the records
+//!  @param[in]   ucMax     number of records the array holds
+//!  @param[in]   ucFlags   SCAN_SORT_RSSI and/or SCAN_DEDUPE_SSID
+//!  @param[out]  pStats    table size and fetch time, or NULL
+//!
+//!  @return  number of records filled in, or -1 if the table couldn't be
+//!           read
+//!
+//!  @brief  Read the whole scan result table. Entries not marked valid are
+//!          skipped. The table is filled by the scan set up with
+//!          wlan_ioctl_set_scan_params.
+//
+//*****************************************************************************
+extern long scan_snapshot(tScanRecord *pRecords, unsigned char ucMax, unsigned char ucFlags,
+                          tScanStats *pStats);
+
+//*****************************************************************************
+//
+//! scan_snapshot_ssid
+//!
+//!  @param[out]  pRecords  array for the records
+//!  @param[in]   ucMax     number of records the array holds
+//!  @param[in]   ucFlags   SCAN_SORT_RSSI and/or SCAN_DEDUPE_SSID
+//!  @param[in]   ssid      SSID to keep
+//!  @param[in]   ssid_len  length of the SSID, up to 32
+//!  @param[out]  pStats    table size and fetch time, or NULL
+//!
+//!  @return  number of records filled in, or -1 if the table couldn't be
+//!           read
+//!
+//!  @brief  Same as scan_snapshot but only keeps the APs of one network,
+//!          e.g. to pick between several APs with the same SSID. Entries
+//!          for other SSIDs count as neither dropped nor duplicates.
+//
+//*****************************************************************************
+extern long scan_snapshot_ssid(tScanRecord *pRecords, unsigned char ucMax, unsigned char ucFlags,
+                               const char *ssid, long ssid_len, tScanStats *pStats);
+
+//*****************************************************************************
+//
+//! scan_set_params
+//!
+//!  @param  ulIntervalMs     time between scans of each channel, at least
+//!                           1000
+//!  @param  ulChannelMask    channels to scan, bit 0 is channel 1
+//!  @param  lRssiThreshold   APs weaker than this (dBm) are left out of the
+//!                           scan table
+//!
+//!  @return  return value of wlan_ioctl_set_scan_params
+//!
+//!  @brief  Set the scan parameters, the rest at their defaults, and
+//!          remember them for scan_limit_channels. Parameters set with
+//!          wlan_ioctl_set_scan_params directly aren't known here.
+//
+//*****************************************************************************
+extern long scan_set_params(unsigned long ulIntervalMs, unsigned long ulChannelMask,
+                            long lRssiThreshold);
+
+//*****************************************************************************
+//
+//! scan_limit_channels
+//!
+//!  @param  ulChannelMask  channels to scan, bit 0 is channel 1, or 0 for
+//!                         the mask given to scan_set_params
+//!
+//!  @return  return value of wlan_ioctl_set_scan_params
+//!
+//!  @brief  Change the channel mask for a while, keeping the interval and
+//!          threshold from scan_set_params. Call again with 0 to put the
+//!          mask back.
+//
+//*****************************************************************************
+extern long scan_limit_channels(unsigned long ulChannelMask);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SCAN_H__
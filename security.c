@@ -17,7 +17,13 @@
 *  reference library. Changes to the reference library file,
 *  if any, are listed below:
 *
-*  No changes
+*  + Added aes_set_key, aes_encrypt_block and aes_decrypt_block, which
+     keep the expanded key in a tAesContext. Without AES_COMPACT they use
+     a 32-bit T-table core (aes_te0 / aes_td0, rotated per column); with
+     it, aes_encr / aes_decr on the cached round keys.
+     
+   + aes_encrypt and aes_decrypt keep the schedule for the last key used
+     instead of re-expanding it into the global expandedKey every block
 * 
 ****************************************************************************/
 
@@ -72,6 +78,7 @@
 //
 //*****************************************************************************
 
+#include <string.h>
 #include "security.h"
 
 #ifndef CC3000_UNENCRYPTED_SMART_CONFIG
@@ -116,8 +123,117 @@ const unsigned char rsbox[256] =
 const unsigned char Rcon[11] = {
   0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
 
-
-unsigned char expandedKey[176];
+#ifndef AES_COMPACT
+// encryption T-table: S-box and MixColumns (2, 1, 1, 3) in one lookup
+static const unsigned long aes_te0[256] = {
+	0xc66363a5UL, 0xf87c7c84UL, 0xee777799UL, 0xf67b7b8dUL, 0xfff2f20dUL, 0xd66b6bbdUL,
+	0xde6f6fb1UL, 0x91c5c554UL, 0x60303050UL, 0x02010103UL, 0xce6767a9UL, 0x562b2b7dUL,
+	0xe7fefe19UL, 0xb5d7d762UL, 0x4dababe6UL, 0xec76769aUL, 0x8fcaca45UL, 0x1f82829dUL,
+	0x89c9c940UL, 0xfa7d7d87UL, 0xeffafa15UL, 0xb25959ebUL, 0x8e4747c9UL, 0xfbf0f00bUL,
+	0x41adadecUL, 0xb3d4d467UL, 0x5fa2a2fdUL, 0x45afafeaUL, 0x239c9cbfUL, 0x53a4a4f7UL,
+	0xe4727296UL, 0x9bc0c05bUL, 0x75b7b7c2UL, 0xe1fdfd1cUL, 0x3d9393aeUL, 0x4c26266aUL,
+	0x6c36365aUL, 0x7e3f3f41UL, 0xf5f7f702UL, 0x83cccc4fUL, 0x6834345cUL, 0x51a5a5f4UL,
+	0xd1e5e534UL, 0xf9f1f108UL, 0xe2717193UL, 0xabd8d873UL, 0x62313153UL, 0x2a15153fUL,
+	0x0804040cUL, 0x95c7c752UL, 0x46232365UL, 0x9dc3c35eUL, 0x30181828UL, 0x379696a1UL,
+	0x0a05050fUL, 0x2f9a9ab5UL, 0x0e070709UL, 0x24121236UL, 0x1b80809bUL, 0xdfe2e23dUL,
+	0xcdebeb26UL, 0x4e272769UL, 0x7fb2b2cdUL, 0xea75759fUL, 0x1209091bUL, 0x1d83839eUL,
+	0x582c2c74UL, 0x341a1a2eUL, 0x361b1b2dUL, 0xdc6e6eb2UL, 0xb45a5aeeUL, 0x5ba0a0fbUL,
+	0xa45252f6UL, 0x763b3b4dUL, 0xb7d6d661UL, 0x7db3b3ceUL, 0x5229297bUL, 0xdde3e33eUL,
+	0x5e2f2f71UL, 0x13848497UL, 0xa65353f5UL, 0xb9d1d168UL, 0x00000000UL, 0xc1eded2cUL,
+	0x40202060UL, 0xe3fcfc1fUL, 0x79b1b1c8UL, 0xb65b5bedUL, 0xd46a6abeUL, 0x8dcbcb46UL,
+	0x67bebed9UL, 0x7239394bUL, 0x944a4adeUL, 0x984c4cd4UL, 0xb05858e8UL, 0x85cfcf4aUL,
+	0xbbd0d06bUL, 0xc5efef2aUL, 0x4faaaae5UL, 0xedfbfb16UL, 0x864343c5UL, 0x9a4d4dd7UL,
+	0x66333355UL, 0x11858594UL, 0x8a4545cfUL, 0xe9f9f910UL, 0x04020206UL, 0xfe7f7f81UL,
+	0xa05050f0UL, 0x783c3c44UL, 0x259f9fbaUL, 0x4ba8a8e3UL, 0xa25151f3UL, 0x5da3a3feUL,
+	0x804040c0UL, 0x058f8f8aUL, 0x3f9292adUL, 0x219d9dbcUL, 0x70383848UL, 0xf1f5f504UL,
+	0x63bcbcdfUL, 0x77b6b6c1UL, 0xafdada75UL, 0x42212163UL, 0x20101030UL, 0xe5ffff1aUL,
+	0xfdf3f30eUL, 0xbfd2d26dUL, 0x81cdcd4cUL, 0x180c0c14UL, 0x26131335UL, 0xc3ecec2fUL,
+	0xbe5f5fe1UL, 0x359797a2UL, 0x884444ccUL, 0x2e171739UL, 0x93c4c457UL, 0x55a7a7f2UL,
+	0xfc7e7e82UL, 0x7a3d3d47UL, 0xc86464acUL, 0xba5d5de7UL, 0x3219192bUL, 0xe6737395UL,
+	0xc06060a0UL, 0x19818198UL, 0x9e4f4fd1UL, 0xa3dcdc7fUL, 0x44222266UL, 0x542a2a7eUL,
+	0x3b9090abUL, 0x0b888883UL, 0x8c4646caUL, 0xc7eeee29UL, 0x6bb8b8d3UL, 0x2814143cUL,
+	0xa7dede79UL, 0xbc5e5ee2UL, 0x160b0b1dUL, 0xaddbdb76UL, 0xdbe0e03bUL, 0x64323256UL,
+	0x743a3a4eUL, 0x140a0a1eUL, 0x924949dbUL, 0x0c06060aUL, 0x4824246cUL, 0xb85c5ce4UL,
+	0x9fc2c25dUL, 0xbdd3d36eUL, 0x43acacefUL, 0xc46262a6UL, 0x399191a8UL, 0x319595a4UL,
+	0xd3e4e437UL, 0xf279798bUL, 0xd5e7e732UL, 0x8bc8c843UL, 0x6e373759UL, 0xda6d6db7UL,
+	0x018d8d8cUL, 0xb1d5d564UL, 0x9c4e4ed2UL, 0x49a9a9e0UL, 0xd86c6cb4UL, 0xac5656faUL,
+	0xf3f4f407UL, 0xcfeaea25UL, 0xca6565afUL, 0xf47a7a8eUL, 0x47aeaee9UL, 0x10080818UL,
+	0x6fbabad5UL, 0xf0787888UL, 0x4a25256fUL, 0x5c2e2e72UL, 0x381c1c24UL, 0x57a6a6f1UL,
+	0x73b4b4c7UL, 0x97c6c651UL, 0xcbe8e823UL, 0xa1dddd7cUL, 0xe874749cUL, 0x3e1f1f21UL,
+	0x964b4bddUL, 0x61bdbddcUL, 0x0d8b8b86UL, 0x0f8a8a85UL, 0xe0707090UL, 0x7c3e3e42UL,
+	0x71b5b5c4UL, 0xcc6666aaUL, 0x904848d8UL, 0x06030305UL, 0xf7f6f601UL, 0x1c0e0e12UL,
+	0xc26161a3UL, 0x6a35355fUL, 0xae5757f9UL, 0x69b9b9d0UL, 0x17868691UL, 0x99c1c158UL,
+	0x3a1d1d27UL, 0x279e9eb9UL, 0xd9e1e138UL, 0xebf8f813UL, 0x2b9898b3UL, 0x22111133UL,
+	0xd26969bbUL, 0xa9d9d970UL, 0x078e8e89UL, 0x339494a7UL, 0x2d9b9bb6UL, 0x3c1e1e22UL,
+	0x15878792UL, 0xc9e9e920UL, 0x87cece49UL, 0xaa5555ffUL, 0x50282878UL, 0xa5dfdf7aUL,
+	0x038c8c8fUL, 0x59a1a1f8UL, 0x09898980UL, 0x1a0d0d17UL, 0x65bfbfdaUL, 0xd7e6e631UL,
+	0x844242c6UL, 0xd06868b8UL, 0x824141c3UL, 0x299999b0UL, 0x5a2d2d77UL, 0x1e0f0f11UL,
+	0x7bb0b0cbUL, 0xa85454fcUL, 0x6dbbbbd6UL, 0x2c16163aUL
+};
+// decryption T-table: inverse S-box and InvMixColumns (e, 9, d, b)
+static const unsigned long aes_td0[256] = {
+	0x51f4a750UL, 0x7e416553UL, 0x1a17a4c3UL, 0x3a275e96UL, 0x3bab6bcbUL, 0x1f9d45f1UL,
+	0xacfa58abUL, 0x4be30393UL, 0x2030fa55UL, 0xad766df6UL, 0x88cc7691UL, 0xf5024c25UL,
+	0x4fe5d7fcUL, 0xc52acbd7UL, 0x26354480UL, 0xb562a38fUL, 0xdeb15a49UL, 0x25ba1b67UL,
+	0x45ea0e98UL, 0x5dfec0e1UL, 0xc32f7502UL, 0x814cf012UL, 0x8d4697a3UL, 0x6bd3f9c6UL,
+	0x038f5fe7UL, 0x15929c95UL, 0xbf6d7aebUL, 0x955259daUL, 0xd4be832dUL, 0x587421d3UL,
+	0x49e06929UL, 0x8ec9c844UL, 0x75c2896aUL, 0xf48e7978UL, 0x99583e6bUL, 0x27b971ddUL,
+	0xbee14fb6UL, 0xf088ad17UL, 0xc920ac66UL, 0x7dce3ab4UL, 0x63df4a18UL, 0xe51a3182UL,
+	0x97513360UL, 0x62537f45UL, 0xb16477e0UL, 0xbb6bae84UL, 0xfe81a01cUL, 0xf9082b94UL,
+	0x70486858UL, 0x8f45fd19UL, 0x94de6c87UL, 0x527bf8b7UL, 0xab73d323UL, 0x724b02e2UL,
+	0xe31f8f57UL, 0x6655ab2aUL, 0xb2eb2807UL, 0x2fb5c203UL, 0x86c57b9aUL, 0xd33708a5UL,
+	0x302887f2UL, 0x23bfa5b2UL, 0x02036abaUL, 0xed16825cUL, 0x8acf1c2bUL, 0xa779b492UL,
+	0xf307f2f0UL, 0x4e69e2a1UL, 0x65daf4cdUL, 0x0605bed5UL, 0xd134621fUL, 0xc4a6fe8aUL,
+	0x342e539dUL, 0xa2f355a0UL, 0x058ae132UL, 0xa4f6eb75UL, 0x0b83ec39UL, 0x4060efaaUL,
+	0x5e719f06UL, 0xbd6e1051UL, 0x3e218af9UL, 0x96dd063dUL, 0xdd3e05aeUL, 0x4de6bd46UL,
+	0x91548db5UL, 0x71c45d05UL, 0x0406d46fUL, 0x605015ffUL, 0x1998fb24UL, 0xd6bde997UL,
+	0x894043ccUL, 0x67d99e77UL, 0xb0e842bdUL, 0x07898b88UL, 0xe7195b38UL, 0x79c8eedbUL,
+	0xa17c0a47UL, 0x7c420fe9UL, 0xf8841ec9UL, 0x00000000UL, 0x09808683UL, 0x322bed48UL,
+	0x1e1170acUL, 0x6c5a724eUL, 0xfd0efffbUL, 0x0f853856UL, 0x3daed51eUL, 0x362d3927UL,
+	0x0a0fd964UL, 0x685ca621UL, 0x9b5b54d1UL, 0x24362e3aUL, 0x0c0a67b1UL, 0x9357e70fUL,
+	0xb4ee96d2UL, 0x1b9b919eUL, 0x80c0c54fUL, 0x61dc20a2UL, 0x5a774b69UL, 0x1c121a16UL,
+	0xe293ba0aUL, 0xc0a02ae5UL, 0x3c22e043UL, 0x121b171dUL, 0x0e090d0bUL, 0xf28bc7adUL,
+	0x2db6a8b9UL, 0x141ea9c8UL, 0x57f11985UL, 0xaf75074cUL, 0xee99ddbbUL, 0xa37f60fdUL,
+	0xf701269fUL, 0x5c72f5bcUL, 0x44663bc5UL, 0x5bfb7e34UL, 0x8b432976UL, 0xcb23c6dcUL,
+	0xb6edfc68UL, 0xb8e4f163UL, 0xd731dccaUL, 0x42638510UL, 0x13972240UL, 0x84c61120UL,
+	0x854a247dUL, 0xd2bb3df8UL, 0xaef93211UL, 0xc729a16dUL, 0x1d9e2f4bUL, 0xdcb230f3UL,
+	0x0d8652ecUL, 0x77c1e3d0UL, 0x2bb3166cUL, 0xa970b999UL, 0x119448faUL, 0x47e96422UL,
+	0xa8fc8cc4UL, 0xa0f03f1aUL, 0x567d2cd8UL, 0x223390efUL, 0x87494ec7UL, 0xd938d1c1UL,
+	0x8ccaa2feUL, 0x98d40b36UL, 0xa6f581cfUL, 0xa57ade28UL, 0xdab78e26UL, 0x3fadbfa4UL,
+	0x2c3a9de4UL, 0x5078920dUL, 0x6a5fcc9bUL, 0x547e4662UL, 0xf68d13c2UL, 0x90d8b8e8UL,
+	0x2e39f75eUL, 0x82c3aff5UL, 0x9f5d80beUL, 0x69d0937cUL, 0x6fd52da9UL, 0xcf2512b3UL,
+	0xc8ac993bUL, 0x10187da7UL, 0xe89c636eUL, 0xdb3bbb7bUL, 0xcd267809UL, 0x6e5918f4UL,
+	0xec9ab701UL, 0x834f9aa8UL, 0xe6956e65UL, 0xaaffe67eUL, 0x21bccf08UL, 0xef15e8e6UL,
+	0xbae79bd9UL, 0x4a6f36ceUL, 0xea9f09d4UL, 0x29b07cd6UL, 0x31a4b2afUL, 0x2a3f2331UL,
+	0xc6a59430UL, 0x35a266c0UL, 0x744ebc37UL, 0xfc82caa6UL, 0xe090d0b0UL, 0x33a7d815UL,
+	0xf104984aUL, 0x41ecdaf7UL, 0x7fcd500eUL, 0x1791f62fUL, 0x764dd68dUL, 0x43efb04dUL,
+	0xccaa4d54UL, 0xe49604dfUL, 0x9ed1b5e3UL, 0x4c6a881bUL, 0xc12c1fb8UL, 0x4665517fUL,
+	0x9d5eea04UL, 0x018c355dUL, 0xfa877473UL, 0xfb0b412eUL, 0xb3671d5aUL, 0x92dbd252UL,
+	0xe9105633UL, 0x6dd64713UL, 0x9ad7618cUL, 0x37a10c7aUL, 0x59f8148eUL, 0xeb133c89UL,
+	0xcea927eeUL, 0xb761c935UL, 0xe11ce5edUL, 0x7a47b13cUL, 0x9cd2df59UL, 0x55f2733fUL,
+	0x1814ce79UL, 0x73c737bfUL, 0x53f7cdeaUL, 0x5ffdaa5bUL, 0xdf3d6f14UL, 0x7844db86UL,
+	0xcaaff381UL, 0xb968c43eUL, 0x3824342cUL, 0xc2a3405fUL, 0x161dc372UL, 0xbce2250cUL,
+	0x283c498bUL, 0xff0d9541UL, 0x39a80171UL, 0x080cb3deUL, 0xd8b4e49cUL, 0x6456c190UL,
+	0x7bcb8461UL, 0xd532b670UL, 0x486c5c74UL, 0xd0b85742UL
+};
+
+#define AES_ROTR(x, n)		((((x) >> (n)) | ((x) << (32 - (n)))) & 0xffffffffUL)
+
+// One T-table round column: bytes a, b, c, d from the four state words
+#define AES_TE(a, b, c, d)	(aes_te0[(a) >> 24] ^ AES_ROTR(aes_te0[((b) >> 16) & 0xff], 8) ^ \
+							 AES_ROTR(aes_te0[((c) >> 8) & 0xff], 16) ^ AES_ROTR(aes_te0[(d) & 0xff], 24))
+#define AES_TD(a, b, c, d)	(aes_td0[(a) >> 24] ^ AES_ROTR(aes_td0[((b) >> 16) & 0xff], 8) ^ \
+							 AES_ROTR(aes_td0[((c) >> 8) & 0xff], 16) ^ AES_ROTR(aes_td0[(d) & 0xff], 24))
+
+// Byte access, so the state can sit anywhere in a TX frame
+#define AES_LOAD32(p)		(((unsigned long)(p)[0] << 24) | ((unsigned long)(p)[1] << 16) | \
+							 ((unsigned long)(p)[2] << 8) | (unsigned long)(p)[3])
+#endif
+
+// key schedule for aes_encrypt / aes_decrypt, kept while the key is unchanged
+static tAesContext aesCachedContext;
+static unsigned char aesCachedKey[AES128_KEY_SIZE];
+static unsigned char aesCachedValid;
 
 //*****************************************************************************
 //
@@ -459,6 +575,200 @@ void aes_decr(unsigned char *state, unsigned char *expandedKey)
 	
 } 
 
+//*****************************************************************************
+//
+//!  aes_set_key
+//!
+//!  @param[out]  pCtx  context
+//!  @param[in]   key   AES128 key of size 16 bytes
+//!
+//!  @return  none
+//!
+//!  @brief   see security.h. The T-table core also needs the decryption
+//!           round keys in reverse order with InvMixColumns applied to the
+//!           middle nine (the equivalent inverse cipher). InvMixColumns of
+//!           a word is aes_td0 looked up through sbox, which undoes the
+//!           rsbox built into aes_td0.
+//!
+//*****************************************************************************
+
+void aes_set_key(tAesContext *pCtx, unsigned char *key)
+{
+#ifdef AES_COMPACT
+	expandKey(pCtx->aucRoundKeys, key);
+#else
+	unsigned char expanded[176];
+	unsigned long w;
+	unsigned char ii, jj;
+
+	expandKey(expanded, key);
+	for (ii = 0; ii < 44; ii++)
+	{
+		pCtx->aulEnc[ii] = AES_LOAD32(&expanded[ii * 4]);
+	}
+
+	for (ii = 0; ii < 4; ii++)
+	{
+		pCtx->aulDec[ii] = pCtx->aulEnc[40 + ii];
+		pCtx->aulDec[40 + ii] = pCtx->aulEnc[ii];
+	}
+	for (ii = 1; ii < 10; ii++)
+	{
+		for (jj = 0; jj < 4; jj++)
+		{
+			w = pCtx->aulEnc[(10 - ii) * 4 + jj];
+			pCtx->aulDec[ii * 4 + jj] = aes_td0[sbox[w >> 24]] ^
+				AES_ROTR(aes_td0[sbox[(w >> 16) & 0xff]], 8) ^
+				AES_ROTR(aes_td0[sbox[(w >> 8) & 0xff]], 16) ^
+				AES_ROTR(aes_td0[sbox[w & 0xff]], 24);
+		}
+	}
+#endif
+}
+
+//*****************************************************************************
+//
+//!  aes_encrypt_block
+//!
+//!  @param[in]      pCtx   context from aes_set_key
+//!  @param[in\out]  state  16 bytes of plain text and cipher text
+//!
+//!  @return  none
+//!
+//!  @brief   see security.h. Each T-table round does SubBytes, ShiftRows
+//!           and MixColumns with four lookups per column; the last round
+//!           has no MixColumns, so it uses sbox directly.
+//!
+//*****************************************************************************
+
+void aes_encrypt_block(tAesContext *pCtx, unsigned char *state)
+{
+#ifdef AES_COMPACT
+	aes_encr(state, pCtx->aucRoundKeys);
+#else
+	const unsigned long *rk = pCtx->aulEnc;
+	unsigned long s0, s1, s2, s3, t0, t1, t2, t3;
+	unsigned char round;
+
+	s0 = AES_LOAD32(state     ) ^ rk[0];
+	s1 = AES_LOAD32(state +  4) ^ rk[1];
+	s2 = AES_LOAD32(state +  8) ^ rk[2];
+	s3 = AES_LOAD32(state + 12) ^ rk[3];
+
+	for (round = 1; round < 10; round++)
+	{
+		rk += 4;
+		t0 = AES_TE(s0, s1, s2, s3) ^ rk[0];
+		t1 = AES_TE(s1, s2, s3, s0) ^ rk[1];
+		t2 = AES_TE(s2, s3, s0, s1) ^ rk[2];
+		t3 = AES_TE(s3, s0, s1, s2) ^ rk[3];
+		s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+	}
+
+	// 10th round without mixcols
+	rk += 4;
+	state[ 0] = sbox[ s0 >> 24        ] ^ (unsigned char)(rk[0] >> 24);
+	state[ 1] = sbox[(s1 >> 16) & 0xff] ^ (unsigned char)(rk[0] >> 16);
+	state[ 2] = sbox[(s2 >>  8) & 0xff] ^ (unsigned char)(rk[0] >>  8);
+	state[ 3] = sbox[ s3        & 0xff] ^ (unsigned char)(rk[0]      );
+	state[ 4] = sbox[ s1 >> 24        ] ^ (unsigned char)(rk[1] >> 24);
+	state[ 5] = sbox[(s2 >> 16) & 0xff] ^ (unsigned char)(rk[1] >> 16);
+	state[ 6] = sbox[(s3 >>  8) & 0xff] ^ (unsigned char)(rk[1] >>  8);
+	state[ 7] = sbox[ s0        & 0xff] ^ (unsigned char)(rk[1]      );
+	state[ 8] = sbox[ s2 >> 24        ] ^ (unsigned char)(rk[2] >> 24);
+	state[ 9] = sbox[(s3 >> 16) & 0xff] ^ (unsigned char)(rk[2] >> 16);
+	state[10] = sbox[(s0 >>  8) & 0xff] ^ (unsigned char)(rk[2] >>  8);
+	state[11] = sbox[ s1        & 0xff] ^ (unsigned char)(rk[2]      );
+	state[12] = sbox[ s3 >> 24        ] ^ (unsigned char)(rk[3] >> 24);
+	state[13] = sbox[(s0 >> 16) & 0xff] ^ (unsigned char)(rk[3] >> 16);
+	state[14] = sbox[(s1 >>  8) & 0xff] ^ (unsigned char)(rk[3] >>  8);
+	state[15] = sbox[ s2        & 0xff] ^ (unsigned char)(rk[3]      );
+#endif
+}
+
+//*****************************************************************************
+//
+//!  aes_decrypt_block
+//!
+//!  @param[in]      pCtx   context from aes_set_key
+//!  @param[in\out]  state  16 bytes of cipher text and plain text
+//!
+//!  @return  none
+//!
+//!  @brief   see security.h. Same shape as aes_encrypt_block, with the
+//!           rows shifted the other way and rsbox in the last round.
+//!
+//*****************************************************************************
+
+void aes_decrypt_block(tAesContext *pCtx, unsigned char *state)
+{
+#ifdef AES_COMPACT
+	aes_decr(state, pCtx->aucRoundKeys);
+#else
+	const unsigned long *rk = pCtx->aulDec;
+	unsigned long s0, s1, s2, s3, t0, t1, t2, t3;
+	unsigned char round;
+
+	s0 = AES_LOAD32(state     ) ^ rk[0];
+	s1 = AES_LOAD32(state +  4) ^ rk[1];
+	s2 = AES_LOAD32(state +  8) ^ rk[2];
+	s3 = AES_LOAD32(state + 12) ^ rk[3];
+
+	for (round = 1; round < 10; round++)
+	{
+		rk += 4;
+		t0 = AES_TD(s0, s3, s2, s1) ^ rk[0];
+		t1 = AES_TD(s1, s0, s3, s2) ^ rk[1];
+		t2 = AES_TD(s2, s1, s0, s3) ^ rk[2];
+		t3 = AES_TD(s3, s2, s1, s0) ^ rk[3];
+		s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+	}
+
+	// 10th round without mixcols
+	rk += 4;
+	state[ 0] = rsbox[ s0 >> 24        ] ^ (unsigned char)(rk[0] >> 24);
+	state[ 1] = rsbox[(s3 >> 16) & 0xff] ^ (unsigned char)(rk[0] >> 16);
+	state[ 2] = rsbox[(s2 >>  8) & 0xff] ^ (unsigned char)(rk[0] >>  8);
+	state[ 3] = rsbox[ s1        & 0xff] ^ (unsigned char)(rk[0]      );
+	state[ 4] = rsbox[ s1 >> 24        ] ^ (unsigned char)(rk[1] >> 24);
+	state[ 5] = rsbox[(s0 >> 16) & 0xff] ^ (unsigned char)(rk[1] >> 16);
+	state[ 6] = rsbox[(s3 >>  8) & 0xff] ^ (unsigned char)(rk[1] >>  8);
+	state[ 7] = rsbox[ s2        & 0xff] ^ (unsigned char)(rk[1]      );
+	state[ 8] = rsbox[ s2 >> 24        ] ^ (unsigned char)(rk[2] >> 24);
+	state[ 9] = rsbox[(s1 >> 16) & 0xff] ^ (unsigned char)(rk[2] >> 16);
+	state[10] = rsbox[(s0 >>  8) & 0xff] ^ (unsigned char)(rk[2] >>  8);
+	state[11] = rsbox[ s3        & 0xff] ^ (unsigned char)(rk[2]      );
+	state[12] = rsbox[ s3 >> 24        ] ^ (unsigned char)(rk[3] >> 24);
+	state[13] = rsbox[(s2 >> 16) & 0xff] ^ (unsigned char)(rk[3] >> 16);
+	state[14] = rsbox[(s1 >>  8) & 0xff] ^ (unsigned char)(rk[3] >>  8);
+	state[15] = rsbox[ s0        & 0xff] ^ (unsigned char)(rk[3]      );
+#endif
+}
+
+//*****************************************************************************
+//
+//!  aes_cached_context
+//!
+//!  @param[in]  key   AES128 key of size 16 bytes
+//!
+//!  @return  context holding the schedule for key
+//!
+//!  @brief   Expand the key only if it differs from the last one
+//!
+//*****************************************************************************
+
+static tAesContext *aes_cached_context(unsigned char *key)
+{
+	if (!aesCachedValid || (memcmp(aesCachedKey, key, AES128_KEY_SIZE) != 0))
+	{
+		aes_set_key(&aesCachedContext, key);
+		memcpy(aesCachedKey, key, AES128_KEY_SIZE);
+		aesCachedValid = 1;
+	}
+
+	return &aesCachedContext;
+}
+
 //*****************************************************************************
 //
 //!  aes_encrypt
@@ -479,9 +789,7 @@ void aes_decr(unsigned char *state, unsigned char *expandedKey)
 void aes_encrypt(unsigned char *state,
                  unsigned char *key)
 {
-	// expand the key into 176 bytes
-	expandKey(expandedKey, key);       
-	aes_encr(state, expandedKey);
+	aes_encrypt_block(aes_cached_context(key), state);
 }
 
 //*****************************************************************************
@@ -504,8 +812,7 @@ void aes_encrypt(unsigned char *state,
 void aes_decrypt(unsigned char *state,
                  unsigned char *key)
 {
-    expandKey(expandedKey, key);       // expand the key into 176 bytes
-    aes_decr(state, expandedKey);
+	aes_decrypt_block(aes_cached_context(key), state);
 }
 
 //*****************************************************************************
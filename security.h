@@ -27,6 +27,11 @@
 *           #ifdef  __cplusplus
 *  from line 86
 *
+*  Added tAesContext with aes_set_key, aes_encrypt_block and
+*  aes_decrypt_block, so the key schedule is expanded once per key
+*  rather than once per block. AES_COMPACT (the default on AVR)
+*  selects the byte-wise core; otherwise a 32-bit T-table core is used.
+*
 ****************************************************************************/
 
 
@@ -161,6 +166,67 @@ extern signed long aes_read_key(unsigned char *key);
 //*****************************************************************************
 extern signed long aes_write_key(unsigned char *key);
 
+// The byte-wise core only needs the S-boxes; the T-table core adds 2 KB of
+// tables, which is too much for AVR flash reads to pay for
+#if defined(__AVR__) && !defined(AES_COMPACT)
+#define AES_COMPACT
+#endif
+
+typedef struct _aes_context_t
+{
+#ifdef AES_COMPACT
+	unsigned char	aucRoundKeys[176];
+#else
+	unsigned long	aulEnc[44];				// round keys as big-endian column words
+	unsigned long	aulDec[44];				// equivalent inverse cipher round keys
+#endif
+} tAesContext;
+
+//*****************************************************************************
+//
+//!  aes_set_key
+//!
+//!  @param[out]  pCtx  context
+//!  @param[in]   key   AES128 key of size 16 bytes
+//!
+//!  @return  none
+//!
+//!  @brief   Expand the key into the context once, for any number of
+//!           aes_encrypt_block / aes_decrypt_block calls after it
+//!
+//*****************************************************************************
+extern void aes_set_key(tAesContext *pCtx, unsigned char *key);
+
+//*****************************************************************************
+//
+//!  aes_encrypt_block
+//!
+//!  @param[in]      pCtx   context from aes_set_key
+//!  @param[in\out]  state  16 bytes of plain text and cipher text, any
+//!                         alignment
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 ECB encryption of one block with a cached key schedule
+//!
+//*****************************************************************************
+extern void aes_encrypt_block(tAesContext *pCtx, unsigned char *state);
+
+//*****************************************************************************
+//
+//!  aes_decrypt_block
+//!
+//!  @param[in]      pCtx   context from aes_set_key
+//!  @param[in\out]  state  16 bytes of cipher text and plain text, any
+//!                         alignment
+//!
+//!  @return  none
+//!
+//!  @brief   AES128 ECB decryption of one block with a cached key schedule
+//!
+//*****************************************************************************
+extern void aes_decrypt_block(tAesContext *pCtx, unsigned char *state);
+
 #endif //CC3000_UNENCRYPTED_SMART_CONFIG
 
 #ifdef  __cplusplus
@@ -37,6 +37,36 @@
 		
 	because 'fd_set' here conflicts with Arduino's built in 'fd_set' from
 	sys/types.h
+	
+   + socket, accept and closesocket clear the socket's bit in
+     socket_close_wait_status so a reused descriptor does not inherit a
+     stale remote close
+     
+   + gethostbyname answers repeated lookups from a small cache (see
+     CC3000_DNS_CACHE_SIZE in socket.h)
+     
+   + simple_link_send split into simple_link_send_build and the send itself
+     so sendto_batch can build the next datagram while the previous one is
+     being acknowledged
+     
+   + recvfrom_batch added
+     
+   + setsockopt/getsockopt keep a per-socket shadow of the SOL_SOCKET
+     options: setting an option to the value it already has and reading
+     a known option no longer go to the CC3000. The shadow is reset by
+     socket, accept and closesocket
+     
+   + Per-socket traffic counters and latency histograms, compiled in with
+     CC3000_SOCKET_STATS
+     
+   + send_buffer_get / send_buffer_commit let the caller write send data
+     straight into the TX buffer; send_stream builds on them
+     
+   + connect_build factored out of connect; connect_async queues connects
+     and runs them one at a time in the background command slot
+     
+   + gethostbyname split into gethostbyname_build and cache helpers;
+     gethostbyname_async runs lookups in the background command slot
 * 
 ****************************************************************************/
 
@@ -145,6 +175,267 @@
 
 #define MDNS_DEVICE_SERVICE_MAX_LENGTH 	(32)
 
+// Largest datagram recvfrom_batch asks for: what fits in the RX buffer after
+// the SPI/HCI headers, the recvfrom arguments (including the source address),
+// the SPI pad byte and the overrun magic number
+#define RECVFROM_BATCH_ARGS_LEN		(BSD_RECV_FROM_FROM_OFFSET + ASIC_ADDR_LEN)
+#define RECVFROM_BATCH_MAX_DATA_LEN	(CC3000_RX_BUFFER_SIZE - HEADERS_SIZE_DATA \
+									 - RECVFROM_BATCH_ARGS_LEN - 2)
+
+// Largest chunk that can be written in place in a send packet, same sums as
+// SENDTO_BATCH_MAX_DATA_LEN without the address
+#define SEND_BUFFER_MAX_DATA_LEN	(CC3000_TX_BUFFER_SIZE - HEADERS_SIZE_DATA \
+									 - HCI_CMND_SEND_ARG_LENGTH - 2)
+
+// Largest datagram sendto_batch can fit in the TX buffer: leave room for the
+// SPI/HCI headers, the sendto arguments, the 8 byte address, the SPI pad
+// byte and the overrun magic number
+#define SENDTO_BATCH_MAX_DATA_LEN	(CC3000_TX_BUFFER_SIZE - HEADERS_SIZE_DATA \
+									 - SOCKET_SENDTO_PARAMS_LEN - ASIC_ADDR_LEN - 2)
+
+
+#ifndef CC3000_TINY_DRIVER
+// Host copy of the socket options set through setsockopt. Bit (1 << optname)
+// of ucKnown says the value is known; SOCKOPT_RECV_NONBLOCK and
+// SOCKOPT_ACCEPT_NONBLOCK are kept as bit (1 << optname) of ucFlags,
+// SOCKOPT_RECV_TIMEOUT in ulRecvTimeout
+typedef struct _sockopt_shadow_t
+{
+	unsigned long	ulRecvTimeout;
+	unsigned char	ucKnown;
+	unsigned char	ucFlags;
+} tSockOptShadow;
+
+#define SOCKOPT_SHADOW_MASK(optname)	(1 << (optname))
+#define SOCKOPT_SHADOW_OPTNAME_OK(level, optname)	(((level) == SOL_SOCKET) && \
+			(((optname) == SOCKOPT_RECV_NONBLOCK) || ((optname) == SOCKOPT_RECV_TIMEOUT) || \
+			 ((optname) == SOCKOPT_ACCEPT_NONBLOCK)))
+
+static tSockOptShadow sockopt_shadow[8];
+
+static tRecvfromBatchStats recvfrom_batch_counters;
+
+//*****************************************************************************
+//
+//! sockopt_shadow_reset
+//!
+//!  @param  sd        socket descriptor
+//!  @param  ucFresh   1 for a socket just returned by socket(), whose
+//!                    receive and accept calls are known to be blocking
+//!
+//!  @return none
+//!
+//!  @brief  Forget the options of a descriptor that has been closed or
+//!          handed out again
+//
+//*****************************************************************************
+static void
+sockopt_shadow_reset(long sd, unsigned char ucFresh)
+{
+	if (M_IS_VALID_SD(sd))
+	{
+		sockopt_shadow[sd].ucKnown = 0;
+		sockopt_shadow[sd].ucFlags = 0;
+		
+		if (ucFresh)
+		{
+			sockopt_shadow[sd].ucKnown = SOCKOPT_SHADOW_MASK(SOCKOPT_RECV_NONBLOCK) |
+				SOCKOPT_SHADOW_MASK(SOCKOPT_ACCEPT_NONBLOCK);
+			sockopt_shadow[sd].ucFlags = (SOCK_OFF << SOCKOPT_RECV_NONBLOCK) |
+				(SOCK_OFF << SOCKOPT_ACCEPT_NONBLOCK);
+		}
+	}
+}
+
+//*****************************************************************************
+//
+//! sockopt_shadow_lookup
+//!
+//!  @param  sd        socket descriptor
+//!  @param  level     option level
+//!  @param  optname   option name
+//!  @param  pulValue  filled with the option value if it is known
+//!
+//!  @return 1 if the value is known, 0 otherwise
+//
+//*****************************************************************************
+static unsigned char
+sockopt_shadow_lookup(long sd, long level, long optname, unsigned long *pulValue)
+{
+	if (!M_IS_VALID_SD(sd) || !SOCKOPT_SHADOW_OPTNAME_OK(level, optname) ||
+			!(sockopt_shadow[sd].ucKnown & SOCKOPT_SHADOW_MASK(optname)))
+	{
+		return 0;
+	}
+	
+	if (optname == SOCKOPT_RECV_TIMEOUT)
+	{
+		*pulValue = sockopt_shadow[sd].ulRecvTimeout;
+	}
+	else
+	{
+		*pulValue = (sockopt_shadow[sd].ucFlags & SOCKOPT_SHADOW_MASK(optname)) ? SOCK_OFF : SOCK_ON;
+	}
+	
+	return 1;
+}
+
+//*****************************************************************************
+//
+//! sockopt_shadow_store
+//!
+//!  @param  sd        socket descriptor
+//!  @param  level     option level
+//!  @param  optname   option name
+//!  @param  ulValue   value the CC3000 accepted
+//!  @param  ucValid   0 if the set failed and the value is now unknown
+//!
+//!  @return none
+//
+//*****************************************************************************
+static void
+sockopt_shadow_store(long sd, long level, long optname, unsigned long ulValue,
+                     unsigned char ucValid)
+{
+	unsigned char ucMask;
+	
+	if (!M_IS_VALID_SD(sd) || !SOCKOPT_SHADOW_OPTNAME_OK(level, optname))
+	{
+		return;
+	}
+	
+	ucMask = SOCKOPT_SHADOW_MASK(optname);
+	
+	if (!ucValid || ((optname != SOCKOPT_RECV_TIMEOUT) && (ulValue > SOCK_OFF)))
+	{
+		sockopt_shadow[sd].ucKnown &= ~ucMask;
+		return;
+	}
+	
+	if (optname == SOCKOPT_RECV_TIMEOUT)
+	{
+		sockopt_shadow[sd].ulRecvTimeout = ulValue;
+	}
+	else if (ulValue == SOCK_OFF)
+	{
+		sockopt_shadow[sd].ucFlags |= ucMask;
+	}
+	else
+	{
+		sockopt_shadow[sd].ucFlags &= ~ucMask;
+	}
+	
+	sockopt_shadow[sd].ucKnown |= ucMask;
+}
+#endif
+
+
+#ifdef CC3000_SOCKET_STATS
+static tSocketStats socket_stats[8];
+
+//*****************************************************************************
+//
+//! socket_stats_latency
+//!
+//!  @param  pusHist   histogram to update
+//!  @param  ulStart   micros() when the operation started
+//!
+//!  @return none
+//!
+//!  @brief  Add one sample to a log2 latency histogram
+//
+//*****************************************************************************
+static void
+socket_stats_latency(unsigned short *pusHist, unsigned long ulStart)
+{
+	unsigned long ulMicros;
+	unsigned char ucBucket;
+	
+	ulMicros = micros() - ulStart;
+	ucBucket = 0;
+	while ((ulMicros >>= 1) && (ucBucket < (SOCKET_STATS_HIST_BUCKETS - 1)))
+	{
+		ucBucket++;
+	}
+	
+	if (pusHist[ucBucket] != 0xFFFF)
+	{
+		pusHist[ucBucket]++;
+	}
+}
+
+//*****************************************************************************
+//
+//! socket_stats_count_inactive
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+void
+socket_stats_count_inactive(long sd)
+{
+	if (M_IS_VALID_SD(sd))
+	{
+		socket_stats[sd].usInactiveErrors++;
+	}
+}
+
+//*****************************************************************************
+//
+//! socket_stats_snapshot
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+socket_stats_snapshot(long sd, tSocketStats *pStats)
+{
+	if (!M_IS_VALID_SD(sd))
+	{
+		return EFAIL;
+	}
+	
+	memcpy(pStats, &socket_stats[sd], sizeof(tSocketStats));
+	
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! socket_stats_reset
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+void
+socket_stats_reset(long sd)
+{
+	if (M_IS_VALID_SD(sd))
+	{
+		memset(&socket_stats[sd], 0, sizeof(tSocketStats));
+	}
+	else if (sd == -1)
+	{
+		memset(socket_stats, 0, sizeof(socket_stats));
+	}
+}
+
+// Statements, so they are safe as the body of an if / else
+#define SOCKET_STATS_TX(sd, len)			do { if (M_IS_VALID_SD(sd)) { socket_stats[sd].ulTxPackets++; socket_stats[sd].ulTxBytes += (len); } } while (0)
+#define SOCKET_STATS_RX(sd, len)			do { if (M_IS_VALID_SD(sd)) { socket_stats[sd].ulRxPackets++; socket_stats[sd].ulRxBytes += (len); } } while (0)
+#define SOCKET_STATS_SEND_LATENCY(sd, start)	do { if (M_IS_VALID_SD(sd)) { socket_stats_latency(socket_stats[sd].ausSendLatency, (start)); } } while (0)
+#define SOCKET_STATS_RECV_LATENCY(sd, start)	do { if (M_IS_VALID_SD(sd)) { socket_stats_latency(socket_stats[sd].ausRecvLatency, (start)); } } while (0)
+#define SOCKET_STATS_INACTIVE(sd)			socket_stats_count_inactive(sd)
+#define SOCKET_STATS_TIMESTAMP(var)			(var) = micros()
+#else
+#define SOCKET_STATS_TX(sd, len)			do { } while (0)
+#define SOCKET_STATS_RX(sd, len)			do { } while (0)
+#define SOCKET_STATS_SEND_LATENCY(sd, start)	do { } while (0)
+#define SOCKET_STATS_RECV_LATENCY(sd, start)	do { } while (0)
+#define SOCKET_STATS_INACTIVE(sd)			do { } while (0)
+#define SOCKET_STATS_TIMESTAMP(var)			do { } while (0)
+#endif
+
 
 //*****************************************************************************
 //
@@ -166,6 +457,11 @@ int
 HostFlowControlConsumeBuff(int sd)
 {
 #ifndef SEND_NON_BLOCKING
+#ifdef CC3000_SOCKET_STATS
+	unsigned long ulStallStart = micros();
+	unsigned char ucStalled = (0 == tSLInformation.usNumberOfFreeBuffers);
+#endif
+	
 	/* wait in busy loop */
 	do
 	{
@@ -180,9 +476,20 @@ HostFlowControlConsumeBuff(int sd)
 		}
 		
 		if(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd))
+		{
+			SOCKET_STATS_INACTIVE(sd);
 			return -1;
+		}
 	} while(0 == tSLInformation.usNumberOfFreeBuffers);
 	
+#ifdef CC3000_SOCKET_STATS
+	if (ucStalled && M_IS_VALID_SD(sd))
+	{
+		socket_stats[sd].ulStalls++;
+		socket_stats[sd].ulStallMicros += micros() - ulStallStart;
+	}
+#endif
+	
 	tSLInformation.usNumberOfFreeBuffers--;
 	
 	return 0;
@@ -198,13 +505,22 @@ HostFlowControlConsumeBuff(int sd)
 		return errno;
 	}
 	if(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd))
+	{
+		SOCKET_STATS_INACTIVE(sd);
 		return -1;
+	}
 	
 	//If there are no available buffers, return -2. It is recommended to use  
 	// select or receive to see if there is any buffer occupied with received data
 	// If so, call receive() to release the buffer.
 	if(0 == tSLInformation.usNumberOfFreeBuffers)
 	{
+#ifdef CC3000_SOCKET_STATS
+		if (M_IS_VALID_SD(sd))
+		{
+			socket_stats[sd].ulStalls++;
+		}
+#endif
 		return -2;
 	}
 	else
@@ -262,10 +578,27 @@ socket(long domain, long type, long protocol)
 	errno = ret;
 	
 	set_socket_active_status(ret, SOCKET_STATUS_ACTIVE);
+	set_socket_close_wait_status(ret, 0);
+	
+#ifndef CC3000_TINY_DRIVER
+	sockopt_shadow_reset(ret, 1);
+#endif
+	
+#ifdef CC3000_SOCKET_STATS
+	// socket_stats_reset(-1) would clear every socket's statistics
+	if (M_IS_VALID_SD(ret))
+	{
+		socket_stats_reset(ret);
+	}
+#endif
 	
 	return(ret);
 }
 
+#ifndef CC3000_TINY_DRIVER
+static long connect_async_close(long sd);
+#endif
+
 //*****************************************************************************
 //
 //! closesocket
@@ -284,6 +617,21 @@ closesocket(long sd)
 	long ret;
 	unsigned char *ptr, *args;
 	
+#ifndef CC3000_TINY_DRIVER
+	// Rather than wait for a connect_async still running on this socket,
+	// leave the close to connect_async_poll. The socket's state is reset
+	// here as on the normal path; its statistics stay readable until the
+	// handle is reused, as they do after a normal close.
+	if (connect_async_close(sd) == 0)
+	{
+		set_socket_active_status(sd, SOCKET_STATUS_INACTIVE);
+		set_socket_close_wait_status(sd, 0);
+		sockopt_shadow_reset(sd, 0);
+		errno = 0;
+		return(0);
+	}
+#endif
+	
 	ret = EFAIL;
 	ptr = tSLInformation.pucTxCommandBuffer;
 	args = (ptr + HEADERS_SIZE_CMD);
@@ -302,6 +650,12 @@ closesocket(long sd)
 	// since 'close' call may result in either OK (and then it closed) or error 
 	// mark this socket as invalid 
 	set_socket_active_status(sd, SOCKET_STATUS_INACTIVE);
+	set_socket_close_wait_status(sd, 0);
+	
+#ifndef CC3000_TINY_DRIVER
+	sockopt_shadow_reset(sd, 0);
+	connect_async_cancel(sd);
+#endif
 	
 	return(ret);
 }
@@ -383,6 +737,13 @@ accept(long sd, sockaddr *addr, socklen_t *addrlen)
 	if(M_IS_VALID_SD(ret))
 	{
 		set_socket_active_status(ret, SOCKET_STATUS_ACTIVE);
+		set_socket_close_wait_status(ret, 0);
+#ifndef CC3000_TINY_DRIVER
+		sockopt_shadow_reset(ret, 0);
+#endif
+#ifdef CC3000_SOCKET_STATS
+		socket_stats_reset(ret);
+#endif
 	}
 	else
 	{
@@ -513,81 +874,648 @@ listen(long sd, long backlog)
 //*****************************************************************************
 
 #ifndef CC3000_TINY_DRIVER
-int 
-gethostbyname(char * hostname, unsigned short usNameLen, 
-							unsigned long* out_ip_addr)
+#if (CC3000_DNS_CACHE_SIZE > 0)
+
+typedef struct _gethostbyname_cache_entry_t
 {
-	tBsdGethostbynameParams ret;
-	unsigned char *ptr, *args;
-	
-	errno = EFAIL;
+	unsigned long	ulHash;
+	unsigned long	ulAddress;
+	unsigned long	ulStamp;		// millis() when the answer was stored
+	long			lRetVal;
+	unsigned char	ucNameLen;		// 0 means the slot is free
+} tGethostbynameCacheEntry;
+
+static tGethostbynameCacheEntry gethostbyname_cache[CC3000_DNS_CACHE_SIZE];
+static tGethostbynameCacheStats gethostbyname_cache_counters;
+
+//*****************************************************************************
+//
+//! gethostbyname_hash
+//!
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!
+//!  @return  32 bit FNV-1a hash of the lower-cased name
+//!
+//!  @brief  Host names are kept as a hash (plus the length) rather than a
+//!          copy, so an entry costs the same RAM whatever the name length.
+//
+//*****************************************************************************
+static unsigned long
+gethostbyname_hash(const char *hostname, unsigned short usNameLen)
+{
+	unsigned long ulHash = 2166136261UL;
+	unsigned char c;
 	
-	if (usNameLen > HOSTNAME_MAX_LENGTH)
+	while (usNameLen--)
 	{
-		return errno;
+		c = *hostname++;
+		if ((c >= 'A') && (c <= 'Z'))
+		{
+			c += 'a' - 'A';
+		}
+		ulHash = (ulHash ^ c) * 16777619UL;
 	}
 	
-	ptr = tSLInformation.pucTxCommandBuffer;
-	args = (ptr + SIMPLE_LINK_HCI_CMND_TRANSPORT_HEADER_SIZE);
-	
-	// Fill in HCI packet structure
-	args = UINT32_TO_STREAM(args, 8);
-	args = UINT32_TO_STREAM(args, usNameLen);
-	ARRAY_TO_STREAM(args, hostname, usNameLen);
-	
-	// Initiate a HCI command
-	hci_command_send(HCI_CMND_GETHOSTNAME, ptr, SOCKET_GET_HOST_BY_NAME_PARAMS_LEN
-									 + usNameLen - 1);
-	
-	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_EVNT_BSD_GETHOSTBYNAME, &ret);
-	
-	errno = ret.retVal;
-	
-	(*((long*)out_ip_addr)) = ret.outputAddress;
-	
-	return (errno);
-	
+	return ulHash;
 }
-#endif
 
 //*****************************************************************************
 //
-//! connect
-//!
-//!  @param[in]   sd       socket descriptor (handle)         
-//!  @param[in]   addr     specifies the destination addr. On this version
-//!                        only AF_INET is supported.
-//!  @param[out]  addrlen  contains the size of the structure pointed to by addr    
-//!  @return  	On success, zero is returned. On error, -1 is returned
+//! gethostbyname_cache_flush
 //!
-//!  @brief  initiate a connection on a socket 
-//!          Function connects the socket referred to by the socket descriptor 
-//!          sd, to the address specified by addr. The addrlen argument 
-//!          specifies the size of addr. The format of the address in addr is 
-//!          determined by the address space of the socket. If it is of type 
-//!          SOCK_DGRAM, this call specifies the peer with which the socket is 
-//!          to be associated; this address is that to which datagrams are to be
-//!          sent, and the only address from which datagrams are to be received.  
-//!          If the socket is of type SOCK_STREAM, this call attempts to make a 
-//!          connection to another socket. The other socket is specified  by 
-//!          address, which is an address in the communications space of the
-//!          socket. Note that the function implements only blocking behavior 
-//!          thus the caller will be waiting either for the connection 
-//!          establishment or for the connection establishment failure.
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+void
+gethostbyname_cache_flush(void)
+{
+	memset(gethostbyname_cache, 0, sizeof(gethostbyname_cache));
+	gethostbyname_cache_counters.ulFlushes++;
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_stats
 //!
-//!  @sa socket
+//!  @brief  see socket.h
 //
 //*****************************************************************************
+void
+gethostbyname_cache_stats(tGethostbynameCacheStats *pStats)
+{
+	memcpy(pStats, &gethostbyname_cache_counters, sizeof(tGethostbynameCacheStats));
+}
 
-long
-connect(long sd, const sockaddr *addr, long addrlen)
+//*****************************************************************************
+//
+//! gethostbyname_cache_find
+//!
+//!  @param  ulHash     gethostbyname_hash of the name
+//!  @param  usNameLen  name length
+//!
+//!  @return  the live entry for the name, or NULL. Expired entries met on
+//!           the way are freed.
+//
+//*****************************************************************************
+static tGethostbynameCacheEntry *
+gethostbyname_cache_find(unsigned long ulHash, unsigned short usNameLen)
 {
-	long int ret;
-	unsigned char *ptr, *args;
+	tGethostbynameCacheEntry *pEntry;
+	unsigned long ulNow, ulTtl;
+	unsigned char i;
+	
+	ulNow = millis();
+	
+	for (i = 0; i < CC3000_DNS_CACHE_SIZE; i++)
+	{
+		pEntry = &gethostbyname_cache[i];
+		
+		if (pEntry->ucNameLen == 0)
+		{
+			continue;
+		}
+		
+		ulTtl = (pEntry->lRetVal > 0) ? CC3000_DNS_CACHE_TTL_MS : CC3000_DNS_CACHE_NEG_TTL_MS;
+		
+		if ((ulNow - pEntry->ulStamp) >= ulTtl)
+		{
+			// Expired, free the slot for reuse
+			pEntry->ucNameLen = 0;
+			continue;
+		}
+		
+		if ((pEntry->ulHash == ulHash) && (pEntry->ucNameLen == usNameLen))
+		{
+			gethostbyname_cache_counters.ulHits++;
+			if (pEntry->lRetVal <= 0)
+			{
+				gethostbyname_cache_counters.ulNegativeHits++;
+			}
+			if (gethostbyname_cache_counters.ulMisses)
+			{
+				gethostbyname_cache_counters.ulSavedMillis += 
+					gethostbyname_cache_counters.ulQueryMillis / gethostbyname_cache_counters.ulMisses;
+			}
+			
+			return pEntry;
+		}
+	}
+	
+	return NULL;
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_store
+//!
+//!  @param  ulHash         gethostbyname_hash of the name
+//!  @param  usNameLen      name length
+//!  @param  ulAddress      address returned by the CC3000
+//!  @param  lRetVal        return value from the CC3000
+//!  @param  ulQueryMillis  time the query took
+//!
+//!  @return  none
+//!
+//!  @brief  Store an answer in a free slot, or over the oldest entry
+//
+//*****************************************************************************
+static void
+gethostbyname_cache_store(unsigned long ulHash, unsigned short usNameLen,
+                          unsigned long ulAddress, long lRetVal, unsigned long ulQueryMillis)
+{
+	tGethostbynameCacheEntry *pEntry, *pVictim;
+	unsigned long ulNow;
+	unsigned char i;
+	
+	ulNow = millis();
+	pVictim = &gethostbyname_cache[0];
+	
+	for (i = 0; i < CC3000_DNS_CACHE_SIZE; i++)
+	{
+		pEntry = &gethostbyname_cache[i];
+		
+		if (pEntry->ucNameLen == 0)
+		{
+			pVictim = pEntry;
+			break;
+		}
+		
+		if ((ulNow - pEntry->ulStamp) > (ulNow - pVictim->ulStamp))
+		{
+			pVictim = pEntry;
+		}
+	}
+	
+	gethostbyname_cache_counters.ulMisses++;
+	gethostbyname_cache_counters.ulQueryMillis += ulQueryMillis;
+	
+	// A zero address is a failed lookup too, cache it as such
+	pVictim->ulHash = ulHash;
+	pVictim->ulAddress = ulAddress;
+	pVictim->ulStamp = ulNow;
+	pVictim->lRetVal = (ulAddress != 0) ? lRetVal : ((lRetVal > 0) ? EFAIL : lRetVal);
+	pVictim->ucNameLen = (unsigned char)usNameLen;
+}
+
+#endif
+
+//*****************************************************************************
+//
+//! gethostbyname_build
+//!
+//!  @param  ptr        command buffer
+//!  @param  hostname   host name
+//!  @param  usNameLen  name length
+//!
+//!  @return  length of the command arguments
+//
+//*****************************************************************************
+static unsigned char
+gethostbyname_build(unsigned char *ptr, const char *hostname, unsigned short usNameLen)
+{
+	unsigned char *args;
+	
+	args = (ptr + SIMPLE_LINK_HCI_CMND_TRANSPORT_HEADER_SIZE);
+	
+	// Fill in HCI packet structure
+	args = UINT32_TO_STREAM(args, 8);
+	args = UINT32_TO_STREAM(args, usNameLen);
+	ARRAY_TO_STREAM(args, hostname, usNameLen);
+	
+	return (SOCKET_GET_HOST_BY_NAME_PARAMS_LEN + usNameLen - 1);
+}
+
+int 
+gethostbyname(char * hostname, unsigned short usNameLen, 
+							unsigned long* out_ip_addr)
+{
+	tBsdGethostbynameParams ret;
+	unsigned char *ptr;
+#if (CC3000_DNS_CACHE_SIZE > 0)
+	tGethostbynameCacheEntry *pEntry;
+	unsigned long ulHash, ulStart;
+#endif
+	
+	errno = EFAIL;
+	
+	if (usNameLen > HOSTNAME_MAX_LENGTH)
+	{
+		return errno;
+	}
+	
+#if (CC3000_DNS_CACHE_SIZE > 0)
+	ulHash = gethostbyname_hash(hostname, usNameLen);
+	pEntry = gethostbyname_cache_find(ulHash, usNameLen);
+	if (pEntry)
+	{
+		*out_ip_addr = pEntry->ulAddress;
+		errno = pEntry->lRetVal;
+		return (errno);
+	}
+	ulStart = millis();
+#endif
 	
-	ret = EFAIL;
 	ptr = tSLInformation.pucTxCommandBuffer;
+	
+	// Initiate a HCI command
+	hci_command_send(HCI_CMND_GETHOSTNAME, ptr, 
+									 gethostbyname_build(ptr, hostname, usNameLen));
+	
+	// Since we are in blocking state - wait for event complete
+	SimpleLinkWaitEvent(HCI_EVNT_BSD_GETHOSTBYNAME, &ret);
+	
+	errno = ret.retVal;
+	
+	(*((long*)out_ip_addr)) = ret.outputAddress;
+	
+#if (CC3000_DNS_CACHE_SIZE > 0)
+	gethostbyname_cache_store(ulHash, usNameLen, ret.outputAddress, ret.retVal,
+	                          millis() - ulStart);
+#endif
+	
+	return (errno);
+	
+}
+
+#define GETHOSTBYNAME_ASYNC_STATE_FREE		(0)
+#define GETHOSTBYNAME_ASYNC_STATE_QUEUED	(1)		// waiting for the CC3000
+#define GETHOSTBYNAME_ASYNC_STATE_RUNNING	(2)		// HCI_CMND_GETHOSTNAME sent
+#define GETHOSTBYNAME_ASYNC_STATE_DONE		(3)		// result not yet delivered
+
+typedef struct _gethostbyname_async_entry_t
+{
+	tGethostbynameAsyncCallback	callback;
+	const char					*pcName;
+	unsigned long				ulIp;
+	unsigned long				ulQueued;		// millis() at gethostbyname_async()
+	unsigned long				ulStarted;		// millis() when sent to the CC3000
+	unsigned long				ulMillis;		// ulQueued to the answer
+	long						lRetVal;
+	unsigned short				usNameLen;
+	unsigned char				ucState;
+} tGethostbynameAsyncEntry;
+
+static tGethostbynameAsyncEntry gethostbyname_async_table[GETHOSTBYNAME_ASYNC_MAX];
+static tGethostbynameAsyncStats gethostbyname_async_counters;
+
+//*****************************************************************************
+//
+//! gethostbyname_async_complete
+//!
+//!  @param  pEntry   the lookup
+//!  @param  lRetVal  gethostbyname return value
+//!  @param  ulIp     resolved address, 0 on failure
+//!
+//!  @return  none
+//
+//*****************************************************************************
+static void
+gethostbyname_async_complete(tGethostbynameAsyncEntry *pEntry, long lRetVal,
+                             unsigned long ulIp)
+{
+	pEntry->lRetVal = lRetVal;
+	pEntry->ulIp = ulIp;
+	pEntry->ulMillis = millis() - pEntry->ulQueued;
+	pEntry->ucState = GETHOSTBYNAME_ASYNC_STATE_DONE;
+	
+	if ((lRetVal > 0) && (ulIp != 0))
+	{
+		gethostbyname_async_counters.ulResolved++;
+	}
+	else
+	{
+		gethostbyname_async_counters.ulFailed++;
+	}
+	if (pEntry->ulMillis > gethostbyname_async_counters.ulMaxMillis)
+	{
+		gethostbyname_async_counters.ulMaxMillis = pEntry->ulMillis;
+	}
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_async_run
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Collect the answer to the running lookup and start the next
+//!          queued one. Names found in the cache complete without a query.
+//
+//*****************************************************************************
+static void
+gethostbyname_async_run(void)
+{
+	tGethostbynameAsyncEntry *pEntry, *pNext;
+	unsigned char aucParams[HCI_ASYNC_PARAMS_LEN];
+	unsigned long ulRetVal, ulIp, ulMillis;
+	unsigned char i;
+	long res;
+#if (CC3000_DNS_CACHE_SIZE > 0)
+	tGethostbynameCacheEntry *pCached;
+#endif
+	
+	for (i = 0; i < GETHOSTBYNAME_ASYNC_MAX; i++)
+	{
+		pEntry = &gethostbyname_async_table[i];
+		if (pEntry->ucState != GETHOSTBYNAME_ASYNC_STATE_RUNNING)
+		{
+			continue;
+		}
+		
+		res = hci_async_poll(HCI_EVNT_BSD_GETHOSTBYNAME, aucParams);
+		if (res == 0)
+		{
+			// Still running, nothing else can be started
+			return;
+		}
+		
+		if (res == 1)
+		{
+			STREAM_TO_UINT32((char *)aucParams, GET_HOST_BY_NAME_RETVAL_OFFSET, ulRetVal);
+			STREAM_TO_UINT32((char *)aucParams, GET_HOST_BY_NAME_ADDR_OFFSET, ulIp);
+		}
+		else
+		{
+			// The CC3000 was stopped while the lookup was running
+			ulRetVal = (unsigned long)EFAIL;
+			ulIp = 0;
+		}
+		
+		ulMillis = millis() - pEntry->ulStarted;
+		gethostbyname_async_counters.ulResolveMillis += ulMillis;
+#if (CC3000_DNS_CACHE_SIZE > 0)
+		if (res == 1)
+		{
+			gethostbyname_cache_store(gethostbyname_hash(pEntry->pcName, pEntry->usNameLen),
+			                          pEntry->usNameLen, ulIp, (long)ulRetVal, ulMillis);
+		}
+#endif
+		gethostbyname_async_complete(pEntry, (long)ulRetVal, ulIp);
+	}
+	
+	for (;;)
+	{
+		// Oldest queued lookup first
+		pNext = NULL;
+		for (i = 0; i < GETHOSTBYNAME_ASYNC_MAX; i++)
+		{
+			pEntry = &gethostbyname_async_table[i];
+			if ((pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_QUEUED) &&
+					((pNext == NULL) || ((long)(pEntry->ulQueued - pNext->ulQueued) < 0)))
+			{
+				pNext = pEntry;
+			}
+		}
+		
+		if (pNext == NULL)
+		{
+			return;
+		}
+		
+#if (CC3000_DNS_CACHE_SIZE > 0)
+		// An earlier lookup may have answered this one meanwhile
+		pCached = gethostbyname_cache_find(gethostbyname_hash(pNext->pcName, pNext->usNameLen),
+		                                   pNext->usNameLen);
+		if (pCached)
+		{
+			gethostbyname_async_counters.ulCacheHits++;
+			gethostbyname_async_complete(pNext, pCached->lRetVal, pCached->ulAddress);
+			continue;
+		}
+#endif
+		
+		if (tSLInformation.pucTxCommandBuffer == NULL)
+		{
+			return;
+		}
+		
+		// Fails if another background command (e.g. a connect) holds the slot
+		if (hci_async_command_send(HCI_CMND_GETHOSTNAME, tSLInformation.pucTxCommandBuffer,
+				gethostbyname_build(tSLInformation.pucTxCommandBuffer, pNext->pcName, pNext->usNameLen),
+				HCI_EVNT_BSD_GETHOSTBYNAME) == 0)
+		{
+			pNext->ulStarted = millis();
+			pNext->ucState = GETHOSTBYNAME_ASYNC_STATE_RUNNING;
+			gethostbyname_async_counters.ulQueueMillis += pNext->ulStarted - pNext->ulQueued;
+		}
+		
+		return;
+	}
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_async
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+gethostbyname_async(const char *hostname, unsigned short usNameLen,
+                    tGethostbynameAsyncCallback callback)
+{
+	tGethostbynameAsyncEntry *pEntry;
+	unsigned char i;
+	
+	if ((hostname == NULL) || (usNameLen == 0) || (usNameLen > HOSTNAME_MAX_LENGTH))
+	{
+		return EFAIL;
+	}
+	
+	for (i = 0; i < GETHOSTBYNAME_ASYNC_MAX; i++)
+	{
+		pEntry = &gethostbyname_async_table[i];
+		if (pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_FREE)
+		{
+			pEntry->callback = callback;
+			pEntry->pcName = hostname;
+			pEntry->usNameLen = usNameLen;
+			pEntry->ulQueued = millis();
+			pEntry->ucState = GETHOSTBYNAME_ASYNC_STATE_QUEUED;
+			
+			gethostbyname_async_counters.ulRequests++;
+			
+			// Callbacks are only ever called from gethostbyname_async_poll
+			gethostbyname_async_run();
+			
+			return i;
+		}
+	}
+	
+	gethostbyname_async_counters.ulRejected++;
+	
+	return EFAIL;
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_async_poll
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+gethostbyname_async_poll(void)
+{
+	tGethostbynameAsyncEntry *pEntry;
+	unsigned char i;
+	long lPending;
+	
+	gethostbyname_async_run();
+	
+	lPending = 0;
+	for (i = 0; i < GETHOSTBYNAME_ASYNC_MAX; i++)
+	{
+		pEntry = &gethostbyname_async_table[i];
+		
+		if ((pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_DONE) && pEntry->callback)
+		{
+			// Free the entry first so the callback can start another lookup
+			pEntry->ucState = GETHOSTBYNAME_ASYNC_STATE_FREE;
+			pEntry->callback(i, pEntry->lRetVal, pEntry->ulIp, pEntry->ulMillis);
+		}
+		else if ((pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_QUEUED) ||
+				(pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_RUNNING))
+		{
+			lPending++;
+		}
+	}
+	
+	return lPending;
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_async_status
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+gethostbyname_async_status(long lHandle, unsigned long *pulIp, unsigned long *pulMillis)
+{
+	tGethostbynameAsyncEntry *pEntry;
+	
+	if ((lHandle < 0) || (lHandle >= GETHOSTBYNAME_ASYNC_MAX))
+	{
+		return EFAIL;
+	}
+	
+	gethostbyname_async_run();
+	
+	pEntry = &gethostbyname_async_table[lHandle];
+	
+	if ((pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_FREE) || pEntry->callback)
+	{
+		return EFAIL;
+	}
+	
+	if (pEntry->ucState != GETHOSTBYNAME_ASYNC_STATE_DONE)
+	{
+		return SOC_IN_PROGRESS;
+	}
+	
+	if (pulIp)
+	{
+		*pulIp = pEntry->ulIp;
+	}
+	if (pulMillis)
+	{
+		*pulMillis = pEntry->ulMillis;
+	}
+	pEntry->ucState = GETHOSTBYNAME_ASYNC_STATE_FREE;
+	
+	// A zero address is a failed lookup
+	return (pEntry->ulIp != 0) ? pEntry->lRetVal : 
+		((pEntry->lRetVal > 0) ? EFAIL : pEntry->lRetVal);
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_async_cancel
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+gethostbyname_async_cancel(long lHandle)
+{
+	tGethostbynameAsyncEntry *pEntry;
+	
+	if ((lHandle < 0) || (lHandle >= GETHOSTBYNAME_ASYNC_MAX))
+	{
+		return EFAIL;
+	}
+	
+	pEntry = &gethostbyname_async_table[lHandle];
+	
+	if ((pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_FREE) ||
+			(pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_RUNNING))
+	{
+		return EFAIL;
+	}
+	
+	if (pEntry->ucState == GETHOSTBYNAME_ASYNC_STATE_QUEUED)
+	{
+		gethostbyname_async_counters.ulCancelled++;
+	}
+	pEntry->ucState = GETHOSTBYNAME_ASYNC_STATE_FREE;
+	
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! gethostbyname_async_stats
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+void
+gethostbyname_async_stats(tGethostbynameAsyncStats *pStats)
+{
+	memcpy(pStats, &gethostbyname_async_counters, sizeof(tGethostbynameAsyncStats));
+}
+#endif
+
+//*****************************************************************************
+//
+//! connect
+//!
+//!  @param[in]   sd       socket descriptor (handle)         
+//!  @param[in]   addr     specifies the destination addr. On this version
+//!                        only AF_INET is supported.
+//!  @param[out]  addrlen  contains the size of the structure pointed to by addr    
+//!  @return  	On success, zero is returned. On error, -1 is returned
+//!
+//!  @brief  initiate a connection on a socket 
+//!          Function connects the socket referred to by the socket descriptor 
+//!          sd, to the address specified by addr. The addrlen argument 
+//!          specifies the size of addr. The format of the address in addr is 
+//!          determined by the address space of the socket. If it is of type 
+//!          SOCK_DGRAM, this call specifies the peer with which the socket is 
+//!          to be associated; this address is that to which datagrams are to be
+//!          sent, and the only address from which datagrams are to be received.  
+//!          If the socket is of type SOCK_STREAM, this call attempts to make a 
+//!          connection to another socket. The other socket is specified  by 
+//!          address, which is an address in the communications space of the
+//!          socket. Note that the function implements only blocking behavior 
+//!          thus the caller will be waiting either for the connection 
+//!          establishment or for the connection establishment failure.
+//!
+//!  @sa socket
+//
+//*****************************************************************************
+
+static void
+connect_build(unsigned char *ptr, long sd, const unsigned char *addr)
+{
+	unsigned char *args;
+	long addrlen;
+	
 	args = (ptr + SIMPLE_LINK_HCI_CMND_TRANSPORT_HEADER_SIZE);
 	addrlen = 8;
 	
@@ -595,7 +1523,22 @@ connect(long sd, const sockaddr *addr, long addrlen)
 	args = UINT32_TO_STREAM(args, sd);
 	args = UINT32_TO_STREAM(args, 0x00000008);
 	args = UINT32_TO_STREAM(args, addrlen);
-	ARRAY_TO_STREAM(args, ((unsigned char *)addr), addrlen);
+	ARRAY_TO_STREAM(args, addr, addrlen);
+}
+
+long
+connect(long sd, const sockaddr *addr, long addrlen)
+{
+	long int ret;
+	unsigned char *ptr;
+	
+	// The CC3000 always takes the 8 byte AF_INET address, whatever addrlen says
+	(void)addrlen;
+	
+	ret = EFAIL;
+	ptr = tSLInformation.pucTxCommandBuffer;
+	
+	connect_build(ptr, sd, (const unsigned char *)addr);
 	
 	// Initiate a HCI command
 	hci_command_send(HCI_CMND_CONNECT,
@@ -610,6 +1553,387 @@ connect(long sd, const sockaddr *addr, long addrlen)
 }
 
 
+#ifndef CC3000_TINY_DRIVER
+#define CONNECT_ASYNC_STATE_FREE		(0)
+#define CONNECT_ASYNC_STATE_QUEUED		(1)		// waiting for the CC3000
+#define CONNECT_ASYNC_STATE_RUNNING		(2)		// HCI_CMND_CONNECT sent
+#define CONNECT_ASYNC_STATE_DONE		(3)		// result waiting for connect_async_status
+#define CONNECT_ASYNC_STATE_CANCELLED	(4)		// running, result to be dropped
+#define CONNECT_ASYNC_STATE_CLOSING		(5)		// running, socket closed once it finishes
+
+// HCI_CMND_CONNECT sent and its event not collected yet
+#define CONNECT_ASYNC_IN_CC3000(state)	(((state) == CONNECT_ASYNC_STATE_RUNNING) || \
+										 ((state) == CONNECT_ASYNC_STATE_CANCELLED) || \
+										 ((state) == CONNECT_ASYNC_STATE_CLOSING))
+
+typedef struct _connect_async_entry_t
+{
+	tConnectAsyncCallback	callback;
+	unsigned long			ulQueued;		// millis() at connect_async()
+	unsigned long			ulStarted;		// millis() when sent to the CC3000
+	long					lResult;
+	unsigned char			aucAddr[8];
+	signed char				cSd;
+	unsigned char			ucState;
+} tConnectAsyncEntry;
+
+static tConnectAsyncEntry connect_async_table[CONNECT_ASYNC_MAX];
+static tConnectAsyncStats connect_async_counters;
+
+//*****************************************************************************
+//
+//! connect_async_find
+//!
+//!  @param  sd  socket handle
+//!
+//!  @return  the socket's connect_async entry, or NULL
+//
+//*****************************************************************************
+static tConnectAsyncEntry *
+connect_async_find(long sd)
+{
+	unsigned char i;
+	
+	for (i = 0; i < CONNECT_ASYNC_MAX; i++)
+	{
+		if ((connect_async_table[i].ucState != CONNECT_ASYNC_STATE_FREE) &&
+				(connect_async_table[i].cSd == sd))
+		{
+			return &connect_async_table[i];
+		}
+	}
+	
+	return NULL;
+}
+
+//*****************************************************************************
+//
+//! connect_async_pending
+//!
+//!  @return  number of connects queued or running
+//
+//*****************************************************************************
+static long
+connect_async_pending(void)
+{
+	unsigned char i;
+	long lPending;
+	
+	lPending = 0;
+	for (i = 0; i < CONNECT_ASYNC_MAX; i++)
+	{
+		if ((connect_async_table[i].ucState == CONNECT_ASYNC_STATE_QUEUED) ||
+				CONNECT_ASYNC_IN_CC3000(connect_async_table[i].ucState))
+		{
+			lPending++;
+		}
+	}
+	
+	return lPending;
+}
+
+//*****************************************************************************
+//
+//! connect_async_complete
+//!
+//!  @param  pEntry   the running connect
+//!  @param  lResult  0 if connected, negative on failure
+//!
+//!  @return  none
+//!
+//!  @brief  Record the result and hand it to the callback, or keep it for
+//!          connect_async_status if there is none
+//
+//*****************************************************************************
+static void
+connect_async_complete(tConnectAsyncEntry *pEntry, long lResult)
+{
+	unsigned long ulNow, ulMillis;
+	
+	ulNow = millis();
+	ulMillis = ulNow - pEntry->ulStarted;
+	
+	if (lResult == 0)
+	{
+		connect_async_counters.ulSucceeded++;
+	}
+	else
+	{
+		connect_async_counters.ulFailed++;
+	}
+	connect_async_counters.ulConnectMillis += ulMillis;
+	if (ulMillis > connect_async_counters.ulMaxConnectMillis)
+	{
+		connect_async_counters.ulMaxConnectMillis = ulMillis;
+	}
+	
+	if (pEntry->callback)
+	{
+		// Free the entry first so the callback can start another connect
+		pEntry->ucState = CONNECT_ASYNC_STATE_FREE;
+		pEntry->callback(pEntry->cSd, lResult, ulNow - pEntry->ulQueued);
+	}
+	else
+	{
+		pEntry->lResult = lResult;
+		pEntry->ucState = CONNECT_ASYNC_STATE_DONE;
+	}
+}
+
+//*****************************************************************************
+//
+//! connect_async_poll
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+connect_async_poll(void)
+{
+	tConnectAsyncEntry *pEntry, *pNext;
+	unsigned char aucParams[HCI_ASYNC_PARAMS_LEN];
+	unsigned long ulResult;
+	unsigned char i, ucClose;
+	long res;
+	
+	for (i = 0; i < CONNECT_ASYNC_MAX; i++)
+	{
+		pEntry = &connect_async_table[i];
+		if (!CONNECT_ASYNC_IN_CC3000(pEntry->ucState))
+		{
+			continue;
+		}
+		
+		res = hci_async_poll(HCI_EVNT_CONNECT, aucParams);
+		if (res == 0)
+		{
+			// Still running, nothing else can be started
+			return connect_async_pending();
+		}
+		
+		if (pEntry->ucState != CONNECT_ASYNC_STATE_RUNNING)
+		{
+			// Cancelled: nobody wants the result. The close closesocket left
+			// behind is only sent if the CC3000 wasn't stopped meanwhile.
+			ucClose = (pEntry->ucState == CONNECT_ASYNC_STATE_CLOSING) && (res == 1);
+			pEntry->ucState = CONNECT_ASYNC_STATE_FREE;
+			if (ucClose)
+			{
+				closesocket(pEntry->cSd);
+			}
+		}
+		else if (res == 1)
+		{
+			STREAM_TO_UINT32((char *)aucParams, 0, ulResult);
+			connect_async_complete(pEntry, (long)ulResult);
+		}
+		else
+		{
+			// The CC3000 was stopped while the connect was running
+			connect_async_complete(pEntry, EFAIL);
+		}
+	}
+	
+	// Start the oldest queued connect
+	pNext = NULL;
+	for (i = 0; i < CONNECT_ASYNC_MAX; i++)
+	{
+		pEntry = &connect_async_table[i];
+		if ((pEntry->ucState == CONNECT_ASYNC_STATE_QUEUED) &&
+				((pNext == NULL) || ((long)(pEntry->ulQueued - pNext->ulQueued) < 0)))
+		{
+			pNext = pEntry;
+		}
+	}
+	
+	if (pNext && tSLInformation.pucTxCommandBuffer)
+	{
+		connect_build(tSLInformation.pucTxCommandBuffer, pNext->cSd, pNext->aucAddr);
+		
+		// Fails if another background command (e.g. a lookup) holds the slot
+		if (hci_async_command_send(HCI_CMND_CONNECT, tSLInformation.pucTxCommandBuffer,
+				SOCKET_CONNECT_PARAMS_LEN, HCI_EVNT_CONNECT) == 0)
+		{
+			pNext->ulStarted = millis();
+			pNext->ucState = CONNECT_ASYNC_STATE_RUNNING;
+			connect_async_counters.ulQueueMillis += pNext->ulStarted - pNext->ulQueued;
+		}
+	}
+	
+	return connect_async_pending();
+}
+
+//*****************************************************************************
+//
+//! connect_async
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+connect_async(long sd, const sockaddr *addr, long addrlen, tConnectAsyncCallback callback)
+{
+	tConnectAsyncEntry *pEntry;
+	unsigned char i;
+	long lPending;
+	
+	if (!M_IS_VALID_SD(sd) || (addr == NULL) || (addrlen < (long)sizeof(sockaddr)) ||
+			connect_async_find(sd))
+	{
+		return EFAIL;
+	}
+	
+	pEntry = NULL;
+	for (i = 0; i < CONNECT_ASYNC_MAX; i++)
+	{
+		if (connect_async_table[i].ucState == CONNECT_ASYNC_STATE_FREE)
+		{
+			pEntry = &connect_async_table[i];
+			break;
+		}
+	}
+	
+	if (pEntry == NULL)
+	{
+		connect_async_counters.ulRejected++;
+		return EFAIL;
+	}
+	
+	memcpy(pEntry->aucAddr, addr, 8);
+	pEntry->callback = callback;
+	pEntry->cSd = (signed char)sd;
+	pEntry->ulQueued = millis();
+	pEntry->ucState = CONNECT_ASYNC_STATE_QUEUED;
+	
+	connect_async_counters.ulRequests++;
+	
+	lPending = connect_async_poll();
+	if (lPending > connect_async_counters.ucPeakPending)
+	{
+		connect_async_counters.ucPeakPending = (unsigned char)lPending;
+	}
+	
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! connect_async_status
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+connect_async_status(long sd, long *plResult)
+{
+	tConnectAsyncEntry *pEntry;
+	
+	connect_async_poll();
+	
+	pEntry = connect_async_find(sd);
+	if ((pEntry == NULL) || (pEntry->ucState == CONNECT_ASYNC_STATE_CANCELLED) ||
+			(pEntry->ucState == CONNECT_ASYNC_STATE_CLOSING))
+	{
+		return EFAIL;
+	}
+	
+	if (pEntry->ucState != CONNECT_ASYNC_STATE_DONE)
+	{
+		return 0;
+	}
+	
+	if (plResult)
+	{
+		*plResult = pEntry->lResult;
+	}
+	pEntry->ucState = CONNECT_ASYNC_STATE_FREE;
+	
+	return 1;
+}
+
+//*****************************************************************************
+//
+//! connect_async_cancel
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+connect_async_cancel(long sd)
+{
+	tConnectAsyncEntry *pEntry;
+	
+	pEntry = connect_async_find(sd);
+	if ((pEntry == NULL) || (pEntry->ucState == CONNECT_ASYNC_STATE_CANCELLED) ||
+			(pEntry->ucState == CONNECT_ASYNC_STATE_CLOSING))
+	{
+		return EFAIL;
+	}
+	
+	if (pEntry->ucState == CONNECT_ASYNC_STATE_RUNNING)
+	{
+		// The CC3000 can't be stopped; drop the result when it comes
+		connect_async_counters.ulCancelled++;
+		pEntry->callback = NULL;
+		pEntry->ucState = CONNECT_ASYNC_STATE_CANCELLED;
+		return 0;
+	}
+	
+	if (pEntry->ucState == CONNECT_ASYNC_STATE_QUEUED)
+	{
+		connect_async_counters.ulCancelled++;
+	}
+	pEntry->ucState = CONNECT_ASYNC_STATE_FREE;
+	
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! connect_async_close
+//!
+//!  @param  sd  socket descriptor (handle) being closed
+//!
+//!  @return  0 if a connect is running on sd and connect_async_poll will
+//!           close the socket when it finishes, -1 otherwise
+//
+//*****************************************************************************
+static long
+connect_async_close(long sd)
+{
+	tConnectAsyncEntry *pEntry;
+	
+	pEntry = connect_async_find(sd);
+	if ((pEntry == NULL) || !CONNECT_ASYNC_IN_CC3000(pEntry->ucState))
+	{
+		return EFAIL;
+	}
+	
+	if (pEntry->ucState == CONNECT_ASYNC_STATE_RUNNING)
+	{
+		connect_async_counters.ulCancelled++;
+	}
+	pEntry->callback = NULL;
+	pEntry->ucState = CONNECT_ASYNC_STATE_CLOSING;
+	
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! connect_async_stats
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+void
+connect_async_stats(tConnectAsyncStats *pStats)
+{
+	memcpy(pStats, &connect_async_counters, sizeof(tConnectAsyncStats));
+}
+#endif
+
+
 //*****************************************************************************
 //
 //! select
@@ -779,6 +2103,16 @@ setsockopt(long sd, long level, long optname, const void *optval,
 {
 	int ret;
 	unsigned char *ptr, *args;
+	unsigned long ulValue, ulKnown;
+	
+	// All the options are at most 32 bits, little endian like the stream
+	ulValue = 0;
+	memcpy(&ulValue, optval, (optlen < sizeof(ulValue)) ? optlen : sizeof(ulValue));
+	
+	if (sockopt_shadow_lookup(sd, level, optname, &ulKnown) && (ulKnown == ulValue))
+	{
+		return (0);
+	}
 	
 	ptr = tSLInformation.pucTxCommandBuffer;
 	args = (ptr + HEADERS_SIZE_CMD);
@@ -800,10 +2134,12 @@ setsockopt(long sd, long level, long optname, const void *optval,
 	
 	if (ret >= 0)
 	{
+		sockopt_shadow_store(sd, level, optname, ulValue, 1);
 		return (0);
 	}
 	else
 	{
+		sockopt_shadow_store(sd, level, optname, 0, 0);
 		errno = ret;
 		return ret;
 	}
@@ -862,6 +2198,16 @@ getsockopt (long sd, long level, long optname, void *optval, socklen_t *optlen)
 {
 	unsigned char *ptr, *args;
 	tBsdGetSockOptReturnParams  tRetParams;
+#ifndef CC3000_TINY_DRIVER
+	unsigned long ulKnown;
+	
+	if (sockopt_shadow_lookup(sd, level, optname, &ulKnown))
+	{
+		*optlen = 4;
+		memcpy(optval, &ulKnown, 4);
+		return (0);
+	}
+#endif
 	
 	ptr = tSLInformation.pucTxCommandBuffer;
 	args = (ptr + HEADERS_SIZE_CMD);
@@ -882,6 +2228,10 @@ getsockopt (long sd, long level, long optname, void *optval, socklen_t *optlen)
 	{
 		*optlen = 4;
 		memcpy(optval, tRetParams.ucOptValue, 4);
+#ifndef CC3000_TINY_DRIVER
+		memcpy(&ulKnown, tRetParams.ucOptValue, 4);
+		sockopt_shadow_store(sd, level, optname, ulKnown, 1);
+#endif
 		return (0);
 	}
 	else
@@ -918,6 +2268,11 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
 {
 	unsigned char *ptr, *args;
 	tBsdReadReturnParams tSocketReadEvent;
+#ifdef CC3000_SOCKET_STATS
+	unsigned long ulStart;
+#endif
+	
+	SOCKET_STATS_TIMESTAMP(ulStart);
 	
 	ptr = tSLInformation.pucTxCommandBuffer;
 	args = (ptr + HEADERS_SIZE_CMD);
@@ -939,8 +2294,16 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
 		// Wait for the data in a synchronous way. Here we assume that the bug is 
 		// big enough to store also parameters of receive from too....
 		SimpleLinkWaitData((unsigned char *)buf, (unsigned char *)from, (unsigned char *)fromlen);
+		
+		SOCKET_STATS_RX(sd, tSocketReadEvent.iNumberOfBytes);
+	}
+	else if (tSocketReadEvent.iNumberOfBytes == ERROR_SOCKET_INACTIVE)
+	{
+		SOCKET_STATS_INACTIVE(sd);
 	}
 	
+	SOCKET_STATS_RECV_LATENCY(sd, ulStart);
+	
 	errno = tSocketReadEvent.iNumberOfBytes;
 	
 	return(tSocketReadEvent.iNumberOfBytes);
@@ -1012,7 +2375,106 @@ recvfrom(long sd, void *buf, long len, long flags, sockaddr *from,
 
 //*****************************************************************************
 //
-//!  simple_link_send
+//!  recvfrom_batch
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+#ifndef CC3000_TINY_DRIVER
+int
+recvfrom_batch(long sd, tRecvfromMsg *msgs, unsigned short usCount, long flags,
+               unsigned long ulTimeoutMs)
+{
+	TICC3000fd_set readsds;
+	struct timeval timeout;
+	unsigned long ulStart, ulNonBlock = SOCK_ON;
+	unsigned short usReceived;
+	long len;
+	int res;
+	
+	recvfrom_batch_counters.ulCalls++;
+	
+	if (!M_IS_VALID_SD(sd) || (usCount == 0))
+	{
+		return EFAIL;
+	}
+	
+	// Ask once whether anything is waiting instead of paying for an empty
+	// recvfrom on an idle socket
+	FD_ZERO(&readsds);
+	FD_SET(sd, &readsds);
+	timeout.tv_sec = ulTimeoutMs / 1000;
+	timeout.tv_usec = (ulTimeoutMs % 1000) * 1000;
+	
+	res = select(sd + 1, &readsds, NULL, NULL, &timeout);
+	if (res < 0)
+	{
+		return res;
+	}
+	if (!FD_ISSET(sd, &readsds))
+	{
+		recvfrom_batch_counters.ulIdleCalls++;
+		return 0;
+	}
+	
+	ulStart = micros();
+	
+	// Past the first datagram we don't know how many are queued, so the
+	// socket must not block once it runs dry. Free if it already doesn't.
+	if (setsockopt(sd, SOL_SOCKET, SOCKOPT_RECV_NONBLOCK, &ulNonBlock, sizeof(ulNonBlock)) != 0)
+	{
+		return EFAIL;
+	}
+	
+	for (usReceived = 0; usReceived < usCount; usReceived++)
+	{
+		len = msgs[usReceived].len;
+		if (len > RECVFROM_BATCH_MAX_DATA_LEN)
+		{
+			len = RECVFROM_BATCH_MAX_DATA_LEN;
+		}
+		
+		msgs[usReceived].fromlen = sizeof(sockaddr);
+		res = simple_link_recv(sd, msgs[usReceived].buf, len, flags,
+							&msgs[usReceived].from, &msgs[usReceived].fromlen, HCI_CMND_RECVFROM);
+		if (res <= 0)
+		{
+			// Queue drained (or the socket failed)
+			recvfrom_batch_counters.ulEmptyRecvs++;
+			break;
+		}
+		
+		msgs[usReceived].result = res;
+		recvfrom_batch_counters.ulBytes += res;
+	}
+	
+	recvfrom_batch_counters.ulDatagrams += usReceived;
+	recvfrom_batch_counters.ulBusyMicros += micros() - ulStart;
+	if (usReceived > recvfrom_batch_counters.usLargestBatch)
+	{
+		recvfrom_batch_counters.usLargestBatch = usReceived;
+	}
+	
+	return usReceived;
+}
+
+//*****************************************************************************
+//
+//!  recvfrom_batch_stats
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+void
+recvfrom_batch_stats(tRecvfromBatchStats *pStats)
+{
+	memcpy(pStats, &recvfrom_batch_counters, sizeof(tRecvfromBatchStats));
+}
+#endif
+
+//*****************************************************************************
+//
+//!  simple_link_send_build
 //!
 //!  @param sd       socket handle
 //!  @param buf      write buffer
@@ -1021,33 +2483,23 @@ recvfrom(long sd, void *buf, long len, long flags, sockaddr *from,
 //!  @param to       pointer to an address structure indicating destination
 //!                  address
 //!  @param tolen    destination address structure size
+//!  @param opcode   HCI_CMND_SEND or HCI_CMND_SENDTO
 //!
-//!  @return         Return the number of bytes transmitted, or -1 if an error
-//!                  occurred, or -2 in case there are no free buffers available
-//!                 (only when SEND_NON_BLOCKING is enabled)
+//!  @return         size of the command arguments, to pass to hci_data_send
 //!
-//!  @brief          This function is used to transmit a message to another
-//!                  socket
+//!  @brief          Build a send/sendto data packet in the TX buffer without
+//!                  sending it. The TX buffer is free again as soon as
+//!                  hci_data_send returns, so the next packet can be built
+//!                  while the CC3000 is still answering the previous one.
 //
 //*****************************************************************************
-int
-simple_link_send(long sd, const void *buf, long len, long flags,
+static unsigned char
+simple_link_send_build(long sd, const void *buf, long len, long flags,
               const sockaddr *to, long tolen, long opcode)
-{    
+{
 	unsigned char uArgSize,  addrlen;
 	unsigned char *ptr, *pDataPtr, *args;
 	unsigned long addr_offset;
-	int res;
-        tBsdReadReturnParams tSocketSendEvent;
-	
-	// Check the bsd_arguments
-	if (0 != (res = HostFlowControlConsumeBuff(sd)))
-	{
-		return res;
-	}
-	
-	//Update the number of sent packets
-	tSLInformation.NumberOfSentPackets++;
 	
 	// Allocate a buffer and construct a packet and send it over spi
 	ptr = tSLInformation.pucTxCommandBuffer;
@@ -1092,8 +2544,13 @@ simple_link_send(long sd, const void *buf, long len, long flags,
 		args = UINT32_TO_STREAM(args, addrlen);
 	}
 	
-	// Copy the data received from user into the TX Buffer
-	ARRAY_TO_STREAM(pDataPtr, ((unsigned char *)buf), len);
+	// Copy the data received from user into the TX Buffer, unless it was
+	// written there in place (send_buffer_get)
+	if ((const unsigned char *)buf != pDataPtr)
+	{
+		memcpy(pDataPtr, buf, len);
+	}
+	pDataPtr += len;
 	
 	// In case we are using SendTo, copy the to parameters
 	if (opcode == HCI_CMND_SENDTO)
@@ -1101,17 +2558,284 @@ simple_link_send(long sd, const void *buf, long len, long flags,
 		ARRAY_TO_STREAM(pDataPtr, ((unsigned char *)to), tolen);
 	}
 	
+	return uArgSize;
+}
+
+//*****************************************************************************
+//
+//!  simple_link_send
+//!
+//!  @param sd       socket handle
+//!  @param buf      write buffer
+//!  @param len      buffer length
+//!  @param flags    On this version, this parameter is not supported
+//!  @param to       pointer to an address structure indicating destination
+//!                  address
+//!  @param tolen    destination address structure size
+//!
+//!  @return         Return the number of bytes transmitted, or -1 if an error
+//!                  occurred, or -2 in case there are no free buffers available
+//!                 (only when SEND_NON_BLOCKING is enabled)
+//!
+//!  @brief          This function is used to transmit a message to another
+//!                  socket
+//
+//*****************************************************************************
+int
+simple_link_send(long sd, const void *buf, long len, long flags,
+              const sockaddr *to, long tolen, long opcode)
+{    
+	unsigned char uArgSize;
+	int res;
+        tBsdReadReturnParams tSocketSendEvent;
+#ifdef CC3000_SOCKET_STATS
+	unsigned long ulStart;
+#endif
+	
+	// Check the bsd_arguments
+	if (0 != (res = HostFlowControlConsumeBuff(sd)))
+	{
+		return res;
+	}
+	
+	//Update the number of sent packets
+	tSLInformation.NumberOfSentPackets++;
+	
+	uArgSize = simple_link_send_build(sd, buf, len, flags, to, tolen, opcode);
+	
+	if (opcode != HCI_CMND_SENDTO)
+	{
+		tolen = 0;
+		to = NULL;
+	}
+	
+	SOCKET_STATS_TIMESTAMP(ulStart);
+	
 	// Initiate a HCI command
-	hci_data_send(opcode, ptr, uArgSize, len,(unsigned char*)to, tolen);
+	hci_data_send(opcode, tSLInformation.pucTxCommandBuffer, uArgSize, len,(unsigned char*)to, tolen);
         
          if (opcode == HCI_CMND_SENDTO)
             SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
          else
             SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
 	
+	SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+	SOCKET_STATS_TX(sd, len);
+	
 	return	(len);
 }
 
+//*****************************************************************************
+//
+//!  send_buffer_get
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+unsigned char *
+send_buffer_get(unsigned short *pusMaxLen)
+{
+	unsigned short usMax = SEND_BUFFER_MAX_DATA_LEN;
+	
+	// Never more than the CC3000 itself can take in one buffer
+	if ((tSLInformation.usSlBufferLength != 0) && (tSLInformation.usSlBufferLength < usMax))
+	{
+		usMax = tSLInformation.usSlBufferLength;
+	}
+	
+	*pusMaxLen = usMax;
+	
+	return (tSLInformation.pucTxCommandBuffer + HEADERS_SIZE_DATA + HCI_CMND_SEND_ARG_LENGTH);
+}
+
+//*****************************************************************************
+//
+//!  send_buffer_commit
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+int
+send_buffer_commit(long sd, long len, long flags)
+{
+	unsigned short usMax;
+	unsigned char *pData;
+	
+	pData = send_buffer_get(&usMax);
+	
+	if ((len < 0) || (len > usMax))
+	{
+		return EFAIL;
+	}
+	
+	return simple_link_send(sd, pData, len, flags, NULL, 0, HCI_CMND_SEND);
+}
+
+//*****************************************************************************
+//
+//!  send_stream
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+long
+send_stream(long sd, tSendStreamSource source, unsigned long ulTotalLen, void *pvContext)
+{
+	tBsdReadReturnParams tSocketSendEvent;
+	unsigned char *pData, uArgSize, ucPending;
+	unsigned short usMax, usChunk;
+	unsigned long ulSent;
+	long len;
+	int res;
+#ifdef CC3000_SOCKET_STATS
+	unsigned long ulStart;
+#endif
+	
+	pData = send_buffer_get(&usMax);
+	ulSent = 0;
+	ucPending = 0;
+	res = 0;
+	
+	while (ulSent < ulTotalLen)
+	{
+		usChunk = ((ulTotalLen - ulSent) < usMax) ? (unsigned short)(ulTotalLen - ulSent) : usMax;
+		
+		// The previous packet has already been clocked out, so the next
+		// chunk can go straight into the TX buffer while the CC3000 is
+		// still answering it
+		len = source(pData, ulSent, usChunk, pvContext);
+		if ((len <= 0) || (len > usChunk))
+		{
+			res = EFAIL;
+			break;
+		}
+		
+		// Same rule as sendto_batch: don't wait for a free buffer while the
+		// previous HCI_EVNT_SEND is holding up the event that would free one
+		if (ucPending && (0 == tSLInformation.usNumberOfFreeBuffers))
+		{
+			SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
+			SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+			ucPending = 0;
+		}
+		
+		if (0 != (res = HostFlowControlConsumeBuff(sd)))
+		{
+			break;
+		}
+		
+		tSLInformation.NumberOfSentPackets++;
+		
+		uArgSize = simple_link_send_build(sd, pData, len, 0, NULL, 0, HCI_CMND_SEND);
+		
+		if (ucPending)
+		{
+			SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
+			SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+		}
+		
+		SOCKET_STATS_TIMESTAMP(ulStart);
+		hci_data_send(HCI_CMND_SEND, tSLInformation.pucTxCommandBuffer, uArgSize, len, NULL, 0);
+		ucPending = 1;
+		SOCKET_STATS_TX(sd, len);
+		
+		ulSent += len;
+	}
+	
+	if (ucPending)
+	{
+		SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
+		SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+	}
+	
+	if ((ulSent == 0) && (res != 0))
+	{
+		return res;
+	}
+	
+	return ulSent;
+}
+
+//*****************************************************************************
+//
+//!  sendto_batch
+//!
+//!  @brief  see socket.h
+//
+//*****************************************************************************
+int
+sendto_batch(long sd, tSendtoMsg *msgs, unsigned short usCount, long flags)
+{
+	tBsdReadReturnParams tSocketSendEvent;
+	unsigned char uArgSize, ucPending;
+	unsigned short i, usSent;
+	int res;
+#ifdef CC3000_SOCKET_STATS
+	unsigned long ulStart;
+#endif
+	
+	for (i = 0; i < usCount; i++)
+	{
+		msgs[i].result = SOC_IN_PROGRESS;
+	}
+	
+	usSent = 0;
+	ucPending = 0;
+	
+	for (i = 0; i < usCount; i++)
+	{
+		if ((msgs[i].len < 0) || (msgs[i].len > SENDTO_BATCH_MAX_DATA_LEN))
+		{
+			msgs[i].result = EFAIL;
+			break;
+		}
+		
+		// Freed buffers are reported by an unsolicited event, which can't get
+		// through while the previous HCI_EVNT_SENDTO is still waiting to be
+		// read. So only take a buffer ahead of that event if one is free now.
+		if (ucPending && (0 == tSLInformation.usNumberOfFreeBuffers))
+		{
+			SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
+			SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+			ucPending = 0;
+		}
+		
+		if (0 != (res = HostFlowControlConsumeBuff(sd)))
+		{
+			msgs[i].result = res;
+			break;
+		}
+		
+		tSLInformation.NumberOfSentPackets++;
+		
+		// Build this packet while the CC3000 works on the previous one
+		uArgSize = simple_link_send_build(sd, msgs[i].buf, msgs[i].len, flags,
+										msgs[i].to, msgs[i].tolen, HCI_CMND_SENDTO);
+		
+		if (ucPending)
+		{
+			SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
+			SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+		}
+		
+		SOCKET_STATS_TIMESTAMP(ulStart);
+		hci_data_send(HCI_CMND_SENDTO, tSLInformation.pucTxCommandBuffer, uArgSize,
+					msgs[i].len, (unsigned char *)msgs[i].to, msgs[i].tolen);
+		ucPending = 1;
+		SOCKET_STATS_TX(sd, msgs[i].len);
+		
+		msgs[i].result = msgs[i].len;
+		usSent++;
+	}
+	
+	if (ucPending)
+	{
+		SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
+		SOCKET_STATS_SEND_LATENCY(sd, ulStart);
+	}
+	
+	return usSent;
+}
 
 //*****************************************************************************
 //
@@ -399,6 +399,169 @@ extern long listen(long sd, long backlog);
 extern int gethostbyname(char * hostname, unsigned short usNameLen, unsigned long* out_ip_addr);
 #endif
 
+// gethostbyname() keeps the last few answers so repeated lookups of the same
+// host don't each cost a DNS query over the air. The CC3000 doesn't tell us
+// the record's TTL so a fixed lifetime is used. Set CC3000_DNS_CACHE_SIZE to
+// 0 to compile the cache out.
+#ifndef CC3000_DNS_CACHE_SIZE
+#define CC3000_DNS_CACHE_SIZE			(4)
+#endif
+#ifndef CC3000_DNS_CACHE_TTL_MS
+#define CC3000_DNS_CACHE_TTL_MS			(300000UL)	// successful lookups
+#endif
+#ifndef CC3000_DNS_CACHE_NEG_TTL_MS
+#define CC3000_DNS_CACHE_NEG_TTL_MS		(10000UL)	// failed lookups
+#endif
+
+typedef struct _gethostbyname_cache_stats_t
+{
+	unsigned long	ulHits;				// answered from the cache, including negative
+	unsigned long	ulNegativeHits;		// answered with a cached failure
+	unsigned long	ulMisses;			// went to the CC3000
+	unsigned long	ulFlushes;			// cache emptied on disconnect or by the user
+	unsigned long	ulQueryMillis;		// total time spent in real DNS queries
+	unsigned long	ulSavedMillis;		// hits * average query time
+} tGethostbynameCacheStats;
+
+#if !defined(CC3000_TINY_DRIVER) && (CC3000_DNS_CACHE_SIZE > 0)
+//*****************************************************************************
+//
+//! gethostbyname_cache_flush
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Forget every cached lookup. Called automatically on
+//!          HCI_EVNT_WLAN_UNSOL_DISCONNECT since the next network may resolve
+//!          names differently.
+//
+//*****************************************************************************
+extern void gethostbyname_cache_flush(void);
+
+//*****************************************************************************
+//
+//! gethostbyname_cache_stats
+//!
+//!  @param[out]  pStats  filled with the cache counters
+//!
+//!  @return  none
+//!
+//!  @brief  Hit/miss counters and time saved. The time saved per lookup is
+//!          ulSavedMillis / (ulHits + ulMisses).
+//
+//*****************************************************************************
+extern void gethostbyname_cache_stats(tGethostbynameCacheStats *pStats);
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+// Most lookups queued with gethostbyname_async at once. The CC3000 runs one
+// command at a time so the queries are sent one after the other
+#ifndef GETHOSTBYNAME_ASYNC_MAX
+#define GETHOSTBYNAME_ASYNC_MAX		(4)
+#endif
+
+typedef void (*tGethostbynameAsyncCallback)(long lHandle, long lRetVal,
+                                            unsigned long ulIp, unsigned long ulMillis);
+
+typedef struct _gethostbyname_async_stats_t
+{
+	unsigned long	ulRequests;			// lookups queued
+	unsigned long	ulResolved;
+	unsigned long	ulFailed;
+	unsigned long	ulCacheHits;		// answered by an earlier lookup of the same name
+	unsigned long	ulCancelled;
+	unsigned long	ulRejected;			// table full
+	unsigned long	ulQueueMillis;		// total time waiting for the CC3000
+	unsigned long	ulResolveMillis;	// total time in DNS queries
+	unsigned long	ulMaxMillis;		// slowest lookup, queued to answered
+} tGethostbynameAsyncStats;
+
+//*****************************************************************************
+//
+//! gethostbyname_async
+//!
+//!  @param[in]   hostname   host name, must stay valid until the lookup
+//!                          has completed
+//!  @param[in]   usNameLen  name length
+//!  @param[in]   callback   called from gethostbyname_async_poll with the
+//!                          handle, the gethostbyname return value, the
+//!                          address (0 if not resolved) and the time since
+//!                          gethostbyname_async in ms. NULL to collect the
+//!                          answer with gethostbyname_async_status instead
+//!
+//!  @return  lookup handle (0 to GETHOSTBYNAME_ASYNC_MAX-1), or -1 if the
+//!           name is too long or GETHOSTBYNAME_ASYNC_MAX lookups are pending
+//!
+//!  @brief  Start a lookup without waiting for the answer. Lookups are
+//!          answered from the gethostbyname cache when possible, otherwise
+//!          queried one at a time, oldest first, while the host carries on.
+//!          Any other driver call made while a query is running waits for
+//!          it to complete.
+//!
+//!  @sa gethostbyname_async_poll, gethostbyname_async_status
+//
+//*****************************************************************************
+extern long gethostbyname_async(const char *hostname, unsigned short usNameLen,
+                                tGethostbynameAsyncCallback callback);
+
+//*****************************************************************************
+//
+//! gethostbyname_async_poll
+//!
+//!  @param  none
+//!
+//!  @return  number of lookups queued or running
+//!
+//!  @brief  Collect the answer to the running query, start the next one
+//!          and call the callbacks of completed lookups. Call it from loop().
+//
+//*****************************************************************************
+extern long gethostbyname_async_poll(void);
+
+//*****************************************************************************
+//
+//! gethostbyname_async_status
+//!
+//!  @param[in]   lHandle    handle from gethostbyname_async
+//!  @param[out]  pulIp      resolved address once done
+//!  @param[out]  pulMillis  time the lookup took once done
+//!
+//!  @return  SOC_IN_PROGRESS while the lookup is pending, otherwise the
+//!           gethostbyname return value (positive on success); the handle
+//!           is then free. -1 for a handle without a pending lookup or
+//!           started with a callback.
+//
+//*****************************************************************************
+extern long gethostbyname_async_status(long lHandle, unsigned long *pulIp,
+                                       unsigned long *pulMillis);
+
+//*****************************************************************************
+//
+//! gethostbyname_async_cancel
+//!
+//!  @param[in]   lHandle   handle from gethostbyname_async
+//!
+//!  @return  0 on success, -1 if there is nothing to cancel or the query
+//!           has already been sent to the CC3000
+//!
+//!  @brief  Drop a queued lookup, or the answer of a completed one
+//
+//*****************************************************************************
+extern long gethostbyname_async_cancel(long lHandle);
+
+//*****************************************************************************
+//
+//! gethostbyname_async_stats
+//!
+//!  @param[out]  pStats  filled with the gethostbyname_async counters
+//!
+//!  @return  none
+//
+//*****************************************************************************
+extern void gethostbyname_async_stats(tGethostbynameAsyncStats *pStats);
+#endif
+
 
 //*****************************************************************************
 //
@@ -430,6 +593,116 @@ extern int gethostbyname(char * hostname, unsigned short usNameLen, unsigned lon
 //*****************************************************************************
 extern long connect(long sd, const sockaddr *addr, long addrlen);
 
+#ifndef CC3000_TINY_DRIVER
+// Most connects queued with connect_async at once. The CC3000 runs one
+// command at a time so they are sent to it one after the other
+#ifndef CONNECT_ASYNC_MAX
+#define CONNECT_ASYNC_MAX			(4)
+#endif
+
+typedef void (*tConnectAsyncCallback)(long sd, long lResult, unsigned long ulMillis);
+
+typedef struct _connect_async_stats_t
+{
+	unsigned long	ulRequests;			// connects queued
+	unsigned long	ulSucceeded;
+	unsigned long	ulFailed;
+	unsigned long	ulCancelled;		// dropped before they were started
+	unsigned long	ulRejected;			// table full or socket already pending
+	unsigned long	ulQueueMillis;		// total time waiting for the CC3000
+	unsigned long	ulConnectMillis;	// total time in the TCP handshake
+	unsigned long	ulMaxConnectMillis;
+	unsigned char	ucPeakPending;
+} tConnectAsyncStats;
+
+//*****************************************************************************
+//
+//! connect_async
+//!
+//!  @param[in]   sd        socket descriptor (handle)
+//!  @param[in]   addr      destination address, as for connect
+//!  @param[in]   addrlen   size of addr
+//!  @param[in]   callback  called from connect_async_poll with the connect
+//!                         result (0 or negative) and the time since
+//!                         connect_async in ms. NULL to collect the result
+//!                         with connect_async_status instead
+//!
+//!  @return  0 if the connect was queued, -1 if sd is invalid, already has
+//!           a connect pending or CONNECT_ASYNC_MAX connects are pending
+//!
+//!  @brief  Start a connect without waiting for the TCP handshake. Up to
+//!          CONNECT_ASYNC_MAX sockets can have a connect pending; the
+//!          CC3000 handles them one at a time, oldest first, while the
+//!          host carries on. Any other driver call made while a connect is
+//!          running waits for it to complete.
+//!
+//!  @sa connect_async_poll, connect_async_status
+//
+//*****************************************************************************
+extern long connect_async(long sd, const sockaddr *addr, long addrlen,
+                          tConnectAsyncCallback callback);
+
+//*****************************************************************************
+//
+//! connect_async_poll
+//!
+//!  @param  none
+//!
+//!  @return  number of connects queued or running
+//!
+//!  @brief  Collect the result of the running connect, call its callback
+//!          and start the next queued one. Call it from loop().
+//
+//*****************************************************************************
+extern long connect_async_poll(void);
+
+//*****************************************************************************
+//
+//! connect_async_status
+//!
+//!  @param[in]   sd        socket descriptor (handle)
+//!  @param[out]  plResult  connect result (0 or negative) once done
+//!
+//!  @return  1 if the connect is done (and forgotten), 0 if it is still
+//!           pending, -1 if sd has no connect_async without a callback
+//!
+//!  @brief  Readiness flag for connects started without a callback
+//
+//*****************************************************************************
+extern long connect_async_status(long sd, long *plResult);
+
+//*****************************************************************************
+//
+//! connect_async_cancel
+//!
+//!  @param[in]   sd   socket descriptor (handle)
+//!
+//!  @return  0 on success, -1 if there is nothing to cancel
+//!
+//!  @brief  Drop a pending connect. A connect the CC3000 is already
+//!          running can't be stopped: its callback is dropped and the
+//!          socket may still end up connected. closesocket cancels
+//!          automatically, and closes the socket once a running connect
+//!          finishes rather than waiting for it.
+//
+//*****************************************************************************
+extern long connect_async_cancel(long sd);
+
+//*****************************************************************************
+//
+//! connect_async_stats
+//!
+//!  @param[out]  pStats  filled with the connect_async counters
+//!
+//!  @return  none
+//!
+//!  @brief  The average handshake is ulConnectMillis / (ulSucceeded +
+//!          ulFailed)
+//
+//*****************************************************************************
+extern void connect_async_stats(tConnectAsyncStats *pStats);
+#endif
+
 //*****************************************************************************
 //
 //! select
@@ -513,6 +786,10 @@ extern int select(long nfds, TICC3000fd_set *readsds, TICC3000fd_set *writesds,
 //!           or off.
 //!		        In that case optval should be SOCK_ON or SOCK_OFF (optval).
 //!
+//!          The driver keeps a copy of these options per socket, so
+//!          setting an option to its current value, or reading one that
+//!          is known, returns without talking to the CC3000.
+//!
 //!  @sa getsockopt
 //
 //*****************************************************************************
@@ -676,6 +953,224 @@ extern int send(long sd, const void *buf, long len, long flags);
 extern int sendto(long sd, const void *buf, long len, long flags, 
                   const sockaddr *to, socklen_t tolen);
 
+// Per-socket traffic counters and latency histograms. Uncomment to compile
+// them in; they cost about 100 bytes of RAM per socket, so they are off by
+// default and every hook compiles to nothing.
+//#define CC3000_SOCKET_STATS
+
+#ifndef SOCKET_STATS_HIST_BUCKETS
+#define SOCKET_STATS_HIST_BUCKETS	(20)	// bucket n counts 2^n..2^(n+1)-1 us, last is open ended
+#endif
+
+typedef struct _socket_stats_t
+{
+	unsigned long		ulTxBytes;
+	unsigned long		ulTxPackets;
+	unsigned long		ulRxBytes;
+	unsigned long		ulRxPackets;
+	unsigned long		ulStalls;			// sends that had to wait for a free buffer
+	unsigned long		ulStallMicros;		// total time spent waiting for one
+	unsigned short		usInactiveErrors;	// operations that failed with ERROR_SOCKET_INACTIVE
+	unsigned short		ausSendLatency[SOCKET_STATS_HIST_BUCKETS];	// send/sendto round trip
+	unsigned short		ausRecvLatency[SOCKET_STATS_HIST_BUCKETS];	// recv/recvfrom round trip
+} tSocketStats;
+
+#ifdef CC3000_SOCKET_STATS
+//*****************************************************************************
+//
+//!  socket_stats_snapshot
+//!
+//!  @param  sd      socket handle
+//!  @param  pStats  filled with a copy of the socket's counters
+//!
+//!  @return  0 on success, -1 on a bad socket handle
+//!
+//!  @brief  Read the traffic counters of one socket. They are zeroed when
+//!          the descriptor is handed out by socket() or accept(), and kept
+//!          after closesocket() so they can still be read.
+//
+//*****************************************************************************
+extern long socket_stats_snapshot(long sd, tSocketStats *pStats);
+
+//*****************************************************************************
+//
+//!  socket_stats_reset
+//!
+//!  @param  sd  socket handle, or -1 for all sockets
+//!
+//!  @return  none
+//!
+//!  @brief  Zero the counters
+//
+//*****************************************************************************
+extern void socket_stats_reset(long sd);
+
+// Driver hook, called by the event handler
+extern void socket_stats_count_inactive(long sd);
+#endif
+
+//*****************************************************************************
+//
+//!  send_buffer_get
+//!
+//!  @param[out]  pusMaxLen  largest amount of data that fits
+//!
+//!  @return  pointer to the data area of the next send packet in the TX
+//!           buffer
+//!
+//!  @brief   Lets the caller build data straight in the TX buffer instead
+//!           of in its own buffer that send would then copy. Finish with
+//!           send_buffer_commit before any other driver call, since every
+//!           command reuses the TX buffer.
+//!
+//!  @sa      send_buffer_commit
+//
+//*****************************************************************************
+extern unsigned char *send_buffer_get(unsigned short *pusMaxLen);
+
+//*****************************************************************************
+//
+//!  send_buffer_commit
+//!
+//!  @param sd       socket handle
+//!  @param len      bytes written at send_buffer_get's pointer
+//!  @param flags    On this version, this parameter is not supported
+//!
+//!  @return         same as send
+//!
+//!  @brief          Send the data built with send_buffer_get
+//
+//*****************************************************************************
+extern int send_buffer_commit(long sd, long len, long flags);
+
+// Data source for send_stream: write up to usLen bytes, starting ulOffset
+// bytes into the stream, to pucDst and return how many were written
+typedef long (*tSendStreamSource)(unsigned char *pucDst, unsigned long ulOffset,
+                                  unsigned short usLen, void *pvContext);
+
+//*****************************************************************************
+//
+//!  send_stream
+//!
+//!  @param sd          TCP socket handle
+//!  @param source      called for each chunk, see tSendStreamSource
+//!  @param ulTotalLen  bytes to send
+//!  @param pvContext   passed through to source
+//!
+//!  @return         bytes sent, or a negative error if nothing was sent.
+//!                  Stops early if source returns 0 or less or the socket
+//!                  fails.
+//!
+//!  @brief          Send a large object, e.g. from PROGMEM or SPI flash,
+//!                  without a RAM copy. Each chunk is as large as both the
+//!                  TX buffer and the CC3000's buffers (usSlBufferLength)
+//!                  allow, and source fills it directly in the TX buffer
+//!                  while the CC3000 is still acknowledging the previous
+//!                  chunk.
+//
+//*****************************************************************************
+extern long send_stream(long sd, tSendStreamSource source, unsigned long ulTotalLen,
+                        void *pvContext);
+
+typedef struct _recvfrom_msg_t
+{
+	void				*buf;		// where to store the datagram
+	long				len;		// size of buf
+	sockaddr			from;		// out: source address
+	socklen_t			fromlen;	// out: source address size
+	int					result;		// out: bytes received
+} tRecvfromMsg;
+
+typedef struct _recvfrom_batch_stats_t
+{
+	unsigned long		ulCalls;
+	unsigned long		ulIdleCalls;	// select() said nothing was waiting
+	unsigned long		ulEmptyRecvs;	// recvfrom that found the queue empty
+	unsigned long		ulDatagrams;
+	unsigned long		ulBytes;
+	unsigned long		ulBusyMicros;	// time spent receiving, excluding the wait
+	unsigned short		usLargestBatch;
+} tRecvfromBatchStats;
+
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//!  recvfrom_batch
+//!
+//!  @param  sd           UDP socket handle
+//!  @param  msgs         array of receive buffers; buf and len must be set,
+//!                       from, fromlen and result are filled in
+//!  @param  usCount      number of entries in msgs
+//!  @param  flags        On this version, this parameter is not supported
+//!  @param  ulTimeoutMs  how long to wait for the first datagram
+//!
+//!  @return  number of datagrams received (0 if none arrived within the
+//!           timeout), or negative on error
+//!
+//!  @brief  Drain up to usCount queued datagrams in one call. A select()
+//!          is made first so an idle socket costs one round trip rather
+//!          than a recvfrom, then datagrams are read until the queue is
+//!          empty or msgs is full. The socket is switched to non-blocking
+//!          receive mode (SOCKOPT_RECV_NONBLOCK) and left that way.
+//!          Each datagram is truncated to what fits in the RX buffer.
+//!
+//!  @sa     recvfrom
+//
+//*****************************************************************************
+extern int recvfrom_batch(long sd, tRecvfromMsg *msgs, unsigned short usCount, long flags,
+                          unsigned long ulTimeoutMs);
+
+//*****************************************************************************
+//
+//!  recvfrom_batch_stats
+//!
+//!  @param[out]  pStats  filled with the recvfrom_batch counters
+//!
+//!  @return  none
+//!
+//!  @brief  The packets per second ceiling of the receive path is
+//!          ulDatagrams * 1000000 / ulBusyMicros
+//
+//*****************************************************************************
+extern void recvfrom_batch_stats(tRecvfromBatchStats *pStats);
+#endif
+
+typedef struct _sendto_msg_t
+{
+	const void			*buf;		// datagram payload
+	long				len;		// payload length
+	const sockaddr		*to;		// destination address
+	socklen_t			tolen;		// destination address size
+	int					result;		// out: bytes sent, or negative error
+} tSendtoMsg;
+
+//*****************************************************************************
+//
+//!  sendto_batch
+//!
+//!  @param sd       socket handle
+//!  @param msgs     array of datagrams to send
+//!  @param usCount  number of entries in msgs
+//!  @param flags    On this version, this parameter is not supported
+//!
+//!  @return         Number of datagrams sent. Each msgs[i].result is set to
+//!                  the bytes sent, or the error for the datagram that
+//!                  stopped the batch (-1 if it is too long to fit the TX
+//!                  buffer, -2 if no buffers were free with
+//!                  SEND_NON_BLOCKING enabled). Datagrams after that one
+//!                  are not sent and their result is SOC_IN_PROGRESS.
+//!
+//!  @brief          Send several datagrams on one UDP socket back to back.
+//!                  Same as calling sendto for each entry, except each
+//!                  datagram is copied into the TX buffer while the CC3000
+//!                  is still acknowledging the previous one, and free
+//!                  buffers are used as they become available.
+//!
+//!  @sa             sendto
+//
+//*****************************************************************************
+extern int sendto_batch(long sd, tSendtoMsg *msgs, unsigned short usCount, long flags);
+
 //*****************************************************************************
 //
 //!  mdnsAdvertiser
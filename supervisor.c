@@ -0,0 +1,479 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  Connection supervisor, see supervisor.h
+*
+*  supervisor_event can run inside the WLAN IRQ, so it only sets three
+*  flags. Everything else, including every call into the driver, happens
+*  in supervisor_poll. A disconnect is latched in ucDropped so a drop and
+*  reconnect between two polls isn't missed.
+*
+*  Backoff is "equal jitter": half the exponential delay is fixed and the
+*  other half random, so retries spread out but never come back sooner
+*  than half the nominal delay.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "wlan.h"
+#include "netapp.h"
+#include "hci.h"
+#include "supervisor.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+// HCI_EVNT_WLAN_UNSOL_DHCP data: status byte, 0 if the addresses are valid
+#define SUPERVISOR_DHCP_STATUS		(20)
+
+// Events supervisor_event needs, see wlan_event_subscribe
+#define SUPERVISOR_EVENTS			(HCI_EVNT_WLAN_UNSOL_CONNECT | HCI_EVNT_WLAN_UNSOL_DISCONNECT |\
+									 HCI_EVNT_WLAN_UNSOL_DHCP)
+
+typedef struct _supervisor_link_t
+{
+	volatile unsigned char	ucAssociated;
+	volatile unsigned char	ucIp;
+	volatile unsigned char	ucDropped;		// disconnect seen since last cleared
+	volatile unsigned char	ucHeld;			// someone else is switching APs, see supervisor_hold
+} tSupervisorLink;
+
+typedef struct _supervisor_ctx_t
+{
+	unsigned char	*pucKey;
+	unsigned long	ulSecType;
+	long			lKeyLen;
+	unsigned long	ulAttemptStart;			// millis() at wlan_connect
+	unsigned long	ulStateStart;			// millis() the current state was entered
+	unsigned long	ulOnlineSince;
+	unsigned long	ulLostAt;
+	unsigned long	ulBackoff;				// this backoff, jitter included
+	unsigned long	ulSeed;
+	char			acSsid[32];
+	unsigned char	ucSsidLen;
+	unsigned char	ucState;
+	unsigned char	ucAttempt;				// failures in a row
+	unsigned char	ucOutage;				// ulLostAt is valid
+} tSupervisorCtx;
+
+
+static tSupervisorLink	supervisorLink;
+static tSupervisorCtx	supervisorCtx;
+static tSupervisorStats	supervisorStats;
+
+
+//*****************************************************************************
+//
+//! supervisor_random
+//!
+//!  @param  none
+//!
+//!  @return  next xorshift32 value
+//
+//*****************************************************************************
+static unsigned long
+supervisor_random(void)
+{
+	unsigned long x = supervisorCtx.ulSeed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	supervisorCtx.ulSeed = x;
+
+	return x;
+}
+
+//*****************************************************************************
+//
+//! supervisor_fail
+//!
+//!  @param  ulNow  millis()
+//!
+//!  @return  none
+//!
+//!  @brief  Count a failed attempt and pick the backoff before the next
+//
+//*****************************************************************************
+static void
+supervisor_fail(unsigned long ulNow)
+{
+	unsigned long ulDelay = SUPERVISOR_BACKOFF_MIN_MS;
+	unsigned char i;
+
+	for (i = 0; (i < supervisorCtx.ucAttempt) && (ulDelay < SUPERVISOR_BACKOFF_MAX_MS); i++)
+	{
+		ulDelay <<= 1;
+	}
+	if (ulDelay > SUPERVISOR_BACKOFF_MAX_MS)
+	{
+		ulDelay = SUPERVISOR_BACKOFF_MAX_MS;
+	}
+	if (supervisorCtx.ucAttempt < 0xff)
+	{
+		supervisorCtx.ucAttempt++;
+	}
+
+	ulDelay = (ulDelay >> 1) + supervisor_random() % ((ulDelay >> 1) + 1);
+
+	supervisorStats.ulFailures++;
+	supervisorStats.ulBackoffMillis = ulDelay;
+	supervisorCtx.ulBackoff = ulDelay;
+	supervisorCtx.ulStateStart = ulNow;
+	supervisorCtx.ucState = SUPERVISOR_STATE_BACKOFF;
+}
+
+//*****************************************************************************
+//
+//! supervisor_online
+//!
+//!  @param  ulNow  millis()
+//!
+//!  @return  none
+//!
+//!  @brief  Got an IP address: record time to IP and the outage, if any
+//
+//*****************************************************************************
+static void
+supervisor_online(unsigned long ulNow)
+{
+	unsigned long ulElapsed = ulNow - supervisorCtx.ulAttemptStart;
+
+	supervisorStats.ulOnlines++;
+	supervisorStats.ulLastTimeToIp = ulElapsed;
+	supervisorStats.ulTotalTimeToIp += ulElapsed;
+	if (ulElapsed > supervisorStats.ulMaxTimeToIp)
+	{
+		supervisorStats.ulMaxTimeToIp = ulElapsed;
+	}
+
+	if (supervisorCtx.ucOutage)
+	{
+		ulElapsed = ulNow - supervisorCtx.ulLostAt;
+		supervisorStats.ulLastOutage = ulElapsed;
+		supervisorStats.ulTotalOutage += ulElapsed;
+		if (ulElapsed > supervisorStats.ulMaxOutage)
+		{
+			supervisorStats.ulMaxOutage = ulElapsed;
+		}
+		supervisorCtx.ucOutage = 0;
+	}
+
+	supervisorCtx.ucAttempt = 0;
+	supervisorCtx.ulOnlineSince = ulNow;
+	supervisorCtx.ucState = SUPERVISOR_STATE_ONLINE;
+}
+
+//*****************************************************************************
+//
+//! supervisor_begin
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+long
+supervisor_begin(unsigned long ulSecType, char *ssid, long ssid_len, unsigned char *key,
+                 long key_len)
+{
+	tNetappIpconfigRetArgs ipconfig;
+
+	if ((ssid_len < 0) || (ssid_len > (long)sizeof(supervisorCtx.acSsid)))
+	{
+		return SUPERVISOR_ERR_PARAM;
+	}
+
+	if (supervisorCtx.ucState == SUPERVISOR_STATE_IDLE)
+	{
+		wlan_event_subscribe(SUPERVISOR_EVENTS);
+	}
+
+	memset(&supervisorCtx, 0, sizeof(supervisorCtx));
+	supervisorCtx.ulSecType = ulSecType;
+	memcpy(supervisorCtx.acSsid, ssid, ssid_len);
+	supervisorCtx.ucSsidLen = (unsigned char)ssid_len;
+	supervisorCtx.pucKey = key;
+	supervisorCtx.lKeyLen = key_len;
+	supervisorCtx.ulSeed = micros() | 1;
+	supervisorCtx.ucState = SUPERVISOR_STATE_START;
+
+	// Pick up a connection that is already there
+	supervisorLink.ucDropped = 0;
+	supervisorLink.ucAssociated = 0;
+	supervisorLink.ucIp = 0;
+	if (wlan_ioctl_statusget() == WLAN_STATUS_CONNECTED)
+	{
+		supervisorLink.ucAssociated = 1;
+		netapp_ipconfig(&ipconfig);
+		if (ipconfig.aucIP[0] | ipconfig.aucIP[1] | ipconfig.aucIP[2] | ipconfig.aucIP[3])
+		{
+			supervisorLink.ucIp = 1;
+			supervisorCtx.ulOnlineSince = millis();
+			supervisorCtx.ucState = SUPERVISOR_STATE_ONLINE;
+		}
+		else
+		{
+			supervisorCtx.ulAttemptStart = millis();
+			supervisorCtx.ulStateStart = supervisorCtx.ulAttemptStart;
+			supervisorCtx.ucState = SUPERVISOR_STATE_WAIT_DHCP;
+		}
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! supervisor_end
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+void
+supervisor_end(void)
+{
+	if (supervisorCtx.ucState == SUPERVISOR_STATE_IDLE)
+	{
+		return;
+	}
+	if (supervisorCtx.ucState == SUPERVISOR_STATE_ONLINE)
+	{
+		supervisorStats.ulUptimeMillis += millis() - supervisorCtx.ulOnlineSince;
+	}
+	wlan_event_unsubscribe(SUPERVISOR_EVENTS);
+	supervisorCtx.ucState = SUPERVISOR_STATE_IDLE;
+	supervisorCtx.pucKey = NULL;
+}
+
+//*****************************************************************************
+//
+//! supervisor_poll
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+unsigned char
+supervisor_poll(void)
+{
+	unsigned long ulNow = millis();
+
+	if (supervisorLink.ucHeld)
+	{
+		return supervisorCtx.ucState;
+	}
+
+	switch (supervisorCtx.ucState)
+	{
+	case SUPERVISOR_STATE_START:
+		// Whatever was seen before this connect no longer applies
+		supervisorLink.ucDropped = 0;
+		supervisorLink.ucAssociated = 0;
+		supervisorLink.ucIp = 0;
+		supervisorStats.ulAttempts++;
+		supervisorCtx.ulAttemptStart = ulNow;
+		supervisorCtx.ulStateStart = ulNow;
+		if (wlan_connect(supervisorCtx.ulSecType, supervisorCtx.acSsid, supervisorCtx.ucSsidLen,
+				NULL, supervisorCtx.pucKey, supervisorCtx.lKeyLen) != 0)
+		{
+			supervisor_fail(ulNow);
+		}
+		else
+		{
+			supervisorCtx.ucState = SUPERVISOR_STATE_CONNECT;
+		}
+		break;
+
+	case SUPERVISOR_STATE_CONNECT:
+		if (supervisorLink.ucDropped)
+		{
+			supervisor_fail(ulNow);
+		}
+		else if (supervisorLink.ucAssociated)
+		{
+			supervisorCtx.ulStateStart = ulNow;
+			supervisorCtx.ucState = SUPERVISOR_STATE_WAIT_DHCP;
+		}
+		else if (ulNow - supervisorCtx.ulStateStart >= SUPERVISOR_CONNECT_TIMEOUT_MS)
+		{
+			wlan_disconnect();
+			supervisor_fail(ulNow);
+		}
+		break;
+
+	case SUPERVISOR_STATE_WAIT_DHCP:
+		if (supervisorLink.ucDropped)
+		{
+			supervisor_fail(ulNow);
+		}
+		else if (supervisorLink.ucIp)
+		{
+			supervisor_online(ulNow);
+		}
+		else if (ulNow - supervisorCtx.ulStateStart >= SUPERVISOR_DHCP_TIMEOUT_MS)
+		{
+			wlan_disconnect();
+			supervisor_fail(ulNow);
+		}
+		break;
+
+	case SUPERVISOR_STATE_ONLINE:
+		if (supervisorLink.ucDropped || !supervisorLink.ucIp)
+		{
+			supervisorStats.ulUptimeMillis += ulNow - supervisorCtx.ulOnlineSince;
+			supervisorStats.ulDrops++;
+			supervisorCtx.ulLostAt = ulNow;
+			supervisorCtx.ucOutage = 1;
+			supervisorCtx.ucState = SUPERVISOR_STATE_LOST;
+		}
+		break;
+
+	case SUPERVISOR_STATE_LOST:
+		// First try again straight away, backoff only after a failure
+		supervisorCtx.ucAttempt = 0;
+		supervisorCtx.ucState = SUPERVISOR_STATE_START;
+		break;
+
+	case SUPERVISOR_STATE_BACKOFF:
+		if (ulNow - supervisorCtx.ulStateStart >= supervisorCtx.ulBackoff)
+		{
+			supervisorCtx.ucState = SUPERVISOR_STATE_START;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return supervisorCtx.ucState;
+}
+
+//*****************************************************************************
+//
+//! supervisor_state
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+unsigned char
+supervisor_state(void)
+{
+	return supervisorCtx.ucState;
+}
+
+//*****************************************************************************
+//
+//! supervisor_hold
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+void
+supervisor_hold(unsigned char ucHold)
+{
+	unsigned long ulNow;
+
+	supervisorLink.ucHeld = ucHold;
+	if (ucHold || (supervisorCtx.ucState != SUPERVISOR_STATE_ONLINE))
+	{
+		return;
+	}
+
+	// Still associated after the switch: only DHCP is left to wait for,
+	// without counting a drop. Otherwise the switch failed and is a drop.
+	if (!supervisorLink.ucAssociated)
+	{
+		supervisorLink.ucDropped = 1;
+	}
+	else if (!supervisorLink.ucIp)
+	{
+		ulNow = millis();
+		supervisorStats.ulUptimeMillis += ulNow - supervisorCtx.ulOnlineSince;
+		supervisorCtx.ulAttemptStart = ulNow;
+		supervisorCtx.ulStateStart = ulNow;
+		supervisorCtx.ucState = SUPERVISOR_STATE_WAIT_DHCP;
+	}
+}
+
+//*****************************************************************************
+//
+//! supervisor_event
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+void
+supervisor_event(long lEventType, char *data, unsigned char length)
+{
+	switch (lEventType)
+	{
+	case HCI_EVNT_WLAN_UNSOL_CONNECT:
+		supervisorLink.ucAssociated = 1;
+		break;
+
+	case HCI_EVNT_WLAN_UNSOL_DISCONNECT:
+		supervisorLink.ucAssociated = 0;
+		supervisorLink.ucIp = 0;
+		if (!supervisorLink.ucHeld)
+		{
+			supervisorLink.ucDropped = 1;
+		}
+		break;
+
+	case HCI_EVNT_WLAN_UNSOL_DHCP:
+		supervisorLink.ucIp = (length > SUPERVISOR_DHCP_STATUS) &&
+		                      (data[SUPERVISOR_DHCP_STATUS] == 0);
+		break;
+
+	default:
+		break;
+	}
+}
+
+//*****************************************************************************
+//
+//! supervisor_get_stats
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+void
+supervisor_get_stats(tSupervisorStats *pStats)
+{
+	memcpy(pStats, &supervisorStats, sizeof(tSupervisorStats));
+	if (supervisorCtx.ucState == SUPERVISOR_STATE_ONLINE)
+	{
+		pStats->ulUptimeMillis += millis() - supervisorCtx.ulOnlineSince;
+	}
+}
+
+//*****************************************************************************
+//
+//! supervisor_reset_stats
+//!
+//!  @brief  see supervisor.h
+//
+//*****************************************************************************
+void
+supervisor_reset_stats(void)
+{
+	memset(&supervisorStats, 0, sizeof(supervisorStats));
+	if (supervisorCtx.ucState == SUPERVISOR_STATE_ONLINE)
+	{
+		supervisorCtx.ulOnlineSince = millis();
+	}
+}
+
+#endif	// CC3000_TINY_DRIVER
@@ -0,0 +1,234 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a connection supervisor. It owns the connect / DHCP
+*  lifecycle so sketches don't have to hand-roll reconnect logic around
+*  ulCC3000Connected and ulCC3000DHCP: call supervisor_begin once with the
+*  network, then supervisor_poll from loop(). When the link drops it
+*  reconnects straight away, and if that fails it retries with jittered
+*  exponential backoff so a room full of boards doesn't hammer the AP in
+*  lockstep. It also keeps uptime, time-to-IP and outage statistics.
+*
+*  The supervisor learns about the link from supervisor_event; pass it to
+*  CC3000_SetEventHook before supervisor_begin so CC3000_AsyncCallback
+*  hands it every unsolicited event. Call
+*  wlan_ioctl_set_connection_policy(DISABLE, DISABLE, DISABLE) first, or
+*  the CC3000 will also be reconnecting on its own.
+*
+****************************************************************************/
+#ifndef __SUPERVISOR_H__
+#define __SUPERVISOR_H__
+
+#include "wlan.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// Longest wait from wlan_connect to associated
+#ifndef SUPERVISOR_CONNECT_TIMEOUT_MS
+#define SUPERVISOR_CONNECT_TIMEOUT_MS	(15000UL)
+#endif
+
+// Longest wait from associated to an IP address
+#ifndef SUPERVISOR_DHCP_TIMEOUT_MS
+#define SUPERVISOR_DHCP_TIMEOUT_MS		(15000UL)
+#endif
+
+// Backoff after the first failed attempt, doubled after each one after that
+#ifndef SUPERVISOR_BACKOFF_MIN_MS
+#define SUPERVISOR_BACKOFF_MIN_MS		(1000UL)
+#endif
+
+#ifndef SUPERVISOR_BACKOFF_MAX_MS
+#define SUPERVISOR_BACKOFF_MAX_MS		(60000UL)
+#endif
+
+//--------- States --------
+
+#define SUPERVISOR_STATE_IDLE		(0)		// supervisor_begin not called
+#define SUPERVISOR_STATE_START		(1)		// about to call wlan_connect
+#define SUPERVISOR_STATE_CONNECT	(2)		// waiting for the association
+#define SUPERVISOR_STATE_WAIT_DHCP	(3)		// associated, waiting for an IP address
+#define SUPERVISOR_STATE_ONLINE		(4)		// associated with an IP address
+#define SUPERVISOR_STATE_LOST		(5)		// was online, link dropped
+#define SUPERVISOR_STATE_BACKOFF	(6)		// attempt failed, waiting to retry
+
+//--------- Errors --------
+
+#define SUPERVISOR_ERR_PARAM		(-1)	// SSID too long
+
+typedef struct _supervisor_stats_t
+{
+	unsigned long	ulAttempts;				// wlan_connect calls
+	unsigned long	ulFailures;				// attempts that timed out or were refused
+	unsigned long	ulDrops;				// times the link was lost while online
+	unsigned long	ulUptimeMillis;			// total time online, current stretch included
+	unsigned long	ulLastTimeToIp;			// wlan_connect to IP address, last success
+	unsigned long	ulMaxTimeToIp;
+	unsigned long	ulTotalTimeToIp;
+	unsigned long	ulOnlines;				// successes, for the average time to IP
+	unsigned long	ulLastOutage;			// link lost to online again, last outage
+	unsigned long	ulMaxOutage;
+	unsigned long	ulTotalOutage;
+	unsigned long	ulBackoffMillis;		// last backoff waited, jitter included
+} tSupervisorStats;
+
+
+//*****************************************************************************
+//
+//! supervisor_begin
+//!
+//!  @param[in]  ulSecType  WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or
+//!                         WLAN_SEC_WPA2
+//!  @param[in]  ssid       SSID, up to 32 bytes
+//!  @param[in]  ssid_len   length of the SSID
+//!  @param[in]  key        security key. Not copied, must stay valid until
+//!                         supervisor_end.
+//!  @param[in]  key_len    key length
+//!
+//!  @return  0 on success, SUPERVISOR_ERR_PARAM
+//!
+//!  @brief  Start supervising the connection to a network. If the CC3000
+//!          is already online the supervisor starts in ONLINE, otherwise
+//!          the next supervisor_poll connects. Subscribes to the connect,
+//!          disconnect and DHCP events until supervisor_end.
+//
+//*****************************************************************************
+extern long supervisor_begin(unsigned long ulSecType, char *ssid, long ssid_len,
+                             unsigned char *key, long key_len);
+
+//*****************************************************************************
+//
+//! supervisor_end
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Stop supervising. The connection is left as it is.
+//
+//*****************************************************************************
+extern void supervisor_end(void);
+
+//*****************************************************************************
+//
+//! supervisor_poll
+//!
+//!  @param  none
+//!
+//!  @return  SUPERVISOR_STATE_xxx after this step
+//!
+//!  @brief  Call this from loop(). Never waits; moves the state machine
+//!          on according to the events seen since the last call.
+//
+//*****************************************************************************
+extern unsigned char supervisor_poll(void);
+
+//*****************************************************************************
+//
+//! supervisor_state
+//!
+//!  @param  none
+//!
+//!  @return  SUPERVISOR_STATE_xxx
+//!
+//!  @brief  Current state, without stepping the state machine
+//
+//*****************************************************************************
+extern unsigned char supervisor_state(void);
+
+//*****************************************************************************
+//
+//! supervisor_hold
+//!
+//!  @param  ucHold  1 before deliberately switching APs, 0 once done
+//!
+//!  @return  none
+//!
+//!  @brief  Keep the supervisor from treating a deliberate disconnect (a
+//!          roam, see roam_poll) as a dropped link and reconnecting by
+//!          SSID. While held supervisor_poll does nothing. On release a
+//!          link that is associated again just waits for DHCP; one that
+//!          isn't counts as a drop.
+//
+//*****************************************************************************
+extern void supervisor_hold(unsigned char ucHold);
+
+//*****************************************************************************
+//
+//! supervisor_event
+//!
+//!  @param  lEventType  event from the CC3000
+//!  @param  data        event data
+//!  @param  length      length of data
+//!
+//!  @return  none
+//!
+//!  @brief  Feed an unsolicited event to the supervisor. Called through
+//!          CC3000_SetEventHook, possibly in interrupt context, so it
+//!          only notes what happened; supervisor_poll acts on it.
+//
+//*****************************************************************************
+extern void supervisor_event(long lEventType, char *data, unsigned char length);
+
+//*****************************************************************************
+//
+//! supervisor_get_stats
+//!
+//!  @param[out]  pStats  copy of the statistics
+//!
+//!  @return  none
+//!
+//!  @brief  Read the connection statistics
+//
+//*****************************************************************************
+extern void supervisor_get_stats(tSupervisorStats *pStats);
+
+//*****************************************************************************
+//
+//! supervisor_reset_stats
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Clear the statistics
+//
+//*****************************************************************************
+extern void supervisor_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __SUPERVISOR_H__
@@ -32,6 +32,23 @@
      #endif //CC3000_UNENCRYPTED_SMART_CONFIG
      I'm not sure why it's needed...differences between the TI
      compiler and the Arduino compiler?
+     
+   + wlan_stop clears the background command slot (hci_async_reset)
+     
+   + Added wlan_start_async and wlan_start_poll, a staged wlan_start that
+     doesn't block, and wlan_start_get_timing. wlan_start shares its set-up
+     with them (WlanStartPrepare) and also clears the background command
+     slot.
+     
+   + Added wlan_event_subscribe and wlan_event_unsubscribe, which keep the
+     CC3000 event mask at the minimum the subscribers need and re-apply it
+     after every start, and the interrupt counters read by
+     wlan_event_get_stats (counted in SpiReceiveHandler)
+     
+   + wlan_smart_config_process expands the AES key once for both key
+     blocks (aes_set_key / aes_decrypt_block)
+     
+   + Added wlan_wait_connected
 * 
 ****************************************************************************/
 
@@ -141,6 +158,26 @@ unsigned char profileArray[SMART_CONFIG_PROFILE_SIZE];
 #define WLAN_CONNECT_PARAM_LEN					(29)
 #define WLAN_SMART_CONFIG_START_PARAMS_LEN		(4)
 
+// wlan_start_async progress, see wlan_start_poll
+static unsigned char ucWlanStartStage = WLAN_START_IDLE;
+static unsigned char ucWlanStartWaitHigh;		// IRQ still has to go high first
+static unsigned char ucWlanStartPatches;
+static tWlanStartTiming wlanStartTiming;
+
+// Events wlan_event_subscribe can mask. Free-buffer and TCP close-wait
+// events are never masked, the driver's own bookkeeping depends on them.
+#define WLAN_EVENT_MASKABLE		(HCI_EVNT_WLAN_UNSOL_CONNECT | HCI_EVNT_WLAN_UNSOL_DISCONNECT |\
+								 HCI_EVNT_WLAN_UNSOL_INIT | HCI_EVNT_WLAN_TX_COMPLETE |\
+								 HCI_EVNT_WLAN_UNSOL_DHCP | HCI_EVNT_WLAN_ASYNC_PING_REPORT |\
+								 HCI_EVNT_WLAN_ASYNC_SIMPLE_CONFIG_DONE | HCI_EVNT_WLAN_KEEPALIVE)
+#define WLAN_EVENT_BITS			(10)	// bits of WLAN_EVENT_MASKABLE, base excluded
+
+// Subscriber count per event bit, see wlan_event_subscribe
+static unsigned char aucWlanEventRefs[WLAN_EVENT_BITS];
+static volatile tWlanEventStats wlanEventStats;
+
+static long WlanEventMaskApply(unsigned char ucStarted);
+
 
 
 
@@ -270,7 +307,11 @@ void SpiReceiveHandler(void *pvBuffer)
 	tSLInformation.usEventOrDataReceived = 1;
 	tSLInformation.pucReceivedData = (unsigned char 	*)pvBuffer;
 	
-	hci_unsolicited_event_handler();
+	wlanEventStats.ulInterrupts++;
+	if (hci_unsolicited_event_handler())
+	{
+		wlanEventStats.ulUnsolicited++;
+	}
 }
 
 
@@ -301,10 +342,21 @@ void SpiReceiveHandler(void *pvBuffer)
 //
 //*****************************************************************************
 
-void
-wlan_start(unsigned short usPatchesAvailableAtHost)
+//*****************************************************************************
+//
+//!  WlanStartPrepare
+//!
+//!  @param   none
+//!
+//!  @return  IRQ line state before WLAN_EN was asserted
+//!
+//!  @brief   Reset the driver state, open SPI and assert WLAN_EN. Shared by
+//!           wlan_start and wlan_start_async.
+//
+//*****************************************************************************
+static unsigned long
+WlanStartPrepare(void)
 {
-	
 	unsigned long ulSpiIRQState;
 	
 	tSLInformation.NumberOfSentPackets = 0;
@@ -327,9 +379,28 @@ wlan_start(unsigned short usPatchesAvailableAtHost)
 	// Check the IRQ line
 	ulSpiIRQState = tSLInformation.ReadWlanInterruptPin();
 	
+	// A command left in the background slot belongs to an earlier start
+	hci_async_reset();
+	ucWlanStartStage = WLAN_START_IDLE;
+	
 	// ASIC 1273 chip enable: toggle WLAN EN line
 	tSLInformation.WriteWlanPin( WLAN_ENABLE );
 	
+	wlanStartTiming.ulEnableMillis = millis();
+	wlanStartTiming.ulPowerUpMillis = 0;
+	wlanStartTiming.ulReadyMillis = 0;
+	
+	return ulSpiIRQState;
+}
+
+void
+wlan_start(unsigned short usPatchesAvailableAtHost)
+{
+	
+	unsigned long ulSpiIRQState;
+	
+	ulSpiIRQState = WlanStartPrepare();
+	
 	if (ulSpiIRQState)
 	{
 		// wait till the IRQ line goes low
@@ -349,11 +420,122 @@ wlan_start(unsigned short usPatchesAvailableAtHost)
 		}
 	}
 	
+	wlanStartTiming.ulPowerUpMillis = millis() - wlanStartTiming.ulEnableMillis;
+	
 	SimpleLink_Init_Start(usPatchesAvailableAtHost);
 	
 	// Read Buffer's size and finish
 	hci_command_send(HCI_CMND_READ_BUFFER_SIZE, tSLInformation.pucTxCommandBuffer, 0);
 	SimpleLinkWaitEvent(HCI_CMND_READ_BUFFER_SIZE, 0);
+	
+	wlanStartTiming.ulReadyMillis = millis() - wlanStartTiming.ulEnableMillis;
+	ucWlanStartStage = WLAN_START_READY;
+	
+	WlanEventMaskApply(1);
+}
+
+//*****************************************************************************
+//
+//!  wlan_start_async
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+void
+wlan_start_async(unsigned short usPatchesAvailableAtHost)
+{
+	// Same IRQ sequence as wlan_start: if the line starts low it goes high
+	// and then low again, otherwise it just goes low
+	ucWlanStartWaitHigh = (WlanStartPrepare() == 0);
+	ucWlanStartPatches = (usPatchesAvailableAtHost != 0);
+	ucWlanStartStage = WLAN_START_POWERUP;
+}
+
+//*****************************************************************************
+//
+//!  wlan_start_poll
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+unsigned char
+wlan_start_poll(void)
+{
+	unsigned char aucParams[HCI_ASYNC_PARAMS_LEN];
+	unsigned char *ptr, *args;
+	
+	ptr = tSLInformation.pucTxCommandBuffer;
+	
+	switch (ucWlanStartStage)
+	{
+	case WLAN_START_POWERUP:
+		if (ucWlanStartWaitHigh)
+		{
+			if (tSLInformation.ReadWlanInterruptPin() != 0)
+			{
+				ucWlanStartWaitHigh = 0;
+			}
+			break;
+		}
+		if (tSLInformation.ReadWlanInterruptPin() != 0)
+		{
+			break;
+		}
+		
+		wlanStartTiming.ulPowerUpMillis = millis() - wlanStartTiming.ulEnableMillis;
+		
+		args = (unsigned char *)(ptr + HEADERS_SIZE_CMD);
+		UINT8_TO_STREAM(args, ((ucWlanStartPatches) ? SL_PATCHES_REQUEST_FORCE_HOST : SL_PATCHES_REQUEST_DEFAULT));
+		
+		if (hci_async_command_send(HCI_CMND_SIMPLE_LINK_START, ptr, 
+				WLAN_SL_INIT_START_PARAMS_LEN, HCI_CMND_SIMPLE_LINK_START) == 0)
+		{
+			ucWlanStartStage = WLAN_START_SIMPLE_LINK;
+		}
+		break;
+		
+	case WLAN_START_SIMPLE_LINK:
+		if (hci_async_poll(HCI_CMND_SIMPLE_LINK_START, aucParams) == 1)
+		{
+			if (hci_async_command_send(HCI_CMND_READ_BUFFER_SIZE, ptr, 0, 
+					HCI_CMND_READ_BUFFER_SIZE) == 0)
+			{
+				ucWlanStartStage = WLAN_START_BUFFER_SIZE;
+			}
+		}
+		break;
+		
+	case WLAN_START_BUFFER_SIZE:
+		if (hci_async_poll(HCI_CMND_READ_BUFFER_SIZE, aucParams) == 1)
+		{
+			STREAM_TO_UINT8((char *)aucParams, 0, tSLInformation.usNumberOfFreeBuffers);
+			STREAM_TO_UINT16((char *)aucParams, 1, tSLInformation.usSlBufferLength);
+			
+			wlanStartTiming.ulReadyMillis = millis() - wlanStartTiming.ulEnableMillis;
+			ucWlanStartStage = WLAN_START_READY;
+			
+			WlanEventMaskApply(1);
+		}
+		break;
+		
+	default:
+		break;
+	}
+	
+	return ucWlanStartStage;
+}
+
+//*****************************************************************************
+//
+//!  wlan_start_get_timing
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+void
+wlan_start_get_timing(tWlanStartTiming *pTiming)
+{
+	memcpy(pTiming, &wlanStartTiming, sizeof(tWlanStartTiming));
 }
 
 
@@ -389,6 +571,10 @@ wlan_stop(void)
 	}
 	
 	SpiClose();
+	
+	// A command left running in the background will never complete
+	hci_async_reset();
+	ucWlanStartStage = WLAN_START_IDLE;
 }
 
 
@@ -1009,14 +1195,155 @@ wlan_set_event_mask(unsigned long ulMask)
 	return(ret);
 }
 
+//*****************************************************************************
+//
+//!  WlanEventMaskApply
+//!
+//!  @param   ucStarted  1 right after a start, when the CC3000 is back at
+//!                      its default of no events masked
+//!
+//!  @return  0 if the mask is in place (or will be at the next start),
+//!           -1 if wlan_set_event_mask failed
+//!
+//!  @brief   Mask every maskable event without a subscriber, if that
+//!           differs from what the CC3000 has
+//
+//*****************************************************************************
+static long
+WlanEventMaskApply(unsigned char ucStarted)
+{
+	unsigned long ulMask;
+	unsigned char i;
+	long ret;
+	
+	ulMask = 0;
+	for (i = 0; i < WLAN_EVENT_BITS; i++)
+	{
+		if ((WLAN_EVENT_MASKABLE & (1UL << i)) && (aucWlanEventRefs[i] == 0))
+		{
+			ulMask |= (1UL << i);
+		}
+	}
+	if (ulMask != 0)
+	{
+		ulMask |= HCI_EVNT_WLAN_UNSOL_BASE;
+	}
+	
+	if (ucStarted)
+	{
+		wlanEventStats.ulMask = 0;
+		tSLInformation.InformHostOnTxComplete = 1;
+	}
+	
+	// Sent once the CC3000 is running
+	if ((ucWlanStartStage != WLAN_START_READY) || (ulMask == wlanEventStats.ulMask))
+	{
+		return 0;
+	}
+	
+	// TX_COMPLETE alone is host-side only and wlan_set_event_mask wouldn't
+	// send anything, leaving the CC3000 with the old mask
+	if (ulMask == HCI_EVNT_WLAN_TX_COMPLETE)
+	{
+		ret = wlan_set_event_mask(0);
+		tSLInformation.InformHostOnTxComplete = 0;
+	}
+	else
+	{
+		ret = wlan_set_event_mask(ulMask);
+	}
+	if (ret == 0)
+	{
+		wlanEventStats.ulMask = ulMask;
+		wlanEventStats.ulMaskUpdates++;
+	}
+	
+	return ret;
+}
+
+//*****************************************************************************
+//
+//!  wlan_event_subscribe
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+long
+wlan_event_subscribe(unsigned long ulEvents)
+{
+	unsigned char i;
+	
+	for (i = 0; i < WLAN_EVENT_BITS; i++)
+	{
+		if ((ulEvents & WLAN_EVENT_MASKABLE & (1UL << i)) && (aucWlanEventRefs[i] < 0xff))
+		{
+			aucWlanEventRefs[i]++;
+		}
+	}
+	
+	return WlanEventMaskApply(0);
+}
+
+//*****************************************************************************
+//
+//!  wlan_event_unsubscribe
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+long
+wlan_event_unsubscribe(unsigned long ulEvents)
+{
+	unsigned char i;
+	
+	for (i = 0; i < WLAN_EVENT_BITS; i++)
+	{
+		if ((ulEvents & WLAN_EVENT_MASKABLE & (1UL << i)) && (aucWlanEventRefs[i] > 0))
+		{
+			aucWlanEventRefs[i]--;
+		}
+	}
+	
+	return WlanEventMaskApply(0);
+}
+
+//*****************************************************************************
+//
+//!  wlan_event_get_stats
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+void
+wlan_event_get_stats(tWlanEventStats *pStats)
+{
+	memcpy(pStats, (const void *)&wlanEventStats, sizeof(tWlanEventStats));
+}
+
+//*****************************************************************************
+//
+//!  wlan_event_reset_stats
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+void
+wlan_event_reset_stats(void)
+{
+	wlanEventStats.ulInterrupts = 0;
+	wlanEventStats.ulUnsolicited = 0;
+	wlanEventStats.ulMaskUpdates = 0;
+	wlanEventStats.ulSinceMillis = millis();
+}
+
 //*****************************************************************************
 //
 //!  wlan_ioctl_statusget
 //!
 //!  @param none 
 //!
-//!  @return    WLAN_STATUS_DISCONNECTED, WLAN_STATUS_SCANING, 
-//!             STATUS_CONNECTING or WLAN_STATUS_CONNECTED      
+//!  @return    WLAN_STATUS_DISCONNECTED, WLAN_STATUS_SCANNING, 
+//!             WLAN_STATUS_CONNECTING or WLAN_STATUS_CONNECTED      
 //!
 //!  @brief    get wlan status: disconnected, scanning, connecting or connected
 //
@@ -1040,6 +1367,28 @@ wlan_ioctl_statusget(void)
 	
 	return(ret);    
 }
+
+//*****************************************************************************
+//
+//!  wlan_wait_connected
+//!
+//!  @brief  see wlan.h
+//
+//*****************************************************************************
+long
+wlan_wait_connected(unsigned long ulStart, unsigned long ulTimeoutMs)
+{
+	while (millis() - ulStart < ulTimeoutMs)
+	{
+		if (wlan_ioctl_statusget() == WLAN_STATUS_CONNECTED)
+		{
+			return 0;
+		}
+		delay(10);
+	}
+	
+	return EFAIL;
+}
 #endif
 
 //*****************************************************************************
@@ -1190,6 +1539,7 @@ wlan_smart_config_process()
 	unsigned long ssidLen, keyLen;
 	unsigned char *decKeyPtr;
 	unsigned char *ssidPtr;
+	tAesContext aesContext;
 	
 	// read the key from EEPROM - fileID 12
 	returnValue = aes_read_key(key);
@@ -1217,9 +1567,10 @@ wlan_smart_config_process()
 	
 	decKeyPtr = &profileArray[profileArray[0] + 3];
 	
-	aes_decrypt(decKeyPtr, key);
+	aes_set_key(&aesContext, key);
+	aes_decrypt_block(&aesContext, decKeyPtr);
 	if (profileArray[profileArray[0] + 1] > 16)
-		aes_decrypt((unsigned char *)(decKeyPtr + 16), key);
+		aes_decrypt_block(&aesContext, (unsigned char *)(decKeyPtr + 16));
 	
 	if (*(unsigned char *)(decKeyPtr +31) != 0)
 	{
@@ -17,7 +17,13 @@
 *  reference library. Changes to the reference library file,
 *  if any, are listed below:
 *
-*  No changes to this file.
+*  + Added wlan_start_async, wlan_start_poll and wlan_start_get_timing
+*
+*  + Added wlan_event_subscribe, wlan_event_unsubscribe,
+*    wlan_event_get_stats and wlan_event_reset_stats
+*
+*  + Added the WLAN_STATUS_xxx values wlan_ioctl_statusget returns, and
+*    wlan_wait_connected
 * 
 ****************************************************************************/
 
@@ -83,6 +89,12 @@ extern "C" {
 #define      WLAN_SEC_WEP	(1)
 #define      WLAN_SEC_WPA	(2)
 #define      WLAN_SEC_WPA2	(3)
+
+// wlan_ioctl_statusget return values
+#define      WLAN_STATUS_DISCONNECTED	(0)
+#define      WLAN_STATUS_SCANNING		(1)
+#define      WLAN_STATUS_CONNECTING	(2)
+#define      WLAN_STATUS_CONNECTED		(3)
 //*****************************************************************************
 //
 //! \addtogroup wlan_api
@@ -175,6 +187,71 @@ extern void wlan_init(		tWlanCB	 	sWlanCB,
 //*****************************************************************************
 extern void wlan_start(unsigned short usPatchesAvailableAtHost);
 
+//--------- wlan_start_poll stages --------
+
+#define WLAN_START_IDLE				(0)		// wlan_start_async not called
+#define WLAN_START_POWERUP			(1)		// waiting for the CC3000 to raise its IRQ
+#define WLAN_START_SIMPLE_LINK		(2)		// HCI_CMND_SIMPLE_LINK_START sent
+#define WLAN_START_BUFFER_SIZE		(3)		// HCI_CMND_READ_BUFFER_SIZE sent
+#define WLAN_START_READY			(4)		// started, other API calls allowed
+
+typedef struct _wlan_start_timing_t
+{
+	unsigned long	ulEnableMillis;			// millis() when WLAN_EN was raised
+	unsigned long	ulPowerUpMillis;		// WLAN_EN to the CC3000 ready for SPI
+	unsigned long	ulReadyMillis;			// WLAN_EN to started, 0 until then
+} tWlanStartTiming;
+
+//*****************************************************************************
+//
+//!  wlan_start_async
+//!
+//!  @param   usPatchesAvailableAtHost  see wlan_start
+//!
+//!  @return  none
+//!
+//!  @brief   Start the WLAN device like wlan_start, but return as soon as
+//!           WLAN_EN is asserted. The start-up is then moved on by
+//!           wlan_start_poll, so the host can initialize its own
+//!           peripherals while the CC3000 boots.
+//!
+//!  @Note    Call wlan_init first. No other wlan API may be called until
+//!           wlan_start_poll has returned WLAN_START_READY.
+//!  @sa      wlan_start_poll , wlan_start
+//
+//*****************************************************************************
+extern void wlan_start_async(unsigned short usPatchesAvailableAtHost);
+
+//*****************************************************************************
+//
+//!  wlan_start_poll
+//!
+//!  @param   none
+//!
+//!  @return  WLAN_START_xxx stage reached
+//!
+//!  @brief   Move a wlan_start_async start-up on without waiting. The
+//!           power-up stage watches the IRQ line; the two HCI commands
+//!           after it go through the background command slot and are
+//!           completed by the IRQ handler, so calling this every few
+//!           milliseconds is enough.
+//
+//*****************************************************************************
+extern unsigned char wlan_start_poll(void);
+
+//*****************************************************************************
+//
+//!  wlan_start_get_timing
+//!
+//!  @param[out]  pTiming  timing of the last wlan_start or wlan_start_async
+//!
+//!  @return  none
+//!
+//!  @brief   Read how long the last start-up took
+//
+//*****************************************************************************
+extern void wlan_start_get_timing(tWlanStartTiming *pTiming);
+
 //*****************************************************************************
 //
 //!  wlan_stop
@@ -322,20 +399,108 @@ extern long wlan_ioctl_del_profile(unsigned long ulIndex);
 //*****************************************************************************
 extern long wlan_set_event_mask(unsigned long ulMask);
 
+typedef struct _wlan_event_stats_t
+{
+	unsigned long	ulInterrupts;			// packets the CC3000 raised its IRQ for
+	unsigned long	ulUnsolicited;			// of those, handled as unsolicited events
+	unsigned long	ulSinceMillis;			// millis() the counters were cleared
+	unsigned long	ulMask;					// event mask applied to the CC3000
+	unsigned long	ulMaskUpdates;			// wlan_set_event_mask calls made
+} tWlanEventStats;
+
+//*****************************************************************************
+//
+//!  wlan_event_subscribe
+//!
+//!  @param    ulEvents  events needed, same bits as wlan_set_event_mask
+//!
+//!  @return   On success, zero is returned. On error, -1 is returned
+//!
+//!  @brief    Declare that a component needs some unsolicited events. The
+//!            driver keeps a count per event and masks every event nobody
+//!            has subscribed to, so the CC3000 doesn't raise an IRQ for it.
+//!            The mask is sent only when it changes, and again after each
+//!            wlan_start since the CC3000 doesn't save it. Calls made
+//!            before the CC3000 is started take effect once it is.
+//!            HCI_EVNT_WLAN_TX_COMPLETE controls the
+//!            HCI_EVENT_CC3000_CAN_SHUT_DOWN callback. Free-buffer and TCP
+//!            close-wait events are always delivered, the driver needs them.
+//!
+//!  @sa       wlan_event_unsubscribe , wlan_set_event_mask
+//
+//*****************************************************************************
+extern long wlan_event_subscribe(unsigned long ulEvents);
+
+//*****************************************************************************
+//
+//!  wlan_event_unsubscribe
+//!
+//!  @param    ulEvents  events no longer needed
+//!
+//!  @return   On success, zero is returned. On error, -1 is returned
+//!
+//!  @brief    Undo a wlan_event_subscribe. Events still subscribed to by
+//!            another component stay unmasked.
+//
+//*****************************************************************************
+extern long wlan_event_unsubscribe(unsigned long ulEvents);
+
+//*****************************************************************************
+//
+//!  wlan_event_get_stats
+//!
+//!  @param[out]  pStats  interrupt counters and the mask in use
+//!
+//!  @return   none
+//!
+//!  @brief    Read the interrupt counters. Interrupts per minute is
+//!            ulInterrupts * 60000 / (millis() - ulSinceMillis).
+//
+//*****************************************************************************
+extern void wlan_event_get_stats(tWlanEventStats *pStats);
+
+//*****************************************************************************
+//
+//!  wlan_event_reset_stats
+//!
+//!  @param    none
+//!
+//!  @return   none
+//!
+//!  @brief    Clear the interrupt counters
+//
+//*****************************************************************************
+extern void wlan_event_reset_stats(void);
+
 //*****************************************************************************
 //
 //!  wlan_ioctl_statusget
 //!
 //!  @param none 
 //!
-//!  @return    WLAN_STATUS_DISCONNECTED, WLAN_STATUS_SCANING, 
-//!             STATUS_CONNECTING or WLAN_STATUS_CONNECTED      
+//!  @return    WLAN_STATUS_DISCONNECTED, WLAN_STATUS_SCANNING, 
+//!             WLAN_STATUS_CONNECTING or WLAN_STATUS_CONNECTED      
 //!
 //!  @brief    get wlan status: disconnected, scanning, connecting or connected
 //
 //*****************************************************************************
 extern long wlan_ioctl_statusget(void);
 
+//*****************************************************************************
+//
+//!  wlan_wait_connected
+//!
+//!  @param    ulStart      millis() the connect was started at
+//!  @param    ulTimeoutMs  longest wait from ulStart
+//!
+//!  @return   0 once wlan_ioctl_statusget reports WLAN_STATUS_CONNECTED,
+//!            -1 on timeout
+//!
+//!  @brief    Wait for the association after wlan_connect
+//
+//*****************************************************************************
+extern long wlan_wait_connected(unsigned long ulStart, unsigned long ulTimeoutMs);
+
 
 //*****************************************************************************
 //
@@ -0,0 +1,1208 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  WebSocket server, see ws.h
+*
+*  During the opening handshake a connection keeps one header name and
+*  the Sec-WebSocket-Key; once it is open the same space holds the
+*  payload of a ping, which has to be echoed in the pong. The SHA-1 and
+*  base64 needed for Sec-WebSocket-Accept are done here, in the smallest
+*  form that does the one 60 byte hash the handshake needs.
+*
+****************************************************************************/
+
+#include <arduino.h>
+
+#include <string.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "evnt_handler.h"
+#include "reactor.h"
+#include "ws.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+//--------- Parser states --------
+
+#define WS_STATE_REQUEST			(0)		// request line, not looked at
+#define WS_STATE_HEADER_NAME		(1)
+#define WS_STATE_HEADER_VALUE		(2)
+#define WS_STATE_FRAME_HEAD			(3)		// FIN, RSV and opcode
+#define WS_STATE_FRAME_LEN			(4)		// MASK and 7 bit length
+#define WS_STATE_FRAME_EXT_LEN		(5)
+#define WS_STATE_FRAME_MASK			(6)
+#define WS_STATE_FRAME_PAYLOAD		(7)
+
+#define WS_CONN_UPGRADE				(0x01)	// "Upgrade: websocket" seen
+#define WS_CONN_KEY					(0x02)	// Sec-WebSocket-Key of the right length seen
+#define WS_CONN_OPEN				(0x04)	// handshake done
+#define WS_CONN_FIN					(0x08)	// frame being read is the last of its message
+#define WS_CONN_IN_MSG				(0x10)	// a fragmented message is being read
+#define WS_CONN_BINARY				(0x20)
+#define WS_CONN_FIRST				(0x40)	// next payload piece is the first of its message
+
+#define WS_HEADER_OTHER				(0)
+#define WS_HEADER_UPGRADE			(1)
+#define WS_HEADER_KEY				(2)
+
+// Long enough for "sec-websocket-key" and "websocket"
+#define WS_TOKEN_MAX				(20)
+
+// Base64 of a 16 byte nonce
+#define WS_KEY_LEN					(24)
+
+// Base64 of a 20 byte SHA-1 digest
+#define WS_ACCEPT_LEN				(28)
+
+#define WS_RECV_BUF					(64)
+
+typedef struct _ws_conn_t
+{
+	unsigned long	ulOpened;				// millis() when accepted
+	unsigned long	ulRemaining;			// payload bytes left in the frame
+	union
+	{
+		struct
+		{
+			char	acToken[WS_TOKEN_MAX + 1];
+			char	acKey[WS_KEY_LEN + 1];
+		} hs;
+		unsigned char	aucControl[WS_CONTROL_MAX];
+	} u;
+	unsigned char	aucMask[4];
+	unsigned char	ucState;
+	unsigned char	ucLen;					// bytes in acToken, acKey or aucControl, or length bytes left
+	unsigned char	ucFlags;
+	unsigned char	ucHeader;
+	unsigned char	ucOpcode;				// of the frame being read
+	unsigned char	ucMaskPos;
+	signed char		cSd;					// -1 if free
+} tWsConn;
+
+// Handshake response: PROGMEM head, RAM middle, PROGMEM tail
+typedef struct _ws_out_t
+{
+	const char		*pcHead;
+	const char		*pcMid;
+	const char		*pcTail;
+	unsigned short	usHeadLen;
+	unsigned short	usMidLen;
+	unsigned short	usTailLen;
+} tWsOut;
+
+
+static tWsConn		wsConns[WS_MAX_CONNS];
+static tWsHandler	wsHandler;
+static tWsStats		wsStats;
+static signed char	cWsListenSd = -1;
+
+static const char	wsGuid[] PROGMEM = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+
+//*****************************************************************************
+//
+//! ws_rol
+//!
+//!  @brief  32 bit rotate left. The masks cost nothing where unsigned long
+//!          is 32 bits and keep the hash right where it is wider
+//
+//*****************************************************************************
+static unsigned long
+ws_rol(unsigned long ulValue, unsigned char ucBits)
+{
+	ulValue &= 0xffffffffUL;
+
+	return ((ulValue << ucBits) | (ulValue >> (32 - ucBits))) & 0xffffffffUL;
+}
+
+//*****************************************************************************
+//
+//! ws_sha1_block
+//!
+//!  @param  pulH      hash state
+//!  @param  pucBlock  64 byte block
+//!
+//!  @return  none
+//!
+//!  @brief  SHA-1 compression function. The message schedule is kept as a
+//!          16 word ring rather than 80 words, to spare the stack
+//
+//*****************************************************************************
+static void
+ws_sha1_block(unsigned long *pulH, const unsigned char *pucBlock)
+{
+	unsigned long aulW[16];
+	unsigned long a, b, c, d, e, f, k, t;
+	unsigned char i;
+
+	for (i = 0; i < 16; i++)
+	{
+		aulW[i] = ((unsigned long)pucBlock[4 * i] << 24) | ((unsigned long)pucBlock[4 * i + 1] << 16) |
+			((unsigned long)pucBlock[4 * i + 2] << 8) | pucBlock[4 * i + 3];
+	}
+
+	a = pulH[0];
+	b = pulH[1];
+	c = pulH[2];
+	d = pulH[3];
+	e = pulH[4];
+
+	for (i = 0; i < 80; i++)
+	{
+		if (i >= 16)
+		{
+			t = aulW[(i + 13) & 15] ^ aulW[(i + 8) & 15] ^ aulW[(i + 2) & 15] ^ aulW[i & 15];
+			aulW[i & 15] = ws_rol(t, 1);
+		}
+
+		if (i < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5A827999UL;
+		}
+		else if (i < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1UL;
+		}
+		else if (i < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDCUL;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6UL;
+		}
+
+		t = (ws_rol(a, 5) + f + e + k + aulW[i & 15]) & 0xffffffffUL;
+		e = d;
+		d = c;
+		c = ws_rol(b, 30);
+		b = a;
+		a = t;
+	}
+
+	pulH[0] = (pulH[0] + a) & 0xffffffffUL;
+	pulH[1] = (pulH[1] + b) & 0xffffffffUL;
+	pulH[2] = (pulH[2] + c) & 0xffffffffUL;
+	pulH[3] = (pulH[3] + d) & 0xffffffffUL;
+	pulH[4] = (pulH[4] + e) & 0xffffffffUL;
+}
+
+//*****************************************************************************
+//
+//! ws_base64_char
+//!
+//!  @param  ucValue  6 bit value
+//!
+//!  @return  its base64 digit
+//
+//*****************************************************************************
+static char
+ws_base64_char(unsigned char ucValue)
+{
+	if (ucValue < 26)
+	{
+		return 'A' + ucValue;
+	}
+	if (ucValue < 52)
+	{
+		return 'a' + ucValue - 26;
+	}
+	if (ucValue < 62)
+	{
+		return '0' + ucValue - 52;
+	}
+
+	return (ucValue == 62) ? '+' : '/';
+}
+
+//*****************************************************************************
+//
+//! ws_accept_key
+//!
+//!  @param[in]   pcKey     Sec-WebSocket-Key, WS_KEY_LEN characters
+//!  @param[out]  pcAccept  Sec-WebSocket-Accept, WS_ACCEPT_LEN characters
+//!                         and a terminating NUL
+//!
+//!  @return  none
+//!
+//!  @brief  base64(SHA-1(key + GUID)). Key and GUID are 60 bytes, so the
+//!          hash is always two blocks and the padding is fixed.
+//
+//*****************************************************************************
+static void
+ws_accept_key(const char *pcKey, char *pcAccept)
+{
+	unsigned char aucBlock[64];
+	unsigned long aulH[5] = { 0x67452301UL, 0xEFCDAB89UL, 0x98BADCFEUL, 0x10325476UL, 0xC3D2E1F0UL };
+	unsigned long ulGroup;
+	unsigned char i, n;
+
+	memcpy(aucBlock, pcKey, WS_KEY_LEN);
+	memcpy_P(aucBlock + WS_KEY_LEN, wsGuid, sizeof(wsGuid) - 1);
+	aucBlock[60] = 0x80;
+	aucBlock[61] = 0;
+	aucBlock[62] = 0;
+	aucBlock[63] = 0;
+	ws_sha1_block(aulH, aucBlock);
+
+	// Second block: zeros and the message length in bits
+	memset(aucBlock, 0, sizeof(aucBlock));
+	aucBlock[62] = (60 * 8) >> 8;
+	aucBlock[63] = (60 * 8) & 0xff;
+	ws_sha1_block(aulH, aucBlock);
+
+	for (i = 0; i < 20; i++)
+	{
+		aucBlock[i] = (aulH[i >> 2] >> (24 - 8 * (i & 3))) & 0xff;
+	}
+	aucBlock[20] = 0;
+
+	n = 0;
+	for (i = 0; i < 20; i += 3)
+	{
+		ulGroup = ((unsigned long)aucBlock[i] << 16) | ((unsigned long)aucBlock[i + 1] << 8) |
+			aucBlock[i + 2];
+		pcAccept[n++] = ws_base64_char((ulGroup >> 18) & 0x3f);
+		pcAccept[n++] = ws_base64_char((ulGroup >> 12) & 0x3f);
+		pcAccept[n++] = ws_base64_char((ulGroup >> 6) & 0x3f);
+		pcAccept[n++] = ws_base64_char(ulGroup & 0x3f);
+	}
+
+	// 20 bytes leave one byte of padding
+	pcAccept[WS_ACCEPT_LEN - 1] = '=';
+	pcAccept[WS_ACCEPT_LEN] = '\0';
+}
+
+//*****************************************************************************
+//
+//! ws_out_source
+//!
+//!  @brief  tSendStreamSource over the pieces of a tWsOut
+//
+//*****************************************************************************
+static long
+ws_out_source(unsigned char *pucDst, unsigned long ulOffset, unsigned short usLen,
+              void *pvContext)
+{
+	tWsOut *pOut = (tWsOut *)pvContext;
+	unsigned short n, usRun, usOff;
+
+	n = 0;
+	while (n < usLen)
+	{
+		usOff = (unsigned short)(ulOffset + n);
+
+		if (usOff < pOut->usHeadLen)
+		{
+			usRun = pOut->usHeadLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			memcpy_P(pucDst + n, pOut->pcHead + usOff, usRun);
+		}
+		else if (usOff < pOut->usHeadLen + pOut->usMidLen)
+		{
+			usOff -= pOut->usHeadLen;
+			usRun = pOut->usMidLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			memcpy(pucDst + n, pOut->pcMid + usOff, usRun);
+		}
+		else
+		{
+			usOff -= pOut->usHeadLen + pOut->usMidLen;
+			usRun = pOut->usTailLen - usOff;
+			if (usRun > usLen - n)
+			{
+				usRun = usLen - n;
+			}
+			memcpy_P(pucDst + n, pOut->pcTail + usOff, usRun);
+		}
+
+		n += usRun;
+	}
+
+	return n;
+}
+
+//*****************************************************************************
+//
+//! ws_find
+//!
+//!  @param  sd  socket handle
+//!
+//!  @return  the connection on sd, or NULL
+//
+//*****************************************************************************
+static tWsConn *
+ws_find(long sd)
+{
+	unsigned char i;
+
+	for (i = 0; i < WS_MAX_CONNS; i++)
+	{
+		if (wsConns[i].cSd == sd)
+		{
+			return &wsConns[i];
+		}
+	}
+
+	return NULL;
+}
+
+//*****************************************************************************
+//
+//! ws_frame_send
+//!
+//!  @param  sd        socket handle
+//!  @param  ucOpcode  opcode of the frame
+//!  @param  pucData   payload
+//!  @param  usLen     payload length
+//!
+//!  @return  payload bytes sent in this frame, or -1
+//!
+//!  @brief  Send as much of the payload as fits in one TX buffer as one
+//!          frame, FIN set if that is all of it. Server frames aren't
+//!          masked, so the payload is copied as is behind a 2 byte header,
+//!          or 4 bytes for more than 125 bytes.
+//
+//*****************************************************************************
+static long
+ws_frame_send(long sd, unsigned char ucOpcode, const unsigned char *pucData, unsigned short usLen)
+{
+	unsigned char *pucDst;
+	unsigned short usMax, usRun, usHead;
+
+	pucDst = send_buffer_get(&usMax);
+
+	usHead = 2;
+	usRun = usLen;
+	if (usRun > usMax - usHead)
+	{
+		usRun = usMax - usHead;
+	}
+	if (usRun > 125)
+	{
+		usHead = 4;
+		if (usRun > usMax - usHead)
+		{
+			usRun = usMax - usHead;
+		}
+		if (usRun <= 125)
+		{
+			usHead = 2;
+			usRun = 125;
+		}
+	}
+
+	pucDst[0] = ((usRun == usLen) ? 0x80 : 0) | ucOpcode;
+	if (usHead == 2)
+	{
+		pucDst[1] = (unsigned char)usRun;
+	}
+	else
+	{
+		pucDst[1] = 126;
+		pucDst[2] = usRun >> 8;
+		pucDst[3] = usRun & 0xff;
+	}
+	memcpy(pucDst + usHead, pucData, usRun);
+
+	if (send_buffer_commit(sd, usHead + usRun, 0) != usHead + usRun)
+	{
+		return -1;
+	}
+
+	wsStats.ulFramesOut++;
+	wsStats.ulBytesOut += usRun;
+
+	return usRun;
+}
+
+//*****************************************************************************
+//
+//! ws_conn_close
+//!
+//!  @param  pConn  connection
+//!
+//!  @return  none
+//!
+//!  @brief  Tell the handler, close the socket and free the slot
+//
+//*****************************************************************************
+static void
+ws_conn_close(tWsConn *pConn)
+{
+	long sd = pConn->cSd;
+
+	if (sd < 0)
+	{
+		return;
+	}
+
+	reactor_unregister(sd);
+	closesocket(sd);
+	pConn->cSd = -1;
+
+	if (pConn->ucFlags & WS_CONN_OPEN)
+	{
+		wsHandler(sd, WS_EVENT_CLOSE, NULL, 0, 0);
+	}
+}
+
+//*****************************************************************************
+//
+//! ws_handshake
+//!
+//!  @param  pConn  connection at the end of the upgrade request
+//!
+//!  @return  0 if the connection is open, 1 to close it
+//
+//*****************************************************************************
+static unsigned char
+ws_handshake(tWsConn *pConn)
+{
+	char acAccept[WS_ACCEPT_LEN + 1];
+	tWsOut out;
+	unsigned long ulTotal;
+
+	memset(&out, 0, sizeof(out));
+
+	if ((pConn->ucFlags & (WS_CONN_UPGRADE | WS_CONN_KEY)) != (WS_CONN_UPGRADE | WS_CONN_KEY))
+	{
+		wsStats.ulBadHandshakes++;
+		out.pcHead = PSTR("HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+		out.usHeadLen = strlen_P(out.pcHead);
+		send_stream(pConn->cSd, ws_out_source, out.usHeadLen, &out);
+		return 1;
+	}
+
+	ws_accept_key(pConn->u.hs.acKey, acAccept);
+
+	out.pcHead = PSTR("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+		"Connection: Upgrade\r\nSec-WebSocket-Accept: ");
+	out.pcMid = acAccept;
+	out.pcTail = PSTR("\r\n\r\n");
+	out.usHeadLen = strlen_P(out.pcHead);
+	out.usMidLen = WS_ACCEPT_LEN;
+	out.usTailLen = strlen_P(out.pcTail);
+
+	ulTotal = (unsigned long)out.usHeadLen + out.usMidLen + out.usTailLen;
+	if (send_stream(pConn->cSd, ws_out_source, ulTotal, &out) != (long)ulTotal)
+	{
+		return 1;
+	}
+
+	wsStats.ulConnections++;
+	pConn->ucFlags = WS_CONN_OPEN;
+	pConn->ucState = WS_STATE_FRAME_HEAD;
+	wsHandler(pConn->cSd, WS_EVENT_OPEN, NULL, 0, 0);
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! ws_fail
+//!
+//!  @param  pConn     connection that broke the protocol or a limit
+//!  @param  usStatus  close status code sent
+//!
+//!  @return  1, to close the connection
+//
+//*****************************************************************************
+static unsigned char
+ws_fail(tWsConn *pConn, unsigned short usStatus)
+{
+	unsigned char aucStatus[2];
+
+	wsStats.ulProtocolErrors++;
+
+	aucStatus[0] = usStatus >> 8;
+	aucStatus[1] = usStatus & 0xff;
+	ws_frame_send(pConn->cSd, WS_OPCODE_CLOSE, aucStatus, 2);
+
+	return 1;
+}
+
+//*****************************************************************************
+//
+//! ws_deliver
+//!
+//!  @param  pConn    connection
+//!  @param  pucData  unmasked payload
+//!  @param  usLen    payload length
+//!
+//!  @return  none
+//!
+//!  @brief  Pass a piece of a data frame to the handler
+//
+//*****************************************************************************
+static void
+ws_deliver(tWsConn *pConn, unsigned char *pucData, unsigned short usLen)
+{
+	unsigned char ucFlags = 0;
+
+	if (pConn->ucFlags & WS_CONN_FIRST)
+	{
+		ucFlags |= WS_FLAG_FIRST;
+		pConn->ucFlags &= ~WS_CONN_FIRST;
+	}
+	if (pConn->ucFlags & WS_CONN_BINARY)
+	{
+		ucFlags |= WS_FLAG_BINARY;
+	}
+	if ((pConn->ucFlags & WS_CONN_FIN) && (pConn->ulRemaining == 0))
+	{
+		ucFlags |= WS_FLAG_FINAL;
+	}
+
+	wsHandler(pConn->cSd, WS_EVENT_DATA, pucData, usLen, ucFlags);
+}
+
+//*****************************************************************************
+//
+//! ws_frame_end
+//!
+//!  @param  pConn  connection with a fully read frame
+//!
+//!  @return  0 to carry on, 1 to close the connection
+//
+//*****************************************************************************
+static unsigned char
+ws_frame_end(tWsConn *pConn)
+{
+	pConn->ucState = WS_STATE_FRAME_HEAD;
+
+	switch (pConn->ucOpcode)
+	{
+	case WS_OPCODE_PING:
+		wsStats.ulPings++;
+		ws_frame_send(pConn->cSd, WS_OPCODE_PONG, pConn->u.aucControl, pConn->ucLen);
+		break;
+
+	case WS_OPCODE_PONG:
+		break;
+
+	case WS_OPCODE_CLOSE:
+		// Echo the status code, then close
+		ws_frame_send(pConn->cSd, WS_OPCODE_CLOSE, pConn->u.aucControl,
+			(pConn->ucLen < 2) ? pConn->ucLen : 2);
+		return 1;
+
+	default:
+		if (pConn->ucFlags & WS_CONN_FIN)
+		{
+			wsStats.ulMessagesIn++;
+			pConn->ucFlags &= ~WS_CONN_IN_MSG;
+		}
+		break;
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! ws_parse
+//!
+//!  @param  pConn    connection
+//!  @param  pucBuf   received bytes, unmasked in place
+//!  @param  usLen    number of bytes
+//!
+//!  @return  0 to carry on, 1 to close the connection
+//
+//*****************************************************************************
+static unsigned char
+ws_parse(tWsConn *pConn, unsigned char *pucBuf, unsigned short usLen)
+{
+	unsigned short usRun, i;
+	unsigned char c;
+
+	while (usLen)
+	{
+		if (pConn->ucState == WS_STATE_FRAME_PAYLOAD)
+		{
+			usRun = usLen;
+			if (pConn->ulRemaining < usRun)
+			{
+				usRun = (unsigned short)pConn->ulRemaining;
+			}
+
+			for (i = 0; i < usRun; i++)
+			{
+				pucBuf[i] ^= pConn->aucMask[pConn->ucMaskPos++ & 3];
+			}
+			pConn->ulRemaining -= usRun;
+			wsStats.ulBytesIn += usRun;
+
+			if (pConn->ucOpcode & 0x08)
+			{
+				// Control frame, keep the payload for the answer
+				for (i = 0; (i < usRun) && (pConn->ucLen < WS_CONTROL_MAX); i++)
+				{
+					pConn->u.aucControl[pConn->ucLen++] = pucBuf[i];
+				}
+			}
+			else
+			{
+				ws_deliver(pConn, pucBuf, usRun);
+				if (pConn->cSd < 0)
+				{
+					// Closed by the handler
+					return 0;
+				}
+			}
+
+			pucBuf += usRun;
+			usLen -= usRun;
+
+			if ((pConn->ulRemaining == 0) && ws_frame_end(pConn))
+			{
+				return 1;
+			}
+			continue;
+		}
+
+		c = *pucBuf++;
+		usLen--;
+
+		switch (pConn->ucState)
+		{
+		case WS_STATE_REQUEST:
+			if (c == '\n')
+			{
+				pConn->ucLen = 0;
+				pConn->ucState = WS_STATE_HEADER_NAME;
+			}
+			break;
+
+		case WS_STATE_HEADER_NAME:
+			if (c == '\r')
+			{
+				break;
+			}
+			if (c == '\n')
+			{
+				if (pConn->ucLen == 0)
+				{
+					// End of the request, frames may follow in the same buffer
+					if (ws_handshake(pConn))
+					{
+						return 1;
+					}
+				}
+				pConn->ucLen = 0;
+				break;
+			}
+			if (c == ':')
+			{
+				pConn->u.hs.acToken[pConn->ucLen] = '\0';
+				if (strcmp_P(pConn->u.hs.acToken, PSTR("upgrade")) == 0)
+				{
+					pConn->ucHeader = WS_HEADER_UPGRADE;
+				}
+				else if (strcmp_P(pConn->u.hs.acToken, PSTR("sec-websocket-key")) == 0)
+				{
+					pConn->ucHeader = WS_HEADER_KEY;
+				}
+				else
+				{
+					pConn->ucHeader = WS_HEADER_OTHER;
+				}
+				pConn->ucLen = 0;
+				pConn->ucState = WS_STATE_HEADER_VALUE;
+				break;
+			}
+			if (pConn->ucLen < WS_TOKEN_MAX)
+			{
+				pConn->u.hs.acToken[pConn->ucLen++] = ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c;
+			}
+			break;
+
+		case WS_STATE_HEADER_VALUE:
+			if ((c == '\r') || (((c == ' ') || (c == '\t')) && (pConn->ucLen == 0)))
+			{
+				break;
+			}
+			if (c == '\n')
+			{
+				if (pConn->ucHeader == WS_HEADER_UPGRADE)
+				{
+					pConn->u.hs.acToken[pConn->ucLen] = '\0';
+					if (strcmp_P(pConn->u.hs.acToken, PSTR("websocket")) == 0)
+					{
+						pConn->ucFlags |= WS_CONN_UPGRADE;
+					}
+				}
+				else if ((pConn->ucHeader == WS_HEADER_KEY) && (pConn->ucLen == WS_KEY_LEN))
+				{
+					pConn->ucFlags |= WS_CONN_KEY;
+				}
+				pConn->ucLen = 0;
+				pConn->ucState = WS_STATE_HEADER_NAME;
+				break;
+			}
+			if (pConn->ucHeader == WS_HEADER_KEY)
+			{
+				if (pConn->ucLen < WS_KEY_LEN)
+				{
+					pConn->u.hs.acKey[pConn->ucLen] = c;
+				}
+				if (pConn->ucLen < 255)
+				{
+					pConn->ucLen++;
+				}
+			}
+			else if ((pConn->ucHeader == WS_HEADER_UPGRADE) && (pConn->ucLen < WS_TOKEN_MAX))
+			{
+				pConn->u.hs.acToken[pConn->ucLen++] = ((c >= 'A') && (c <= 'Z')) ? c + ('a' - 'A') : c;
+			}
+			break;
+
+		case WS_STATE_FRAME_HEAD:
+			if (c & 0x70)
+			{
+				// No extensions were negotiated, RSV bits must be 0
+				return ws_fail(pConn, WS_STATUS_PROTOCOL_ERROR);
+			}
+
+			pConn->ucOpcode = c & 0x0f;
+			if (pConn->ucOpcode & 0x08)
+			{
+				// Control frames can't be fragmented
+				if (!(c & 0x80) || (pConn->ucOpcode > WS_OPCODE_PONG))
+				{
+					return ws_fail(pConn, WS_STATUS_PROTOCOL_ERROR);
+				}
+			}
+			else if (pConn->ucOpcode == WS_OPCODE_CONTINUATION)
+			{
+				if (!(pConn->ucFlags & WS_CONN_IN_MSG))
+				{
+					return ws_fail(pConn, WS_STATUS_PROTOCOL_ERROR);
+				}
+			}
+			else if (((pConn->ucOpcode == WS_OPCODE_TEXT) || (pConn->ucOpcode == WS_OPCODE_BINARY)) &&
+					!(pConn->ucFlags & WS_CONN_IN_MSG))
+			{
+				pConn->ucFlags |= WS_CONN_IN_MSG | WS_CONN_FIRST;
+				if (pConn->ucOpcode == WS_OPCODE_BINARY)
+				{
+					pConn->ucFlags |= WS_CONN_BINARY;
+				}
+				else
+				{
+					pConn->ucFlags &= ~WS_CONN_BINARY;
+				}
+			}
+			else
+			{
+				return ws_fail(pConn, WS_STATUS_PROTOCOL_ERROR);
+			}
+
+			if (c & 0x80)
+			{
+				pConn->ucFlags |= WS_CONN_FIN;
+			}
+			else
+			{
+				pConn->ucFlags &= ~WS_CONN_FIN;
+			}
+			pConn->ucState = WS_STATE_FRAME_LEN;
+			break;
+
+		case WS_STATE_FRAME_LEN:
+			// Clients must mask every frame, control payloads are 125 bytes at most
+			if (!(c & 0x80) || ((pConn->ucOpcode & 0x08) && ((c & 0x7f) > 125)))
+			{
+				return ws_fail(pConn, WS_STATUS_PROTOCOL_ERROR);
+			}
+
+			// A pong has to carry the whole ping payload back
+			if ((pConn->ucOpcode == WS_OPCODE_PING) && ((c & 0x7f) > WS_CONTROL_MAX))
+			{
+				return ws_fail(pConn, WS_STATUS_TOO_BIG);
+			}
+
+			pConn->ulRemaining = 0;
+			pConn->ucLen = 0;
+			c &= 0x7f;
+			if (c == 126)
+			{
+				pConn->ucLen = 2;
+				pConn->ucState = WS_STATE_FRAME_EXT_LEN;
+			}
+			else if (c == 127)
+			{
+				pConn->ucLen = 8;
+				pConn->ucState = WS_STATE_FRAME_EXT_LEN;
+			}
+			else
+			{
+				pConn->ulRemaining = c;
+				pConn->ucState = WS_STATE_FRAME_MASK;
+			}
+			break;
+
+		case WS_STATE_FRAME_EXT_LEN:
+			if ((pConn->ucLen > 4) && c)
+			{
+				// 4GB or more
+				return ws_fail(pConn, WS_STATUS_PROTOCOL_ERROR);
+			}
+			pConn->ulRemaining = (pConn->ulRemaining << 8) | c;
+			if (--pConn->ucLen == 0)
+			{
+				pConn->ucState = WS_STATE_FRAME_MASK;
+			}
+			break;
+
+		case WS_STATE_FRAME_MASK:
+			pConn->aucMask[pConn->ucLen++] = c;
+			if (pConn->ucLen < 4)
+			{
+				break;
+			}
+
+			wsStats.ulFramesIn++;
+			pConn->ucMaskPos = 0;
+			pConn->ucLen = 0;
+			pConn->ucState = WS_STATE_FRAME_PAYLOAD;
+
+			if (pConn->ulRemaining == 0)
+			{
+				if (!(pConn->ucOpcode & 0x08))
+				{
+					ws_deliver(pConn, pucBuf, 0);
+					if (pConn->cSd < 0)
+					{
+						return 0;
+					}
+				}
+				if (ws_frame_end(pConn))
+				{
+					return 1;
+				}
+			}
+			break;
+		}
+	}
+
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! ws_reactor_handler
+//!
+//!  @brief  tReactorHandler for the listening socket and the connections
+//
+//*****************************************************************************
+static void
+ws_reactor_handler(long sd, unsigned char ucEvent, long lArg)
+{
+	unsigned char aucBuf[WS_RECV_BUF];
+	tWsConn *pConn;
+	int len;
+
+	switch (ucEvent)
+	{
+	case REACTOR_EVENT_ACCEPT:
+		pConn = ws_find(-1);
+		if ((pConn == NULL) || (reactor_register(lArg, REACTOR_EVENT_READ, ws_reactor_handler) != 0))
+		{
+			wsStats.ulRejected++;
+			closesocket(lArg);
+			break;
+		}
+		memset(pConn, 0, sizeof(tWsConn));
+		pConn->cSd = (signed char)lArg;
+		pConn->ulOpened = millis();
+		pConn->ucState = WS_STATE_REQUEST;
+		break;
+
+	case REACTOR_EVENT_READ:
+		pConn = ws_find(sd);
+		if (pConn == NULL)
+		{
+			break;
+		}
+		len = recv(sd, aucBuf, sizeof(aucBuf), 0);
+		if ((len <= 0) || ws_parse(pConn, aucBuf, len))
+		{
+			// len <= 0: the peer closed or the socket failed
+			ws_conn_close(pConn);
+		}
+		break;
+
+	case REACTOR_EVENT_CLOSE:
+		pConn = ws_find(sd);
+		if (pConn)
+		{
+			// Already unregistered by the reactor
+			pConn->cSd = -1;
+			if (pConn->ucFlags & WS_CONN_OPEN)
+			{
+				wsHandler(sd, WS_EVENT_CLOSE, NULL, 0, 0);
+			}
+		}
+		closesocket(sd);
+		if (sd == cWsListenSd)
+		{
+			cWsListenSd = -1;
+		}
+		break;
+	}
+}
+
+//*****************************************************************************
+//
+//! ws_begin
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+long
+ws_begin(unsigned short usPort, tWsHandler handler)
+{
+	sockaddr addr;
+	unsigned char i;
+	long sd;
+
+	for (i = 0; i < WS_MAX_CONNS; i++)
+	{
+		wsConns[i].cSd = -1;
+	}
+	wsHandler = handler;
+
+	sd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (!M_IS_VALID_SD(sd))
+	{
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sa_family = AF_INET;
+	addr.sa_data[0] = (usPort >> 8) & 0xff;
+	addr.sa_data[1] = usPort & 0xff;
+
+	if ((bind(sd, &addr, sizeof(addr)) != 0) || (listen(sd, MAX_LISTEN_QUEUE) != 0) ||
+			(reactor_register(sd, REACTOR_EVENT_ACCEPT, ws_reactor_handler) != 0))
+	{
+		closesocket(sd);
+		return -1;
+	}
+
+	cWsListenSd = (signed char)sd;
+
+	return sd;
+}
+
+//*****************************************************************************
+//
+//! ws_end
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+void
+ws_end(void)
+{
+	unsigned char i;
+
+	for (i = 0; i < WS_MAX_CONNS; i++)
+	{
+		if (wsConns[i].cSd >= 0)
+		{
+			ws_close(wsConns[i].cSd, WS_STATUS_GOING_AWAY);
+		}
+	}
+
+	if (cWsListenSd >= 0)
+	{
+		reactor_unregister(cWsListenSd);
+		closesocket(cWsListenSd);
+		cWsListenSd = -1;
+	}
+}
+
+//*****************************************************************************
+//
+//! ws_poll
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+int
+ws_poll(unsigned long ulTimeoutMs)
+{
+	unsigned long ulNow;
+	unsigned char i;
+	int res;
+
+	res = reactor_run_once(ulTimeoutMs);
+
+	ulNow = millis();
+	for (i = 0; i < WS_MAX_CONNS; i++)
+	{
+		if ((wsConns[i].cSd >= 0) && !(wsConns[i].ucFlags & WS_CONN_OPEN) &&
+				((ulNow - wsConns[i].ulOpened) >= WS_HANDSHAKE_TIMEOUT_MS))
+		{
+			wsStats.ulBadHandshakes++;
+			ws_conn_close(&wsConns[i]);
+		}
+	}
+
+	return res;
+}
+
+//*****************************************************************************
+//
+//! ws_send
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+long
+ws_send(long sd, unsigned char ucOpcode, const void *buf, unsigned short usLen)
+{
+	const unsigned char *pucData = (const unsigned char *)buf;
+	tWsConn *pConn;
+	unsigned long ulStart;
+	unsigned short usSent, usMax;
+	long lRun;
+
+	pConn = ws_find(sd);
+	if ((sd < 0) || (pConn == NULL) || !(pConn->ucFlags & WS_CONN_OPEN))
+	{
+		return -1;
+	}
+
+	// A control frame has to fit in one frame
+	send_buffer_get(&usMax);
+	if ((ucOpcode & 0x08) && ((usLen > 125) || (usLen + 2 > usMax)))
+	{
+		return -1;
+	}
+
+	ulStart = micros();
+
+	usSent = 0;
+	do
+	{
+		lRun = ws_frame_send(sd, ucOpcode, pucData + usSent, usLen - usSent);
+		if (lRun < 0)
+		{
+			return (usSent) ? usSent : -1;
+		}
+		usSent += lRun;
+		ucOpcode = WS_OPCODE_CONTINUATION;
+	} while (usSent < usLen);
+
+	wsStats.ulMessagesOut++;
+	wsStats.ulSendMicros += micros() - ulStart;
+
+	return usSent;
+}
+
+//*****************************************************************************
+//
+//! ws_broadcast
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+long
+ws_broadcast(unsigned char ucOpcode, const void *buf, unsigned short usLen)
+{
+	unsigned char i;
+	long n = 0;
+
+	for (i = 0; i < WS_MAX_CONNS; i++)
+	{
+		if ((wsConns[i].cSd >= 0) && (wsConns[i].ucFlags & WS_CONN_OPEN) &&
+				(ws_send(wsConns[i].cSd, ucOpcode, buf, usLen) == usLen))
+		{
+			n++;
+		}
+	}
+
+	return n;
+}
+
+//*****************************************************************************
+//
+//! ws_close
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+void
+ws_close(long sd, unsigned short usStatus)
+{
+	unsigned char aucStatus[2];
+	tWsConn *pConn;
+
+	pConn = ws_find(sd);
+	if ((sd < 0) || (pConn == NULL))
+	{
+		return;
+	}
+
+	if (pConn->ucFlags & WS_CONN_OPEN)
+	{
+		aucStatus[0] = usStatus >> 8;
+		aucStatus[1] = usStatus & 0xff;
+		ws_frame_send(sd, WS_OPCODE_CLOSE, aucStatus, 2);
+	}
+
+	ws_conn_close(pConn);
+}
+
+//*****************************************************************************
+//
+//! ws_get_stats
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+void
+ws_get_stats(tWsStats *pStats)
+{
+	memcpy(pStats, &wsStats, sizeof(tWsStats));
+}
+
+//*****************************************************************************
+//
+//! ws_reset_stats
+//!
+//!  @brief  see ws.h
+//
+//*****************************************************************************
+void
+ws_reset_stats(void)
+{
+	memset(&wsStats, 0, sizeof(tWsStats));
+}
+
+#endif	// CC3000_TINY_DRIVER
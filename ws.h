@@ -0,0 +1,229 @@
+/**************************************************************************
+*
+*  This file is part of the ArduinoCC3000 library.
+*
+*  Version 1.0.1b
+*
+*  Copyright (C) 2013 Chris Magagna - cmagagna@yahoo.com
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*  Don't sue me if my code blows up your board and burns down your house
+*
+*
+*  This file is a WebSocket (RFC 6455) server on top of the reactor.
+*  The opening handshake and the frames are parsed a byte at a time as
+*  they arrive; payloads are unmasked in place in the receive buffer and
+*  handed to the handler in pieces, so a message of any size costs no
+*  extra RAM. Fragmented messages are passed on as they come and pings
+*  are answered. Outgoing frames are built straight in the TX buffer and
+*  sized so each one fits in a single CC3000 buffer.
+*
+****************************************************************************/
+#ifndef __WS_H__
+#define __WS_H__
+
+#include "socket.h"
+
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#ifndef CC3000_TINY_DRIVER
+
+// Connections served at once, each keeps one of the CC3000's 8 sockets
+#ifndef WS_MAX_CONNS
+#define WS_MAX_CONNS				(3)
+#endif
+
+// Longest ping payload answered; a longer ping closes the connection with
+// WS_STATUS_TOO_BIG, since the pong has to carry the whole payload back.
+// Set it to 125 to answer every ping; each connection holds a buffer this size.
+#ifndef WS_CONTROL_MAX
+#define WS_CONTROL_MAX				(32)
+#endif
+
+// Connections that haven't finished the opening handshake in this time
+// are closed
+#ifndef WS_HANDSHAKE_TIMEOUT_MS
+#define WS_HANDSHAKE_TIMEOUT_MS		(5000UL)
+#endif
+
+//--------- Opcodes --------
+
+#define WS_OPCODE_CONTINUATION		(0x0)
+#define WS_OPCODE_TEXT				(0x1)
+#define WS_OPCODE_BINARY			(0x2)
+#define WS_OPCODE_CLOSE				(0x8)
+#define WS_OPCODE_PING				(0x9)
+#define WS_OPCODE_PONG				(0xA)
+
+//--------- Close status codes --------
+
+#define WS_STATUS_NORMAL			(1000)
+#define WS_STATUS_GOING_AWAY		(1001)
+#define WS_STATUS_PROTOCOL_ERROR	(1002)
+#define WS_STATUS_TOO_BIG			(1009)
+
+//--------- Handler events --------
+
+#define WS_EVENT_OPEN				(0x01)	// handshake done, the connection can send
+#define WS_EVENT_DATA				(0x02)	// part of a received message
+#define WS_EVENT_CLOSE				(0x04)	// connection closed, sd is no longer valid after
+
+//--------- WS_EVENT_DATA flags --------
+
+#define WS_FLAG_FIRST				(0x01)	// first piece of a message
+#define WS_FLAG_FINAL				(0x02)	// last piece of a message
+#define WS_FLAG_BINARY				(0x04)	// binary message, otherwise text
+
+// Connection handler. For WS_EVENT_DATA, pucData holds usLen unmasked
+// payload bytes (usLen may be 0 for an empty message); the handler may
+// modify them. Messages sent from the handler go out right away
+typedef void (*tWsHandler)(long sd, unsigned char ucEvent, unsigned char *pucData,
+                           unsigned short usLen, unsigned char ucFlags);
+
+typedef struct _ws_stats_t
+{
+	unsigned long	ulConnections;			// handshakes completed
+	unsigned long	ulRejected;				// closed at once, no free connection
+	unsigned long	ulBadHandshakes;
+	unsigned long	ulProtocolErrors;
+	unsigned long	ulFramesIn;
+	unsigned long	ulFramesOut;
+	unsigned long	ulMessagesIn;
+	unsigned long	ulMessagesOut;
+	unsigned long	ulPings;				// pings answered
+	unsigned long	ulBytesIn;				// payload bytes
+	unsigned long	ulBytesOut;
+	unsigned long	ulSendMicros;			// total time in ws_send
+} tWsStats;
+
+
+//*****************************************************************************
+//
+//! ws_begin
+//!
+//!  @param  usPort   TCP port to listen on
+//!  @param  handler  connection handler
+//!
+//!  @return  listening socket, or -1 on failure
+//!
+//!  @brief  Open the listening socket and register it with the reactor.
+//!          Upgrade requests for any path are accepted.
+//
+//*****************************************************************************
+extern long ws_begin(unsigned short usPort, tWsHandler handler);
+
+//*****************************************************************************
+//
+//! ws_end
+//!
+//!  @param  none
+//!
+//!  @return  none
+//!
+//!  @brief  Close every connection (status 1001) and the listening socket
+//
+//*****************************************************************************
+extern void ws_end(void);
+
+//*****************************************************************************
+//
+//! ws_poll
+//!
+//!  @param  ulTimeoutMs  passed to reactor_run_once
+//!
+//!  @return  return value of reactor_run_once
+//!
+//!  @brief  Run one pass of the reactor and close connections stuck in
+//!          the opening handshake
+//
+//*****************************************************************************
+extern int ws_poll(unsigned long ulTimeoutMs);
+
+//*****************************************************************************
+//
+//! ws_send
+//!
+//!  @param  sd        connection, as passed to the handler
+//!  @param  ucOpcode  WS_OPCODE_TEXT, WS_OPCODE_BINARY or WS_OPCODE_PING
+//!  @param  buf       payload
+//!  @param  usLen     payload length, at most 125 for a ping
+//!
+//!  @return  payload bytes sent, or negative on error
+//!
+//!  @brief  Send a message. It is split into as many frames as it takes
+//!          for each to fit in one TX buffer and one CC3000 buffer
+//!          (usSlBufferLength); the payload is copied once, into the TX
+//!          buffer.
+//
+//*****************************************************************************
+extern long ws_send(long sd, unsigned char ucOpcode, const void *buf, unsigned short usLen);
+
+//*****************************************************************************
+//
+//! ws_broadcast
+//!
+//!  @param  ucOpcode  as ws_send
+//!  @param  buf       payload
+//!  @param  usLen     payload length
+//!
+//!  @return  number of connections the message was sent to
+//!
+//!  @brief  Send a message to every open connection
+//
+//*****************************************************************************
+extern long ws_broadcast(unsigned char ucOpcode, const void *buf, unsigned short usLen);
+
+//*****************************************************************************
+//
+//! ws_close
+//!
+//!  @param  sd        connection
+//!  @param  usStatus  close status code, e.g. WS_STATUS_NORMAL
+//!
+//!  @return  none
+//!
+//!  @brief  Send a close frame and close the connection without waiting
+//!          for the client's close frame
+//
+//*****************************************************************************
+extern void ws_close(long sd, unsigned short usStatus);
+
+//*****************************************************************************
+//
+//! ws_get_stats
+//!
+//!  @param[out]  pStats  filled with a copy of the server counters
+//!
+//!  @return  none
+//!
+//!  @brief  ws_reset_stats() zeroes the counters.
+//
+//*****************************************************************************
+extern void ws_get_stats(tWsStats *pStats);
+extern void ws_reset_stats(void);
+
+#endif	// CC3000_TINY_DRIVER
+
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef  __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __WS_H__